@@ -1,6 +1,6 @@
 /**
  *****************************************************************************
- * @file    : 74hc595.c
+ * @file    : 74hc595.h
  * @brief   : Hardware 74hc595 driver
  * @author  : Cao Jin
  * @date    : 15-Oct-2021
@@ -11,6 +11,12 @@
 #ifndef HARDWARE_74HC595_H
 #define HARDWARE_74HC595_H
 
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "driver/gpio.h"
+#include "driver/spi_master.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -18,34 +24,80 @@ extern "C" {
 /**
   * @brief SN74HC595 GPIO Configuration.
   */
-#define SN74HC595_SDA_PIN GPIO_NUM_32 /* ESP32_GPIO_NUM_X -> SN74HC595_SDA */
-#define SN74HC595_RCK_PIN GPIO_NUM_18 /* ESP32_GPIO_NUM_X -> SN74HC595_RCK */
-#define SN74HC595_SCK_PIN GPIO_NUM_19 /* ESP32_GPIO_NUM_X -> SN74HC595_SCK */
+#define SN74HC595_SDA_PIN GPIO_NUM_32 /* ESP32_GPIO_NUM_X -> SN74HC595_SDA (SPI MOSI) */
+#define SN74HC595_RCK_PIN GPIO_NUM_18 /* ESP32_GPIO_NUM_X -> SN74HC595_RCK (SPI CS, latched on the rising edge) */
+#define SN74HC595_SCK_PIN GPIO_NUM_19 /* ESP32_GPIO_NUM_X -> SN74HC595_SCK (SPI SCLK) */
+
+/**
+  * @brief SN74HC595 SPI Configuration.
+  */
+#define SN74HC595_SPI_HOST      SPI3_HOST           /* VSPI, routed through the GPIO matrix. */
+#define SN74HC595_SPI_CLOCK_HZ  (10 * 1000 * 1000)  /* 10MHz, well inside the 74HC595 limit at 3.3V. */
+#define SN74HC595_SPI_DMA_CHAN  SPI_DMA_CH_AUTO     /* DMA is used for chains longer than 4 bytes. */
+
+/**
+  * @brief SN74HC595 chain update statistics.
+  */
+typedef struct
+{
+    uint32_t updates; /* Latched updates. */
+    uint32_t errors;  /* Failed SPI transfers. */
+    uint32_t last_us; /* Duration of the last full chain update. */
+    uint32_t max_us;  /* Longest full chain update. */
+} sn74hc595_stats_t;
 
 /**
-  * @brief Initialize sn74hc595 chip.
+  * @brief Initialize sn74hc595 chain on the SPI peripheral, outputs are not touched.
+  * 
+  * @param[IN]
+  *     - chain_length number of chained sn74hc595 devices, one byte each.
   * 
   * @return -ESP_OK succeed.
   *         -other  failed.
   */
-esp_err_t sn74hc595_init(void);
+esp_err_t sn74hc595_init(size_t chain_length);
+
+/**
+  * @brief Release the SPI device and bus of the chain, outputs keep the last latched image.
+  * 
+  * @return
+  *     - ESP_OK:                succeed.
+  *     - ESP_ERR_INVALID_STATE: not initialized.
+  *     - other:                 SPI release failed.
+  */
+esp_err_t sn74hc595_deinit(void);
 
 /**
-  * @brief  Set the output value of the sn74hc595 device.
+  * @brief  Shift a shadow register image into the chain and latch it with one RCK edge.
+  *         Not thread safe, the caller owns the chain.
   * 
   * @param[IN]
-  *     - _data output value 8/16/24/32 ... Bits.
+  *     - data   image, data[0] drives the device wired to the ESP32, bit n drives output Qn.
+  *     - length image length in bytes, must equal the chain length.
+  * 
+  * @return
+  *     - ESP_OK:                succeed.
+  *     - ESP_ERR_INVALID_ARG:   bad image or length.
+  *     - ESP_ERR_INVALID_STATE: not initialized.
+  *     - other:                 SPI transfer failed.
+  */
+esp_err_t sn74hc595_send_data(const uint8_t *data, size_t length);
+
+/**
+  * @brief  Get the chain update statistics.
+  * 
+  * @param[OUT]
+  *     - stats copy of the statistics.
   * 
   * @return
-  *     - ESP_OK:   succeed.
-  *     - ESP_FAIL: failed.
-  *
+  *     - ESP_OK:              succeed.
+  *     - ESP_ERR_INVALID_ARG: stats is NULL.
   */
-esp_err_t sn74hc595_send_data(void *_data);
+esp_err_t sn74hc595_get_stats(sn74hc595_stats_t *stats);
 
 #ifdef __cplusplus
 }
 #endif
 
 #endif /* HARDWARE_74HC595_H */
-/******************************** End of file *********************************/
\ No newline at end of file
+/******************************** End of file *********************************/
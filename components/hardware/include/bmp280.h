@@ -0,0 +1,109 @@
+/**
+ *****************************************************************************
+ * @file    : bmp280.h
+ * @brief   : Hardware bmp280 pressure sensor driver
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0 
+ *****************************************************************************
+ */
+
+#ifndef HARDWARE_BMP280_H
+#define HARDWARE_BMP280_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+  * @brief BMP280 I2C address, SDO pin low / high.
+  */
+#define BMP280_I2C_ADDRESS_LOW      (0x76U)
+#define BMP280_I2C_ADDRESS_HIGH     (0x77U)
+
+/**
+  * @brief BMP280 registers, BME280 uses the same pressure and temperature layout.
+  */
+#define BMP280_REG_CALIB            (0x88U) /* dig_T1 .. dig_P9, little endian. */
+#define BMP280_REG_CHIP_ID          (0xD0U)
+#define BMP280_REG_CTRL_MEAS        (0xF4U)
+#define BMP280_REG_CONFIG           (0xF5U)
+#define BMP280_REG_DATA             (0xF7U) /* press_msb .. temp_xlsb, one burst. */
+
+#define BMP280_CALIB_LENGTH         (24U)
+#define BMP280_DATA_LENGTH          (6U)
+
+#define BMP280_CHIP_ID              (0x58U)
+#define BME280_CHIP_ID              (0x60U)
+
+/**
+  * @brief Normal mode, temperature x2, pressure x16, 1000 ms standby, IIR filter x4.
+  *        A register and value pair list, written in one transaction.
+  */
+#define BMP280_SETUP_LENGTH         (4U)
+extern const uint8_t bmp280_setup[BMP280_SETUP_LENGTH];
+
+/**
+  * @brief BMP280 calibration, converted once from the calibration registers.
+  */
+typedef struct
+{
+    int32_t t1_x2;  /* dig_T1 << 1. */
+    int32_t t1;     /* dig_T1. */
+    int32_t t2;     /* dig_T2. */
+    int32_t t3;     /* dig_T3. */
+    int64_t p1;     /* dig_P1. */
+    int64_t p2;     /* dig_P2. */
+    int64_t p3;     /* dig_P3. */
+    int64_t p4_q35; /* dig_P4 << 35. */
+    int64_t p5_q17; /* dig_P5 << 17. */
+    int64_t p6;     /* dig_P6. */
+    int64_t p7_q4;  /* dig_P7 << 4. */
+    int64_t p8;     /* dig_P8. */
+    int64_t p9;     /* dig_P9. */
+} bmp280_calib_t;
+
+/**
+  * @brief BMP280 measurement, fixed-point.
+  */
+typedef struct
+{
+    int32_t temperature; /* 1/100 degree Celsius. */
+    uint32_t pressure;   /* Pa, that is 1/100 hPa. */
+} bmp280_data_t;
+
+/**
+  * @brief  Convert the calibration registers.
+  * 
+  * @param[IN]
+  *     - raw   BMP280_CALIB_LENGTH bytes read from BMP280_REG_CALIB.
+  * @param[OUT]
+  *     - calib calibration.
+  * 
+  * @return
+  *     - ESP_OK:               succeed.
+  *     - ESP_ERR_INVALID_RESPONSE: blank calibration.
+  */
+esp_err_t bmp280_parse_calib(const uint8_t *raw, bmp280_calib_t *calib);
+
+/**
+  * @brief  Compensate a burst read with the integer formulas of the datasheet.
+  * 
+  * @param[IN]
+  *     - calib calibration.
+  *     - raw   BMP280_DATA_LENGTH bytes read from BMP280_REG_DATA.
+  * @param[OUT]
+  *     - data  measurement.
+  * 
+  * @return
+  *     - ESP_OK:               succeed.
+  *     - ESP_ERR_INVALID_STATE: no measurement yet (reset values).
+  */
+esp_err_t bmp280_decode(const bmp280_calib_t *calib, const uint8_t *raw, bmp280_data_t *data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HARDWARE_BMP280_H */
+/******************************** End of file *********************************/
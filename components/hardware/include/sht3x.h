@@ -0,0 +1,76 @@
+/**
+ *****************************************************************************
+ * @file    : sht3x.h
+ * @brief   : Hardware sht3x temperature and humidity sensor driver
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0 
+ *****************************************************************************
+ */
+
+#ifndef HARDWARE_SHT3X_H
+#define HARDWARE_SHT3X_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+  * @brief SHT3x I2C address, ADDR pin low / high.
+  */
+#define SHT3X_I2C_ADDRESS_LOW   (0x44U)
+#define SHT3X_I2C_ADDRESS_HIGH  (0x45U)
+
+/**
+  * @brief SHT3x command and measurement lengths.
+  */
+#define SHT3X_COMMAND_LENGTH    (2U)
+#define SHT3X_DATA_LENGTH       (6U)
+
+/**
+  * @brief SHT3x commands, MSB first.
+  */
+extern const uint8_t sht3x_cmd_periodic_1mps_high[SHT3X_COMMAND_LENGTH]; /* Periodic mode, 1 measurement per second, high repeatability. */
+extern const uint8_t sht3x_cmd_fetch_data[SHT3X_COMMAND_LENGTH];         /* Read the last periodic measurement. */
+extern const uint8_t sht3x_cmd_break[SHT3X_COMMAND_LENGTH];              /* Stop the periodic mode. */
+
+/**
+  * @brief SHT3x measurement, fixed-point in 1/100 unit.
+  */
+typedef struct
+{
+    int32_t temperature; /* 1/100 degree Celsius. */
+    int32_t humidity;    /* 1/100 %RH. */
+} sht3x_data_t;
+
+/**
+  * @brief  Calculate the SHT3x CRC-8 of a data word.
+  * 
+  * @param[IN]
+  *     - data  bytes.
+  *     - length number of bytes.
+  * 
+  * @return CRC-8, polynomial 0x31, initial value 0xFF.
+  */
+uint8_t sht3x_crc8(const uint8_t *data, size_t length);
+
+/**
+  * @brief  Convert a fetched measurement, no floating point.
+  * 
+  * @param[IN]
+  *     - raw   SHT3X_DATA_LENGTH bytes read after sht3x_cmd_fetch_data.
+  * @param[OUT]
+  *     - data  measurement.
+  * 
+  * @return
+  *     - ESP_OK:              succeed.
+  *     - ESP_ERR_INVALID_CRC: corrupted measurement.
+  */
+esp_err_t sht3x_decode(const uint8_t *raw, sht3x_data_t *data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HARDWARE_SHT3X_H */
+/******************************** End of file *********************************/
@@ -13,75 +13,200 @@
 #include <string.h>
 #include <stdlib.h>
 #include "driver/gpio.h"
+#include "driver/spi_master.h"
+#include "esp_heap_caps.h"
 #include "esp_log.h"
-#include "sys/unistd.h"
+#include "esp_timer.h"
 
 #include "74hc595.h"
 
-#define SET_SN74HC595_SDA_H() gpio_set_level(SN74HC595_SDA_PIN, 1)
-#define SET_SN74HC595_SDA_L() gpio_set_level(SN74HC595_SDA_PIN, 0)
+/**
+  * @brief Images up to this length go through the transaction tx_data, without DMA.
+  */
+#define SN74HC595_TXDATA_LENGTH (4U)
 
-#define SET_SN74HC595_RCK_H() gpio_set_level(SN74HC595_RCK_PIN, 1)
-#define SET_SN74HC595_RCK_L() gpio_set_level(SN74HC595_RCK_PIN, 0)
+static const char *TAG = "74HC595";
 
-#define SET_SN74HC595_SCK_H() gpio_set_level(SN74HC595_SCK_PIN, 1)
-#define SET_SN74HC595_SCK_L() gpio_set_level(SN74HC595_SCK_PIN, 0)
+static spi_device_handle_t sn74hc595_spi = NULL;
+static uint8_t *sn74hc595_dma_buffer = NULL;
+static size_t sn74hc595_chain_length = 0;
+static sn74hc595_stats_t sn74hc595_stats;
 
-esp_err_t sn74hc595_init(void)
+esp_err_t sn74hc595_init(size_t chain_length)
 {
     esp_err_t ret = ESP_OK;
-    gpio_config_t io_config;
 
-    io_config.pin_bit_mask = (1ULL << SN74HC595_SDA_PIN) | (1ULL << SN74HC595_RCK_PIN) | (1ULL << SN74HC595_SCK_PIN);
-    io_config.mode = GPIO_MODE_OUTPUT;
-    io_config.pull_down_en =  GPIO_PULLDOWN_ENABLE;
-    io_config.pull_up_en = GPIO_PULLUP_DISABLE;
-    io_config.intr_type = GPIO_PIN_INTR_DISABLE;
+    if (chain_length == 0)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (sn74hc595_spi != NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    spi_bus_config_t bus_config = {
+        .mosi_io_num = SN74HC595_SDA_PIN,
+        .miso_io_num = -1,
+        .sclk_io_num = SN74HC595_SCK_PIN,
+        .quadwp_io_num = -1,
+        .quadhd_io_num = -1,
+        .max_transfer_sz = chain_length,
+    };
+
+    /* RCK is the chip select: low while shifting, the rising edge at the end of the transaction latches the chain. */
+    spi_device_interface_config_t device_config = {
+        .mode = 0,
+        .clock_speed_hz = SN74HC595_SPI_CLOCK_HZ,
+        .spics_io_num = SN74HC595_RCK_PIN,
+        .cs_ena_posttrans = 1,
+        .queue_size = 1,
+    };
+
+    if (chain_length > SN74HC595_TXDATA_LENGTH)
+    {
+        sn74hc595_dma_buffer = heap_caps_malloc(chain_length, MALLOC_CAP_DMA);
+        if (sn74hc595_dma_buffer == NULL)
+        {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    ret = spi_bus_initialize(SN74HC595_SPI_HOST, &bus_config, SN74HC595_SPI_DMA_CHAN);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "SPI bus initialize failed: %s", esp_err_to_name(ret));
+        goto cleanup;
+    }
+
+    ret = spi_bus_add_device(SN74HC595_SPI_HOST, &device_config, &sn74hc595_spi);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "SPI add device failed: %s", esp_err_to_name(ret));
+        spi_bus_free(SN74HC595_SPI_HOST);
+        goto cleanup;
+    }
 
-    ret = gpio_config(&io_config);
+    sn74hc595_chain_length = chain_length;
+    memset(&sn74hc595_stats, 0, sizeof(sn74hc595_stats));
 
-    SET_SN74HC595_SDA_L();
-    SET_SN74HC595_RCK_L();
-    SET_SN74HC595_SCK_L();
+    ESP_LOGI(TAG, "%u device chain on SPI%d", (unsigned)chain_length, SN74HC595_SPI_HOST + 1);
 
+    return ESP_OK;
+
+cleanup:
+    heap_caps_free(sn74hc595_dma_buffer);
+    sn74hc595_dma_buffer = NULL;
+    sn74hc595_spi = NULL;
     return ret;
 }
 
-esp_err_t sn74hc595_send_data(void *_data)
+esp_err_t sn74hc595_deinit(void)
 {
-    uint8_t *send_data = NULL;
-    uint8_t send_length = 0;
+    esp_err_t ret = ESP_OK;
+
+    if (sn74hc595_spi == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    ret = spi_bus_remove_device(sn74hc595_spi);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
 
-    send_data = (uint8_t *)_data;
-    send_length = (sizeof(send_data) / 8);
+    ret = spi_bus_free(SN74HC595_SPI_HOST);
+    sn74hc595_spi = NULL;
+    sn74hc595_chain_length = 0;
+    heap_caps_free(sn74hc595_dma_buffer);
+    sn74hc595_dma_buffer = NULL;
 
-    if (send_length == 0)
+    return ret;
+}
+
+esp_err_t sn74hc595_send_data(const uint8_t *data, size_t length)
+{
+    esp_err_t ret = ESP_OK;
+    spi_transaction_t trans;
+    uint8_t *buffer = NULL;
+    int64_t start_us = 0;
+    uint32_t elapsed_us = 0;
+
+    if ((data == NULL) || (length == 0))
     {
-        return false;
+        return ESP_ERR_INVALID_ARG;
     }
 
-    for (uint8_t i = 0; i < send_length; i++)
+    if (sn74hc595_spi == NULL)
     {
-        for (uint8_t j = 0; j < 8; j++)
-        {
-            SET_SN74HC595_SCK_L();
-
-            if (((send_data[i] << j) & 0x8000) != 0)
-            {
-                SET_SN74HC595_SDA_H();
-            }
-            else
-            {
-                SET_SN74HC595_SDA_L();
-            }
-
-            SET_SN74HC595_SCK_H();
-        }
+        return ESP_ERR_INVALID_STATE;
     }
-    SET_SN74HC595_RCK_L();
-    usleep(10);
-    SET_SN74HC595_RCK_H();
 
-    return true;
+    if (length != sn74hc595_chain_length)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(&trans, 0, sizeof(trans));
+    trans.length = length * 8;
+
+    if (length <= SN74HC595_TXDATA_LENGTH)
+    {
+        trans.flags = SPI_TRANS_USE_TXDATA;
+        buffer = trans.tx_data;
+    }
+    else
+    {
+        trans.tx_buffer = sn74hc595_dma_buffer;
+        buffer = sn74hc595_dma_buffer;
+    }
+
+    /* The first byte shifted out ends up in the far end of the chain, so send the image backwards, MSB first. */
+    for (size_t i = 0; i < length; i++)
+    {
+        buffer[i] = data[length - 1 - i];
+    }
+
+    start_us = esp_timer_get_time();
+
+    if (length <= SN74HC595_TXDATA_LENGTH)
+    {
+        ret = spi_device_polling_transmit(sn74hc595_spi, &trans);
+    }
+    else
+    {
+        ret = spi_device_transmit(sn74hc595_spi, &trans);
+    }
+
+    elapsed_us = (uint32_t)(esp_timer_get_time() - start_us);
+
+    if (ret != ESP_OK)
+    {
+        sn74hc595_stats.errors++;
+        return ret;
+    }
+
+    sn74hc595_stats.updates++;
+    sn74hc595_stats.last_us = elapsed_us;
+    if (elapsed_us > sn74hc595_stats.max_us)
+    {
+        sn74hc595_stats.max_us = elapsed_us;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t sn74hc595_get_stats(sn74hc595_stats_t *stats)
+{
+    if (stats == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *stats = sn74hc595_stats;
+
+    return ESP_OK;
 }
-/******************************** End of file *********************************/
\ No newline at end of file
+/******************************** End of file *********************************/
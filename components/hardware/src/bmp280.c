@@ -0,0 +1,105 @@
+/**
+ *****************************************************************************
+ * @file    : bmp280.c
+ * @brief   : hardware bmp280 pressure sensor driver
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0 
+ *
+ * @note Register level only, the caller owns the bus. In normal mode the
+ *       sensor measures on its own and one 6 byte burst reads both values.
+ *****************************************************************************
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#include "bmp280.h"
+
+/** @brief Value of the 20-bit data registers before the first measurement. */
+#define BMP280_ADC_SKIPPED  (0x80000)
+
+const uint8_t bmp280_setup[BMP280_SETUP_LENGTH] = {
+    BMP280_REG_CONFIG, 0xA8,    /* t_sb 1000 ms, filter x4. */
+    BMP280_REG_CTRL_MEAS, 0x57, /* osrs_t x2, osrs_p x16, normal mode. */
+};
+
+static inline uint16_t bmp280_u16(const uint8_t *raw)
+{
+    return (uint16_t)(raw[0] | (raw[1] << 8));
+}
+
+static inline int16_t bmp280_s16(const uint8_t *raw)
+{
+    return (int16_t)bmp280_u16(raw);
+}
+
+esp_err_t bmp280_parse_calib(const uint8_t *raw, bmp280_calib_t *calib)
+{
+    uint16_t t1 = bmp280_u16(&raw[0]);
+    uint16_t p1 = bmp280_u16(&raw[6]);
+
+    if ((t1 == 0) || (p1 == 0))
+    {
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    calib->t1 = t1;
+    calib->t1_x2 = (int32_t)t1 << 1;
+    calib->t2 = bmp280_s16(&raw[2]);
+    calib->t3 = bmp280_s16(&raw[4]);
+    calib->p1 = p1;
+    calib->p2 = bmp280_s16(&raw[8]);
+    calib->p3 = bmp280_s16(&raw[10]);
+    calib->p4_q35 = (int64_t)bmp280_s16(&raw[12]) * ((int64_t)1 << 35);
+    calib->p5_q17 = (int64_t)bmp280_s16(&raw[14]) * ((int64_t)1 << 17);
+    calib->p6 = bmp280_s16(&raw[16]);
+    calib->p7_q4 = (int64_t)bmp280_s16(&raw[18]) * 16;
+    calib->p8 = bmp280_s16(&raw[20]);
+    calib->p9 = bmp280_s16(&raw[22]);
+
+    return ESP_OK;
+}
+
+esp_err_t bmp280_decode(const bmp280_calib_t *calib, const uint8_t *raw, bmp280_data_t *data)
+{
+    int32_t adc_p = (int32_t)(((uint32_t)raw[0] << 12) | ((uint32_t)raw[1] << 4) | (raw[2] >> 4));
+    int32_t adc_t = (int32_t)(((uint32_t)raw[3] << 12) | ((uint32_t)raw[4] << 4) | (raw[5] >> 4));
+
+    if ((adc_p == BMP280_ADC_SKIPPED) || (adc_t == BMP280_ADC_SKIPPED))
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    /* Temperature, 32-bit formula of the datasheet. */
+    int32_t var1 = (((adc_t >> 3) - calib->t1_x2) * calib->t2) >> 11;
+    int32_t delta = (adc_t >> 4) - calib->t1;
+    int32_t var2 = (((delta * delta) >> 12) * calib->t3) >> 14;
+    int32_t t_fine = var1 + var2;
+
+    data->temperature = (t_fine * 5 + 128) >> 8;
+
+    /* Pressure, 64-bit formula of the datasheet, Q24.8 Pa. */
+    int64_t p_var1 = (int64_t)t_fine - 128000;
+    int64_t p_var2 = p_var1 * p_var1 * calib->p6;
+    p_var2 += p_var1 * calib->p5_q17;
+    p_var2 += calib->p4_q35;
+    p_var1 = ((p_var1 * p_var1 * calib->p3) >> 8) + ((p_var1 * calib->p2) * 4096);
+    p_var1 = ((((int64_t)1 << 47) + p_var1) * calib->p1) >> 33;
+    if (p_var1 == 0)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    int64_t p = 1048576 - adc_p;
+    p = ((p * ((int64_t)1 << 31) - p_var2) * 3125) / p_var1;
+    p_var1 = (calib->p9 * (p >> 13) * (p >> 13)) >> 25;
+    p_var2 = (calib->p8 * p) >> 19;
+    p = ((p + p_var1 + p_var2) >> 8) + calib->p7_q4;
+
+    data->pressure = (uint32_t)((p + 128) >> 8);
+
+    return ESP_OK;
+}
+/******************************** End of file *********************************/
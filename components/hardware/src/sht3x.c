@@ -0,0 +1,56 @@
+/**
+ *****************************************************************************
+ * @file    : sht3x.c
+ * @brief   : hardware sht3x temperature and humidity sensor driver
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0 
+ *
+ * @note Register level only, the caller owns the bus. The periodic mode lets
+ *       one fetch transaction replace a trigger, a wait and a read.
+ *****************************************************************************
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#include "sht3x.h"
+
+const uint8_t sht3x_cmd_periodic_1mps_high[SHT3X_COMMAND_LENGTH] = { 0x21, 0x30 };
+const uint8_t sht3x_cmd_fetch_data[SHT3X_COMMAND_LENGTH] = { 0xE0, 0x00 };
+const uint8_t sht3x_cmd_break[SHT3X_COMMAND_LENGTH] = { 0x30, 0x93 };
+
+uint8_t sht3x_crc8(const uint8_t *data, size_t length)
+{
+    uint8_t crc = 0xFF;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        crc ^= data[i];
+        for (uint8_t j = 0; j < 8; j++)
+        {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x31) : (uint8_t)(crc << 1);
+        }
+    }
+
+    return crc;
+}
+
+esp_err_t sht3x_decode(const uint8_t *raw, sht3x_data_t *data)
+{
+    if ((sht3x_crc8(&raw[0], 2) != raw[2]) || (sht3x_crc8(&raw[3], 2) != raw[5]))
+    {
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    uint32_t raw_temperature = ((uint32_t)raw[0] << 8) | raw[1];
+    uint32_t raw_humidity = ((uint32_t)raw[3] << 8) | raw[4];
+
+    /* T = -45 + 175 * St / 65535, RH = 100 * Srh / 65535, both products fit in 32 bits. */
+    data->temperature = (int32_t)((17500U * raw_temperature + 32767U) / 65535U) - 4500;
+    data->humidity = (int32_t)((10000U * raw_humidity + 32767U) / 65535U);
+
+    return ESP_OK;
+}
+/******************************** End of file *********************************/
@@ -31,13 +31,21 @@ typedef struct led_strip_s led_strip_t;
 */
 typedef void *led_strip_dev_t;
 
+/**
+* @brief LED Strip refresh done callback, called from the transmit done interrupt
+*
+* @param strip: LED strip
+* @param arg: user argument passed to refresh_async
+*/
+typedef void (*led_strip_refresh_done_cb_t)(led_strip_t *strip, void *arg);
+
 /**
 * @brief Declare of LED Strip Type
 *
 */
 struct led_strip_s {
     /**
-    * @brief Set RGB for a specific pixel
+    * @brief Set RGB for a specific pixel, gamma and brightness corrected
     *
     * @param strip: LED strip
     * @param index: index of pixel to set
@@ -68,6 +76,35 @@ struct led_strip_s {
     */
     esp_err_t (*refresh)(led_strip_t *strip, uint32_t timeout_ms);
 
+    /**
+    * @brief Start flushing memory colors to LEDs without waiting
+    *
+    * @param strip: LED strip
+    * @param done_cb: called from interrupt context when the frame is out, can be NULL
+    * @param arg: user argument for done_cb
+    *
+    * @return
+    *      - ESP_OK: Refresh started
+    *      - ESP_ERR_INVALID_STATE: The previous frame is still transmitting
+    *      - ESP_FAIL: Refresh failed because some other error occurred
+    *
+    * @note:
+    *      The frame is double buffered, set_pixel can render the next frame while this one is transmitting.
+    */
+    esp_err_t (*refresh_async)(led_strip_t *strip, led_strip_refresh_done_cb_t done_cb, void *arg);
+
+    /**
+    * @brief Wait until the frame being transmitted is out
+    *
+    * @param strip: LED strip
+    * @param timeout_ms: timeout value for waiting
+    *
+    * @return
+    *      - ESP_OK: No frame is transmitting
+    *      - ESP_ERR_TIMEOUT: The frame is still transmitting
+    */
+    esp_err_t (*wait_refresh_done)(led_strip_t *strip, uint32_t timeout_ms);
+
     /**
     * @brief Clear LED strip (turn off all LEDs)
     *
@@ -81,6 +118,34 @@ struct led_strip_s {
     */
     esp_err_t (*clear)(led_strip_t *strip, uint32_t timeout_ms);
 
+    /**
+    * @brief Set the brightness of the pixels set afterwards
+    *
+    * @param strip: LED strip
+    * @param brightness: 0 ~ 255, 255 is full scale
+    *
+    * @return
+    *      - ESP_OK: Set brightness successfully
+    *
+    * @note:
+    *      The gamma and brightness table is only rebuilt here, pixels already set keep their level.
+    */
+    esp_err_t (*set_brightness)(led_strip_t *strip, uint8_t brightness);
+
+    /**
+    * @brief Enable temporal dithering
+    *
+    * @param strip: LED strip
+    * @param enable: true to spread the sub-step part of each level over successive refreshes
+    *
+    * @return
+    *      - ESP_OK: Set dithering successfully
+    *
+    * @note:
+    *      Dithering only shows when the strip is refreshed continuously, e.g. at a fixed frame rate.
+    */
+    esp_err_t (*set_dithering)(led_strip_t *strip, bool enable);
+
     /**
     * @brief Free LED strip resources
     *
@@ -102,6 +167,19 @@ typedef struct {
     led_strip_dev_t dev; /*!< LED strip device (e.g. RMT channel, PWM channel, etc) */
 } led_strip_config_t;
 
+/**
+* @brief WS2812 LED Strip statistics
+*
+*/
+typedef struct {
+    uint32_t frames;           /*!< Frames transmitted */
+    uint32_t last_frame_us;    /*!< Duration of the last frame, start to transmit done */
+    uint32_t max_frame_us;     /*!< Longest frame */
+    uint64_t translated_bytes; /*!< Bytes converted to RMT items, 3 per LED */
+    uint64_t translate_cycles; /*!< CPU cycles spent in the RMT translator */
+    uint32_t last_prepare_cycles; /*!< CPU cycles of the last frame hand-over, copy and dithering */
+} led_strip_ws2812_stats_t;
+
 /**
  * @brief Default configuration for LED strip
  *
@@ -121,6 +199,37 @@ typedef struct {
 */
 led_strip_t *led_strip_new_rmt_ws2812(const led_strip_config_t *config);
 
+/**
+* @brief Refresh several ws2812 strips in parallel and wait for all of them
+*
+* @note Each strip must be on its own RMT channel. Where the RMT supports synchronous transmission the
+*       channels start on the same clock edge, otherwise they start back to back. Either way the group
+*       costs one frame of wall-clock time, the one of the longest strip.
+*
+* @param strips: LED strips created by led_strip_new_rmt_ws2812
+* @param count: number of strips
+* @param timeout_ms: timeout value for each wait
+* @return
+*      - ESP_OK: Refresh successfully
+*      - ESP_ERR_INVALID_ARG: Invalid parameters
+*      - ESP_ERR_TIMEOUT: Refresh failed because of timeout
+*      - ESP_FAIL: Refresh failed because some other error occurred
+*/
+esp_err_t led_strip_rmt_ws2812_refresh_group(led_strip_t *const *strips, size_t count, uint32_t timeout_ms);
+
+/**
+* @brief Get the statistics of a ws2812 strip
+*
+* @note Translator cycles per LED is translate_cycles * 3 / translated_bytes.
+*
+* @param strip: LED strip created by led_strip_new_rmt_ws2812
+* @param stats: statistics
+* @return
+*      - ESP_OK: Get statistics successfully
+*      - ESP_ERR_INVALID_ARG: Invalid parameters
+*/
+esp_err_t led_strip_rmt_ws2812_get_stats(led_strip_t *strip, led_strip_ws2812_stats_t *stats);
+
 #ifdef __cplusplus
 }
 #endif
@@ -13,11 +13,17 @@
 // limitations under the License.
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 #include <sys/cdefs.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 #include "esp_log.h"
 #include "esp_attr.h"
+#include "esp_timer.h"
+#include "hal/cpu_hal.h"
 #include "led_strip.h"
 #include "driver/rmt.h"
+#include "soc/soc_caps.h"
 
 static const char *TAG = "ws2812";
 #define STRIP_CHECK(a, str, goto_tag, ret_value, ...)                             \
@@ -37,18 +43,75 @@ static const char *TAG = "ws2812";
 #define WS2812_T1L_NS (350)
 #define WS2812_RESET_US (280)
 
-static uint32_t ws2812_t0h_ticks = 0;
-static uint32_t ws2812_t1h_ticks = 0;
-static uint32_t ws2812_t0l_ticks = 0;
-static uint32_t ws2812_t1l_ticks = 0;
+#define WS2812_BITS_PER_BYTE (8)
+#define WS2812_DEL_TIMEOUT_MS (1000)
+#define WS2812_GAMMA (2.2f)
 
 typedef struct {
     led_strip_t parent;
     rmt_channel_t rmt_channel;
     uint32_t strip_len;
-    uint8_t buffer[0];
+    rmt_item32_t lut[256][WS2812_BITS_PER_BYTE]; // RMT items of every byte value in this channel's ticks, MSB first
+    uint16_t level[256];                 // gamma and brightness corrected level of every color value, 8.8 fixed-point
+    uint8_t brightness;
+    bool dithering;                      // spread the level fractions over successive frames
+    uint32_t back;                       // frame rendered by set_pixel, the other one may be transmitting
+    volatile bool busy;                  // a frame is transmitting, cleared after done_cb
+    led_strip_refresh_done_cb_t done_cb;
+    void *done_arg;
+    int64_t frame_start_us;
+    SemaphoreHandle_t done_sem;
+    portMUX_TYPE lock;                   // protects stats, updated from the RMT interrupt
+    led_strip_ws2812_stats_t stats;
+    uint8_t buffer[0];                   // two frames, level fractions and dither errors, strip_len * 3 bytes each
 } ws2812_t;
 
+// The RMT driver has one transmit done callback for all channels
+static ws2812_t *ws2812_strips[RMT_CHANNEL_MAX];
+
+static inline uint8_t *ws2812_frame(ws2812_t *ws2812, uint32_t index)
+{
+    return ws2812->buffer + index * ws2812->strip_len * 3;
+}
+
+static inline uint8_t *ws2812_fraction(ws2812_t *ws2812)
+{
+    return ws2812->buffer + 2 * ws2812->strip_len * 3;
+}
+
+static inline uint8_t *ws2812_dither_error(ws2812_t *ws2812)
+{
+    return ws2812->buffer + 3 * ws2812->strip_len * 3;
+}
+
+// Only runs when the brightness changes, set_pixel is a table lookup
+static void ws2812_build_level(ws2812_t *ws2812, uint8_t brightness)
+{
+    const float full_scale = 255.0f * 256.0f * brightness / 255.0f;
+    for (int value = 0; value < 256; value++) {
+        ws2812->level[value] = (uint16_t)(full_scale * powf(value / 255.0f, WS2812_GAMMA) + 0.5f);
+    }
+    ws2812->brightness = brightness;
+}
+
+static void ws2812_build_lut(ws2812_t *ws2812, uint32_t counter_clk_hz)
+{
+    // ns -> ticks, each channel may run its own clock divider
+    float ratio = (float)counter_clk_hz / 1e9;
+    uint32_t t0h_ticks = (uint32_t)(ratio * WS2812_T0H_NS);
+    uint32_t t0l_ticks = (uint32_t)(ratio * WS2812_T0L_NS);
+    uint32_t t1h_ticks = (uint32_t)(ratio * WS2812_T1H_NS);
+    uint32_t t1l_ticks = (uint32_t)(ratio * WS2812_T1L_NS);
+    const rmt_item32_t bit0 = {{{ t0h_ticks, 1, t0l_ticks, 0 }}}; //Logical 0
+    const rmt_item32_t bit1 = {{{ t1h_ticks, 1, t1l_ticks, 0 }}}; //Logical 1
+    for (int value = 0; value < 256; value++) {
+        for (int i = 0; i < WS2812_BITS_PER_BYTE; i++) {
+            // MSB first
+            ws2812->lut[value][i].val = (value & (1 << (7 - i))) ? bit1.val : bit0.val;
+        }
+    }
+}
+
 /**
  * @brief Conver RGB data to RMT format.
  *
@@ -64,33 +127,60 @@ typedef struct {
 static void IRAM_ATTR ws2812_rmt_adapter(const void *src, rmt_item32_t *dest, size_t src_size,
         size_t wanted_num, size_t *translated_size, size_t *item_num)
 {
-    if (src == NULL || dest == NULL) {
+    ws2812_t *ws2812 = NULL;
+    if (src == NULL || dest == NULL ||
+        rmt_translator_get_context(item_num, (void **)&ws2812) != ESP_OK || ws2812 == NULL) {
         *translated_size = 0;
         *item_num = 0;
         return;
     }
-    const rmt_item32_t bit0 = {{{ ws2812_t0h_ticks, 1, ws2812_t0l_ticks, 0 }}}; //Logical 0
-    const rmt_item32_t bit1 = {{{ ws2812_t1h_ticks, 1, ws2812_t1l_ticks, 0 }}}; //Logical 1
+    uint32_t start_cycles = cpu_hal_get_cycle_count();
     size_t size = 0;
     size_t num = 0;
-    uint8_t *psrc = (uint8_t *)src;
+    const uint8_t *psrc = (const uint8_t *)src;
     rmt_item32_t *pdest = dest;
-    while (size < src_size && num < wanted_num) {
-        for (int i = 0; i < 8; i++) {
-            // MSB first
-            if (*psrc & (1 << (7 - i))) {
-                pdest->val =  bit1.val;
-            } else {
-                pdest->val =  bit0.val;
-            }
-            num++;
-            pdest++;
-        }
+    while (size < src_size && num + WS2812_BITS_PER_BYTE <= wanted_num) {
+        memcpy(pdest, ws2812->lut[*psrc], sizeof(ws2812->lut[0]));
+        pdest += WS2812_BITS_PER_BYTE;
+        num += WS2812_BITS_PER_BYTE;
         size++;
         psrc++;
     }
     *translated_size = size;
     *item_num = num;
+
+    uint32_t cycles = cpu_hal_get_cycle_count() - start_cycles;
+    portENTER_CRITICAL_ISR(&ws2812->lock);
+    ws2812->stats.translated_bytes += size;
+    ws2812->stats.translate_cycles += cycles;
+    portEXIT_CRITICAL_ISR(&ws2812->lock);
+}
+
+static void IRAM_ATTR ws2812_tx_end(rmt_channel_t channel, void *arg)
+{
+    if (channel >= RMT_CHANNEL_MAX || ws2812_strips[channel] == NULL) {
+        return;
+    }
+    ws2812_t *ws2812 = ws2812_strips[channel];
+    uint32_t elapsed_us = (uint32_t)(esp_timer_get_time() - ws2812->frame_start_us);
+    portENTER_CRITICAL_ISR(&ws2812->lock);
+    ws2812->stats.frames++;
+    ws2812->stats.last_frame_us = elapsed_us;
+    if (elapsed_us > ws2812->stats.max_frame_us) {
+        ws2812->stats.max_frame_us = elapsed_us;
+    }
+    portEXIT_CRITICAL_ISR(&ws2812->lock);
+
+    if (ws2812->done_cb) {
+        ws2812->done_cb(&ws2812->parent, ws2812->done_arg);
+    }
+    ws2812->busy = false;
+
+    BaseType_t woken = pdFALSE;
+    xSemaphoreGiveFromISR(ws2812->done_sem, &woken);
+    if (woken == pdTRUE) {
+        portYIELD_FROM_ISR();
+    }
 }
 
 static esp_err_t ws2812_set_pixel(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue)
@@ -98,23 +188,82 @@ static esp_err_t ws2812_set_pixel(led_strip_t *strip, uint32_t index, uint32_t r
     esp_err_t ret = ESP_OK;
     ws2812_t *ws2812 = __containerof(strip, ws2812_t, parent);
     STRIP_CHECK(index < ws2812->strip_len, "index out of the maximum number of leds", err, ESP_ERR_INVALID_ARG);
+    uint8_t *buffer = ws2812_frame(ws2812, ws2812->back);
+    uint8_t *fraction = ws2812_fraction(ws2812);
     uint32_t start = index * 3;
+    uint16_t grb[3] = {
+        ws2812->level[green & 0xFF],
+        ws2812->level[red & 0xFF],
+        ws2812->level[blue & 0xFF],
+    };
     // In thr order of GRB
-    ws2812->buffer[start + 0] = green & 0xFF;
-    ws2812->buffer[start + 1] = red & 0xFF;
-    ws2812->buffer[start + 2] = blue & 0xFF;
+    for (int i = 0; i < 3; i++) {
+        buffer[start + i] = grb[i] >> 8;
+        fraction[start + i] = grb[i] & 0xFF;
+    }
     return ESP_OK;
 err:
     return ret;
 }
 
-static esp_err_t ws2812_refresh(led_strip_t *strip, uint32_t timeout_ms)
+static esp_err_t ws2812_refresh_async(led_strip_t *strip, led_strip_refresh_done_cb_t done_cb, void *arg)
 {
     esp_err_t ret = ESP_OK;
     ws2812_t *ws2812 = __containerof(strip, ws2812_t, parent);
-    STRIP_CHECK(rmt_write_sample(ws2812->rmt_channel, ws2812->buffer, ws2812->strip_len * 3, true) == ESP_OK,
-                "transmit RMT samples failed", err, ESP_FAIL);
-    return rmt_wait_tx_done(ws2812->rmt_channel, pdMS_TO_TICKS(timeout_ms));
+    STRIP_CHECK(!ws2812->busy, "previous frame is still transmitting", err, ESP_ERR_INVALID_STATE);
+
+    // Hand the rendered frame to the RMT, keep rendering on a copy of it
+    uint32_t start_cycles = cpu_hal_get_cycle_count();
+    uint32_t front = ws2812->back;
+    ws2812->back ^= 1;
+    memcpy(ws2812_frame(ws2812, ws2812->back), ws2812_frame(ws2812, front), ws2812->strip_len * 3);
+    if (ws2812->dithering) {
+        // Carry the accumulated fractions into the transmitted copy only, a level with a fraction is below 255
+        uint8_t *frame = ws2812_frame(ws2812, front);
+        const uint8_t *fraction = ws2812_fraction(ws2812);
+        uint8_t *error = ws2812_dither_error(ws2812);
+        for (uint32_t i = 0; i < ws2812->strip_len * 3; i++) {
+            uint32_t sum = error[i] + fraction[i];
+            frame[i] += sum >> 8;
+            error[i] = sum & 0xFF;
+        }
+    }
+    uint32_t prepare_cycles = cpu_hal_get_cycle_count() - start_cycles;
+    portENTER_CRITICAL(&ws2812->lock);
+    ws2812->stats.last_prepare_cycles = prepare_cycles;
+    portEXIT_CRITICAL(&ws2812->lock);
+
+    xSemaphoreTake(ws2812->done_sem, 0);
+    ws2812->done_cb = done_cb;
+    ws2812->done_arg = arg;
+    ws2812->busy = true;
+    ws2812->frame_start_us = esp_timer_get_time();
+    if (rmt_write_sample(ws2812->rmt_channel, ws2812_frame(ws2812, front), ws2812->strip_len * 3, false) != ESP_OK) {
+        ws2812->busy = false;
+        STRIP_CHECK(false, "transmit RMT samples failed", err, ESP_FAIL);
+    }
+    return ESP_OK;
+err:
+    return ret;
+}
+
+static esp_err_t ws2812_wait_refresh_done(led_strip_t *strip, uint32_t timeout_ms)
+{
+    ws2812_t *ws2812 = __containerof(strip, ws2812_t, parent);
+    while (ws2812->busy) {
+        if (xSemaphoreTake(ws2812->done_sem, pdMS_TO_TICKS(timeout_ms)) != pdTRUE) {
+            return ESP_ERR_TIMEOUT;
+        }
+    }
+    return ESP_OK;
+}
+
+static esp_err_t ws2812_refresh(led_strip_t *strip, uint32_t timeout_ms)
+{
+    esp_err_t ret = ESP_OK;
+    STRIP_CHECK(ws2812_wait_refresh_done(strip, timeout_ms) == ESP_OK, "previous frame timeout", err, ESP_ERR_TIMEOUT);
+    STRIP_CHECK(ws2812_refresh_async(strip, NULL, NULL) == ESP_OK, "transmit RMT samples failed", err, ESP_FAIL);
+    return ws2812_wait_refresh_done(strip, timeout_ms);
 err:
     return ret;
 }
@@ -123,49 +272,135 @@ static esp_err_t ws2812_clear(led_strip_t *strip, uint32_t timeout_ms)
 {
     ws2812_t *ws2812 = __containerof(strip, ws2812_t, parent);
     // Write zero to turn off all leds
-    memset(ws2812->buffer, 0, ws2812->strip_len * 3);
+    memset(ws2812_frame(ws2812, ws2812->back), 0, ws2812->strip_len * 3);
+    memset(ws2812_fraction(ws2812), 0, ws2812->strip_len * 3);
     return ws2812_refresh(strip, timeout_ms);
 }
 
+static esp_err_t ws2812_set_brightness(led_strip_t *strip, uint8_t brightness)
+{
+    ws2812_t *ws2812 = __containerof(strip, ws2812_t, parent);
+    if (brightness != ws2812->brightness) {
+        ws2812_build_level(ws2812, brightness);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t ws2812_set_dithering(led_strip_t *strip, bool enable)
+{
+    ws2812_t *ws2812 = __containerof(strip, ws2812_t, parent);
+    if (!enable) {
+        memset(ws2812_dither_error(ws2812), 0, ws2812->strip_len * 3);
+    }
+    ws2812->dithering = enable;
+    return ESP_OK;
+}
+
 static esp_err_t ws2812_del(led_strip_t *strip)
 {
     ws2812_t *ws2812 = __containerof(strip, ws2812_t, parent);
+    ws2812_wait_refresh_done(strip, WS2812_DEL_TIMEOUT_MS);
+    rmt_translator_set_context(ws2812->rmt_channel, NULL);
+    ws2812_strips[ws2812->rmt_channel] = NULL;
+    vSemaphoreDelete(ws2812->done_sem);
     free(ws2812);
     return ESP_OK;
 }
 
+esp_err_t led_strip_rmt_ws2812_refresh_group(led_strip_t *const *strips, size_t count, uint32_t timeout_ms)
+{
+    esp_err_t ret = ESP_OK;
+    size_t started = 0;
+    STRIP_CHECK(strips && count, "invalid arguments", err, ESP_ERR_INVALID_ARG);
+    for (size_t i = 0; i < count; i++) {
+        STRIP_CHECK(ws2812_wait_refresh_done(strips[i], timeout_ms) == ESP_OK, "previous frame timeout", err, ESP_ERR_TIMEOUT);
+    }
+#if SOC_RMT_SUPPORT_TX_SYNCHRO
+    // The channels of the group start together once all of them have been written
+    for (size_t i = 0; i < count; i++) {
+        rmt_add_channel_to_group(__containerof(strips[i], ws2812_t, parent)->rmt_channel);
+    }
+#endif
+    // Without the synchronous group the strips start back to back and still transmit in parallel
+    for (started = 0; started < count; started++) {
+        if (ws2812_refresh_async(strips[started], NULL, NULL) != ESP_OK) {
+            ret = ESP_FAIL;
+            break;
+        }
+    }
+    for (size_t i = 0; i < started; i++) {
+        if (ws2812_wait_refresh_done(strips[i], timeout_ms) != ESP_OK) {
+            ret = ESP_ERR_TIMEOUT;
+        }
+    }
+#if SOC_RMT_SUPPORT_TX_SYNCHRO
+    for (size_t i = 0; i < count; i++) {
+        rmt_remove_channel_from_group(__containerof(strips[i], ws2812_t, parent)->rmt_channel);
+    }
+#endif
+    return ret;
+err:
+    return ret;
+}
+
+esp_err_t led_strip_rmt_ws2812_get_stats(led_strip_t *strip, led_strip_ws2812_stats_t *stats)
+{
+    esp_err_t ret = ESP_OK;
+    STRIP_CHECK(strip && stats, "invalid arguments", err, ESP_ERR_INVALID_ARG);
+    ws2812_t *ws2812 = __containerof(strip, ws2812_t, parent);
+    portENTER_CRITICAL(&ws2812->lock);
+    *stats = ws2812->stats;
+    portEXIT_CRITICAL(&ws2812->lock);
+    return ESP_OK;
+err:
+    return ret;
+}
+
 led_strip_t *led_strip_new_rmt_ws2812(const led_strip_config_t *config)
 {
     led_strip_t *ret = NULL;
     STRIP_CHECK(config, "configuration can't be null", err, NULL);
+    STRIP_CHECK((rmt_channel_t)config->dev < RMT_CHANNEL_MAX, "invalid rmt channel", err, NULL);
+    STRIP_CHECK(ws2812_strips[(rmt_channel_t)config->dev] == NULL, "rmt channel already has a strip", err, NULL);
 
-    // 24 bits per led
-    uint32_t ws2812_size = sizeof(ws2812_t) + config->max_leds * 3;
+    // 24 bits per led, two frames, fractions and dither errors
+    uint32_t ws2812_size = sizeof(ws2812_t) + config->max_leds * 3 * 4;
     ws2812_t *ws2812 = calloc(1, ws2812_size);
     STRIP_CHECK(ws2812, "request memory for ws2812 failed", err, NULL);
 
+    ws2812->done_sem = xSemaphoreCreateBinary();
+    STRIP_CHECK(ws2812->done_sem, "create semaphore failed", err_sem, NULL);
+
     uint32_t counter_clk_hz = 0;
     STRIP_CHECK(rmt_get_counter_clock((rmt_channel_t)config->dev, &counter_clk_hz) == ESP_OK,
-                "get rmt counter clock failed", err, NULL);
-    // ns -> ticks
-    float ratio = (float)counter_clk_hz / 1e9;
-    ws2812_t0h_ticks = (uint32_t)(ratio * WS2812_T0H_NS);
-    ws2812_t0l_ticks = (uint32_t)(ratio * WS2812_T0L_NS);
-    ws2812_t1h_ticks = (uint32_t)(ratio * WS2812_T1H_NS);
-    ws2812_t1l_ticks = (uint32_t)(ratio * WS2812_T1L_NS);
-
-    // set ws2812 to rmt adapter
-    rmt_translator_init((rmt_channel_t)config->dev, ws2812_rmt_adapter);
+                "get rmt counter clock failed", err_clk, NULL);
+    ws2812_build_lut(ws2812, counter_clk_hz);
+    ws2812_build_level(ws2812, 255);
 
     ws2812->rmt_channel = (rmt_channel_t)config->dev;
     ws2812->strip_len = config->max_leds;
+    portMUX_INITIALIZE(&ws2812->lock);
+    ws2812_strips[ws2812->rmt_channel] = ws2812;
+
+    // set ws2812 to rmt adapter
+    rmt_translator_init((rmt_channel_t)config->dev, ws2812_rmt_adapter);
+    rmt_translator_set_context((rmt_channel_t)config->dev, ws2812);
+    rmt_register_tx_end_callback(ws2812_tx_end, NULL);
 
     ws2812->parent.set_pixel = ws2812_set_pixel;
     ws2812->parent.refresh = ws2812_refresh;
+    ws2812->parent.refresh_async = ws2812_refresh_async;
+    ws2812->parent.wait_refresh_done = ws2812_wait_refresh_done;
     ws2812->parent.clear = ws2812_clear;
+    ws2812->parent.set_brightness = ws2812_set_brightness;
+    ws2812->parent.set_dithering = ws2812_set_dithering;
     ws2812->parent.del = ws2812_del;
 
     return &ws2812->parent;
+err_clk:
+    vSemaphoreDelete(ws2812->done_sem);
+err_sem:
+    free(ws2812);
 err:
     return ret;
 }
@@ -0,0 +1,72 @@
+/**
+ *****************************************************************************
+ * @file    : user_codec.h
+ * @brief   : MQTT payload encoder and decoder
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *****************************************************************************
+ */
+
+#ifndef USER_CODEC_H
+#define USER_CODEC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Binary payload format version, the first byte of every binary payload. */
+#define USER_CODEC_VERSION          (1U)
+
+/** @brief Binary payload frame types, the second byte of a binary telemetry payload. */
+#define USER_CODEC_FRAME_TELEMETRY  (1U)
+#define USER_CODEC_FRAME_HISTORY    (2U)
+
+/** @brief Fixed-point values are encoded in 1/USER_CODEC_VALUE_SCALE units, two decimals in text. */
+#define USER_CODEC_VALUE_SCALE      (100)
+
+/**
+ * @brief MQTT payload format.
+ * 
+ * @note Only switch, level, color and value payloads have a binary form. The
+ *       configuration topics, light recipes, irrigation zones and the format
+ *       command itself, are text in both formats.
+ */
+typedef enum
+{
+    USER_CODEC_FORMAT_TEXT,   /* ASCII payloads, "on", "128", "255,255,255", JSON telemetry. */
+    USER_CODEC_FORMAT_BINARY  /* Versioned packed little-endian payloads. */
+} user_codec_format_t;
+
+/** @brief Timestamped telemetry record, as stored while the broker is unreachable. */
+typedef struct
+{
+    uint32_t timestamp; /* Seconds, from time(). */
+    uint8_t channel;    /* Telemetry channel, user_telemetry_channel_t. */
+    int32_t value;      /* Fixed-point value in 1/USER_CODEC_VALUE_SCALE units. */
+} user_codec_record_t;
+
+esp_err_t user_codec_decode_switch(user_codec_format_t format, const char *data, int data_len, bool *on);
+esp_err_t user_codec_decode_level(user_codec_format_t format, const char *data, int data_len, uint32_t max,
+                                  uint32_t *level);
+esp_err_t user_codec_decode_rgb(user_codec_format_t format, const char *data, int data_len, uint8_t rgb[3]);
+
+int user_codec_encode_switch(user_codec_format_t format, char *buf, size_t size, bool on);
+int user_codec_encode_value(user_codec_format_t format, char *buf, size_t size, int32_t value);
+int user_codec_encode_batch(user_codec_format_t format, char *buf, size_t size, const char *const names[],
+                            const int32_t values[], uint32_t mask);
+int user_codec_encode_history(user_codec_format_t format, char *buf, size_t size, const char *const names[],
+                              const user_codec_record_t records[], int count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USER_CODEC_H */
+/******************************** End of File *********************************/
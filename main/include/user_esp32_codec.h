@@ -0,0 +1,44 @@
+/**
+ *****************************************************************************
+ * @file    : user_esp32_codec.h
+ * @brief   : ESP32 MQTT payload codec Application
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *****************************************************************************
+ */
+
+#ifndef USER_ESP32_CODEC_H
+#define USER_ESP32_CODEC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#include "user_codec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+esp_err_t user_esp32_codec_init(void);
+esp_err_t user_esp32_codec_set_format(user_codec_format_t format);
+user_codec_format_t user_esp32_codec_get_format(void);
+
+esp_err_t user_esp32_codec_decode_switch(const char *data, int data_len, bool *on);
+esp_err_t user_esp32_codec_decode_level(const char *data, int data_len, uint32_t max, uint32_t *level);
+esp_err_t user_esp32_codec_decode_rgb(const char *data, int data_len, uint8_t rgb[3]);
+
+int user_esp32_codec_encode_switch(char *buf, size_t size, bool on);
+int user_esp32_codec_encode_value(char *buf, size_t size, int32_t value);
+int user_esp32_codec_encode_batch(char *buf, size_t size, const char *const names[], const int32_t values[], uint32_t mask);
+int user_esp32_codec_encode_history(char *buf, size_t size, const char *const names[], const user_codec_record_t records[], int count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USER_ESP32_CODEC_H */
+/******************************** End of File *********************************/
@@ -0,0 +1,44 @@
+/**
+ *****************************************************************************
+ * @file    : user_esp32_environment.h
+ * @brief   : ESP32 environment sensors Application
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *****************************************************************************
+ */
+
+#ifndef USER_ESP32_ENVIRONMENT_H
+#define USER_ESP32_ENVIRONMENT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Environment sensors on the I2C bus. */
+typedef enum
+{
+    USER_ENVIRONMENT_SHT3X,  /* Temperature and humidity, PUB_ENVM_TEMP1 and PUB_ENVM_HUMI1. */
+    USER_ENVIRONMENT_BMP280, /* Pressure, PUB_ENVM_TMOS1. */
+    USER_ENVIRONMENT_SENSOR_MAX
+} user_environment_sensor_t;
+
+/** @brief Environment sensor statistics. */
+typedef struct
+{
+    uint32_t reads;         /* Measurements converted. */
+    uint32_t errors;        /* Bus, CRC or not-ready errors. */
+    uint32_t busy;          /* Samples skipped because the previous read was still queued. */
+    uint32_t last_cycles;   /* CPU cycles of the last conversion. */
+    uint32_t max_cycles;    /* Largest CPU cycles of a conversion. */
+} user_environment_stats_t;
+
+esp_err_t user_esp32_environment_init(void);
+esp_err_t user_esp32_environment_get_stats(user_environment_sensor_t sensor, user_environment_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USER_ESP32_ENVIRONMENT_H */
+/******************************** End of File *********************************/
@@ -0,0 +1,41 @@
+/**
+ *****************************************************************************
+ * @file    : user_esp32_fan.h
+ * @brief   : ESP32 closed-loop fan speed Application
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *****************************************************************************
+ */
+
+#ifndef USER_ESP32_FAN_H
+#define USER_ESP32_FAN_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Fan1 speed at full duty, 100% of a fanSpeedCommand. */
+#define USER_FAN_RATED_RPM      (3000U)
+
+/** @brief Fan speed controller statistics. */
+typedef struct
+{
+    uint32_t target_rpm;    /* Requested speed, 0 means stopped. */
+    uint32_t rpm;           /* Last measured speed. */
+    uint32_t duty;          /* Last controller output, 0 ~ USER_PWM_DUTY_MAX. */
+    uint32_t updates;       /* Controller updates. */
+    uint32_t last_cycles;   /* CPU cycles of the last update, tachometer read included. */
+    uint32_t max_cycles;    /* Largest CPU cycles of an update. */
+} user_fan_stats_t;
+
+esp_err_t user_esp32_fan_init(void);
+esp_err_t user_esp32_fan_set_target_rpm(uint32_t rpm);
+esp_err_t user_esp32_fan_get_stats(user_fan_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USER_ESP32_FAN_H */
+/******************************** End of File *********************************/
@@ -15,11 +15,44 @@
 extern "C" {
 #endif
 
+/**
+  * @brief Number of chained sn74hc595 devices driving the relays and valves.
+  */
+#define USER_HARDWARE_SN74HC595_CHAIN_LENGTH (1U)
 
+/**
+  * @brief Output shadow flush period, one latch per sampler tick at most.
+  */
+#define USER_HARDWARE_OUTPUT_FLUSH_PERIOD_MS (10U)
 
+/**
+  * @brief Relay and valve outputs, the value is the sn74hc595 output bit.
+  */
+typedef enum
+{
+    USER_HARDWARE_OUTPUT_VALVE1 = 0, /* Chain byte 0, Q0. */
+    USER_HARDWARE_OUTPUT_VALVE2,
+    USER_HARDWARE_OUTPUT_VALVE3,
+    USER_HARDWARE_OUTPUT_PUMP1,
+    USER_HARDWARE_OUTPUT_FAN1,
+    USER_HARDWARE_OUTPUT_MAX,
+} user_hardware_output_t;
 
+/**
+  * @brief Output state manager statistics, requests == writes + coalesced once flushed.
+  */
+typedef struct
+{
+    uint32_t requests;  /* Output requests applied to the shadow bitmap. */
+    uint32_t writes;    /* Images latched into the sn74hc595 chain. */
+    uint32_t coalesced; /* Requests merged into another write or skipped as redundant. */
+    uint32_t errors;    /* Failed flushes, retried at the next tick. */
+} user_hardware_output_stats_t;
 
 esp_err_t user_esp32_hardware_init(void);
+esp_err_t user_esp32_hardware_set_output(user_hardware_output_t output, bool on);
+esp_err_t user_esp32_hardware_get_output(user_hardware_output_t output, bool *on);
+esp_err_t user_esp32_hardware_get_output_stats(user_hardware_output_stats_t *stats);
 
 #ifdef __cplusplus
 }
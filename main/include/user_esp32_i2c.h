@@ -11,11 +11,18 @@
 #ifndef USER_ESP32_I2C_H
 #define USER_ESP32_I2C_H
 
+#include "user_i2c_bus.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 esp_err_t user_esp32_i2c_init(void);
+esp_err_t user_esp32_i2c_submit(user_i2c_transaction_t *trans);
+esp_err_t user_esp32_i2c_transfer(uint8_t address, const uint8_t *write_buf, size_t write_len,
+                                  uint8_t *read_buf, size_t read_len, uint32_t timeout_ms);
+esp_err_t user_esp32_i2c_get_stats(user_i2c_bus_stats_t *stats);
+esp_err_t user_esp32_i2c_get_device_stats(uint8_t address, user_i2c_device_stats_t *stats);
 
 #ifdef __cplusplus
 }
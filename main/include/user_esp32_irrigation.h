@@ -0,0 +1,44 @@
+/**
+ *****************************************************************************
+ * @file    : user_esp32_irrigation.h
+ * @brief   : ESP32 local irrigation control Application
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *****************************************************************************
+ */
+
+#ifndef USER_ESP32_IRRIGATION_H
+#define USER_ESP32_IRRIGATION_H
+
+#include "user_irrigation.h"
+#include "user_esp32_hardware.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Irrigation control statistics. */
+typedef struct
+{
+    uint32_t evaluations;       /* Controller evaluations. */
+    uint32_t changes;           /* Evaluations that switched a valve or the pump. */
+    uint32_t last_latency_us;   /* Moisture sample to output request, of the last switching sample. */
+    uint32_t max_latency_us;    /* Largest moisture sample to output request time. */
+    uint32_t last_cycles;       /* CPU cycles of the last evaluation. */
+    uint32_t max_cycles;        /* Largest CPU cycles of an evaluation. */
+} user_irrigation_stats_t;
+
+esp_err_t user_esp32_irrigation_init(void);
+esp_err_t user_esp32_irrigation_update_moisture(uint32_t zone, int32_t moisture);
+esp_err_t user_esp32_irrigation_set_zone(uint32_t zone, const irrigation_zone_config_t *config);
+esp_err_t user_esp32_irrigation_set_manual(user_hardware_output_t output, bool on);
+esp_err_t user_esp32_irrigation_set_active(bool active);
+esp_err_t user_esp32_irrigation_get_stats(user_irrigation_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USER_ESP32_IRRIGATION_H */
+/******************************** End of File *********************************/
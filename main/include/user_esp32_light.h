@@ -0,0 +1,43 @@
+/**
+ *****************************************************************************
+ * @file    : user_esp32_light.h
+ * @brief   : ESP32 grow light recipe Application
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *****************************************************************************
+ */
+
+#ifndef USER_ESP32_LIGHT_H
+#define USER_ESP32_LIGHT_H
+
+#include "user_light_recipe.h"
+#include "user_esp32_rmt.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Light recipe statistics. */
+typedef struct
+{
+    uint32_t frames;        /* Recipe frames. */
+    uint32_t updates;       /* Frames that changed a strip. */
+    uint32_t refreshes;     /* Frames that refreshed the strips, every frame while dithering. */
+    uint32_t last_cycles;   /* CPU cycles of the last frame, refresh excluded. */
+    uint32_t max_cycles;    /* Largest CPU cycles of a frame, refresh excluded. */
+} user_light_stats_t;
+
+esp_err_t user_esp32_light_init(void);
+esp_err_t user_esp32_light_set_recipe(user_rmt_strip_t strip, const light_recipe_keyframe_t *keyframes, int count);
+esp_err_t user_esp32_light_set_active(user_rmt_strip_t strip, bool active);
+esp_err_t user_esp32_light_set_frame_rate(uint32_t fps);
+esp_err_t user_esp32_light_set_dithering(bool enable);
+esp_err_t user_esp32_light_get_stats(user_light_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USER_ESP32_LIGHT_H */
+/******************************** End of File *********************************/
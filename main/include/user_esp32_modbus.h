@@ -11,13 +11,15 @@
 #ifndef USER_ESP32_MODBUS_H
 #define USER_ESP32_MODBUS_H
 
+#include "user_modbus_master.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-
-
 esp_err_t user_esp32_modbus_init(void);
+esp_err_t user_esp32_modbus_get_cycle_stats(user_modbus_cycle_stats_t *stats);
+esp_err_t user_esp32_modbus_get_slave_stats(uint8_t address, user_modbus_slave_stats_t *stats);
 
 #ifdef __cplusplus
 }
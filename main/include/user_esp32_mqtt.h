@@ -11,12 +11,62 @@
 #ifndef USER_ESP32_MQTT_H
 #define USER_ESP32_MQTT_H
 
+#include "user_mqtt_pool.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/** @brief MQTT publish the topic groups. */
+#define PUB_SWITCH_VALVE_STATE1 "firstSwitchState"  /* Switch valve1 -> Switch status topic. */
+#define PUB_SWITCH_VALVE_STATE2 "secondSwitchState" /* Switch valve2 -> Switch status topic. */
+#define PUB_SWITCH_VALVE_STATE3 "thirdSwitchState"  /* Switch valve3 -> Switch status topic. */
+#define PUB_PUMP_STATE1 "pumpState"                 /* Water pump1 -> Switch status topic. */
+#define PUB_RGB_STATE1 "firstLightState"            /* WS2812 RGB1 -> Switch status topic. */
+#define PUB_RGB_STATE2 "secondLightState"           /* WS2812 RGB2 -> Switch status topic. */
+#define PUB_RGB_LIGHT1 "firstBrightnessState"       /* WS2812 RGB1 -> Brightness status topic. */
+#define PUB_RGB_LIGHT2 "secondBrightnessState"      /* WS2812 RGB2 -> Brightness status topic. */
+#define PUB_RGB_COLOR1 "firstRgbState"              /* WS2812 RGB1 -> Color status topic. */
+#define PUB_RGB_COLOR2 "secondRgbState"             /* WS2812 RGB2 -> Color status topic. */
+#define PUB_FAN_STATE1 "fanState"                   /* Fan1 -> Switch status topic. */
+#define PUB_FAN_SPEED1 "fanSpeedState"              /* Fan1 -> Speed status topic. */
+#define PUB_SOIL_HUMI1 "firstSoilMoisture"          /* Soil moisture sensor1 -> Humidity information topic. */
+#define PUB_SOIL_HUMI2 "secondSoilMoisture"         /* Soil moisture sensor2 -> Humidity information topic. */
+#define PUB_SOIL_HUMI3 "thirdSoilMoisture"          /* Soil moisture sensor3 -> Humidity information topic. */
+#define PUB_ENVM_HUMI1 "environmentMoisture"        /* Environmental temperature and humidity sensor1 -> Humidity information topic. */
+#define PUB_ENVM_TEMP1 "environmentTemp"            /* Environmental temperature and humidity sensor1 -> Temperature information topic. */
+#define PUB_ENVM_TMOS1 "atmos"                      /* Atmospheric pressure sensor -> Atmospheric pressure information topic. */
+#define PUB_TDS_VALUE1 "tds"                        /* Water quality sensor -> Water quality information topic. */
+#define PUB_MQTT_INGRESS_STATE "mqttIngressState"   /* MQTT message pool and queue overflow counters topic. */
+#define PUB_TELEMETRY_BATCH "telemetry"             /* Batched sensor values -> All sensor information topic. */
+#define PUB_TELEMETRY_HISTORY "telemetryHistory"    /* Stored sensor values -> Timestamped records recorded while offline. */
+
+/** @brief MQTT subscribe the topic groups. */
+#define SUB_SWITCH_VALVE_STATE1 "firstSwitchCommand"  /* Switch valve1 -> Switch command topic. */
+#define SUB_SWITCH_VALVE_STATE2 "secondSwitchCommand" /* Switch valve2 -> Switch command topic. */
+#define SUB_SWITCH_VALVE_STATE3 "thirdSwitchCommand"  /* Switch valve3 -> Switch command topic. */
+#define SUB_PUMP_STATE1 "pumpCommand"                 /* Water pump1 -> Switch command topic. */
+#define SUB_RGB_STATE1 "firstLightCommand"            /* WS2812 RGB1 -> Switch command topic. */
+#define SUB_RGB_STATE2 "secondLightCommand"           /* WS2812 RGB2 -> Switch command topic. */
+#define SUB_RGB_LIGHT1 "firstBrightnessCommand"       /* WS2812 RGB1 -> Brightness command topic. */
+#define SUB_RGB_LIGHT2 "secondBrightnessCommand"      /* WS2812 RGB2 -> Brightness command topic. */
+#define SUB_RGB_COLOR1 "firstRgbCommand"              /* WS2812 RGB1 -> Color command topic. */
+#define SUB_RGB_COLOR2 "secondRgbCommand"             /* WS2812 RGB2 -> Color command topic. */
+#define SUB_RGB_RECIPE1 "firstLightRecipeCommand"     /* WS2812 RGB1 -> Light recipe command topic. */
+#define SUB_RGB_RECIPE2 "secondLightRecipeCommand"    /* WS2812 RGB2 -> Light recipe command topic. */
+#define SUB_IRRIGATION_STATE "irrigationCommand"      /* Irrigation -> Local control switch command topic. */
+#define SUB_IRRIGATION_ZONE "irrigationZoneCommand"   /* Irrigation -> Zone parameters command topic. */
+#define SUB_FAN_STATE1 "fanCommand"                   /* Fan1 -> Switch command topic. */
+#define SUB_FAN_SPEED1 "fanSpeedCommand"              /* Fan1 -> Speed command topic. */
+#define SUB_OTA_SERVICE "OTAServiceCommand"           /* Device -> OTA service command topic. */
+#define SUB_CODEC_FORMAT "codecFormatCommand"         /* Device -> Payload format command topic, always text. */
+
 esp_err_t user_esp32_create_mqtt_client(void);
 esp_err_t user_esp32_delete_mqtt_client(void);
+esp_err_t user_esp32_mqtt_get_pool_stats(user_mqtt_pool_stats_t *stats);
+esp_err_t user_esp32_mqtt_set_overflow_policy(user_mqtt_overflow_policy_t policy);
+int user_esp32_mqtt_publish(const char *topic, const char *data, int len);
+bool user_esp32_mqtt_is_connected(void);
 
 #ifdef __cplusplus
 }
@@ -15,9 +15,40 @@
 extern "C" {
 #endif
 
+/** @brief Full scale of a PWM duty request, in 1/1000. */
+#define USER_PWM_DUTY_MAX       (1000U)
 
+/**
+ * @brief PWM channels.
+ */
+typedef enum
+{
+    USER_PWM_FAN1 = 0, /* Fan1 speed, 25kHz. */
+    USER_PWM_CHANNEL_MAX,
+} user_pwm_channel_t;
+
+/**
+ * @brief PWM ramp done callback, runs in the timer service task and must not block.
+ */
+typedef void (*user_pwm_done_cb_t)(user_pwm_channel_t channel, uint32_t duty, void *arg);
+
+/**
+ * @brief PWM channel statistics, cycles are the CPU cost of one user_esp32_pwm_set_duty call.
+ */
+typedef struct
+{
+    uint32_t changes;     /* Duty requests. */
+    uint32_t coalesced;   /* Waiting requests replaced by a newer one. */
+    uint32_t fades;       /* Completed hardware ramps. */
+    uint32_t errors;
+    uint32_t last_cycles;
+    uint32_t max_cycles;
+} user_pwm_stats_t;
 
 esp_err_t user_esp32_pwm_init(void);
+esp_err_t user_esp32_pwm_set_duty(user_pwm_channel_t channel, uint32_t duty, uint32_t ramp_ms,
+                                  user_pwm_done_cb_t callback, void *arg);
+esp_err_t user_esp32_pwm_get_stats(user_pwm_channel_t channel, user_pwm_stats_t *stats);
 
 #ifdef __cplusplus
 }
@@ -11,13 +11,48 @@
 #ifndef USER_ESP32_RMT_H
 #define USER_ESP32_RMT_H
 
+#include "led_strip.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ * @brief Grow light strips, one per SUB_RGB_* topic group.
+ */
+typedef enum
+{
+    USER_RMT_STRIP1 = 0,
+    USER_RMT_STRIP2,
+    USER_RMT_STRIP_MAX,
+} user_rmt_strip_t;
 
+/**
+ * @brief Group refresh statistics, the refresh time covers all strips.
+ *        The render cycles cover the level lookup and set_pixel of every LED
+ *        of one strip, render_leds long, cycles per LED are their quotient.
+ */
+typedef struct
+{
+    uint32_t refreshes;
+    uint32_t errors;
+    uint32_t last_refresh_us;
+    uint32_t max_refresh_us;
+    uint32_t renders;
+    uint32_t render_leds;
+    uint32_t last_render_cycles;
+    uint32_t max_render_cycles;
+} user_rmt_stats_t;
 
 esp_err_t user_esp32_rmt_init(void);
+led_strip_t *user_esp32_rmt_get_strip(user_rmt_strip_t strip);
+esp_err_t user_esp32_rmt_refresh(void);
+esp_err_t user_esp32_rmt_set_light(user_rmt_strip_t strip, uint8_t brightness, const uint8_t rgb[3]);
+esp_err_t user_esp32_rmt_set_state(user_rmt_strip_t strip, bool on);
+esp_err_t user_esp32_rmt_set_brightness(user_rmt_strip_t strip, uint8_t brightness);
+esp_err_t user_esp32_rmt_set_color(user_rmt_strip_t strip, const uint8_t rgb[3]);
+esp_err_t user_esp32_rmt_set_dithering(bool enable);
+esp_err_t user_esp32_rmt_get_stats(user_rmt_stats_t *stats);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,36 @@
+/**
+ *****************************************************************************
+ * @file    : user_esp32_sampler.h
+ * @brief   : ESP32 sensor sampling scheduler Application
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *****************************************************************************
+ */
+
+#ifndef USER_ESP32_SAMPLER_H
+#define USER_ESP32_SAMPLER_H
+
+#include "user_sampler_wheel.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Sampling channel callback, runs in the sampler task and must not block. */
+typedef sampler_wheel_callback_t user_sampler_callback_t;
+
+/** @brief Sampling channel statistics. */
+typedef sampler_wheel_stats_t user_sampler_stats_t;
+
+esp_err_t user_esp32_sampler_init(void);
+esp_err_t user_esp32_sampler_register(uint32_t period_ms, uint32_t phase_ms,
+                                      user_sampler_callback_t callback, void *arg, int *channel);
+esp_err_t user_esp32_sampler_get_stats(int channel, user_sampler_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USER_ESP32_SAMPLER_H */
+/******************************** End of File *********************************/
@@ -0,0 +1,41 @@
+/**
+ *****************************************************************************
+ * @file    : user_esp32_store.h
+ * @brief   : ESP32 telemetry store-and-forward Application
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *****************************************************************************
+ */
+
+#ifndef USER_ESP32_STORE_H
+#define USER_ESP32_STORE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Telemetry store statistics. */
+typedef struct
+{
+    uint32_t capacity;      /* Records the ring can hold. */
+    uint32_t pending;       /* Records waiting to be forwarded. */
+    uint32_t appended;      /* Records appended since boot. */
+    uint32_t forwarded;     /* Records published since boot. */
+    uint32_t overwritten;   /* Unforwarded records lost because the ring wrapped. */
+    uint32_t discarded;     /* Records released unpublished because they could not be encoded. */
+    uint32_t erases;        /* Sectors erased since boot. */
+    uint32_t mark_failures; /* Consumed marks that failed to write, those records are forwarded again after a reboot. */
+} user_store_stats_t;
+
+esp_err_t user_esp32_store_init(void);
+esp_err_t user_esp32_store_append(uint8_t channel, uint32_t timestamp, int32_t value);
+void user_esp32_store_resume(void);
+esp_err_t user_esp32_store_get_stats(user_store_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USER_ESP32_STORE_H */
+/******************************** End of File *********************************/
@@ -0,0 +1,67 @@
+/**
+ *****************************************************************************
+ * @file    : user_esp32_telemetry.h
+ * @brief   : ESP32 sensor telemetry publisher Application
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *****************************************************************************
+ */
+
+#ifndef USER_ESP32_TELEMETRY_H
+#define USER_ESP32_TELEMETRY_H
+
+#include "user_telemetry_filter.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Telemetry values are fixed-point, in 1/USER_TELEMETRY_SCALE of the channel unit. */
+#define USER_TELEMETRY_SCALE    (100)
+
+/** @brief Telemetry sensor channels, one per PUB_* sensor topic. */
+typedef enum
+{
+    USER_TELEMETRY_SOIL_HUMI1, /* Soil moisture sensor1, %. */
+    USER_TELEMETRY_SOIL_HUMI2, /* Soil moisture sensor2, %. */
+    USER_TELEMETRY_SOIL_HUMI3, /* Soil moisture sensor3, %. */
+    USER_TELEMETRY_ENVM_HUMI1, /* Environment humidity, %RH. */
+    USER_TELEMETRY_ENVM_TEMP1, /* Environment temperature, degree Celsius. */
+    USER_TELEMETRY_ENVM_TMOS1, /* Atmospheric pressure, hPa. */
+    USER_TELEMETRY_TDS_VALUE1, /* Water quality, ppm. */
+    USER_TELEMETRY_CHANNEL_MAX
+} user_telemetry_channel_t;
+
+/** @brief Telemetry publish mode. */
+typedef enum
+{
+    USER_TELEMETRY_MODE_BATCH,     /* One PUB_TELEMETRY_BATCH message per interval with every channel. */
+    USER_TELEMETRY_MODE_PER_TOPIC  /* One message per channel on its own PUB_* topic, compatibility mode. */
+} user_telemetry_mode_t;
+
+/** @brief Telemetry publisher statistics. */
+typedef struct
+{
+    uint32_t samples;              /* Samples accepted. */
+    uint32_t publish_calls;        /* MQTT publish calls issued. */
+    uint32_t payload_bytes;        /* Payload bytes handed to the MQTT client. */
+    uint32_t reported;             /* Window values that passed the report-by-exception filter and were handed over. */
+    uint32_t suppressed;           /* Window values suppressed by the report-by-exception filter. */
+    uint32_t suppression_permille; /* suppressed / (reported + suppressed), in 1/1000. */
+} user_telemetry_stats_t;
+
+esp_err_t user_esp32_telemetry_init(void);
+esp_err_t user_esp32_telemetry_update(user_telemetry_channel_t channel, int32_t value);
+esp_err_t user_esp32_telemetry_set_mode(user_telemetry_mode_t mode);
+esp_err_t user_esp32_telemetry_set_interval(uint32_t interval_ms);
+esp_err_t user_esp32_telemetry_set_filter(user_telemetry_channel_t channel, const user_telemetry_filter_t *filter);
+const char *const *user_esp32_telemetry_get_topics(void);
+esp_err_t user_esp32_telemetry_get_stats(user_telemetry_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USER_ESP32_TELEMETRY_H */
+/******************************** End of File *********************************/
@@ -11,24 +11,93 @@
 #ifndef USER_ESP32_UART_H
 #define USER_ESP32_UART_H
 
+#include "driver/uart.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-// typedef struct
-// {
-//     uart_port_t port;             /* UART port number, the max port number is (UART_NUM_MAX -1). */
-//     QueueHandle_t queue;          /* UART queue handle,  */
-//     SemaphoreHandle_t semaphore;  /* UART queue handle, */
-//     void (*transmit_start)(void); /* UART Callback function before sending data. */
-//     void (*transmit_stop)(void);  /* UART Callback function after data is sent. */
-// } user_uart_param_t;
+/** @brief Number of UART ports managed at the same time, UART0 stays the console. */
+#define USER_UART_PORT_MAX          (2)
+
+/** @brief Received frame buffers of a port, a Modbus ASCII frame is the largest one. */
+#define USER_UART_FRAME_MAX_LENGTH  (520U)
+#define USER_UART_FRAME_POOL_SIZE   (4U)
+
+/** @brief Byte ring of a stream port, a power of two. */
+#define USER_UART_STREAM_RING_SIZE  (1024U)
+
+/** @brief Receive mode of a port. */
+typedef enum
+{
+    USER_UART_RX_FRAME,  /* Frames split on idle time or pattern, for request/response protocols. */
+    USER_UART_RX_STREAM  /* Byte stream through a lock-free ring, for sensors that parse their own records. */
+} user_uart_rx_mode_t;
+
+typedef struct
+{
+    uart_port_t port;            /* UART port number, the max port number is (UART_NUM_MAX -1). */
+    gpio_num_t tx_io_num;        /* UART TX pin GPIO number. */
+    gpio_num_t rx_io_num;        /* UART RX pin GPIO number. */
+    gpio_num_t rts_io_num;       /* UART RTS pin GPIO number, drives DE/RE in RS-485 mode. */
+    gpio_num_t cts_io_num;       /* UART CTS pin GPIO number. */
+    uart_config_t config;        /* UART configuration parameters for uart_param_config function. */
+    int rx_buffer_size;          /* UART RX ring buffer size, more than the FIFO and two frames. */
+    int tx_buffer_size;          /* UART TX ring buffer size, 0 makes the transmit block until the FIFO takes the frame. */
+    uart_mode_t mode;            /* UART_MODE_RS485_HALF_DUPLEX switches the transceiver direction in hardware. */
+    uint8_t rx_timeout_symbols;  /* Idle time in character times that ends a frame, 0 keeps the driver default. */
+    char pattern_chr;            /* Character that ends a frame, 0 ends frames by idle time only. */
+    user_uart_rx_mode_t rx_mode; /* Receive mode. */
+} user_uart_param_t;
+
+/** @brief Port statistics. */
+typedef struct
+{
+    uint32_t rx_bytes;         /* Bytes received. */
+    uint32_t tx_bytes;         /* Bytes sent. */
+    uint32_t frames;           /* Frames handed over, frame mode. */
+    uint32_t overruns;         /* Hardware FIFO or driver ring overflows. */
+    uint32_t framing_errors;   /* Characters with a framing error. */
+    uint32_t parity_errors;    /* Characters with a parity error. */
+    uint32_t dropped;          /* Bytes lost because the consumer fell behind. */
+    uint32_t rx_bytes_per_sec; /* Receive rate over the last second. */
+    uint32_t tx_bytes_per_sec; /* Transmit rate over the last second. */
+} user_uart_stats_t;
+
+/** @brief Received frame, owned by the consumer until released. */
+typedef struct
+{
+    size_t length;                            /* Number of bytes received. */
+    bool error;                               /* When set, means a framing, parity or length error hit the frame. */
+    uint8_t data[USER_UART_FRAME_MAX_LENGTH]; /* Frame bytes. */
+} user_uart_frame_t;
+
+/** @brief Loopback benchmark result. */
+typedef struct
+{
+    uint32_t frames;          /* Frames echoed back intact. */
+    uint32_t bad;             /* Frames echoed back with an error or other bytes. */
+    uint32_t lost;            /* Frames not echoed back in time. */
+    uint32_t bytes_per_sec;   /* Payload bytes echoed back per second over the run. */
+    uint32_t turnaround_min;  /* Shortest time from the last stop bit sent to the frame handed over, microseconds. */
+    uint32_t turnaround_avg;  /* Average of the same, microseconds. */
+    uint32_t turnaround_max;  /* Longest of the same, microseconds. */
+} user_uart_benchmark_t;
 
-// esp_err_t user_esp32_uart_init(user_uart_param_t param);
+esp_err_t user_esp32_uart_init(void);
+esp_err_t user_esp32_uart_register(const user_uart_param_t *param);
+esp_err_t user_esp32_uart_transmit(uart_port_t port, const uint8_t *buf, size_t len, uint32_t timeout_ms);
+esp_err_t user_esp32_uart_receive_frame(uart_port_t port, user_uart_frame_t **frame, uint32_t timeout_ms);
+esp_err_t user_esp32_uart_release_frame(uart_port_t port, user_uart_frame_t *frame);
+esp_err_t user_esp32_uart_flush(uart_port_t port);
+int user_esp32_uart_read(uart_port_t port, uint8_t *buf, size_t len, uint32_t timeout_ms);
+esp_err_t user_esp32_uart_get_stats(uart_port_t port, user_uart_stats_t *stats);
+esp_err_t user_esp32_uart_loopback_benchmark(uart_port_t port, size_t len, uint32_t count, user_uart_benchmark_t *result);
+esp_err_t user_esp32_uart_deinit(void);
 
 #ifdef __cplusplus
 }
 #endif
 
 #endif /* USER_ESP32_UART_H */
-/******************************** End of File *********************************/
\ No newline at end of file
+/******************************** End of File *********************************/
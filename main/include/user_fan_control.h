@@ -0,0 +1,45 @@
+/**
+ *****************************************************************************
+ * @file    : user_fan_control.h
+ * @brief   : Fixed-point fan speed controller
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *****************************************************************************
+ */
+
+#ifndef USER_FAN_CONTROL_H
+#define USER_FAN_CONTROL_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Controller gains are Q16.16 fixed-point. */
+#define FAN_CONTROL_Q               (16U)
+#define FAN_CONTROL_GAIN(x)         ((int32_t)((x) * (1 << FAN_CONTROL_Q)))
+
+/** @brief PI controller, output in duty units, error in RPM. */
+typedef struct
+{
+    int32_t kp;          /* Proportional gain, duty per RPM, Q16.16. */
+    int32_t ki;          /* Integral gain per update, duty per RPM, Q16.16. */
+    int32_t output_min;  /* Output clamp, also the integral clamp (anti-windup). */
+    int32_t output_max;
+    int64_t integral;    /* Integral term, duty in Q16.16. */
+    int32_t output;      /* Last output. */
+} fan_control_pi_t;
+
+void fan_control_pi_init(fan_control_pi_t *pi, int32_t kp, int32_t ki, int32_t output_min, int32_t output_max);
+void fan_control_pi_reset(fan_control_pi_t *pi, int32_t output);
+int32_t fan_control_pi_update(fan_control_pi_t *pi, int32_t setpoint, int32_t measured);
+uint32_t fan_control_tach_rpm(uint32_t pulses, uint32_t interval_ms, uint32_t pulses_per_rev);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USER_FAN_CONTROL_H */
+/******************************** End of File *********************************/
@@ -0,0 +1,118 @@
+/**
+ *****************************************************************************
+ * @file    : user_i2c_bus.h
+ * @brief   : I2C transaction scheduler of the sensor bus
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *****************************************************************************
+ */
+
+#ifndef USER_I2C_BUS_H
+#define USER_I2C_BUS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Maximum number of transactions sent in one bus transfer. */
+#define USER_I2C_BATCH_MAX          (4)
+
+/** @brief Number of devices with latency statistics. */
+#define USER_I2C_DEVICE_MAX         (8)
+
+/** @brief Latency histogram, bucket n counts latencies in [2^n, 2^(n+1)) us, the last one is open. */
+#define USER_I2C_HISTOGRAM_BUCKETS  (16)
+
+typedef struct user_i2c_transaction user_i2c_transaction_t;
+
+/** @brief Transaction completion callback, runs in the bus owner context and must not block. */
+typedef void (*user_i2c_done_cb_t)(user_i2c_transaction_t *trans, void *arg);
+
+/**
+ * @brief I2C transaction descriptor, owned by the caller until completion.
+ *        write_len only is a write, read_len only is a read, both is a write then a repeated start read.
+ *        Only idempotent transactions, such as a register read, share a bus transfer: after a
+ *        failed transfer they may be repeated. A command, a register write or a fetch that
+ *        consumes the device data always runs alone.
+ */
+struct user_i2c_transaction
+{
+    uint8_t address;             /* 7-bit device address. */
+    uint8_t priority;            /* Higher runs first. */
+    const uint8_t *write_buf;    /* Bytes to write. */
+    size_t write_len;            /* Number of bytes to write. */
+    uint8_t *read_buf;           /* Buffer of the bytes read. */
+    size_t read_len;             /* Number of bytes to read. */
+    uint32_t timeout_ms;         /* Deadline from submission, 0 means none. */
+    bool idempotent;             /* Safe to run twice, allows batching with other idempotent transactions. */
+    user_i2c_done_cb_t callback; /* Completion callback. */
+    void *arg;                   /* Completion callback argument. */
+
+    /* Filled in by the scheduler. */
+    esp_err_t result;            /* ESP_OK, ESP_ERR_TIMEOUT if the deadline passed before the transfer, or the bus error. */
+    uint32_t submit_us;          /* Submission time. */
+    uint32_t deadline_us;        /* Absolute deadline. */
+    user_i2c_transaction_t *next;
+};
+
+/**
+ * @brief Executes a batch of transactions as one bus transfer, the mock point of host builds.
+ *        On failure, done returns the number of leading transactions known to have completed,
+ *        0 when the bus cannot tell where the transfer stopped.
+ */
+typedef esp_err_t (*user_i2c_transfer_t)(void *ctx, user_i2c_transaction_t *const *batch, int count, int *done);
+
+/** @brief Microsecond clock, wraps around. */
+typedef uint32_t (*user_i2c_clock_t)(void *ctx);
+
+/** @brief Per-device statistics. */
+typedef struct
+{
+    uint8_t address;                                /* 7-bit device address. */
+    uint32_t completed;                             /* Transactions completed with ESP_OK. */
+    uint32_t errors;                                /* Transactions failed on the bus. */
+    uint32_t expired;                               /* Transactions whose deadline passed in the queue. */
+    uint32_t max_latency_us;                        /* Largest submission to completion time. */
+    uint32_t histogram[USER_I2C_HISTOGRAM_BUCKETS]; /* Submission to completion time histogram. */
+} user_i2c_device_stats_t;
+
+/** @brief Bus statistics. */
+typedef struct
+{
+    uint32_t transfers;    /* Bus transfers issued. */
+    uint32_t transactions; /* Transactions transferred. */
+    uint32_t batched;      /* Transactions that shared a bus transfer with a previous one. */
+    uint32_t retried;      /* Transactions repeated alone after their batch failed. */
+    uint32_t pending;      /* Transactions waiting. */
+} user_i2c_bus_stats_t;
+
+/** @brief I2C transaction scheduler, single threaded, the owner serializes the calls. */
+typedef struct
+{
+    user_i2c_transfer_t transfer;                          /* Bus transfer. */
+    user_i2c_clock_t clock;                                /* Microsecond clock. */
+    void *ctx;                                             /* Transfer and clock context. */
+    user_i2c_transaction_t *head;                          /* Pending transactions, in execution order. */
+    user_i2c_bus_stats_t stats;                            /* Bus statistics. */
+    int device_count;                                      /* Devices with statistics. */
+    user_i2c_device_stats_t devices[USER_I2C_DEVICE_MAX];  /* Device statistics. */
+} user_i2c_bus_t;
+
+void user_i2c_bus_init(user_i2c_bus_t *bus, user_i2c_transfer_t transfer, user_i2c_clock_t clock, void *ctx);
+void user_i2c_bus_submit(user_i2c_bus_t *bus, user_i2c_transaction_t *trans);
+int user_i2c_bus_process(user_i2c_bus_t *bus);
+const user_i2c_device_stats_t *user_i2c_bus_get_device_stats(const user_i2c_bus_t *bus, uint8_t address);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USER_I2C_BUS_H */
+/******************************** End of File *********************************/
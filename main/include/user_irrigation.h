@@ -0,0 +1,84 @@
+/**
+ *****************************************************************************
+ * @file    : user_irrigation.h
+ * @brief   : Soil moisture irrigation controller
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *****************************************************************************
+ */
+
+#ifndef USER_IRRIGATION_H
+#define USER_IRRIGATION_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Irrigation zones, one valve and one soil moisture probe each. */
+#define IRRIGATION_MAX_ZONES            (3U)
+
+/** @brief Output bits of irrigation_outputs(), zone n is bit n, the shared pump follows the zones. */
+#define IRRIGATION_ZONE_BIT(zone)       (1UL << (zone))
+#define IRRIGATION_PUMP_BIT             (1UL << IRRIGATION_MAX_ZONES)
+
+/** @brief Zone parameters, moisture in the unit of the samples. */
+typedef struct
+{
+    bool enabled;           /* When cleared, the valve stays closed. */
+    int32_t on_below;       /* Open the valve at or below this moisture. */
+    int32_t off_above;      /* Close the valve at or above this moisture, higher than on_below. */
+    uint32_t min_on_ms;     /* Shortest watering. */
+    uint32_t min_off_ms;    /* Shortest pause, lets the water soak in before the probe is trusted. */
+    uint32_t max_on_ms;     /* Longest watering, guards against a stuck or dry probe, 0 unlimited. */
+} irrigation_zone_config_t;
+
+/** @brief Pump parameters, shared by every zone. */
+typedef struct
+{
+    uint32_t max_open_zones;    /* Valves the pump can feed at the same time. */
+    uint32_t pump_min_off_ms;   /* Pump restart delay. */
+    uint32_t sample_timeout_ms; /* A zone without a sample for this long is closed, 0 never. */
+} irrigation_pump_config_t;
+
+/** @brief Zone state. */
+typedef struct
+{
+    irrigation_zone_config_t config;
+    int32_t moisture;       /* Last sample. */
+    uint32_t sample_ms;     /* Time of the last sample. */
+    bool sampled;           /* When set, moisture is recent enough to act on. */
+    bool on;                /* Valve open. */
+    uint32_t changed_ms;    /* Time of the last valve change. */
+    uint32_t hold_ms;       /* The valve keeps its state this long after changed_ms. */
+} irrigation_zone_t;
+
+/** @brief Irrigation controller. */
+typedef struct
+{
+    irrigation_zone_t zones[IRRIGATION_MAX_ZONES];
+    irrigation_pump_config_t pump;
+    bool pump_on;
+    uint32_t pump_changed_ms;
+    uint32_t pump_hold_ms;
+    uint32_t manual;        /* Output bits left to the manual commands, see irrigation_set_manual(). */
+} irrigation_t;
+
+void irrigation_init(irrigation_t *ctrl, const irrigation_pump_config_t *pump);
+bool irrigation_set_zone(irrigation_t *ctrl, uint32_t zone, const irrigation_zone_config_t *config);
+void irrigation_set_manual(irrigation_t *ctrl, uint32_t manual, uint32_t now_ms);
+void irrigation_set_moisture(irrigation_t *ctrl, uint32_t zone, int32_t moisture, uint32_t now_ms);
+uint32_t irrigation_evaluate(irrigation_t *ctrl, uint32_t now_ms);
+uint32_t irrigation_outputs(const irrigation_t *ctrl);
+int irrigation_parse_zone(const char *data, size_t data_len, irrigation_zone_config_t *config);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USER_IRRIGATION_H */
+/******************************** End of File *********************************/
@@ -0,0 +1,60 @@
+/**
+ *****************************************************************************
+ * @file    : user_light_recipe.h
+ * @brief   : Grow light recipe interpolation engine
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *****************************************************************************
+ */
+
+#ifndef USER_LIGHT_RECIPE_H
+#define USER_LIGHT_RECIPE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Recipe capacity and day length. */
+#define LIGHT_RECIPE_MAX_KEYFRAMES  (16)
+#define LIGHT_RECIPE_MINUTES_PER_DAY (24U * 60U)
+#define LIGHT_RECIPE_MS_PER_DAY     (LIGHT_RECIPE_MINUTES_PER_DAY * 60U * 1000U)
+
+/** @brief Interpolated components: brightness, red, green, blue. */
+#define LIGHT_RECIPE_COMPONENTS     (4)
+
+/** @brief Recipe keyframe, the light is interpolated linearly to the next keyframe. */
+typedef struct
+{
+    uint16_t minute;                           /* Minute of the day, 0 ~ 1439. */
+    uint8_t value[LIGHT_RECIPE_COMPONENTS];    /* Brightness, red, green, blue. */
+} light_recipe_keyframe_t;
+
+/** @brief Recipe engine, no dynamic memory. */
+typedef struct
+{
+    light_recipe_keyframe_t keyframes[LIGHT_RECIPE_MAX_KEYFRAMES]; /* Sorted by minute, repeated every day. */
+    int count;                                 /* Keyframes, 0 disables the recipe. */
+    uint32_t frame_ms;                         /* Time between two steps. */
+    int segment;                               /* Keyframe the current segment starts from. */
+    uint32_t frames_left;                      /* Steps to the end of the segment. */
+    int64_t value[LIGHT_RECIPE_COMPONENTS];    /* Current value, Q32.32, a day of small steps does not drift. */
+    int64_t step[LIGHT_RECIPE_COMPONENTS];     /* Increment per step, Q32.32. */
+    uint8_t output[LIGHT_RECIPE_COMPONENTS];   /* Last output. */
+} light_recipe_t;
+
+bool light_recipe_init(light_recipe_t *recipe, const light_recipe_keyframe_t *keyframes, int count, uint32_t frame_ms);
+void light_recipe_seek(light_recipe_t *recipe, uint32_t ms_of_day);
+bool light_recipe_step(light_recipe_t *recipe);
+int light_recipe_parse(const char *data, size_t data_len, light_recipe_keyframe_t *keyframes, int max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USER_LIGHT_RECIPE_H */
+/******************************** End of File *********************************/
@@ -0,0 +1,178 @@
+/**
+ *****************************************************************************
+ * @file    : user_modbus_master.h
+ * @brief   : Modbus RTU/ASCII master polling engine
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *****************************************************************************
+ */
+
+#ifndef USER_MODBUS_MASTER_H
+#define USER_MODBUS_MASTER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Modbus read functions supported by the polling engine. */
+#define USER_MODBUS_READ_HOLDING_REGISTERS  (0x03U)
+#define USER_MODBUS_READ_INPUT_REGISTERS    (0x04U)
+
+/** @brief Polling engine capacity. */
+#define USER_MODBUS_MAX_SLAVES              (8)
+#define USER_MODBUS_MAX_POINTS              (32)
+#define USER_MODBUS_MAX_BLOCKS              (USER_MODBUS_MAX_POINTS)
+
+/** @brief Largest read of one request, and the unused registers a merged read may span. */
+#define USER_MODBUS_MAX_READ_REGISTERS      (125U)
+#define USER_MODBUS_MERGE_GAP               (4U)
+
+/** @brief Largest request frame, ASCII. */
+#define USER_MODBUS_REQUEST_MAX_LENGTH      (17U)
+
+/** @brief Largest frame, an ASCII response of USER_MODBUS_MAX_READ_REGISTERS registers. */
+#define USER_MODBUS_FRAME_MAX_LENGTH        (520U)
+
+/** @brief Bits of a character for the RTU silent intervals, 1 start, 8 data, parity and 1 stop or 2 stop. */
+#define USER_MODBUS_CHAR_BITS               (11U)
+
+/** @brief Above 19200 baud the silent intervals are fixed, t1.5 = 750 us, t3.5 = 1750 us. */
+#define USER_MODBUS_FIXED_TIMING_BAUD       (19200U)
+#define USER_MODBUS_FIXED_T15_US            (750U)
+#define USER_MODBUS_FIXED_T35_US            (1750U)
+
+/** @brief Margin added to the learned response time of a slave. */
+#define USER_MODBUS_TIMEOUT_MARGIN_MS       (5U)
+
+/** @brief Retry backoff of a failing slave, doubled on every failed poll. */
+#define USER_MODBUS_BACKOFF_BASE_MS         (1000U)
+#define USER_MODBUS_BACKOFF_MAX_MS          (60 * 1000U)
+
+/** @brief Modbus serial transmission mode. */
+typedef enum
+{
+    USER_MODBUS_MODE_RTU,   /* Binary frames with CRC-16, delimited by silent intervals. */
+    USER_MODBUS_MODE_ASCII  /* Hexadecimal frames with LRC, delimited by ':' and CR LF. */
+} user_modbus_mode_t;
+
+/**
+ * @brief Serial transport of the master, the mock point of host builds.
+ */
+typedef struct
+{
+    /* Discard pending input and send one frame. */
+    esp_err_t (*send)(void *ctx, const uint8_t *frame, size_t length);
+    /* Receive one frame ended by gap_us of silence, return its length, 0 on timeout, negative on error. */
+    int (*receive)(void *ctx, uint8_t *frame, size_t size, uint32_t timeout_ms, uint32_t gap_us);
+    /* Millisecond clock, wraps around. */
+    uint32_t (*clock_ms)(void *ctx);
+    void *ctx;
+} user_modbus_transport_t;
+
+typedef struct user_modbus_point user_modbus_point_t;
+
+/** @brief Register map point handler, runs in the polling context. */
+typedef void (*user_modbus_point_cb_t)(const user_modbus_point_t *point, const uint16_t *regs);
+
+/** @brief Register map point, one or more consecutive registers of a slave. */
+struct user_modbus_point
+{
+    uint8_t slave;                  /* Slave address. */
+    uint8_t function;               /* USER_MODBUS_READ_HOLDING_REGISTERS or USER_MODBUS_READ_INPUT_REGISTERS. */
+    uint16_t address;               /* First register. */
+    uint16_t count;                 /* Number of registers. */
+    user_modbus_point_cb_t handler; /* Receives the registers of the point after every successful read. */
+    void *arg;                      /* Handler argument. */
+};
+
+/** @brief Slave configuration. */
+typedef struct
+{
+    uint8_t address;     /* Slave address. */
+    uint32_t timeout_ms; /* Largest response timeout, the learned timeout is used below it. */
+    uint8_t retries;     /* Immediate repeats of a failed request. */
+} user_modbus_slave_config_t;
+
+/** @brief Slave statistics and backoff state. */
+typedef struct
+{
+    uint32_t requests;   /* Requests sent. */
+    uint32_t responses;  /* Valid responses. */
+    uint32_t timeouts;   /* Requests without response. */
+    uint32_t errors;     /* Corrupted, mismatched or exception responses. */
+    uint32_t skipped;    /* Reads skipped while backing off. */
+    uint32_t failures;   /* Consecutive failed polls. */
+    uint32_t retry_at;   /* Time of the next attempt while failures is not 0. */
+    uint32_t srtt_q4;    /* Smoothed response latency without the transfer time, in 1/16 ms. */
+    uint32_t rttvar_q4;  /* Smoothed latency deviation, in 1/16 ms. */
+    uint32_t timeout_ms; /* Current response timeout before the transfer time, 0 until learned. */
+} user_modbus_slave_stats_t;
+
+/** @brief Poll cycle statistics. */
+typedef struct
+{
+    uint32_t cycles;        /* Completed poll cycles. */
+    uint32_t last_cycle_ms; /* Duration of the last cycle. */
+    uint32_t min_cycle_ms;  /* Shortest cycle. */
+    uint32_t max_cycle_ms;  /* Longest cycle. */
+    uint32_t points;        /* Register map points. */
+    uint32_t blocks;        /* Reads per cycle after merging. */
+    uint32_t t15_us;        /* RTU inter-character limit. */
+    uint32_t t35_us;        /* RTU inter-frame silent interval. */
+} user_modbus_cycle_stats_t;
+
+/** @brief Merged read of adjacent points of a slave. */
+typedef struct
+{
+    uint8_t slave_index; /* Index in the slave table. */
+    uint8_t function;    /* Read function. */
+    uint16_t address;    /* First register. */
+    uint16_t count;      /* Number of registers. */
+    uint8_t first;       /* First point, index in the sorted order. */
+    uint8_t point_count; /* Number of points. */
+    uint8_t request_length;                          /* Request frame length. */
+    uint8_t request[USER_MODBUS_REQUEST_MAX_LENGTH]; /* Request frame, built once. */
+    uint32_t response_ms;                            /* Time on the wire of the response. */
+} user_modbus_block_t;
+
+/** @brief Modbus master polling engine, single threaded. */
+typedef struct
+{
+    user_modbus_mode_t mode;
+    user_modbus_transport_t transport;
+    uint32_t char_us;
+    int slave_count;
+    user_modbus_slave_config_t slaves[USER_MODBUS_MAX_SLAVES];
+    user_modbus_slave_stats_t slave_stats[USER_MODBUS_MAX_SLAVES];
+    const user_modbus_point_t *points;
+    uint8_t order[USER_MODBUS_MAX_POINTS];
+    int block_count;
+    user_modbus_block_t blocks[USER_MODBUS_MAX_BLOCKS];
+    user_modbus_cycle_stats_t stats;
+    uint8_t frame[USER_MODBUS_FRAME_MAX_LENGTH];
+    uint16_t regs[USER_MODBUS_MAX_READ_REGISTERS];
+} user_modbus_master_t;
+
+uint16_t user_modbus_crc16(const uint8_t *data, size_t length);
+uint8_t user_modbus_lrc(const uint8_t *data, size_t length);
+void user_modbus_rtu_timing(uint32_t baud_rate, uint32_t *t15_us, uint32_t *t35_us);
+esp_err_t user_modbus_master_init(user_modbus_master_t *master, user_modbus_mode_t mode, uint32_t baud_rate,
+                                  const user_modbus_transport_t *transport,
+                                  const user_modbus_slave_config_t *slaves, int slave_count,
+                                  const user_modbus_point_t *points, int point_count);
+void user_modbus_master_poll(user_modbus_master_t *master);
+const user_modbus_slave_stats_t *user_modbus_master_get_slave_stats(const user_modbus_master_t *master, uint8_t address);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USER_MODBUS_MASTER_H */
+/******************************** End of File *********************************/
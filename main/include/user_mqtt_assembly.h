@@ -0,0 +1,70 @@
+/**
+ *****************************************************************************
+ * @file    : user_mqtt_assembly.h
+ * @brief   : Reassembly of fragmented MQTT messages into message pool slots
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *****************************************************************************
+ */
+
+#ifndef USER_MQTT_ASSEMBLY_H
+#define USER_MQTT_ASSEMBLY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "user_mqtt_pool.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Part of a received payload, as carried by an MQTT_EVENT_DATA event. */
+typedef struct
+{
+    const char *topic; /* Only carried by the first fragment. */
+    int topic_len;
+    const char *data;
+    int data_len;
+    int offset;        /* Offset of data in the payload, 0 for the first fragment. */
+    int total_len;     /* Payload length. */
+} user_mqtt_fragment_t;
+
+/** @brief Outcome of a fragment. */
+typedef enum
+{
+    USER_MQTT_ASSEMBLY_PENDING,      /* Copied, more fragments are expected. */
+    USER_MQTT_ASSEMBLY_QUEUED,       /* Last fragment, the message is queued. */
+    USER_MQTT_ASSEMBLY_MERGED,       /* The message replaced the payload of a queued one. */
+    USER_MQTT_ASSEMBLY_IGNORED,      /* Rest of a dropped message. */
+    USER_MQTT_ASSEMBLY_OVERSIZED,    /* The message does not fit a pool slot, dropped. */
+    USER_MQTT_ASSEMBLY_EXHAUSTED,    /* No pool slot for the message, dropped. */
+    USER_MQTT_ASSEMBLY_OUT_OF_RANGE  /* The fragment is outside the announced payload, the message is dropped. */
+} user_mqtt_assembly_result_t;
+
+/**
+ * @brief Reassembly state of one producer. The pool calls run between lock
+ *        and unlock, the fragments are copied into the held slot without the lock.
+ */
+typedef struct
+{
+    user_mqtt_pool_t *pool;
+    void (*lock)(void *ctx);
+    void (*unlock)(void *ctx);
+    void *ctx;
+    uint8_t index; /* Slot of the message being reassembled, USER_MQTT_POOL_INDEX_NONE when none. */
+} user_mqtt_assembly_t;
+
+void user_mqtt_assembly_init(user_mqtt_assembly_t *assembly, user_mqtt_pool_t *pool, void (*lock)(void *ctx),
+                             void (*unlock)(void *ctx), void *ctx);
+user_mqtt_assembly_result_t user_mqtt_assembly_feed(user_mqtt_assembly_t *assembly,
+                                                    const user_mqtt_fragment_t *fragment, uint32_t seq);
+bool user_mqtt_assembly_abort(user_mqtt_assembly_t *assembly);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USER_MQTT_ASSEMBLY_H */
+/******************************** End of File *********************************/
@@ -0,0 +1,51 @@
+/**
+ *****************************************************************************
+ * @file    : user_mqtt_latest.h
+ * @brief   : Newest value slots of last-writer-wins MQTT topics
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *****************************************************************************
+ */
+
+#ifndef USER_MQTT_LATEST_H
+#define USER_MQTT_LATEST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Number of slots, one bit each in the dirty bitmap. */
+#define USER_MQTT_LATEST_SLOTS              (32U)
+
+/** @brief Longest value kept in a slot, longer payloads go through the message queue. */
+#define USER_MQTT_LATEST_DATA_MAX_LENGTH    (32U)
+
+/** @brief Newest value of a last-writer-wins topic. */
+typedef struct
+{
+    char data[USER_MQTT_LATEST_DATA_MAX_LENGTH];
+    int data_len;
+    uint32_t seq; /* Arrival order, given by the owner when the value is stored. */
+} user_mqtt_latest_value_t;
+
+/** @brief Value slots, a set dirty bit marks a value that is not applied yet. */
+typedef struct
+{
+    user_mqtt_latest_value_t values[USER_MQTT_LATEST_SLOTS];
+    uint32_t dirty;
+} user_mqtt_latest_t;
+
+void user_mqtt_latest_init(user_mqtt_latest_t *latest);
+bool user_mqtt_latest_store(user_mqtt_latest_t *latest, uint32_t slot, const char *data, int data_len, uint32_t seq);
+int user_mqtt_latest_take(user_mqtt_latest_t *latest, uint32_t before, user_mqtt_latest_value_t *value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USER_MQTT_LATEST_H */
+/******************************** End of File *********************************/
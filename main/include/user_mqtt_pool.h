@@ -0,0 +1,95 @@
+/**
+ *****************************************************************************
+ * @file    : user_mqtt_pool.h
+ * @brief   : Static MQTT message pool and message queue
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *****************************************************************************
+ */
+
+#ifndef USER_MQTT_POOL_H
+#define USER_MQTT_POOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Message pool configuration, the message queue is as deep as the pool. */
+#define USER_MQTT_POOL_SIZE                 (10U)
+#define USER_MQTT_POOL_TOPIC_MAX_LENGTH     (64U)
+#define USER_MQTT_POOL_DATA_MAX_LENGTH      (1024U)
+
+/** @brief No message pool slot. */
+#define USER_MQTT_POOL_INDEX_NONE           (0xFFU)
+
+/** @brief MQTT ingress overflow policy, applied when every message pool slot is in use. */
+typedef enum
+{
+    USER_MQTT_OVERFLOW_DROP_OLDEST, /* Drop the oldest queued message. */
+    USER_MQTT_OVERFLOW_DROP_NEWEST, /* Drop the incoming message. */
+    USER_MQTT_OVERFLOW_COALESCE     /* Replace a queued message of the same topic, otherwise drop the oldest. */
+} user_mqtt_overflow_policy_t;
+
+/** @brief MQTT message pool statistics. */
+typedef struct
+{
+    uint32_t received;        /* Messages stored in the pool. */
+    uint32_t overflow;        /* Messages received while the pool was exhausted. */
+    uint32_t dropped_oldest;  /* Queued messages dropped to make room for a newer one. */
+    uint32_t dropped_newest;  /* Incoming messages dropped. */
+    uint32_t coalesced;       /* Queued messages replaced by a newer one of the same topic. */
+    uint32_t oversized;       /* Messages dropped because they do not fit a pool slot. */
+    uint32_t incomplete;      /* Fragmented messages dropped before the last fragment arrived. */
+    uint32_t in_use;          /* Slots currently in use. */
+    uint32_t high_water_mark; /* Maximum number of slots in use at the same time. */
+    uint32_t latest;          /* Last-writer-wins values stored outside the pool. */
+    uint32_t superseded;      /* Last-writer-wins values overwritten before they were applied. */
+} user_mqtt_pool_stats_t;
+
+/** @brief MQTT message, a slot of the message pool. */
+typedef struct
+{
+    char topic[USER_MQTT_POOL_TOPIC_MAX_LENGTH];
+    int topic_len;
+    char data[USER_MQTT_POOL_DATA_MAX_LENGTH];
+    int data_len;
+    uint32_t seq; /* Arrival order, given by the owner when the message is queued. */
+    bool queued;  /* In the message queue, its payload may only change through a coalesce. */
+} user_mqtt_msg_t;
+
+/**
+ * @brief Message pool, every slot is either free, held by its producer or
+ *        consumer, or queued. The queues only carry slot indexes.
+ */
+typedef struct
+{
+    user_mqtt_msg_t slots[USER_MQTT_POOL_SIZE];
+    uint8_t free_slots[USER_MQTT_POOL_SIZE]; /* Stack of free slot indexes. */
+    uint32_t free_count;
+    uint8_t queue[USER_MQTT_POOL_SIZE];      /* Queued slot indexes, oldest first from queue_head. */
+    uint32_t queue_head;
+    uint32_t queue_count;
+    user_mqtt_overflow_policy_t policy;
+    user_mqtt_pool_stats_t stats;
+} user_mqtt_pool_t;
+
+void user_mqtt_pool_init(user_mqtt_pool_t *pool, user_mqtt_overflow_policy_t policy);
+esp_err_t user_mqtt_pool_acquire(user_mqtt_pool_t *pool, const char *topic, int topic_len, const char *data,
+                                 int data_len, int total_data_len, uint8_t *index);
+esp_err_t user_mqtt_pool_queue(user_mqtt_pool_t *pool, uint8_t index, uint32_t seq);
+bool user_mqtt_pool_receive(user_mqtt_pool_t *pool, uint8_t *index);
+void user_mqtt_pool_release(user_mqtt_pool_t *pool, uint8_t index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USER_MQTT_POOL_H */
+/******************************** End of File *********************************/
@@ -0,0 +1,55 @@
+/**
+ *****************************************************************************
+ * @file    : user_mqtt_topic.h
+ * @brief   : MQTT subscribe topic dispatch table
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *****************************************************************************
+ */
+
+#ifndef USER_MQTT_TOPIC_H
+#define USER_MQTT_TOPIC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief MQTT subscribe topic message handler. */
+typedef void (*mqtt_topic_handler_t)(const char *data, int data_len);
+
+/** @brief MQTT subscribe topic dispatch table entry. */
+typedef struct
+{
+    const char *topic;            /* Subscribe topic name. */
+    int topic_len;                /* Subscribe topic length, without the terminating null. */
+    mqtt_topic_handler_t handler; /* Subscribe topic message handler. */
+    bool latest_only;             /* Last-writer-wins state, only the newest value is applied. */
+} mqtt_topic_entry_t;
+
+/** @brief Build a dispatch table entry, the topic length is resolved at compile time. */
+#define MQTT_TOPIC_ENTRY(_topic, _handler)          { (_topic), (sizeof(_topic) - 1), (_handler), false }
+#define MQTT_TOPIC_LATEST_ENTRY(_topic, _handler)   { (_topic), (sizeof(_topic) - 1), (_handler), true }
+
+/** @brief Slots of the topic hash index, a power of two, at least twice the table entries. */
+#define MQTT_TOPIC_INDEX_SIZE                       (64U)
+
+/** @brief Hash index of a dispatch table, open addressing with linear probing. */
+typedef struct
+{
+    const mqtt_topic_entry_t *table;
+    uint8_t slots[MQTT_TOPIC_INDEX_SIZE]; /* Table index + 1 of the entry in the slot, 0 when the slot is free. */
+} mqtt_topic_index_t;
+
+int mqtt_topic_index_build(mqtt_topic_index_t *index, const mqtt_topic_entry_t *table, int count);
+const mqtt_topic_entry_t *mqtt_topic_index_lookup(const mqtt_topic_index_t *index, const char *topic, int topic_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USER_MQTT_TOPIC_H */
+/******************************** End of File *********************************/
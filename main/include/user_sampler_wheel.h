@@ -0,0 +1,74 @@
+/**
+ *****************************************************************************
+ * @file    : user_sampler_wheel.h
+ * @brief   : Hierarchical timer wheel of the sensor sampling scheduler
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *****************************************************************************
+ */
+
+#ifndef USER_SAMPLER_WHEEL_H
+#define USER_SAMPLER_WHEEL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Timer wheel geometry, 1 ms ticks, 64 slots per level, 4 levels (about 16.7 minutes). */
+#define SAMPLER_WHEEL_BITS          (6U)
+#define SAMPLER_WHEEL_SLOTS         (1U << SAMPLER_WHEEL_BITS)
+#define SAMPLER_WHEEL_MASK          (SAMPLER_WHEEL_SLOTS - 1U)
+#define SAMPLER_WHEEL_LEVELS        (4U)
+
+/** @brief Maximum number of sampling channels. */
+#define SAMPLER_WHEEL_MAX_CHANNELS  (16)
+
+/** @brief Sampling channel callback, runs in the scheduler context and must not block. */
+typedef void (*sampler_wheel_callback_t)(void *arg);
+
+/** @brief Sampling channel statistics. */
+typedef struct
+{
+    uint32_t runs;            /* Callback invocations. */
+    uint32_t overruns;        /* Runs skipped because the channel fell a whole period behind. */
+    uint32_t last_jitter_ms;  /* Delay between the scheduled and the actual time of the last run. */
+    uint32_t max_jitter_ms;   /* Largest delay between the scheduled and the actual time of a run. */
+    uint64_t total_jitter_ms; /* Sum of the delays, divide by runs for the mean. */
+} sampler_wheel_stats_t;
+
+/** @brief Sampling channel. */
+typedef struct
+{
+    sampler_wheel_callback_t callback; /* Sampling callback. */
+    void *arg;                         /* Sampling callback argument. */
+    uint32_t period;                   /* Period in ms. */
+    uint32_t expiry;                   /* Next run, absolute ms. */
+    int16_t next;                      /* Next channel of the same slot. */
+    sampler_wheel_stats_t stats;       /* Channel statistics. */
+} sampler_wheel_channel_t;
+
+/** @brief Hierarchical timer wheel, no dynamic memory. */
+typedef struct
+{
+    uint32_t now;                                                /* Last processed ms. */
+    int channel_count;                                           /* Registered channels. */
+    int16_t slots[SAMPLER_WHEEL_LEVELS][SAMPLER_WHEEL_SLOTS];    /* Channel list head of every slot. */
+    sampler_wheel_channel_t channels[SAMPLER_WHEEL_MAX_CHANNELS]; /* Channel storage. */
+} sampler_wheel_t;
+
+void sampler_wheel_init(sampler_wheel_t *wheel, uint32_t now_ms);
+int sampler_wheel_add(sampler_wheel_t *wheel, uint32_t period_ms, uint32_t phase_ms,
+                      sampler_wheel_callback_t callback, void *arg);
+void sampler_wheel_advance(sampler_wheel_t *wheel, uint32_t now_ms);
+bool sampler_wheel_get_stats(const sampler_wheel_t *wheel, int channel, sampler_wheel_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USER_SAMPLER_WHEEL_H */
+/******************************** End of File *********************************/
@@ -0,0 +1,85 @@
+/**
+ *****************************************************************************
+ * @file    : user_store_ring.h
+ * @brief   : Flash record ring of the telemetry store
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *****************************************************************************
+ */
+
+#ifndef USER_STORE_RING_H
+#define USER_STORE_RING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Bytes of a flash record. */
+#define USER_STORE_RECORD_SIZE          (16U)
+
+/** @brief Records scanned per flash read during recovery. */
+#define USER_STORE_RECOVER_CHUNK        (32U)
+
+/**
+ * @brief Flash access of the ring, offsets from the start of the partition.
+ *        NOR semantics: a write only clears bits, an erase sets a sector to 0xFF.
+ */
+typedef struct
+{
+    esp_err_t (*read)(void *ctx, size_t offset, void *buf, size_t len);
+    esp_err_t (*write)(void *ctx, size_t offset, const void *buf, size_t len);
+    esp_err_t (*erase)(void *ctx, size_t offset, size_t len);
+    void *ctx;
+} user_store_flash_t;
+
+/** @brief Record read back from the ring. */
+typedef struct
+{
+    uint32_t sequence;  /* Sequence number. */
+    uint32_t timestamp; /* Seconds, from time(). */
+    uint8_t channel;    /* Telemetry channel. */
+    int32_t value;      /* Fixed-point value. */
+} user_store_entry_t;
+
+/** @brief Ring counters since initialization. */
+typedef struct
+{
+    uint32_t appended;      /* Records appended. */
+    uint32_t overwritten;   /* Unreleased records lost because the ring wrapped. */
+    uint32_t erases;        /* Sectors erased. */
+    uint32_t mark_failures; /* Release marks that could not be written, those records come back after a reboot. */
+} user_store_ring_stats_t;
+
+/** @brief Record ring, the record with sequence number N is always stored in slot N % capacity. */
+typedef struct
+{
+    user_store_flash_t flash;
+    uint32_t sector_size;       /* Erase unit. */
+    uint32_t records_per_sector;
+    uint32_t capacity;          /* Records the ring can hold. */
+    uint8_t channel_max;        /* Channels at or above it are not valid. */
+    uint32_t head;              /* Sequence number of the next record. */
+    uint32_t tail;              /* Oldest unreleased record, records [tail, head) are pending. */
+    user_store_ring_stats_t stats;
+} user_store_ring_t;
+
+uint16_t user_store_crc16(uint16_t crc, const uint8_t *data, size_t length);
+esp_err_t user_store_ring_init(user_store_ring_t *ring, const user_store_flash_t *flash, uint32_t size,
+                               uint32_t sector_size, uint8_t channel_max);
+esp_err_t user_store_ring_append(user_store_ring_t *ring, uint8_t channel, uint32_t timestamp, int32_t value);
+int user_store_ring_read(const user_store_ring_t *ring, uint32_t start, uint32_t count, user_store_entry_t *entries);
+esp_err_t user_store_ring_release(user_store_ring_t *ring, uint32_t start, uint32_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USER_STORE_RING_H */
+/******************************** End of File *********************************/
@@ -0,0 +1,51 @@
+/**
+ *****************************************************************************
+ * @file    : user_telemetry_filter.h
+ * @brief   : Telemetry report-by-exception filter
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *****************************************************************************
+ */
+
+#ifndef USER_TELEMETRY_FILTER_H
+#define USER_TELEMETRY_FILTER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Telemetry channel report-by-exception filter, values in the fixed-point unit of the channel. */
+typedef struct
+{
+    int32_t deadband;         /* Minimum change to report. */
+    int32_t rate_per_min;     /* Report a change at least this fast per minute, even inside the minimum interval, 0 off. */
+    uint32_t min_interval_ms; /* Minimum time between two reports. */
+    uint32_t max_silence_ms;  /* Heartbeat, report without change after this time. */
+} user_telemetry_filter_t;
+
+/** @brief Report-by-exception state of a channel. */
+typedef struct
+{
+    int32_t last_value; /* Last reported value. */
+    uint32_t last_ms;   /* Time of the last report. */
+    bool reported;      /* When set, means the channel has been reported at least once. */
+    int32_t prev_value; /* Value of the previous window, reported or not. */
+    uint32_t prev_ms;   /* Time of the previous window. */
+    bool sampled;       /* When set, means prev_value holds a window. */
+} user_telemetry_filter_state_t;
+
+bool user_telemetry_filter_valid(const user_telemetry_filter_t *filter);
+bool user_telemetry_filter_check(const user_telemetry_filter_t *filter, const user_telemetry_filter_state_t *state,
+                                 int32_t value, uint32_t now_ms);
+void user_telemetry_filter_update(user_telemetry_filter_state_t *state, int32_t value, uint32_t now_ms, bool reported);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USER_TELEMETRY_FILTER_H */
+/******************************** End of File *********************************/
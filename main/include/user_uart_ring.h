@@ -0,0 +1,55 @@
+/**
+ *****************************************************************************
+ * @file    : user_uart_ring.h
+ * @brief   : Single producer single consumer byte ring of the UART stream ports
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *****************************************************************************
+ */
+
+#ifndef USER_UART_RING_H
+#define USER_UART_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Fills free space of the ring, like uart_read_bytes without waiting.
+ *
+ * @return Number of bytes written to dst, 0 or less when no more are available.
+ */
+typedef int (*user_uart_ring_fill_t)(void *ctx, uint8_t *dst, size_t len);
+
+/**
+ * @brief Byte ring. The indexes run freely and wrap at 2^32, head - tail is
+ *        the number of stored bytes. head is only stored by the producer,
+ *        tail only by the consumer.
+ */
+typedef struct
+{
+    uint32_t head;   /* Write index. */
+    uint32_t tail;   /* Read index. */
+    uint32_t size;   /* Buffer length, a power of two. */
+    uint8_t *buffer;
+} user_uart_ring_t;
+
+esp_err_t user_uart_ring_init(user_uart_ring_t *ring, uint8_t *buffer, uint32_t size);
+size_t user_uart_ring_write(user_uart_ring_t *ring, size_t size, user_uart_ring_fill_t fill, void *ctx,
+                            size_t *overflow);
+size_t user_uart_ring_available(const user_uart_ring_t *ring);
+size_t user_uart_ring_read(user_uart_ring_t *ring, uint8_t *buf, size_t len);
+void user_uart_ring_clear(user_uart_ring_t *ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USER_UART_RING_H */
+/******************************** End of File *********************************/
@@ -9,6 +9,8 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -26,6 +28,14 @@
 #include "user_esp32_modbus.h"
 #include "user_esp32_i2c.h"
 #include "user_esp32_hardware.h"
+#include "user_esp32_telemetry.h"
+#include "user_esp32_codec.h"
+#include "user_esp32_store.h"
+#include "user_esp32_sampler.h"
+#include "user_esp32_environment.h"
+#include "user_esp32_fan.h"
+#include "user_esp32_light.h"
+#include "user_esp32_irrigation.h"
 
 void app_main(void)
 {
@@ -41,18 +51,42 @@ void app_main(void)
     }
     ESP_ERROR_CHECK(ret);
 
+    /* Local time zone, before any task converts the wall clock. */
+    setenv("TZ", CONFIG_USER_TIMEZONE, 1);
+    tzset();
+
+    /* Load MQTT payload format. */
+    user_esp32_codec_init();
+
+    /* Initialize sensor sampling scheduler. */
+    user_esp32_sampler_init();
+
     /* Initialize Wi-Fi */
     user_esp32_wifi_init();
     /* Initialize I2C. */
     user_esp32_i2c_init();
     /* Initialize UART. */
-    // user_esp32_uart_init();
+    user_esp32_uart_init();
     /* Initialize PWM. */
     user_esp32_pwm_init();
     /* Initialize RMT. */
     user_esp32_rmt_init();
     /* Initialize hardware. */
     user_esp32_hardware_init();
+    /* Initialize telemetry store-and-forward. */
+    user_esp32_store_init();
+    /* Initialize telemetry publisher. */
+    user_esp32_telemetry_init();
+    /* Initialize environment sensors. */
+    user_esp32_environment_init();
+    /* Initialize closed-loop fan speed control. */
+    user_esp32_fan_init();
+    /* Initialize grow light recipes. */
+    user_esp32_light_init();
+    /* Initialize local irrigation control, before the probes that feed it. */
+    user_esp32_irrigation_init();
+    /* Initialize RS-485 probes. */
+    user_esp32_modbus_init();
 
     while (1)
     {
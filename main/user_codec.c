@@ -0,0 +1,439 @@
+/**
+ *****************************************************************************
+ * @file    : user_codec.c
+ * @brief   : MQTT payload encoder and decoder
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *
+ * @note Plain C without FreeRTOS or ESP-IDF dependencies, the payload format
+ *       is passed in by the caller, so the codec can be fuzzed on the host.
+ *       Integer arithmetic only, nothing is allocated.
+ *****************************************************************************
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "user_codec.h"
+
+/** @brief Compare payload with a string literal, the lengths must be equal. */
+#define CODEC_DATA_EQUAL(_data, _data_len, _str) \
+    (((_data_len) == (sizeof(_str) - 1)) && (memcmp((_data), (_str), (_data_len)) == 0))
+
+/**
+ * @brief  Store a 32-bit value in little-endian byte order.
+ */
+static void codec_put_le32(uint8_t *buf, uint32_t value)
+{
+    buf[0] = (uint8_t)(value);
+    buf[1] = (uint8_t)(value >> 8);
+    buf[2] = (uint8_t)(value >> 16);
+    buf[3] = (uint8_t)(value >> 24);
+}
+/**
+ * @brief  Parse an unsigned decimal number that is not null terminated.
+ * 
+ * @param data[IN] Digits.
+ * @param data_len[IN] Number of digits.
+ * @param max[IN] Largest accepted value.
+ * @param value[OUT] Parsed value.
+ * 
+ * @return - ESP_OK              succeed
+ *         - ESP_ERR_INVALID_ARG not a number or greater than max
+ */
+static esp_err_t codec_parse_uint(const char *data, int data_len, uint32_t max, uint32_t *value)
+{
+    uint32_t result = 0;
+
+    if ((data_len <= 0) || (data_len > 10))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    for (int i = 0; i < data_len; i++)
+    {
+        if ((data[i] < '0') || (data[i] > '9'))
+        {
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        uint64_t next = (uint64_t)result * 10 + (uint32_t)(data[i] - '0');
+        if (next > max)
+        {
+            return ESP_ERR_INVALID_ARG;
+        }
+        result = (uint32_t)next;
+    }
+
+    *value = result;
+
+    return ESP_OK;
+}
+/**
+ * @brief  Check the version byte and length of a binary payload.
+ * 
+ * @param data[IN] Payload.
+ * @param data_len[IN] Payload length.
+ * @param body_len[IN] Expected length after the version byte.
+ * 
+ * @return - ESP_OK                   succeed
+ *         - ESP_ERR_INVALID_VERSION  unknown version
+ *         - ESP_ERR_INVALID_SIZE     wrong length
+ */
+static esp_err_t codec_check_binary(const char *data, int data_len, int body_len)
+{
+    if (data_len != (1 + body_len))
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    if ((uint8_t)data[0] != USER_CODEC_VERSION)
+    {
+        return ESP_ERR_INVALID_VERSION;
+    }
+
+    return ESP_OK;
+}
+/**
+ * @brief  Decode a switch command, "on"/"off" or [version][0|1].
+ * 
+ * @param format[IN] Payload format.
+ * @param data[IN] Payload, decoded in place.
+ * @param data_len[IN] Payload length.
+ * @param on[OUT] Switch state.
+ * 
+ * @return - ESP_OK  succeed
+ *         - other   malformed payload
+ */
+esp_err_t user_codec_decode_switch(user_codec_format_t format, const char *data, int data_len, bool *on)
+{
+    if (format == USER_CODEC_FORMAT_BINARY)
+    {
+        esp_err_t ret = codec_check_binary(data, data_len, 1);
+        if ((ret != ESP_OK) || ((uint8_t)data[1] > 1))
+        {
+            return (ret != ESP_OK) ? ret : ESP_ERR_INVALID_ARG;
+        }
+
+        *on = (data[1] == 1);
+        return ESP_OK;
+    }
+
+    if (CODEC_DATA_EQUAL(data, data_len, "on"))
+    {
+        *on = true;
+    }
+    else if (CODEC_DATA_EQUAL(data, data_len, "off"))
+    {
+        *on = false;
+    }
+    else
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    return ESP_OK;
+}
+/**
+ * @brief  Decode a level command such as a brightness or a speed, "128" or [version][level].
+ * 
+ * @param format[IN] Payload format.
+ * @param data[IN] Payload, decoded in place.
+ * @param data_len[IN] Payload length.
+ * @param max[IN] Largest accepted level, at most 255.
+ * @param level[OUT] Level.
+ * 
+ * @return - ESP_OK  succeed
+ *         - other   malformed payload or level out of range
+ */
+esp_err_t user_codec_decode_level(user_codec_format_t format, const char *data, int data_len, uint32_t max,
+                                  uint32_t *level)
+{
+    if (format == USER_CODEC_FORMAT_BINARY)
+    {
+        esp_err_t ret = codec_check_binary(data, data_len, 1);
+        if ((ret != ESP_OK) || ((uint8_t)data[1] > max))
+        {
+            return (ret != ESP_OK) ? ret : ESP_ERR_INVALID_ARG;
+        }
+
+        *level = (uint8_t)data[1];
+        return ESP_OK;
+    }
+
+    return codec_parse_uint(data, data_len, max, level);
+}
+/**
+ * @brief  Decode a color command, "255,255,255" or [version][red][green][blue].
+ * 
+ * @param format[IN] Payload format.
+ * @param data[IN] Payload, decoded in place.
+ * @param data_len[IN] Payload length.
+ * @param rgb[OUT] Red, green and blue components.
+ * 
+ * @return - ESP_OK  succeed
+ *         - other   malformed payload
+ */
+esp_err_t user_codec_decode_rgb(user_codec_format_t format, const char *data, int data_len, uint8_t rgb[3])
+{
+    if (format == USER_CODEC_FORMAT_BINARY)
+    {
+        esp_err_t ret = codec_check_binary(data, data_len, 3);
+        if (ret != ESP_OK)
+        {
+            return ret;
+        }
+
+        memcpy(rgb, &data[1], 3);
+        return ESP_OK;
+    }
+
+    int start = 0;
+    for (int i = 0; i < 3; i++)
+    {
+        uint32_t value;
+        int end = start;
+
+        while ((end < data_len) && (data[end] != ','))
+        {
+            end++;
+        }
+
+        /* Exactly two separators, the last component runs to the end of the payload. */
+        if (((i < 2) && (end == data_len)) || ((i == 2) && (end != data_len)))
+        {
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        if (codec_parse_uint(&data[start], end - start, UINT8_MAX, &value) != ESP_OK)
+        {
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        rgb[i] = (uint8_t)value;
+        start = end + 1;
+    }
+
+    return ESP_OK;
+}
+/**
+ * @brief  Encode a switch state, "on"/"off" or [version][0|1].
+ * 
+ * @param format[IN] Payload format.
+ * @param buf[OUT] Outgoing payload buffer.
+ * @param size[IN] Buffer size.
+ * @param on[IN] Switch state.
+ * 
+ * @return Payload length, -1 if the buffer is too small.
+ */
+int user_codec_encode_switch(user_codec_format_t format, char *buf, size_t size, bool on)
+{
+    if (format == USER_CODEC_FORMAT_BINARY)
+    {
+        if (size < 2)
+        {
+            return -1;
+        }
+
+        buf[0] = USER_CODEC_VERSION;
+        buf[1] = on ? 1 : 0;
+        return 2;
+    }
+
+    int len = snprintf(buf, size, "%s", on ? "on" : "off");
+
+    return (len < (int)size) ? len : -1;
+}
+/**
+ * @brief  Encode a fixed-point value, decimal text or [version][int32 little-endian].
+ * 
+ * @param format[IN] Payload format.
+ * @param buf[OUT] Outgoing payload buffer.
+ * @param size[IN] Buffer size.
+ * @param value[IN] Fixed-point value in 1/USER_CODEC_VALUE_SCALE units.
+ * 
+ * @return Payload length, -1 if the buffer is too small.
+ */
+int user_codec_encode_value(user_codec_format_t format, char *buf, size_t size, int32_t value)
+{
+    if (format == USER_CODEC_FORMAT_BINARY)
+    {
+        if (size < 5)
+        {
+            return -1;
+        }
+
+        buf[0] = USER_CODEC_VERSION;
+        codec_put_le32((uint8_t *)&buf[1], (uint32_t)value);
+        return 5;
+    }
+
+    uint32_t magnitude = (value < 0) ? (0U - (uint32_t)value) : (uint32_t)value;
+
+    /* Two decimals, matching USER_CODEC_VALUE_SCALE, without floating point. */
+    int len = snprintf(buf, size, "%s%" PRIu32 ".%02" PRIu32, (value < 0) ? "-" : "",
+                       magnitude / USER_CODEC_VALUE_SCALE, magnitude % USER_CODEC_VALUE_SCALE);
+
+    return (len < (int)size) ? len : -1;
+}
+/**
+ * @brief  Encode several values in one payload, directly into the outgoing buffer.
+ * 
+ * @note Text:   {"name":value,...}
+ *       Binary: [version][USER_CODEC_FRAME_TELEMETRY][mask uint16][int32 value]...
+ *               one little-endian value per mask bit, lowest bit first.
+ * 
+ * @param format[IN] Payload format.
+ * @param buf[OUT] Outgoing payload buffer.
+ * @param size[IN] Buffer size.
+ * @param names[IN] Value name of every channel, used by the text format.
+ * @param values[IN] Value of every channel, in 1/USER_CODEC_VALUE_SCALE units.
+ * @param mask[IN] Channels to encode, at most 16 channels.
+ * 
+ * @return Payload length, 0 if mask is empty, -1 if the buffer is too small.
+ */
+int user_codec_encode_batch(user_codec_format_t format, char *buf, size_t size, const char *const names[],
+                           const int32_t values[], uint32_t mask)
+{
+    uint32_t pending = mask;
+    int len = 0;
+
+    if ((mask == 0) || (mask > UINT16_MAX))
+    {
+        return (mask == 0) ? 0 : -1;
+    }
+
+    if (format == USER_CODEC_FORMAT_BINARY)
+    {
+        if (size < (4 + 4 * (size_t)__builtin_popcount(mask)))
+        {
+            return -1;
+        }
+
+        buf[0] = USER_CODEC_VERSION;
+        buf[1] = USER_CODEC_FRAME_TELEMETRY;
+        buf[2] = (uint8_t)(mask);
+        buf[3] = (uint8_t)(mask >> 8);
+        len = 4;
+
+        while (pending != 0)
+        {
+            int ch = __builtin_ctz(pending);
+            pending &= (pending - 1);
+
+            codec_put_le32((uint8_t *)&buf[len], (uint32_t)values[ch]);
+            len += 4;
+        }
+
+        return len;
+    }
+
+    while (pending != 0)
+    {
+        int ch = __builtin_ctz(pending);
+        pending &= (pending - 1);
+
+        int n = snprintf(buf + len, size - len, "%c\"%s\":", (len == 0) ? '{' : ',', names[ch]);
+        if ((n < 0) || (n >= (int)(size - len)))
+        {
+            return -1;
+        }
+        len += n;
+
+        n = user_codec_encode_value(format, buf + len, size - len, values[ch]);
+        if (n < 0)
+        {
+            return -1;
+        }
+        len += n;
+    }
+
+    if ((len + 1) >= (int)size)
+    {
+        return -1;
+    }
+    buf[len++] = '}';
+    buf[len] = '\0';
+
+    return len;
+}
+/**
+ * @brief  Encode timestamped records in one payload, directly into the outgoing buffer.
+ * 
+ * @note Text:   [[timestamp,"name",value],...]
+ *       Binary: [version][USER_CODEC_FRAME_HISTORY][count uint8]
+ *               then [timestamp uint32][channel uint8][value int32] per record, little-endian.
+ * 
+ * @param format[IN] Payload format.
+ * @param buf[OUT] Outgoing payload buffer.
+ * @param size[IN] Buffer size.
+ * @param names[IN] Value name of every channel, used by the text format.
+ * @param records[IN] Records, oldest first.
+ * @param count[IN] Number of records, at most 255.
+ * 
+ * @return Payload length, 0 if count is 0, -1 if the buffer is too small.
+ */
+int user_codec_encode_history(user_codec_format_t format, char *buf, size_t size, const char *const names[],
+                             const user_codec_record_t records[], int count)
+{
+    int len = 0;
+
+    if ((count <= 0) || (count > UINT8_MAX))
+    {
+        return (count == 0) ? 0 : -1;
+    }
+
+    if (format == USER_CODEC_FORMAT_BINARY)
+    {
+        if (size < (3 + 9 * (size_t)count))
+        {
+            return -1;
+        }
+
+        buf[0] = USER_CODEC_VERSION;
+        buf[1] = USER_CODEC_FRAME_HISTORY;
+        buf[2] = (uint8_t)count;
+        len = 3;
+
+        for (int i = 0; i < count; i++)
+        {
+            codec_put_le32((uint8_t *)&buf[len], records[i].timestamp);
+            buf[len + 4] = records[i].channel;
+            codec_put_le32((uint8_t *)&buf[len + 5], (uint32_t)records[i].value);
+            len += 9;
+        }
+
+        return len;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        int n = snprintf(buf + len, size - len, "%c[%" PRIu32 ",\"%s\",", (i == 0) ? '[' : ',',
+                         records[i].timestamp, names[records[i].channel]);
+        if ((n < 0) || (n >= (int)(size - len)))
+        {
+            return -1;
+        }
+        len += n;
+
+        n = user_codec_encode_value(format, buf + len, size - len, records[i].value);
+        if ((n < 0) || ((len + n + 1) >= (int)size))
+        {
+            return -1;
+        }
+        len += n;
+        buf[len++] = ']';
+    }
+
+    if ((len + 1) >= (int)size)
+    {
+        return -1;
+    }
+    buf[len++] = ']';
+    buf[len] = '\0';
+
+    return len;
+}
+/******************************** End of File *********************************/
@@ -0,0 +1,151 @@
+/**
+ *****************************************************************************
+ * @file    : user_esp32_codec.c
+ * @brief   : ESP32 MQTT payload codec Application
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *****************************************************************************
+ */
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "nvs.h"
+
+#include "user_esp32_codec.h"
+#include "user_esp32_telemetry.h"
+
+/** @brief Default MQTT payload format when nothing is stored in NVS. */
+#define DEFAULT_CODEC_FORMAT        USER_CODEC_FORMAT_TEXT
+
+/** @brief NVS namespace and key of the stored payload format. */
+#define CODEC_NVS_NAMESPACE         "codec"
+#define CODEC_NVS_KEY_FORMAT        "format"
+
+_Static_assert(USER_CODEC_VALUE_SCALE == USER_TELEMETRY_SCALE, "Telemetry values are encoded with two decimals");
+
+/** @brief log output label. */
+static const char *TAG = "Codec Application";
+
+/** @brief MQTT payload format of this device. */
+static volatile user_codec_format_t codec_format = DEFAULT_CODEC_FORMAT;
+
+/**
+ * @brief  Load the payload format of this device from NVS.
+ * 
+ * @note NVS must be initialized first.
+ * 
+ * @return - ESP_OK   succeed
+ */
+esp_err_t user_esp32_codec_init(void)
+{
+    nvs_handle_t handle;
+    uint8_t format = DEFAULT_CODEC_FORMAT;
+
+    if (nvs_open(CODEC_NVS_NAMESPACE, NVS_READONLY, &handle) == ESP_OK)
+    {
+        nvs_get_u8(handle, CODEC_NVS_KEY_FORMAT, &format);
+        nvs_close(handle);
+    }
+
+    codec_format = (format == USER_CODEC_FORMAT_BINARY) ? USER_CODEC_FORMAT_BINARY : USER_CODEC_FORMAT_TEXT;
+    ESP_LOGI(TAG, "Payload format: %s.", (codec_format == USER_CODEC_FORMAT_BINARY) ? "binary" : "text");
+
+    return ESP_OK;
+}
+/**
+ * @brief  Select and store the payload format of this device.
+ * 
+ * @param format[IN] Payload format.
+ * 
+ * @return - ESP_OK              succeed
+ *         - ESP_ERR_INVALID_ARG unknown format
+ *         - other               NVS error, the format is applied but not stored
+ */
+esp_err_t user_esp32_codec_set_format(user_codec_format_t format)
+{
+    nvs_handle_t handle;
+    esp_err_t ret;
+
+    if ((format != USER_CODEC_FORMAT_TEXT) && (format != USER_CODEC_FORMAT_BINARY))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    codec_format = format;
+
+    ret = nvs_open(CODEC_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "NVS open failed. Error Code: (%s).", esp_err_to_name(ret));
+        return ret;
+    }
+
+    ret = nvs_set_u8(handle, CODEC_NVS_KEY_FORMAT, (uint8_t)format);
+    if (ret == ESP_OK)
+    {
+        ret = nvs_commit(handle);
+    }
+    nvs_close(handle);
+
+    return ret;
+}
+/**
+ * @brief  Get the payload format of this device.
+ * 
+ * @return Payload format.
+ */
+user_codec_format_t user_esp32_codec_get_format(void)
+{
+    return codec_format;
+}
+/**
+ * @brief  Decode a switch command in the payload format of this device, see user_codec_decode_switch.
+ */
+esp_err_t user_esp32_codec_decode_switch(const char *data, int data_len, bool *on)
+{
+    return user_codec_decode_switch(codec_format, data, data_len, on);
+}
+/**
+ * @brief  Decode a level command in the payload format of this device, see user_codec_decode_level.
+ */
+esp_err_t user_esp32_codec_decode_level(const char *data, int data_len, uint32_t max, uint32_t *level)
+{
+    return user_codec_decode_level(codec_format, data, data_len, max, level);
+}
+/**
+ * @brief  Decode a color command in the payload format of this device, see user_codec_decode_rgb.
+ */
+esp_err_t user_esp32_codec_decode_rgb(const char *data, int data_len, uint8_t rgb[3])
+{
+    return user_codec_decode_rgb(codec_format, data, data_len, rgb);
+}
+/**
+ * @brief  Encode a switch state in the payload format of this device, see user_codec_encode_switch.
+ */
+int user_esp32_codec_encode_switch(char *buf, size_t size, bool on)
+{
+    return user_codec_encode_switch(codec_format, buf, size, on);
+}
+/**
+ * @brief  Encode a fixed-point value in the payload format of this device, see user_codec_encode_value.
+ */
+int user_esp32_codec_encode_value(char *buf, size_t size, int32_t value)
+{
+    return user_codec_encode_value(codec_format, buf, size, value);
+}
+/**
+ * @brief  Encode several values in the payload format of this device, see user_codec_encode_batch.
+ */
+int user_esp32_codec_encode_batch(char *buf, size_t size, const char *const names[], const int32_t values[], uint32_t mask)
+{
+    return user_codec_encode_batch(codec_format, buf, size, names, values, mask);
+}
+/**
+ * @brief  Encode timestamped records in the payload format of this device, see user_codec_encode_history.
+ */
+int user_esp32_codec_encode_history(char *buf, size_t size, const char *const names[], const user_codec_record_t records[], int count)
+{
+    return user_codec_encode_history(codec_format, buf, size, names, records, count);
+}
+/******************************** End of File *********************************/
@@ -0,0 +1,305 @@
+/**
+ *****************************************************************************
+ * @file    : user_esp32_environment.c
+ * @brief   : ESP32 environment sensors Application
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *
+ * @note The sampler queues one burst read per sensor and period on the I2C bus,
+ *       the conversion runs in the completion callback and feeds the telemetry.
+ *****************************************************************************
+ */
+
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "hal/cpu_hal.h"
+
+#include "sht3x.h"
+#include "bmp280.h"
+
+#include "user_esp32_i2c.h"
+#include "user_esp32_sampler.h"
+#include "user_esp32_telemetry.h"
+#include "user_esp32_environment.h"
+
+/** @brief Environment sensor addresses. */
+#define ENVIRONMENT_SHT3X_ADDRESS       SHT3X_I2C_ADDRESS_LOW
+#define ENVIRONMENT_BMP280_ADDRESS      BMP280_I2C_ADDRESS_LOW
+
+/** @brief Sampling period and phases, the phases keep the two reads apart on the bus. */
+#define ENVIRONMENT_SAMPLE_PERIOD_MS    (2000U)
+#define ENVIRONMENT_SHT3X_PHASE_MS      (250U)
+#define ENVIRONMENT_BMP280_PHASE_MS     (1250U)
+
+/** @brief Time the SHT3x needs after a break before it takes the next command. */
+#define ENVIRONMENT_SHT3X_BREAK_MS      (1U)
+
+/** @brief I2C transaction priority and deadline of the sensor reads. */
+#define ENVIRONMENT_I2C_PRIORITY        (1U)
+#define ENVIRONMENT_I2C_TIMEOUT_MS      (500U)
+
+/** @brief Environment sensor read state. */
+typedef struct
+{
+    user_i2c_transaction_t trans;   /* Burst read transaction. */
+    uint8_t data[8];                /* Burst read buffer. */
+    volatile bool busy;             /* When set, means the transaction is queued. */
+    user_environment_stats_t stats; /* Sensor statistics. */
+} environment_sensor_state_t;
+
+/** @brief log output label. */
+static const char *TAG = "Environment Application";
+
+/** @brief Read state of every environment sensor. */
+static environment_sensor_state_t environment_sensors[USER_ENVIRONMENT_SENSOR_MAX];
+
+/** @brief BMP280 calibration, read once at initialization. */
+static bmp280_calib_t environment_bmp280_calib;
+
+/** @brief BMP280 burst read start register. */
+static const uint8_t environment_bmp280_data_reg = BMP280_REG_DATA;
+
+/** @brief Environment sensor statistics lock. */
+static portMUX_TYPE environment_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief  Account a conversion of a sensor.
+ */
+static void environment_account(environment_sensor_state_t *sensor, esp_err_t ret, uint32_t cycles)
+{
+    portENTER_CRITICAL(&environment_lock);
+    if (ret == ESP_OK)
+    {
+        sensor->stats.reads++;
+        sensor->stats.last_cycles = cycles;
+        if (cycles > sensor->stats.max_cycles)
+        {
+            sensor->stats.max_cycles = cycles;
+        }
+    }
+    else
+    {
+        sensor->stats.errors++;
+    }
+    portEXIT_CRITICAL(&environment_lock);
+}
+/**
+ * @brief  SHT3x fetch completion, runs in the I2C bus task.
+ */
+static void environment_sht3x_done(user_i2c_transaction_t *trans, void *arg)
+{
+    environment_sensor_state_t *sensor = (environment_sensor_state_t *)arg;
+    esp_err_t ret = trans->result;
+    uint32_t cycles = 0;
+    sht3x_data_t data;
+
+    if (ret == ESP_OK)
+    {
+        uint32_t start = cpu_hal_get_cycle_count();
+        ret = sht3x_decode(sensor->data, &data);
+        cycles = cpu_hal_get_cycle_count() - start;
+    }
+
+    if (ret == ESP_OK)
+    {
+        user_esp32_telemetry_update(USER_TELEMETRY_ENVM_TEMP1, data.temperature);
+        user_esp32_telemetry_update(USER_TELEMETRY_ENVM_HUMI1, data.humidity);
+    }
+
+    environment_account(sensor, ret, cycles);
+    sensor->busy = false;
+}
+/**
+ * @brief  BMP280 burst read completion, runs in the I2C bus task.
+ */
+static void environment_bmp280_done(user_i2c_transaction_t *trans, void *arg)
+{
+    environment_sensor_state_t *sensor = (environment_sensor_state_t *)arg;
+    esp_err_t ret = trans->result;
+    uint32_t cycles = 0;
+    bmp280_data_t data;
+
+    if (ret == ESP_OK)
+    {
+        uint32_t start = cpu_hal_get_cycle_count();
+        ret = bmp280_decode(&environment_bmp280_calib, sensor->data, &data);
+        cycles = cpu_hal_get_cycle_count() - start;
+    }
+
+    if (ret == ESP_OK)
+    {
+        user_esp32_telemetry_update(USER_TELEMETRY_ENVM_TMOS1, (int32_t)data.pressure);
+    }
+
+    environment_account(sensor, ret, cycles);
+    sensor->busy = false;
+}
+/**
+ * @brief  Sampling callback, queues the burst read of a sensor without blocking.
+ * 
+ * @param arg[IN] Sensor read state.
+ */
+static void environment_sample(void *arg)
+{
+    environment_sensor_state_t *sensor = (environment_sensor_state_t *)arg;
+
+    if (sensor->busy)
+    {
+        portENTER_CRITICAL(&environment_lock);
+        sensor->stats.busy++;
+        portEXIT_CRITICAL(&environment_lock);
+        return;
+    }
+
+    sensor->busy = true;
+    if (user_esp32_i2c_submit(&sensor->trans) != ESP_OK)
+    {
+        sensor->busy = false;
+        environment_account(sensor, ESP_FAIL, 0);
+    }
+}
+/**
+ * @brief  Start the SHT3x periodic mode and register its sampling channel.
+ * 
+ * @note After a warm restart the sensor may still run the periodic mode, where
+ *       it ignores any command but fetch and break, so a break goes first.
+ */
+static esp_err_t environment_sht3x_init(void)
+{
+    environment_sensor_state_t *sensor = &environment_sensors[USER_ENVIRONMENT_SHT3X];
+
+    /* The result does not matter, an idle sensor has nothing to stop. */
+    user_esp32_i2c_transfer(ENVIRONMENT_SHT3X_ADDRESS, sht3x_cmd_break, SHT3X_COMMAND_LENGTH, NULL, 0, ENVIRONMENT_I2C_TIMEOUT_MS);
+    /* One tick more, so the wait is at least the break time whatever the tick phase. */
+    vTaskDelay(pdMS_TO_TICKS(ENVIRONMENT_SHT3X_BREAK_MS) + 1);
+
+    esp_err_t ret = user_esp32_i2c_transfer(ENVIRONMENT_SHT3X_ADDRESS, sht3x_cmd_periodic_1mps_high, SHT3X_COMMAND_LENGTH,
+                                            NULL, 0, ENVIRONMENT_I2C_TIMEOUT_MS);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+
+    sensor->trans = (user_i2c_transaction_t){
+        .address = ENVIRONMENT_SHT3X_ADDRESS,
+        .priority = ENVIRONMENT_I2C_PRIORITY,
+        .write_buf = sht3x_cmd_fetch_data,
+        .write_len = SHT3X_COMMAND_LENGTH,
+        .read_buf = sensor->data,
+        .read_len = SHT3X_DATA_LENGTH,
+        .timeout_ms = ENVIRONMENT_I2C_TIMEOUT_MS,
+        .callback = environment_sht3x_done,
+        .arg = sensor,
+    };
+
+    return user_esp32_sampler_register(ENVIRONMENT_SAMPLE_PERIOD_MS, ENVIRONMENT_SHT3X_PHASE_MS,
+                                       environment_sample, sensor, NULL);
+}
+/**
+ * @brief  Read the BMP280 calibration, start its normal mode and register its sampling channel.
+ */
+static esp_err_t environment_bmp280_init(void)
+{
+    environment_sensor_state_t *sensor = &environment_sensors[USER_ENVIRONMENT_BMP280];
+    const uint8_t chip_id_reg = BMP280_REG_CHIP_ID;
+    const uint8_t calib_reg = BMP280_REG_CALIB;
+    uint8_t calib[BMP280_CALIB_LENGTH];
+    uint8_t chip_id = 0;
+
+    esp_err_t ret = user_esp32_i2c_transfer(ENVIRONMENT_BMP280_ADDRESS, &chip_id_reg, 1, &chip_id, 1, ENVIRONMENT_I2C_TIMEOUT_MS);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+
+    if ((chip_id != BMP280_CHIP_ID) && (chip_id != BME280_CHIP_ID))
+    {
+        ESP_LOGE(TAG, "Unknown pressure sensor chip id 0x%02x.", chip_id);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    ret = user_esp32_i2c_transfer(ENVIRONMENT_BMP280_ADDRESS, &calib_reg, 1, calib, sizeof(calib), ENVIRONMENT_I2C_TIMEOUT_MS);
+    if (ret == ESP_OK)
+    {
+        ret = bmp280_parse_calib(calib, &environment_bmp280_calib);
+    }
+
+    if (ret == ESP_OK)
+    {
+        ret = user_esp32_i2c_transfer(ENVIRONMENT_BMP280_ADDRESS, bmp280_setup, BMP280_SETUP_LENGTH, NULL, 0, ENVIRONMENT_I2C_TIMEOUT_MS);
+    }
+
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+
+    sensor->trans = (user_i2c_transaction_t){
+        .address = ENVIRONMENT_BMP280_ADDRESS,
+        .priority = ENVIRONMENT_I2C_PRIORITY,
+        .write_buf = &environment_bmp280_data_reg,
+        .write_len = 1,
+        .read_buf = sensor->data,
+        .read_len = BMP280_DATA_LENGTH,
+        .timeout_ms = ENVIRONMENT_I2C_TIMEOUT_MS,
+        .idempotent = true,
+        .callback = environment_bmp280_done,
+        .arg = sensor,
+    };
+
+    return user_esp32_sampler_register(ENVIRONMENT_SAMPLE_PERIOD_MS, ENVIRONMENT_BMP280_PHASE_MS,
+                                       environment_sample, sensor, NULL);
+}
+/**
+ * @brief  Initialize the environment sensors, requires the I2C bus and the sampler.
+ * 
+ * @note A missing sensor is logged and skipped, the other one keeps running.
+ * 
+ * @return - ESP_OK             succeed
+ *         - ESP_ERR_NOT_FOUND  no sensor answered
+ */
+esp_err_t user_esp32_environment_init(void)
+{
+    esp_err_t sht3x_ret = environment_sht3x_init();
+    if (sht3x_ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "SHT3x initialization failed: %s", esp_err_to_name(sht3x_ret));
+    }
+
+    esp_err_t bmp280_ret = environment_bmp280_init();
+    if (bmp280_ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "BMP280 initialization failed: %s", esp_err_to_name(bmp280_ret));
+    }
+
+    return ((sht3x_ret == ESP_OK) || (bmp280_ret == ESP_OK)) ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+/**
+ * @brief  Get the statistics of an environment sensor.
+ * 
+ * @param sensor[IN] Environment sensor.
+ * @param stats[OUT] Sensor statistics, including the conversion cost in CPU cycles.
+ * 
+ * @return - ESP_OK              succeed
+ *         - ESP_ERR_INVALID_ARG unknown sensor
+ */
+esp_err_t user_esp32_environment_get_stats(user_environment_sensor_t sensor, user_environment_stats_t *stats)
+{
+    if ((sensor >= USER_ENVIRONMENT_SENSOR_MAX) || (stats == NULL))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&environment_lock);
+    *stats = environment_sensors[sensor].stats;
+    portEXIT_CRITICAL(&environment_lock);
+
+    return ESP_OK;
+}
+/******************************** End of File *********************************/
@@ -0,0 +1,280 @@
+/**
+ *****************************************************************************
+ * @file    : user_esp32_fan.c
+ * @brief   : ESP32 closed-loop fan speed Application
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *
+ * @note The tachometer is counted by the PCNT peripheral, no GPIO interrupt
+ *       per pulse. A sampler channel reads the count, runs the PI controller
+ *       and hands the duty to the LEDC fade engine. The measured speed is
+ *       published on PUB_FAN_SPEED1 by exception.
+ *****************************************************************************
+ */
+
+#include "freertos/FreeRTOS.h"
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "driver/pcnt.h"
+#include "hal/cpu_hal.h"
+
+#include "user_fan_control.h"
+#include "user_esp32_pwm.h"
+#include "user_esp32_sampler.h"
+#include "user_esp32_hardware.h"
+#include "user_esp32_mqtt.h"
+#include "user_esp32_codec.h"
+#include "user_esp32_telemetry.h"
+#include "user_esp32_fan.h"
+
+/** @brief Tachometer input, open collector with an external pull-up (GPIO34 has no internal one). */
+#define FAN_TACH_GPIO                   GPIO_NUM_34
+#define FAN_TACH_PCNT_UNIT              PCNT_UNIT_0
+#define FAN_TACH_PULSES_PER_REV         (2U)
+
+/** @brief The counter wraps to 0 at this limit, far above the pulses of one period. */
+#define FAN_TACH_COUNTER_LIMIT          (32000)
+
+/** @brief Glitch filter in APB cycles, 1000 / 80MHz = 12.5us. */
+#define FAN_TACH_FILTER_CYCLES          (1000U)
+
+/** @brief Controller period and phase on the sampler. */
+#define FAN_CONTROL_PERIOD_MS           (1000U)
+#define FAN_CONTROL_PHASE_MS            (500U)
+
+/** @brief Duty ramp of a controller update, shorter than the period. */
+#define FAN_CONTROL_RAMP_MS             (200U)
+
+/** @brief PI gains, duty (1/1000) per RPM of error. */
+#define FAN_CONTROL_KP                  FAN_CONTROL_GAIN(0.2)
+#define FAN_CONTROL_KI                  FAN_CONTROL_GAIN(0.2)
+
+/** @brief Measured speed report-by-exception on PUB_FAN_SPEED1, see user_telemetry_filter_t. */
+#define FAN_REPORT_DEADBAND_RPM         (50U)
+#define FAN_REPORT_MIN_INTERVAL_MS      (5 * 1000U)
+#define FAN_REPORT_MAX_SILENCE_MS       (5 * 60 * 1000U)
+
+/** @brief Speed report payload buffer length. */
+#define FAN_REPORT_PAYLOAD_MAX_LENGTH   (16U)
+
+/** @brief log output label. */
+static const char *TAG = "Fan Application";
+
+/** @brief Fan1 speed controller, only used in the sampler task. */
+static fan_control_pi_t fan_pi;
+static int16_t fan_tach_last_count = 0;
+static int64_t fan_tach_last_us = 0;
+
+/** @brief Last reported speed, only used in the sampler task. */
+static uint32_t fan_report_rpm = 0;
+static int64_t fan_report_us = 0;
+static bool fan_reported = false;
+
+/** @brief Requested speed, written by any task. */
+static volatile uint32_t fan_target_rpm = 0;
+
+/** @brief Fan statistics. */
+static user_fan_stats_t fan_stats;
+static portMUX_TYPE fan_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief  Count the tachometer pulses since the previous call.
+ * 
+ * @param interval_ms[OUT] Time since the previous call.
+ * 
+ * @return Pulses.
+ */
+static uint32_t fan_tach_read(uint32_t *interval_ms)
+{
+    int16_t count = 0;
+    int64_t now_us = esp_timer_get_time();
+    int32_t pulses = 0;
+
+    pcnt_get_counter_value(FAN_TACH_PCNT_UNIT, &count);
+
+    /* The counter keeps running, so no pulse is lost between reading and clearing it. */
+    pulses = (int32_t)count - fan_tach_last_count;
+    if (pulses < 0)
+    {
+        pulses += FAN_TACH_COUNTER_LIMIT;
+    }
+
+    *interval_ms = (uint32_t)((now_us - fan_tach_last_us) / 1000);
+    fan_tach_last_count = count;
+    fan_tach_last_us = now_us;
+
+    return (uint32_t)pulses;
+}
+/**
+ * @brief  Publish the measured speed when it moved by the dead-band, or as a heartbeat.
+ * 
+ * @param rpm[IN] Measured speed.
+ */
+static void fan_speed_report(uint32_t rpm)
+{
+    char payload[FAN_REPORT_PAYLOAD_MAX_LENGTH];
+    int64_t now_us = esp_timer_get_time();
+    uint32_t elapsed_ms = (uint32_t)((now_us - fan_report_us) / 1000);
+    uint32_t delta = (rpm > fan_report_rpm) ? (rpm - fan_report_rpm) : (fan_report_rpm - rpm);
+    int len = 0;
+
+    if (fan_reported && (elapsed_ms < FAN_REPORT_MAX_SILENCE_MS) &&
+        ((elapsed_ms < FAN_REPORT_MIN_INTERVAL_MS) || (delta < FAN_REPORT_DEADBAND_RPM)))
+    {
+        return;
+    }
+
+    /* Offline, the first sample after the connection is reported. */
+    if (!user_esp32_mqtt_is_connected())
+    {
+        return;
+    }
+
+    len = user_esp32_codec_encode_value(payload, sizeof(payload), (int32_t)rpm * USER_TELEMETRY_SCALE);
+    if ((len <= 0) || (user_esp32_mqtt_publish(PUB_FAN_SPEED1, payload, len) == -1))
+    {
+        return;
+    }
+
+    fan_report_rpm = rpm;
+    fan_report_us = now_us;
+    fan_reported = true;
+}
+/**
+ * @brief  Fan speed control, runs in the sampler task.
+ * 
+ * @param arg[IN] Unused.
+ */
+static void fan_control_sample(void *arg)
+{
+    uint32_t start = cpu_hal_get_cycle_count();
+    uint32_t target = fan_target_rpm;
+    uint32_t interval_ms = 0;
+    uint32_t pulses = fan_tach_read(&interval_ms);
+    uint32_t rpm = fan_control_tach_rpm(pulses, interval_ms, FAN_TACH_PULSES_PER_REV);
+    int32_t duty = 0;
+    uint32_t cycles = 0;
+    bool powered = true;
+
+    /* With the relay off the fan can not follow, the integral would wind up to full duty. */
+    user_esp32_hardware_get_output(USER_HARDWARE_OUTPUT_FAN1, &powered);
+
+    if ((target == 0) || !powered)
+    {
+        fan_control_pi_reset(&fan_pi, 0);
+    }
+    else
+    {
+        duty = fan_control_pi_update(&fan_pi, (int32_t)target, (int32_t)rpm);
+    }
+
+    user_esp32_pwm_set_duty(USER_PWM_FAN1, (uint32_t)duty, FAN_CONTROL_RAMP_MS, NULL, NULL);
+
+    cycles = cpu_hal_get_cycle_count() - start;
+
+    portENTER_CRITICAL(&fan_lock);
+    fan_stats.target_rpm = target;
+    fan_stats.rpm = rpm;
+    fan_stats.duty = (uint32_t)duty;
+    fan_stats.updates++;
+    fan_stats.last_cycles = cycles;
+    if (cycles > fan_stats.max_cycles)
+    {
+        fan_stats.max_cycles = cycles;
+    }
+    portEXIT_CRITICAL(&fan_lock);
+
+    fan_speed_report(rpm);
+}
+/**
+ * @brief  Initialize the tachometer counter and the fan speed controller, fan stopped.
+ * 
+ * @return - ESP_OK   succeed
+ *         - other    failed
+ */
+esp_err_t user_esp32_fan_init(void)
+{
+    esp_err_t ret = ESP_OK;
+    pcnt_config_t pcnt_config = {
+        .pulse_gpio_num = FAN_TACH_GPIO,
+        .ctrl_gpio_num = PCNT_PIN_NOT_USED,
+        .lctrl_mode = PCNT_MODE_KEEP,
+        .hctrl_mode = PCNT_MODE_KEEP,
+        .pos_mode = PCNT_COUNT_INC,   /* Count rising edges. */
+        .neg_mode = PCNT_COUNT_DIS,
+        .counter_h_lim = FAN_TACH_COUNTER_LIMIT,
+        .counter_l_lim = 0,
+        .unit = FAN_TACH_PCNT_UNIT,
+        .channel = PCNT_CHANNEL_0,
+    };
+
+    ret = pcnt_unit_config(&pcnt_config);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "PCNT config failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    pcnt_set_filter_value(FAN_TACH_PCNT_UNIT, FAN_TACH_FILTER_CYCLES);
+    pcnt_filter_enable(FAN_TACH_PCNT_UNIT);
+    pcnt_counter_pause(FAN_TACH_PCNT_UNIT);
+    pcnt_counter_clear(FAN_TACH_PCNT_UNIT);
+    pcnt_counter_resume(FAN_TACH_PCNT_UNIT);
+
+    fan_tach_last_count = 0;
+    fan_tach_last_us = esp_timer_get_time();
+    fan_control_pi_init(&fan_pi, FAN_CONTROL_KP, FAN_CONTROL_KI, 0, USER_PWM_DUTY_MAX);
+
+    ret = user_esp32_sampler_register(FAN_CONTROL_PERIOD_MS, FAN_CONTROL_PHASE_MS, fan_control_sample, NULL, NULL);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Sampler register failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    return ESP_OK;
+}
+/**
+ * @brief  Set the fan speed target, applied at the next controller update.
+ * 
+ * @param rpm[IN] Target speed, 0 stops the fan.
+ * 
+ * @return - ESP_OK              succeed
+ *         - ESP_ERR_INVALID_ARG above USER_FAN_RATED_RPM
+ */
+esp_err_t user_esp32_fan_set_target_rpm(uint32_t rpm)
+{
+    if (rpm > USER_FAN_RATED_RPM)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    fan_target_rpm = rpm;
+
+    return ESP_OK;
+}
+/**
+ * @brief  Get the fan speed controller statistics.
+ * 
+ * @param stats[OUT] Statistics.
+ * 
+ * @return - ESP_OK              succeed
+ *         - ESP_ERR_INVALID_ARG stats is NULL
+ */
+esp_err_t user_esp32_fan_get_stats(user_fan_stats_t *stats)
+{
+    if (stats == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&fan_lock);
+    *stats = fan_stats;
+    portEXIT_CRITICAL(&fan_lock);
+
+    return ESP_OK;
+}
+/******************************** End of File *********************************/
@@ -5,19 +5,124 @@
  * @author  : Cao Jin
  * @date    : 21-Oct-2021
  * @version : 1.0.0
+ *
+ * @note The relay and valve outputs live in a shadow bitmap. Requests only
+ *       flip bits atomically, the sampler flushes the whole image to the
+ *       sn74hc595 chain with one latch per tick and only when it changed.
  *****************************************************************************
  */
 
+#include <string.h>
+
 #include "esp_err.h"
 #include "esp_log.h"
 
+#include "74hc595.h"
+#include "user_esp32_sampler.h"
 #include "user_esp32_hardware.h"
 
+/** @brief Shadow bitmap size in 32-bit words. */
+#define HARDWARE_OUTPUT_WORDS               ((USER_HARDWARE_SN74HC595_CHAIN_LENGTH * 8U + 31U) / 32U)
+
+_Static_assert(USER_HARDWARE_OUTPUT_MAX <= USER_HARDWARE_SN74HC595_CHAIN_LENGTH * 8U, "sn74hc595 chain too short for the outputs");
+
+/** @brief log output label. */
+static const char *TAG = "HARDWARE";
+
+/** @brief Requested output state, one bit per sn74hc595 output. */
+static uint32_t hardware_output_shadow[HARDWARE_OUTPUT_WORDS];
+
+/** @brief Image latched into the chain by the last successful flush. */
+static uint8_t hardware_output_latched[USER_HARDWARE_SN74HC595_CHAIN_LENGTH];
+
+/** @brief Requests applied to the shadow since the last flush. */
+static uint32_t hardware_output_pending = 0;
+
+/** @brief Output statistics, see user_hardware_output_stats_t. */
+static uint32_t hardware_output_requests = 0;
+static uint32_t hardware_output_writes = 0;
+static uint32_t hardware_output_coalesced = 0;
+static uint32_t hardware_output_errors = 0;
+
+/**
+ * @brief  Flush the shadow bitmap to the sn74hc595 chain, runs in the sampler task once per tick.
+ * 
+ * @param arg[IN] Unused.
+ */
+static void hardware_output_flush(void *arg)
+{
+    uint8_t image[USER_HARDWARE_SN74HC595_CHAIN_LENGTH];
+    uint32_t pending = 0;
+    uint32_t word = 0;
+
+    pending = __atomic_exchange_n(&hardware_output_pending, 0, __ATOMIC_ACQ_REL);
+    if (pending == 0)
+    {
+        return;
+    }
 
+    for (size_t i = 0; i < sizeof(image); i++)
+    {
+        if ((i % 4) == 0)
+        {
+            word = __atomic_load_n(&hardware_output_shadow[i / 4], __ATOMIC_ACQUIRE);
+        }
+        image[i] = (uint8_t)(word >> ((i % 4) * 8));
+    }
+
+    /* Redundant requests or changes that cancelled out, the chain already holds this image. */
+    if (memcmp(image, hardware_output_latched, sizeof(image)) == 0)
+    {
+        __atomic_fetch_add(&hardware_output_coalesced, pending, __ATOMIC_RELAXED);
+        return;
+    }
+
+    if (sn74hc595_send_data(image, sizeof(image)) != ESP_OK)
+    {
+        /* Keep the requests pending, the next tick tries again. */
+        __atomic_fetch_add(&hardware_output_pending, pending, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&hardware_output_errors, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    memcpy(hardware_output_latched, image, sizeof(image));
+    __atomic_fetch_add(&hardware_output_writes, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&hardware_output_coalesced, pending - 1, __ATOMIC_RELAXED);
+}
+/**
+ * @brief  Initialize the sn74hc595 chain and the output state manager, all outputs off.
+ * 
+ * @return - ESP_OK   succeed
+ *         - other    failed
+ */
 esp_err_t user_esp32_hardware_init(void)
 {
-    /* Initialize sn74hc595. */
-    
+    esp_err_t ret = ESP_OK;
+
+    /* Initialize sn74hc595, all relays and valves off. */
+    ret = sn74hc595_init(USER_HARDWARE_SN74HC595_CHAIN_LENGTH);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "sn74hc595 init failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    memset(hardware_output_shadow, 0, sizeof(hardware_output_shadow));
+    memset(hardware_output_latched, 0, sizeof(hardware_output_latched));
+
+    ret = sn74hc595_send_data(hardware_output_latched, sizeof(hardware_output_latched));
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "sn74hc595 clear failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    ret = user_esp32_sampler_register(USER_HARDWARE_OUTPUT_FLUSH_PERIOD_MS, 0, hardware_output_flush, NULL, NULL);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Output flush register failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
 
     return ESP_OK;
 }
@@ -26,4 +131,80 @@ esp_err_t user_esp32_hardware_deinit(void)
 {
     return ESP_OK;
 }
+/**
+ * @brief  Request an output state, applied at the next flush. Safe from any task.
+ * 
+ * @param output[IN] Output.
+ * @param on[IN] true: energized, false: released.
+ * 
+ * @return - ESP_OK              succeed
+ *         - ESP_ERR_INVALID_ARG unknown output
+ */
+esp_err_t user_esp32_hardware_set_output(user_hardware_output_t output, bool on)
+{
+    uint32_t mask = 0;
+
+    if ((unsigned)output >= USER_HARDWARE_OUTPUT_MAX)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    mask = 1UL << (output % 32);
+
+    if (on)
+    {
+        __atomic_fetch_or(&hardware_output_shadow[output / 32], mask, __ATOMIC_RELEASE);
+    }
+    else
+    {
+        __atomic_fetch_and(&hardware_output_shadow[output / 32], ~mask, __ATOMIC_RELEASE);
+    }
+
+    __atomic_fetch_add(&hardware_output_requests, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&hardware_output_pending, 1, __ATOMIC_RELEASE);
+
+    return ESP_OK;
+}
+/**
+ * @brief  Get the requested state of an output.
+ * 
+ * @param output[IN] Output.
+ * @param on[OUT] Requested state, may not be latched yet.
+ * 
+ * @return - ESP_OK              succeed
+ *         - ESP_ERR_INVALID_ARG unknown output or on is NULL
+ */
+esp_err_t user_esp32_hardware_get_output(user_hardware_output_t output, bool *on)
+{
+    if (((unsigned)output >= USER_HARDWARE_OUTPUT_MAX) || (on == NULL))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *on = (__atomic_load_n(&hardware_output_shadow[output / 32], __ATOMIC_ACQUIRE) & (1UL << (output % 32))) != 0;
 
+    return ESP_OK;
+}
+/**
+ * @brief  Get the output state manager statistics.
+ * 
+ * @param stats[OUT] Statistics.
+ * 
+ * @return - ESP_OK              succeed
+ *         - ESP_ERR_INVALID_ARG stats is NULL
+ */
+esp_err_t user_esp32_hardware_get_output_stats(user_hardware_output_stats_t *stats)
+{
+    if (stats == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    stats->requests = __atomic_load_n(&hardware_output_requests, __ATOMIC_RELAXED);
+    stats->writes = __atomic_load_n(&hardware_output_writes, __ATOMIC_RELAXED);
+    stats->coalesced = __atomic_load_n(&hardware_output_coalesced, __ATOMIC_RELAXED);
+    stats->errors = __atomic_load_n(&hardware_output_errors, __ATOMIC_RELAXED);
+
+    return ESP_OK;
+}
+/******************************** End of File *********************************/
@@ -5,11 +5,20 @@
  * @author  : Cao Jin
  * @date    : 20-Oct-2021
  * @version : 1.0.0
+ *
+ * @note One owner task runs every transaction of the bus, sensor drivers
+ *       submit descriptors and get a completion callback.
  *****************************************************************************
  */
 
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
 #include "esp_err.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 
 #include "driver/i2c.h"
 #include "driver/gpio.h"
@@ -21,8 +30,144 @@
 #define DEFAULT_ESP32_I2C_SDA           GPIO_NUM_22           
 #define DEFAULT_ESP32_I2C_SCL           GPIO_NUM_23
 #define DEFAULT_ESP32_I2C_FREQ_HZ       (400000U)
-#define DEFAULT_ESP32_I2C_TIMEOUT_MS    (1000U)
+#define DEFAULT_ESP32_I2C_TIMEOUT_MS    (100U)
+
+/** @brief FreeRTOS I2C bus owner task configuration. */
+#define I2C_TASK_STACK_DEPTH            (3 * 1024U)
+#define I2C_TASK_PRIORITY               (6U)
+
+/** @brief Number of submitted transactions waiting for the owner task. */
+#define I2C_SUBMIT_QUEUE_LENGTH         (16U)
+
+/** @brief Completion state of a synchronous transfer. */
+typedef struct
+{
+    TaskHandle_t task;  /* Waiting task. */
+    volatile bool done; /* When set, means the transaction completed. */
+} i2c_sync_t;
+
+/** @brief log output label. */
+static const char *TAG = "I2C Application";
+
+/** @brief I2C transaction scheduler, only used by the owner task. */
+static user_i2c_bus_t i2c_bus;
+
+/** @brief Transactions submitted to the owner task. */
+static QueueHandle_t i2c_submit_queue = NULL;
+static StaticQueue_t i2c_submit_queue_buffer;
+static uint8_t i2c_submit_queue_storage[I2C_SUBMIT_QUEUE_LENGTH * sizeof(user_i2c_transaction_t *)];
+
+/** @brief Statistics lock, held by the owner task while it updates the scheduler. */
+static SemaphoreHandle_t i2c_stats_mutex = NULL;
+static StaticSemaphore_t i2c_stats_mutex_buffer;
+
+/** @brief I2C bus owner task handle. */
+static TaskHandle_t i2c_task_handle = NULL;
+
+/**
+ * @brief  Microsecond clock of the transaction scheduler.
+ */
+static uint32_t i2c_clock(void *ctx)
+{
+    return (uint32_t)esp_timer_get_time();
+}
+/**
+ * @brief  Run a batch of transactions as one command link, repeated start between them.
+ * 
+ * @note The driver does not report which command of the link failed, so on failure
+ *       no transaction is known to have completed.
+ * 
+ * @param ctx[IN] I2C port.
+ * @param batch[IN] Transactions.
+ * @param count[IN] Number of transactions.
+ * @param done[OUT] Number of leading transactions known to have completed on failure.
+ * 
+ * @return - ESP_OK succeed
+ *         - others failed
+ */
+static esp_err_t i2c_transfer(void *ctx, user_i2c_transaction_t *const *batch, int count, int *done)
+{
+    i2c_port_t i2c_port = (i2c_port_t)(intptr_t)ctx;
+    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
+
+    *done = 0;
+    if (cmd == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        const user_i2c_transaction_t *trans = batch[i];
+
+        if ((trans->write_len > 0) || (trans->read_len == 0))
+        {
+            i2c_master_start(cmd);
+            i2c_master_write_byte(cmd, (trans->address << 1) | I2C_MASTER_WRITE, true);
+            if (trans->write_len > 0)
+            {
+                i2c_master_write(cmd, trans->write_buf, trans->write_len, true);
+            }
+        }
+
+        if (trans->read_len > 0)
+        {
+            i2c_master_start(cmd);
+            i2c_master_write_byte(cmd, (trans->address << 1) | I2C_MASTER_READ, true);
+            i2c_master_read(cmd, trans->read_buf, trans->read_len, I2C_MASTER_LAST_NACK);
+        }
+    }
+    i2c_master_stop(cmd);
+
+    esp_err_t ret = i2c_master_cmd_begin(i2c_port, cmd, pdMS_TO_TICKS(DEFAULT_ESP32_I2C_TIMEOUT_MS));
+    i2c_cmd_link_delete(cmd);
+
+    return ret;
+}
+/**
+ * @brief  I2C bus owner task, moves the submitted transactions to the scheduler and runs them.
+ * 
+ * @param arg[IN] The parameter of the task.
+ */
+static void i2c_task(void *arg)
+{
+    user_i2c_transaction_t *trans = NULL;
+
+    while (1)
+    {
+        TickType_t wait = (i2c_bus.head == NULL) ? portMAX_DELAY : 0;
+        BaseType_t received = xQueueReceive(i2c_submit_queue, &trans, wait);
+
+        xSemaphoreTake(i2c_stats_mutex, portMAX_DELAY);
+        while (received == pdTRUE)
+        {
+            user_i2c_bus_submit(&i2c_bus, trans);
+            received = xQueueReceive(i2c_submit_queue, &trans, 0);
+        }
+        user_i2c_bus_process(&i2c_bus);
+        xSemaphoreGive(i2c_stats_mutex);
+    }
+}
+/**
+ * @brief  Completion callback of a synchronous transfer.
+ * 
+ * @note Once done is set the waiter may return and release sync and trans, so
+ *       nothing of them is read afterwards.
+ */
+static void i2c_sync_done(user_i2c_transaction_t *trans, void *arg)
+{
+    i2c_sync_t *sync = (i2c_sync_t *)arg;
+    TaskHandle_t task = sync->task;
 
+    sync->done = true;
+    xTaskNotifyGive(task);
+}
+/**
+ * @brief  Initialize the I2C master and its bus owner task.
+ * 
+ * @return - ESP_OK   succeed
+ *         - others   failed
+ */
 esp_err_t user_esp32_i2c_init(void)
 {
     i2c_port_t i2c_port = DEFAULT_ESP32_I2C_NUM;
@@ -35,7 +180,163 @@ esp_err_t user_esp32_i2c_init(void)
         .master.clk_speed = DEFAULT_ESP32_I2C_FREQ_HZ,
     };
 
+    if (i2c_task_handle != NULL)
+    {
+        return ESP_OK;
+    }
+
     i2c_param_config(i2c_port, &i2c_config);
 
-    return i2c_driver_install(i2c_port, i2c_config.mode, 0, 0, 0);
-}
\ No newline at end of file
+    esp_err_t ret = i2c_driver_install(i2c_port, i2c_config.mode, 0, 0, 0);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "I2C driver install failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    user_i2c_bus_init(&i2c_bus, i2c_transfer, i2c_clock, (void *)(intptr_t)i2c_port);
+    i2c_stats_mutex = xSemaphoreCreateMutexStatic(&i2c_stats_mutex_buffer);
+    i2c_submit_queue = xQueueCreateStatic(I2C_SUBMIT_QUEUE_LENGTH, sizeof(user_i2c_transaction_t *),
+                                          i2c_submit_queue_storage, &i2c_submit_queue_buffer);
+
+    BaseType_t uxBits = xTaskCreate(i2c_task,                      /* Pointer to the task entry function. */
+                                    "I2C bus task",                /* Descriptive name for the task. */
+                                    I2C_TASK_STACK_DEPTH,          /* The size of the task stack specified as the number of bytes. */
+                                    NULL,                          /* Pointer that will be used as the parameter for the task being created. */
+                                    I2C_TASK_PRIORITY,             /* The priority at which the task should run. */
+                                    &i2c_task_handle);             /* Used to pass back a handle by which the created task can be referenced. */
+    if (uxBits != pdPASS)
+    {
+        ESP_LOGE(TAG, "I2C bus task creation failed.");
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+/**
+ * @brief  Submit a transaction to the bus owner task, does not block.
+ * 
+ * @note The descriptor must stay valid until its callback runs in the bus owner task.
+ * 
+ * @param trans[IN] Transaction descriptor.
+ * 
+ * @return - ESP_OK                 succeed
+ *         - ESP_ERR_INVALID_STATE  the bus is not initialized
+ *         - ESP_ERR_INVALID_ARG    invalid descriptor
+ *         - ESP_ERR_NO_MEM         the submit queue is full
+ */
+esp_err_t user_esp32_i2c_submit(user_i2c_transaction_t *trans)
+{
+    if (i2c_submit_queue == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if ((trans == NULL) || ((trans->write_len > 0) && (trans->write_buf == NULL)) || ((trans->read_len > 0) && (trans->read_buf == NULL)))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (xQueueSend(i2c_submit_queue, &trans, 0) != pdTRUE)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    return ESP_OK;
+}
+/**
+ * @brief  Run a transaction and wait for its completion.
+ * 
+ * @note Uses the task notification of the calling task, do not call it from the
+ *       sampler or the bus owner task.
+ * 
+ * @param address[IN] 7-bit device address.
+ * @param write_buf[IN] Bytes to write.
+ * @param write_len[IN] Number of bytes to write.
+ * @param read_buf[OUT] Buffer of the bytes read.
+ * @param read_len[IN] Number of bytes to read.
+ * @param timeout_ms[IN] Deadline of the transaction.
+ * 
+ * @return - ESP_OK           succeed
+ *         - ESP_ERR_TIMEOUT  the deadline passed before the transaction ran
+ *         - others           failed
+ */
+esp_err_t user_esp32_i2c_transfer(uint8_t address, const uint8_t *write_buf, size_t write_len,
+                                  uint8_t *read_buf, size_t read_len, uint32_t timeout_ms)
+{
+    i2c_sync_t sync = {
+        .task = xTaskGetCurrentTaskHandle(),
+        .done = false,
+    };
+    user_i2c_transaction_t trans = {
+        .address = address,
+        .write_buf = write_buf,
+        .write_len = write_len,
+        .read_buf = read_buf,
+        .read_len = read_len,
+        .timeout_ms = timeout_ms,
+        .callback = i2c_sync_done,
+        .arg = &sync,
+    };
+
+    esp_err_t ret = user_esp32_i2c_submit(&trans);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+
+    while (!sync.done)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+
+    return trans.result;
+}
+/**
+ * @brief  Get the bus statistics.
+ * 
+ * @param stats[OUT] Bus statistics.
+ * 
+ * @return - ESP_OK                 succeed
+ *         - ESP_ERR_INVALID_STATE  the bus is not initialized
+ */
+esp_err_t user_esp32_i2c_get_stats(user_i2c_bus_stats_t *stats)
+{
+    if (i2c_stats_mutex == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(i2c_stats_mutex, portMAX_DELAY);
+    *stats = i2c_bus.stats;
+    xSemaphoreGive(i2c_stats_mutex);
+
+    return ESP_OK;
+}
+/**
+ * @brief  Get the latency histogram and the counters of a device.
+ * 
+ * @param address[IN] 7-bit device address.
+ * @param stats[OUT] Device statistics.
+ * 
+ * @return - ESP_OK                 succeed
+ *         - ESP_ERR_INVALID_STATE  the bus is not initialized
+ *         - ESP_ERR_NOT_FOUND      no transaction of the device completed yet
+ */
+esp_err_t user_esp32_i2c_get_device_stats(uint8_t address, user_i2c_device_stats_t *stats)
+{
+    if (i2c_stats_mutex == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(i2c_stats_mutex, portMAX_DELAY);
+    const user_i2c_device_stats_t *device = user_i2c_bus_get_device_stats(&i2c_bus, address);
+    if (device != NULL)
+    {
+        *stats = *device;
+    }
+    xSemaphoreGive(i2c_stats_mutex);
+
+    return (device != NULL) ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
@@ -0,0 +1,479 @@
+/**
+ *****************************************************************************
+ * @file    : user_esp32_irrigation.c
+ * @brief   : ESP32 local irrigation control Application
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ * 
+ * @note The soil moisture probes feed the irrigation controller directly, a
+ *       sample wakes the irrigation task which decides the valves and the pump
+ *       and hands them to the output shadow, latched within one flush period.
+ *       The cloud only sets the zone parameters, control goes on without it.
+ *       A manual valve or pump command takes that output over until local
+ *       control is resumed, the other zones stay under local control.
+ *****************************************************************************
+ */
+
+#include <string.h>
+#include <inttypes.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "hal/cpu_hal.h"
+
+#include "user_esp32_mqtt.h"
+#include "user_esp32_codec.h"
+#include "user_esp32_hardware.h"
+#include "user_esp32_irrigation.h"
+
+/** @brief FreeRTOS irrigation task configuration, above the modbus poll task that feeds it. */
+#define IRRIGATION_TASK_STACK_DEPTH         (3 * 1024U)
+#define IRRIGATION_TASK_PRIORITY            (5U)
+
+/** @brief The minimum and maximum times are checked this often between two samples. */
+#define IRRIGATION_TICK_MS                  (1000U)
+
+/** @brief Pump parameters, see irrigation_pump_config_t. */
+#define IRRIGATION_MAX_OPEN_ZONES           (2U)
+#define IRRIGATION_PUMP_MIN_OFF_MS          (30 * 1000U)
+#define IRRIGATION_SAMPLE_TIMEOUT_MS        (30 * 1000U)
+
+/** @brief NVS storage of the zone parameters, one blob of every zone. */
+#define IRRIGATION_NVS_NAMESPACE            "irrigation"
+#define IRRIGATION_NVS_KEY                  "zones"
+
+/** @brief Every output bit of irrigation_outputs(). */
+#define IRRIGATION_OUTPUT_MASK              (IRRIGATION_PUMP_BIT | (IRRIGATION_PUMP_BIT - 1))
+
+/** @brief State payload buffer length. */
+#define IRRIGATION_PAYLOAD_MAX_LENGTH       (8U)
+
+/** @brief log output label. */
+static const char *TAG = "Irrigation Application";
+
+/** @brief Output and state topic of every irrigation_outputs() bit. */
+static const user_hardware_output_t irrigation_hardware_outputs[IRRIGATION_MAX_ZONES + 1] = {
+    USER_HARDWARE_OUTPUT_VALVE1,
+    USER_HARDWARE_OUTPUT_VALVE2,
+    USER_HARDWARE_OUTPUT_VALVE3,
+    USER_HARDWARE_OUTPUT_PUMP1,
+};
+static const char *const irrigation_topics[IRRIGATION_MAX_ZONES + 1] = {
+    PUB_SWITCH_VALVE_STATE1,
+    PUB_SWITCH_VALVE_STATE2,
+    PUB_SWITCH_VALVE_STATE3,
+    PUB_PUMP_STATE1,
+};
+
+static const irrigation_pump_config_t irrigation_pump_config = {
+    .max_open_zones = IRRIGATION_MAX_OPEN_ZONES,
+    .pump_min_off_ms = IRRIGATION_PUMP_MIN_OFF_MS,
+    .sample_timeout_ms = IRRIGATION_SAMPLE_TIMEOUT_MS,
+};
+
+/**
+ * @brief Irrigation controller, evaluated by the irrigation task, fed by the modbus and MQTT tasks.
+ * 
+ * @note The controller outputs are requested with irrigation_mutex held, so a
+ *       manual command, which takes the mutex too, is never overwritten by a
+ *       decision made before it.
+ */
+static irrigation_t irrigation;
+static int64_t irrigation_sample_us = 0;
+static SemaphoreHandle_t irrigation_mutex = NULL;
+static StaticSemaphore_t irrigation_mutex_buffer;
+
+/** @brief Latch and publish every controller output at the next evaluation, they may have been moved manually. */
+static bool irrigation_resync = true;
+
+/** @brief Irrigation task handle. */
+static TaskHandle_t irrigation_task_handle = NULL;
+
+/** @brief Irrigation statistics. */
+static user_irrigation_stats_t irrigation_stats;
+static portMUX_TYPE irrigation_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief  Controller time base.
+ */
+static inline uint32_t irrigation_now_ms(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+/**
+ * @brief  Request the changed outputs, called with irrigation_mutex held.
+ * 
+ * @note Only the output shadow changes here, the next flush latches every bit
+ *       in one transfer, so the pump and the valves of one decision switch
+ *       at the same time.
+ * 
+ * @param changed[IN] Changed output bits.
+ * @param outputs[IN] Output bits.
+ */
+static void irrigation_apply(uint32_t changed, uint32_t outputs)
+{
+    for (uint32_t bit = 0; bit <= IRRIGATION_MAX_ZONES; bit++)
+    {
+        if (changed & (1UL << bit))
+        {
+            user_esp32_hardware_set_output(irrigation_hardware_outputs[bit], (outputs & (1UL << bit)) != 0);
+        }
+    }
+}
+/**
+ * @brief  Publish the changed outputs on their state topics, nothing is queued while offline.
+ * 
+ * @param changed[IN] Changed output bits.
+ * @param outputs[IN] Output bits.
+ */
+static void irrigation_publish(uint32_t changed, uint32_t outputs)
+{
+    char payload[IRRIGATION_PAYLOAD_MAX_LENGTH];
+    int len = 0;
+
+    for (uint32_t bit = 0; bit <= IRRIGATION_MAX_ZONES; bit++)
+    {
+        if (!(changed & (1UL << bit)))
+        {
+            continue;
+        }
+
+        len = user_esp32_codec_encode_switch(payload, sizeof(payload), (outputs & (1UL << bit)) != 0);
+        if ((len > 0) && (user_esp32_mqtt_publish(irrigation_topics[bit], payload, len) == -1))
+        {
+            ESP_LOGD(TAG, "Publish %s failed.", irrigation_topics[bit]);
+        }
+    }
+}
+/**
+ * @brief  Irrigation task, evaluates the controller on every sample and at least once per tick.
+ * 
+ * @param arg[IN] The parameter of the task.
+ */
+static void irrigation_task(void *arg)
+{
+    while (1)
+    {
+        uint32_t changed = 0;
+        uint32_t outputs = 0;
+        uint32_t start = 0;
+        uint32_t cycles = 0;
+        uint32_t latency_us = 0;
+        int64_t sample_us = 0;
+
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(IRRIGATION_TICK_MS));
+
+        start = cpu_hal_get_cycle_count();
+
+        /* The safety limits keep running for the zones left to the controller. */
+        xSemaphoreTake(irrigation_mutex, portMAX_DELAY);
+        changed = irrigation_evaluate(&irrigation, irrigation_now_ms());
+        outputs = irrigation_outputs(&irrigation);
+        if (irrigation_resync)
+        {
+            irrigation_resync = false;
+            changed = IRRIGATION_OUTPUT_MASK & ~irrigation.manual;
+        }
+        irrigation_apply(changed, outputs);
+        sample_us = irrigation_sample_us;
+        irrigation_sample_us = 0;
+        xSemaphoreGive(irrigation_mutex);
+
+        cycles = cpu_hal_get_cycle_count() - start;
+        if (sample_us != 0)
+        {
+            latency_us = (uint32_t)(esp_timer_get_time() - sample_us);
+        }
+
+        portENTER_CRITICAL(&irrigation_stats_lock);
+        irrigation_stats.evaluations++;
+        irrigation_stats.last_cycles = cycles;
+        if (cycles > irrigation_stats.max_cycles)
+        {
+            irrigation_stats.max_cycles = cycles;
+        }
+        if (changed != 0)
+        {
+            irrigation_stats.changes++;
+        }
+        if ((changed != 0) && (sample_us != 0))
+        {
+            irrigation_stats.last_latency_us = latency_us;
+            if (latency_us > irrigation_stats.max_latency_us)
+            {
+                irrigation_stats.max_latency_us = latency_us;
+            }
+        }
+        portEXIT_CRITICAL(&irrigation_stats_lock);
+
+        if (changed != 0)
+        {
+            ESP_LOGI(TAG, "Outputs 0x%02" PRIx32 ".", outputs);
+            irrigation_publish(changed, outputs);
+        }
+    }
+}
+/**
+ * @brief  Load the zone parameters from NVS, absent or invalid zones stay disabled.
+ */
+static void irrigation_load(void)
+{
+    irrigation_zone_config_t configs[IRRIGATION_MAX_ZONES];
+    size_t length = sizeof(configs);
+    nvs_handle_t handle;
+
+    if (nvs_open(IRRIGATION_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK)
+    {
+        return;
+    }
+
+    if ((nvs_get_blob(handle, IRRIGATION_NVS_KEY, configs, &length) == ESP_OK) && (length == sizeof(configs)))
+    {
+        for (uint32_t zone = 0; zone < IRRIGATION_MAX_ZONES; zone++)
+        {
+            if (!irrigation_set_zone(&irrigation, zone, &configs[zone]))
+            {
+                ESP_LOGE(TAG, "Zone%" PRIu32 " stored parameters are invalid.", zone + 1);
+            }
+        }
+    }
+    nvs_close(handle);
+}
+/**
+ * @brief  Load the zone parameters and start the irrigation task.
+ * 
+ * @note NVS and the hardware outputs must be initialized first, the modbus
+ *       probes after it.
+ * 
+ * @return - ESP_OK   succeed
+ *         - ESP_FAIL failed
+ */
+esp_err_t user_esp32_irrigation_init(void)
+{
+    if (irrigation_task_handle != NULL)
+    {
+        return ESP_OK;
+    }
+
+    irrigation_mutex = xSemaphoreCreateMutexStatic(&irrigation_mutex_buffer);
+
+    irrigation_init(&irrigation, &irrigation_pump_config);
+    irrigation_load();
+
+    if (xTaskCreate(irrigation_task,             /* Task function. */
+                    "irrigation_task",           /* Task name. */
+                    IRRIGATION_TASK_STACK_DEPTH, /* Task stack depth. */
+                    NULL,                        /* Task parameter. */
+                    IRRIGATION_TASK_PRIORITY,    /* Task priority. */
+                    &irrigation_task_handle      /* Task handle. */
+                    ) != pdPASS)
+    {
+        ESP_LOGE(TAG, "Irrigation task create failed.");
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+/**
+ * @brief  Feed a soil moisture sample to its zone, the controller is evaluated right away.
+ * 
+ * @param zone[IN] Zone, 0 ~ IRRIGATION_MAX_ZONES - 1.
+ * @param moisture[IN] Soil moisture in 1/USER_TELEMETRY_SCALE %.
+ * 
+ * @return - ESP_OK                succeed
+ *         - ESP_ERR_INVALID_ARG   unknown zone
+ *         - ESP_ERR_INVALID_STATE not initialized
+ */
+esp_err_t user_esp32_irrigation_update_moisture(uint32_t zone, int32_t moisture)
+{
+    int64_t now_us = esp_timer_get_time();
+
+    if (zone >= IRRIGATION_MAX_ZONES)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (irrigation_task_handle == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(irrigation_mutex, portMAX_DELAY);
+    irrigation_set_moisture(&irrigation, zone, moisture, (uint32_t)(now_us / 1000));
+    irrigation_sample_us = now_us;
+    xSemaphoreGive(irrigation_mutex);
+
+    xTaskNotifyGive(irrigation_task_handle);
+
+    return ESP_OK;
+}
+/**
+ * @brief  Replace and store the parameters of a zone, applied right away.
+ * 
+ * @param zone[IN] Zone, 0 ~ IRRIGATION_MAX_ZONES - 1.
+ * @param config[IN] Zone parameters, moisture in 1/USER_TELEMETRY_SCALE %.
+ * 
+ * @return - ESP_OK                succeed
+ *         - ESP_ERR_INVALID_ARG   unknown zone or invalid parameters
+ *         - ESP_ERR_INVALID_STATE not initialized
+ *         - other                 NVS error, the parameters are applied but not stored
+ */
+esp_err_t user_esp32_irrigation_set_zone(uint32_t zone, const irrigation_zone_config_t *config)
+{
+    irrigation_zone_config_t configs[IRRIGATION_MAX_ZONES];
+    nvs_handle_t handle;
+    bool valid = false;
+    esp_err_t ret = ESP_OK;
+
+    if (config == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (irrigation_task_handle == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(irrigation_mutex, portMAX_DELAY);
+    valid = irrigation_set_zone(&irrigation, zone, config);
+    for (uint32_t i = 0; i < IRRIGATION_MAX_ZONES; i++)
+    {
+        configs[i] = irrigation.zones[i].config;
+    }
+    xSemaphoreGive(irrigation_mutex);
+
+    if (!valid)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xTaskNotifyGive(irrigation_task_handle);
+
+    ret = nvs_open(IRRIGATION_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "NVS open failed. Error Code: (%s).", esp_err_to_name(ret));
+        return ret;
+    }
+
+    ret = nvs_set_blob(handle, IRRIGATION_NVS_KEY, configs, sizeof(configs));
+    if (ret == ESP_OK)
+    {
+        ret = nvs_commit(handle);
+    }
+    nvs_close(handle);
+
+    return ret;
+}
+/**
+ * @brief  Switch a valve or the pump manually, the output is left to the manual commands until local control resumes.
+ * 
+ * @note Taking the pump over closes the zones of the controller, it can not
+ *       keep the interlock without it.
+ * 
+ * @param output[IN] USER_HARDWARE_OUTPUT_VALVE1 ~ 3 or USER_HARDWARE_OUTPUT_PUMP1.
+ * @param on[IN] true: open or run.
+ * 
+ * @return - ESP_OK              succeed
+ *         - ESP_ERR_INVALID_ARG not an irrigation output
+ */
+esp_err_t user_esp32_irrigation_set_manual(user_hardware_output_t output, bool on)
+{
+    uint32_t bit = 0;
+
+    while ((bit <= IRRIGATION_MAX_ZONES) && (irrigation_hardware_outputs[bit] != output))
+    {
+        bit++;
+    }
+
+    if (bit > IRRIGATION_MAX_ZONES)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (irrigation_task_handle == NULL)
+    {
+        /* No local control, the command goes straight to the output. */
+        return user_esp32_hardware_set_output(output, on);
+    }
+
+    xSemaphoreTake(irrigation_mutex, portMAX_DELAY);
+    irrigation_set_manual(&irrigation, irrigation.manual | (1UL << bit), irrigation_now_ms());
+    user_esp32_hardware_set_output(output, on);
+    xSemaphoreGive(irrigation_mutex);
+
+    /* Close the zones left without their pump right away. */
+    xTaskNotifyGive(irrigation_task_handle);
+
+    return ESP_OK;
+}
+/**
+ * @brief  Resume local control of every output, or leave them all to the manual commands.
+ * 
+ * @note Resuming latches and publishes every controller output, the manual
+ *       state is not kept. Pausing closes the valves and stops the pump the
+ *       controller had switched on.
+ * 
+ * @param active[IN] true: local control.
+ * 
+ * @return - ESP_OK                succeed
+ *         - ESP_ERR_INVALID_STATE not initialized
+ */
+esp_err_t user_esp32_irrigation_set_active(bool active)
+{
+    uint32_t closed = 0;
+
+    if (irrigation_task_handle == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(irrigation_mutex, portMAX_DELAY);
+    if (!active)
+    {
+        closed = irrigation_outputs(&irrigation);
+        irrigation_set_manual(&irrigation, IRRIGATION_OUTPUT_MASK, irrigation_now_ms());
+        irrigation_apply(closed, 0);
+    }
+    else if (irrigation.manual != 0)
+    {
+        irrigation_set_manual(&irrigation, 0, irrigation_now_ms());
+        irrigation_resync = true;
+    }
+    xSemaphoreGive(irrigation_mutex);
+
+    irrigation_publish(closed, 0);
+    xTaskNotifyGive(irrigation_task_handle);
+
+    return ESP_OK;
+}
+/**
+ * @brief  Get the irrigation control statistics.
+ * 
+ * @param stats[OUT] Statistics.
+ * 
+ * @return - ESP_OK              succeed
+ *         - ESP_ERR_INVALID_ARG stats is NULL
+ */
+esp_err_t user_esp32_irrigation_get_stats(user_irrigation_stats_t *stats)
+{
+    if (stats == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&irrigation_stats_lock);
+    *stats = irrigation_stats;
+    portEXIT_CRITICAL(&irrigation_stats_lock);
+
+    return ESP_OK;
+}
+/******************************** End of File *********************************/
@@ -0,0 +1,486 @@
+/**
+ *****************************************************************************
+ * @file    : user_esp32_light.c
+ * @brief   : ESP32 grow light recipe Application
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *
+ * @note Each grow light strip can follow a daily recipe of keyframes stored
+ *       in NVS. The recipe task steps the interpolation every frame and only
+ *       renders and refreshes the strips when an output value changed. With
+ *       dithering on, the strips are refreshed every frame.
+ *****************************************************************************
+ */
+
+#include <string.h>
+#include <time.h>
+#include <sys/time.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "nvs.h"
+#include "hal/cpu_hal.h"
+
+#include "user_esp32_light.h"
+
+/** @brief FreeRTOS light recipe task configuration. */
+#define LIGHT_TASK_STACK_DEPTH              (3 * 1024U)
+#define LIGHT_TASK_PRIORITY                 (2U)
+
+/** @brief Default and highest recipe frame rate. */
+#define LIGHT_DEFAULT_FRAME_RATE            (20U)
+#define LIGHT_MAX_FRAME_RATE                (50U)
+
+/** @brief The recipes are realigned to the wall clock this often, it may have been corrected by SNTP. */
+#define LIGHT_RESYNC_PERIOD_MS              (60 * 1000U)
+
+/** @brief Earlier times mean SNTP has not set the clock yet (2021-01-01). */
+#define LIGHT_TIME_VALID_EPOCH              (1609459200)
+
+/** @brief NVS storage of the recipes, one blob of keyframes per strip. */
+#define LIGHT_NVS_NAMESPACE                 "light"
+
+/** @brief Light recipe of a strip. */
+typedef struct
+{
+    light_recipe_t recipe;
+    bool active;    /* When cleared, the strip is left to the manual commands. */
+} light_strip_t;
+
+/** @brief log output label. */
+static const char *TAG = "Light Application";
+
+/** @brief NVS keys of the recipes, indexed by user_rmt_strip_t. */
+static const char *const light_nvs_keys[USER_RMT_STRIP_MAX] = {
+    [USER_RMT_STRIP1] = "recipe1",
+    [USER_RMT_STRIP2] = "recipe2",
+};
+
+static light_strip_t light_strips[USER_RMT_STRIP_MAX];
+static uint32_t light_frame_ms = 1000U / LIGHT_DEFAULT_FRAME_RATE;
+
+/** @brief When set, the strips are refreshed every frame so the dithering shows. */
+static bool light_dithering = false;
+
+/** @brief Recipe lock, the recipes are stepped by the light task and replaced by the MQTT task. */
+static SemaphoreHandle_t light_mutex = NULL;
+static StaticSemaphore_t light_mutex_buffer;
+
+/** @brief Light task handle. */
+static TaskHandle_t light_task_handle = NULL;
+
+/** @brief Light recipe statistics. */
+static user_light_stats_t light_stats;
+static portMUX_TYPE light_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief  Local time of the day.
+ * 
+ * @param ms_of_day[OUT] Time of the day in ms.
+ * 
+ * @return true if the clock has been set.
+ */
+static bool light_time_of_day(uint32_t *ms_of_day)
+{
+    struct timeval now;
+    struct tm local;
+
+    gettimeofday(&now, NULL);
+    if (now.tv_sec < LIGHT_TIME_VALID_EPOCH)
+    {
+        return false;
+    }
+
+    localtime_r(&now.tv_sec, &local);
+    *ms_of_day = ((uint32_t)local.tm_hour * 3600U + (uint32_t)local.tm_min * 60U + (uint32_t)local.tm_sec) * 1000U +
+                 (uint32_t)(now.tv_usec / 1000);
+
+    return true;
+}
+/**
+ * @brief  Realign every active recipe to the wall clock, called with light_mutex held.
+ * 
+ * @param ms_of_day[IN] Time of the day in ms.
+ */
+static void light_seek_all(uint32_t ms_of_day)
+{
+    for (int strip = 0; strip < USER_RMT_STRIP_MAX; strip++)
+    {
+        light_recipe_seek(&light_strips[strip].recipe, ms_of_day);
+    }
+}
+/**
+ * @brief  Render the output of a recipe on its strip, called with light_mutex held.
+ */
+static void light_render(user_rmt_strip_t strip)
+{
+    const uint8_t *output = light_strips[strip].recipe.output;
+
+    user_esp32_rmt_set_light(strip, output[0], &output[1]);
+}
+/**
+ * @brief  Light recipe task, one recipe frame per period.
+ * 
+ * @param arg[IN] The parameter of the task.
+ */
+static void light_task(void *arg)
+{
+    TickType_t last_wake = xTaskGetTickCount();
+    uint32_t resync_ms = 0;
+    bool synced = false;
+
+    while (1)
+    {
+        uint32_t frame_ms = light_frame_ms;
+        uint32_t ms_of_day = 0;
+        uint32_t start = 0;
+        uint32_t cycles = 0;
+        bool changed = false;
+        bool refresh = false;
+
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(frame_ms));
+
+        if (!light_time_of_day(&ms_of_day))
+        {
+            continue;
+        }
+
+        start = cpu_hal_get_cycle_count();
+
+        xSemaphoreTake(light_mutex, portMAX_DELAY);
+
+        resync_ms += frame_ms;
+        if (!synced || (resync_ms >= LIGHT_RESYNC_PERIOD_MS))
+        {
+            light_seek_all(ms_of_day);
+            resync_ms = 0;
+        }
+
+        for (int strip = 0; strip < USER_RMT_STRIP_MAX; strip++)
+        {
+            light_strip_t *light = &light_strips[strip];
+            bool step_changed = light_recipe_step(&light->recipe);
+
+            if (light->active && (light->recipe.count > 0) && (step_changed || !synced))
+            {
+                light_render((user_rmt_strip_t)strip);
+                changed = true;
+            }
+        }
+        synced = true;
+        refresh = changed || light_dithering;
+
+        xSemaphoreGive(light_mutex);
+
+        cycles = cpu_hal_get_cycle_count() - start;
+
+        if (refresh)
+        {
+            user_esp32_rmt_refresh();
+        }
+
+        portENTER_CRITICAL(&light_stats_lock);
+        light_stats.frames++;
+        light_stats.updates += changed ? 1 : 0;
+        light_stats.refreshes += refresh ? 1 : 0;
+        light_stats.last_cycles = cycles;
+        if (cycles > light_stats.max_cycles)
+        {
+            light_stats.max_cycles = cycles;
+        }
+        portEXIT_CRITICAL(&light_stats_lock);
+    }
+}
+/**
+ * @brief  Load the recipe of a strip from NVS, an absent recipe leaves the strip manual.
+ * 
+ * @param strip[IN] Strip.
+ */
+static void light_load(user_rmt_strip_t strip)
+{
+    light_recipe_keyframe_t keyframes[LIGHT_RECIPE_MAX_KEYFRAMES];
+    size_t length = sizeof(keyframes);
+    nvs_handle_t handle;
+    int count = 0;
+
+    if (nvs_open(LIGHT_NVS_NAMESPACE, NVS_READONLY, &handle) == ESP_OK)
+    {
+        if (nvs_get_blob(handle, light_nvs_keys[strip], keyframes, &length) == ESP_OK)
+        {
+            count = (int)(length / sizeof(keyframes[0]));
+        }
+        nvs_close(handle);
+    }
+
+    if (!light_recipe_init(&light_strips[strip].recipe, keyframes, count, light_frame_ms))
+    {
+        ESP_LOGE(TAG, "Strip%d stored recipe is invalid.", strip + 1);
+        light_recipe_init(&light_strips[strip].recipe, keyframes, 0, light_frame_ms);
+        count = 0;
+    }
+
+    light_strips[strip].active = (count > 0);
+    ESP_LOGI(TAG, "Strip%d recipe: %d keyframes.", strip + 1, count);
+}
+/**
+ * @brief  Load the recipes and start the light recipe task.
+ * 
+ * @note NVS and the RMT strips must be initialized first. The recipes follow
+ *       the local time zone, CONFIG_USER_TIMEZONE, set by app_main.
+ * 
+ * @return - ESP_OK   succeed
+ *         - ESP_FAIL failed
+ */
+esp_err_t user_esp32_light_init(void)
+{
+    if (light_task_handle != NULL)
+    {
+        return ESP_OK;
+    }
+
+    light_mutex = xSemaphoreCreateMutexStatic(&light_mutex_buffer);
+
+    for (int strip = 0; strip < USER_RMT_STRIP_MAX; strip++)
+    {
+        light_load((user_rmt_strip_t)strip);
+    }
+
+#ifdef CONFIG_USER_LIGHT_DITHERING
+    user_esp32_light_set_dithering(true);
+#endif
+
+    if (xTaskCreate(light_task,             /* Task function. */
+                    "light_task",           /* Task name. */
+                    LIGHT_TASK_STACK_DEPTH, /* Task stack depth. */
+                    NULL,                   /* Task parameter. */
+                    LIGHT_TASK_PRIORITY,    /* Task priority. */
+                    &light_task_handle      /* Task handle. */
+                    ) != pdPASS)
+    {
+        ESP_LOGE(TAG, "Light task create failed.");
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+/**
+ * @brief  Replace and store the recipe of a strip, the strip follows it from the next frame.
+ * 
+ * @param strip[IN] Strip.
+ * @param keyframes[IN] Keyframes sorted by strictly increasing minute.
+ * @param count[IN] Keyframes, 0 removes the recipe.
+ * 
+ * @return - ESP_OK                succeed
+ *         - ESP_ERR_INVALID_ARG   invalid recipe
+ *         - ESP_ERR_INVALID_STATE not initialized
+ *         - other                 NVS error, the recipe is applied but not stored
+ */
+esp_err_t user_esp32_light_set_recipe(user_rmt_strip_t strip, const light_recipe_keyframe_t *keyframes, int count)
+{
+    light_recipe_t recipe;
+    nvs_handle_t handle;
+    uint32_t ms_of_day = 0;
+    bool rendered = false;
+    esp_err_t ret = ESP_OK;
+
+    if (((unsigned)strip >= USER_RMT_STRIP_MAX) || ((keyframes == NULL) && (count > 0)))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (light_mutex == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (!light_recipe_init(&recipe, keyframes, count, light_frame_ms))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(light_mutex, portMAX_DELAY);
+    light_strips[strip].recipe = recipe;
+    light_strips[strip].active = (count > 0);
+    if (light_time_of_day(&ms_of_day) && (count > 0))
+    {
+        light_recipe_seek(&light_strips[strip].recipe, ms_of_day);
+        light_render(strip);
+        rendered = true;
+    }
+    xSemaphoreGive(light_mutex);
+
+    if (rendered)
+    {
+        user_esp32_rmt_refresh();
+    }
+
+    ret = nvs_open(LIGHT_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "NVS open failed. Error Code: (%s).", esp_err_to_name(ret));
+        return ret;
+    }
+
+    if (count > 0)
+    {
+        ret = nvs_set_blob(handle, light_nvs_keys[strip], keyframes, count * sizeof(keyframes[0]));
+    }
+    else
+    {
+        ret = nvs_erase_key(handle, light_nvs_keys[strip]);
+        ret = (ret == ESP_ERR_NVS_NOT_FOUND) ? ESP_OK : ret;
+    }
+    if (ret == ESP_OK)
+    {
+        ret = nvs_commit(handle);
+    }
+    nvs_close(handle);
+
+    return ret;
+}
+/**
+ * @brief  Let a strip follow its recipe, or leave it to the manual commands.
+ * 
+ * @param strip[IN] Strip.
+ * @param active[IN] true: follow the recipe.
+ * 
+ * @return - ESP_OK                succeed
+ *         - ESP_ERR_INVALID_ARG   unknown strip
+ *         - ESP_ERR_INVALID_STATE not initialized
+ */
+esp_err_t user_esp32_light_set_active(user_rmt_strip_t strip, bool active)
+{
+    uint32_t ms_of_day = 0;
+    bool rendered = false;
+
+    if ((unsigned)strip >= USER_RMT_STRIP_MAX)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (light_mutex == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(light_mutex, portMAX_DELAY);
+    if (active && !light_strips[strip].active && (light_strips[strip].recipe.count > 0) && light_time_of_day(&ms_of_day))
+    {
+        light_recipe_seek(&light_strips[strip].recipe, ms_of_day);
+        light_render(strip);
+        rendered = true;
+    }
+    light_strips[strip].active = active;
+    xSemaphoreGive(light_mutex);
+
+    if (rendered)
+    {
+        user_esp32_rmt_refresh();
+    }
+
+    return ESP_OK;
+}
+/**
+ * @brief  Set the recipe frame rate, the recipes are realigned to the new frame time.
+ * 
+ * @param fps[IN] Frames per second, 1 ~ LIGHT_MAX_FRAME_RATE.
+ * 
+ * @return - ESP_OK                succeed
+ *         - ESP_ERR_INVALID_ARG   out of range
+ *         - ESP_ERR_INVALID_STATE not initialized
+ */
+esp_err_t user_esp32_light_set_frame_rate(uint32_t fps)
+{
+    uint32_t ms_of_day = 0;
+    bool valid = false;
+
+    if ((fps == 0) || (fps > LIGHT_MAX_FRAME_RATE))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (light_mutex == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(light_mutex, portMAX_DELAY);
+    light_frame_ms = 1000U / fps;
+    valid = light_time_of_day(&ms_of_day);
+    for (int strip = 0; strip < USER_RMT_STRIP_MAX; strip++)
+    {
+        light_recipe_t *recipe = &light_strips[strip].recipe;
+        light_recipe_keyframe_t keyframes[LIGHT_RECIPE_MAX_KEYFRAMES];
+        int count = recipe->count;
+
+        memcpy(keyframes, recipe->keyframes, sizeof(keyframes));
+        light_recipe_init(recipe, keyframes, count, light_frame_ms);
+        if (valid)
+        {
+            light_recipe_seek(recipe, ms_of_day);
+        }
+    }
+    xSemaphoreGive(light_mutex);
+
+    return ESP_OK;
+}
+/**
+ * @brief  Switch the temporal dithering of the strips, the light task then refreshes them every frame.
+ * 
+ * @note The sub-step part of each level is spread over successive frames, so
+ *       dim levels ramp without visible steps. Each refresh costs one strip
+ *       frame of wall-clock time in the light task.
+ * 
+ * @param enable[IN] true: dithering on.
+ * 
+ * @return - ESP_OK                succeed
+ *         - ESP_ERR_INVALID_STATE not initialized
+ */
+esp_err_t user_esp32_light_set_dithering(bool enable)
+{
+    esp_err_t ret = ESP_OK;
+
+    if (light_mutex == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    ret = user_esp32_rmt_set_dithering(enable);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+
+    xSemaphoreTake(light_mutex, portMAX_DELAY);
+    light_dithering = enable;
+    xSemaphoreGive(light_mutex);
+
+    return ESP_OK;
+}
+/**
+ * @brief  Get the light recipe statistics.
+ * 
+ * @param stats[OUT] Statistics.
+ * 
+ * @return - ESP_OK              succeed
+ *         - ESP_ERR_INVALID_ARG stats is NULL
+ */
+esp_err_t user_esp32_light_get_stats(user_light_stats_t *stats)
+{
+    if (stats == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&light_stats_lock);
+    *stats = light_stats;
+    portEXIT_CRITICAL(&light_stats_lock);
+
+    return ESP_OK;
+}
+/******************************** End of File *********************************/
@@ -5,21 +5,318 @@
  * @author  : Cao Jin
  * @date    : 20-Oct-2021
  * @version : 1.0.0
+ *
+ * @note Modbus master of the RS-485 probes, the register map below is polled
+ *       by user_modbus_master.c and every value is fed to the telemetry, the
+ *       soil moisture values also to the irrigation control.
  *****************************************************************************
  */
 
 #include <string.h>
 
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
 #include "esp_err.h"
 #include "esp_log.h"
 
-#include "mbcontroller.h"
+#include "driver/uart.h"
+#include "driver/gpio.h"
 
+#include "user_modbus_master.h"
+#include "user_esp32_uart.h"
+#include "user_esp32_telemetry.h"
+#include "user_esp32_irrigation.h"
 #include "user_esp32_modbus.h"
 
+/** @brief Default RS-485 bus configuration, RTS drives the transceiver DE/RE pins. */
+#define DEFAULT_MODBUS_UART_NUM         UART_NUM_2
+#define DEFAULT_MODBUS_BAUD_RATE        (9600)
+#define DEFAULT_MODBUS_TX_PIN           GPIO_NUM_17
+#define DEFAULT_MODBUS_RX_PIN           GPIO_NUM_16
+#define DEFAULT_MODBUS_RTS_PIN          GPIO_NUM_5
+#define DEFAULT_MODBUS_MODE             USER_MODBUS_MODE_RTU
+
+/** @brief RS-485 ring buffers, the RX one holds two of the largest frames. */
+#define MODBUS_RX_BUFFER_SIZE           (2 * USER_UART_FRAME_MAX_LENGTH)
+#define MODBUS_TX_BUFFER_SIZE           (0)
+
+/** @brief Time allowed to send a request. */
+#define MODBUS_TRANSMIT_TIMEOUT_MS      (100U)
+
+/** @brief Loopback benchmark at start-up, CONFIG_USER_UART_BENCHMARK. */
+#define MODBUS_BENCHMARK_FRAME_LENGTH   (64)
+#define MODBUS_BENCHMARK_FRAME_COUNT    (50)
+
+/** @brief FreeRTOS modbus poll task configuration. */
+#define MODBUS_TASK_STACK_DEPTH         (3 * 1024U)
+#define MODBUS_TASK_PRIORITY            (4U)
+
+/** @brief Poll cycle period. */
+#define MODBUS_POLL_PERIOD_MS           (5000U)
+
+/** @brief Conversion of a register to a telemetry channel. */
+typedef struct
+{
+    user_telemetry_channel_t channel; /* Telemetry channel. */
+    int32_t scale;                    /* Register unit to 1/USER_TELEMETRY_SCALE channel unit. */
+} modbus_telemetry_point_t;
+
+/** @brief Conversion of a soil moisture register, also fed to its irrigation zone. */
+typedef struct
+{
+    modbus_telemetry_point_t telemetry; /* Telemetry channel. */
+    uint32_t zone;                      /* Irrigation zone. */
+} modbus_soil_point_t;
+
+/** @brief log output label. */
+static const char *TAG = "Modbus Application";
+
+/** @brief Soil moisture probes report 0.1 %, the TDS probe reports ppm. */
+static const modbus_soil_point_t modbus_soil_humi1 = { { USER_TELEMETRY_SOIL_HUMI1, USER_TELEMETRY_SCALE / 10 }, 0 };
+static const modbus_soil_point_t modbus_soil_humi2 = { { USER_TELEMETRY_SOIL_HUMI2, USER_TELEMETRY_SCALE / 10 }, 1 };
+static const modbus_soil_point_t modbus_soil_humi3 = { { USER_TELEMETRY_SOIL_HUMI3, USER_TELEMETRY_SCALE / 10 }, 2 };
+static const modbus_telemetry_point_t modbus_tds_value1 = { USER_TELEMETRY_TDS_VALUE1, USER_TELEMETRY_SCALE };
+
+static void modbus_telemetry_handler(const user_modbus_point_t *point, const uint16_t *regs);
+static void modbus_soil_handler(const user_modbus_point_t *point, const uint16_t *regs);
+
+/** @brief Slaves of the RS-485 bus. { address, timeout ms, retries } */
+static const user_modbus_slave_config_t modbus_slaves[] = {
+    { 1, 200, 1 }, /* Soil moisture probe 1. */
+    { 2, 200, 1 }, /* Soil moisture probe 2. */
+    { 3, 200, 1 }, /* Soil moisture probe 3. */
+    { 4, 200, 1 }, /* TDS probe. */
+};
+
+/** @brief Register map. { slave, function, register, count, handler, argument } */
+static const user_modbus_point_t modbus_points[] = {
+    { 1, USER_MODBUS_READ_HOLDING_REGISTERS, 0x0000, 1, modbus_soil_handler, (void *)&modbus_soil_humi1 },
+    { 2, USER_MODBUS_READ_HOLDING_REGISTERS, 0x0000, 1, modbus_soil_handler, (void *)&modbus_soil_humi2 },
+    { 3, USER_MODBUS_READ_HOLDING_REGISTERS, 0x0000, 1, modbus_soil_handler, (void *)&modbus_soil_humi3 },
+    { 4, USER_MODBUS_READ_HOLDING_REGISTERS, 0x0000, 1, modbus_telemetry_handler, (void *)&modbus_tds_value1 },
+};
+
+/** @brief Modbus master polling engine, only used by the poll task. */
+static user_modbus_master_t modbus_master;
+
+/** @brief Statistics copied after every poll cycle. */
+static user_modbus_cycle_stats_t modbus_cycle_stats;
+static user_modbus_slave_stats_t modbus_slave_stats[USER_MODBUS_MAX_SLAVES];
+static portMUX_TYPE modbus_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/** @brief Modbus poll task handle. */
+static TaskHandle_t modbus_task_handle = NULL;
+
+/**
+ * @brief  Feed a register to its telemetry channel.
+ */
+static void modbus_telemetry_handler(const user_modbus_point_t *point, const uint16_t *regs)
+{
+    const modbus_telemetry_point_t *telemetry = (const modbus_telemetry_point_t *)point->arg;
+
+    user_esp32_telemetry_update(telemetry->channel, (int32_t)(int16_t)regs[0] * telemetry->scale);
+}
+/**
+ * @brief  Feed a soil moisture register to its telemetry channel and its irrigation zone.
+ */
+static void modbus_soil_handler(const user_modbus_point_t *point, const uint16_t *regs)
+{
+    const modbus_soil_point_t *soil = (const modbus_soil_point_t *)point->arg;
+    int32_t value = (int32_t)(int16_t)regs[0] * soil->telemetry.scale;
+
+    user_esp32_telemetry_update(soil->telemetry.channel, value);
+    user_esp32_irrigation_update_moisture(soil->zone, value);
+}
+/**
+ * @brief  Discard stale input and send a frame, RS-485 direction is driven by the UART hardware.
+ */
+static esp_err_t modbus_uart_send(void *ctx, const uint8_t *frame, size_t length)
+{
+    uart_port_t port = (uart_port_t)(intptr_t)ctx;
+
+    user_esp32_uart_flush(port);
+
+    return user_esp32_uart_transmit(port, frame, length, MODBUS_TRANSMIT_TIMEOUT_MS);
+}
+/**
+ * @brief  Receive a frame, split by the UART layer on the t3.5 receive timeout or, in ASCII mode, on LF.
+ */
+static int modbus_uart_receive(void *ctx, uint8_t *frame, size_t size, uint32_t timeout_ms, uint32_t gap_us)
+{
+    uart_port_t port = (uart_port_t)(intptr_t)ctx;
+    user_uart_frame_t *received = NULL;
+
+    if (user_esp32_uart_receive_frame(port, &received, timeout_ms) != ESP_OK)
+    {
+        return 0;
+    }
+
+    int length = -1;
+    if (!received->error && (received->length <= size))
+    {
+        length = (int)received->length;
+        memcpy(frame, received->data, received->length);
+    }
+    user_esp32_uart_release_frame(port, received);
+
+    return length;
+}
+/**
+ * @brief  Millisecond clock of the polling engine.
+ */
+static uint32_t modbus_clock_ms(void *ctx)
+{
+    return (uint32_t)(xTaskGetTickCount() * portTICK_PERIOD_MS);
+}
+/**
+ * @brief  Modbus poll task, runs one poll cycle per period.
+ * 
+ * @param arg[IN] The parameter of the task.
+ */
+static void modbus_task(void *arg)
+{
+    TickType_t last_wake = xTaskGetTickCount();
+
+    while (1)
+    {
+        user_modbus_master_poll(&modbus_master);
+
+        portENTER_CRITICAL(&modbus_stats_lock);
+        modbus_cycle_stats = modbus_master.stats;
+        memcpy(modbus_slave_stats, modbus_master.slave_stats, sizeof(modbus_slave_stats));
+        portEXIT_CRITICAL(&modbus_stats_lock);
+
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(MODBUS_POLL_PERIOD_MS));
+    }
+}
+/**
+ * @brief  Initialize the RS-485 bus and start polling the register map.
+ * 
+ * @return - ESP_OK   succeed
+ *         - others   failed
+ */
 esp_err_t user_esp32_modbus_init(void)
 {
+    uart_port_t port = DEFAULT_MODBUS_UART_NUM;
+    user_uart_param_t uart_param = {
+        .port = port,
+        .tx_io_num = DEFAULT_MODBUS_TX_PIN,
+        .rx_io_num = DEFAULT_MODBUS_RX_PIN,
+        .rts_io_num = DEFAULT_MODBUS_RTS_PIN,
+        .cts_io_num = UART_PIN_NO_CHANGE,
+        .config = {
+            .baud_rate = DEFAULT_MODBUS_BAUD_RATE,
+            .data_bits = (DEFAULT_MODBUS_MODE == USER_MODBUS_MODE_RTU) ? UART_DATA_8_BITS : UART_DATA_7_BITS,
+            .parity = (DEFAULT_MODBUS_MODE == USER_MODBUS_MODE_RTU) ? UART_PARITY_DISABLE : UART_PARITY_EVEN,
+            .stop_bits = UART_STOP_BITS_1,
+            .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+            .source_clk = UART_SCLK_APB,
+        },
+        .rx_buffer_size = MODBUS_RX_BUFFER_SIZE,
+        .tx_buffer_size = MODBUS_TX_BUFFER_SIZE,
+        .mode = UART_MODE_RS485_HALF_DUPLEX,
+        .pattern_chr = (DEFAULT_MODBUS_MODE == USER_MODBUS_MODE_ASCII) ? '\n' : 0,
+        .rx_mode = USER_UART_RX_FRAME,
+    };
+    user_modbus_transport_t transport = {
+        .send = modbus_uart_send,
+        .receive = modbus_uart_receive,
+        .clock_ms = modbus_clock_ms,
+        .ctx = (void *)(intptr_t)port,
+    };
+
+    if (modbus_task_handle != NULL)
+    {
+        return ESP_OK;
+    }
+
+    esp_err_t ret = user_modbus_master_init(&modbus_master, DEFAULT_MODBUS_MODE, DEFAULT_MODBUS_BAUD_RATE, &transport,
+                                            modbus_slaves, sizeof(modbus_slaves) / sizeof(modbus_slaves[0]),
+                                            modbus_points, sizeof(modbus_points) / sizeof(modbus_points[0]));
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Invalid register map.");
+        return ret;
+    }
+
+    /* RTU frames end after t3.5 of silence, rounded up to whole characters. */
+    uart_param.rx_timeout_symbols = (uint8_t)((modbus_master.stats.t35_us + modbus_master.char_us - 1) / modbus_master.char_us);
+    ret = user_esp32_uart_register(&uart_param);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "RS-485 UART configuration failed. Error Code: (%s).", esp_err_to_name(ret));
+        return ret;
+    }
+
+#ifdef CONFIG_USER_UART_BENCHMARK
+    user_uart_benchmark_t benchmark;
+    if (user_esp32_uart_loopback_benchmark(port, MODBUS_BENCHMARK_FRAME_LENGTH, MODBUS_BENCHMARK_FRAME_COUNT, &benchmark) == ESP_OK)
+    {
+        ESP_LOGI(TAG, "Loopback %d frames of %d bytes: %d ok, %d bad, %d lost, %d B/s, turnaround %d/%d/%d us.",
+                 MODBUS_BENCHMARK_FRAME_COUNT, MODBUS_BENCHMARK_FRAME_LENGTH, benchmark.frames, benchmark.bad, benchmark.lost,
+                 benchmark.bytes_per_sec, benchmark.turnaround_min, benchmark.turnaround_avg, benchmark.turnaround_max);
+    }
+#endif
+
+    BaseType_t uxBits = xTaskCreate(modbus_task,                   /* Pointer to the task entry function. */
+                                    "Modbus poll task",            /* Descriptive name for the task. */
+                                    MODBUS_TASK_STACK_DEPTH,       /* The size of the task stack specified as the number of bytes. */
+                                    NULL,                          /* Pointer that will be used as the parameter for the task being created. */
+                                    MODBUS_TASK_PRIORITY,          /* The priority at which the task should run. */
+                                    &modbus_task_handle);          /* Used to pass back a handle by which the created task can be referenced. */
+    if (uxBits != pdPASS)
+    {
+        ESP_LOGE(TAG, "Modbus poll task creation failed.");
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "Polling %d points in %d reads, t3.5 %d us.", modbus_master.stats.points, modbus_master.stats.blocks, modbus_master.stats.t35_us);
+
+    return ESP_OK;
+}
+/**
+ * @brief  Get the poll cycle statistics.
+ * 
+ * @param stats[OUT] Poll cycle statistics.
+ * 
+ * @return - ESP_OK              succeed
+ *         - ESP_ERR_INVALID_ARG stats is NULL
+ */
+esp_err_t user_esp32_modbus_get_cycle_stats(user_modbus_cycle_stats_t *stats)
+{
+    if (stats == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
 
+    portENTER_CRITICAL(&modbus_stats_lock);
+    *stats = modbus_cycle_stats;
+    portEXIT_CRITICAL(&modbus_stats_lock);
 
     return ESP_OK;
-}
\ No newline at end of file
+}
+/**
+ * @brief  Get the statistics of a slave.
+ * 
+ * @param address[IN] Slave address.
+ * @param stats[OUT] Slave statistics.
+ * 
+ * @return - ESP_OK             succeed
+ *         - ESP_ERR_NOT_FOUND  unknown slave
+ */
+esp_err_t user_esp32_modbus_get_slave_stats(uint8_t address, user_modbus_slave_stats_t *stats)
+{
+    for (int i = 0; i < (int)(sizeof(modbus_slaves) / sizeof(modbus_slaves[0])); i++)
+    {
+        if (modbus_slaves[i].address == address)
+        {
+            portENTER_CRITICAL(&modbus_stats_lock);
+            *stats = modbus_slave_stats[i];
+            portEXIT_CRITICAL(&modbus_stats_lock);
+            return ESP_OK;
+        }
+    }
+
+    return ESP_ERR_NOT_FOUND;
+}
@@ -8,9 +8,11 @@
  *****************************************************************************
  */
 
+#include <string.h>
+#include <inttypes.h>
+
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/queue.h"
 #include "freertos/event_groups.h"
 
 #include "esp_log.h"
@@ -20,7 +22,18 @@
 #include "mqtt_client.h"
 
 #include "user_esp32_mqtt.h"
+#include "user_mqtt_topic.h"
+#include "user_mqtt_pool.h"
+#include "user_mqtt_latest.h"
+#include "user_mqtt_assembly.h"
 #include "user_esp32_ota.h"
+#include "user_esp32_codec.h"
+#include "user_esp32_store.h"
+#include "user_esp32_hardware.h"
+#include "user_esp32_fan.h"
+#include "user_esp32_rmt.h"
+#include "user_esp32_light.h"
+#include "user_esp32_irrigation.h"
 
 /** @brief FreeRTOS MQTT message process task configuration. */
 #define MQTT_MSG_PROC_TASK_STACK_DEPTH      (4 * 1024)
@@ -38,49 +51,16 @@
 /** @brief Default MQTT used Quality of Service. */
 #define MQTT_QOS_LEVEL                      MQTT_QOS_0
 
-/** @brief MQTT message queue maximum length. (esp_mqtt_message_t) */
-#define MAXIMUM_MQTT_MSG_LENGTH             (10U)
+/** @brief Default MQTT ingress overflow policy, see user_mqtt_overflow_policy_t. */
+#define MQTT_DEFAULT_OVERFLOW_POLICY        USER_MQTT_OVERFLOW_COALESCE
+
+/** @brief MQTT ingress statistics publish period in milliseconds. */
+#define MQTT_INGRESS_STATS_PERIOD_MS        (60 * 1000U)
 
 /** @brief Complete MQTT broker URI  */
 #define DEFAULT_MQTT_BROKER_URL             "mqtt://47.102.193.111:1883" 
                                             //"mqtt://106.14.31.82:2005"
                                             
-/** @brief MQTT subscribe the topic groups. */
-#define SUB_SWITCH_VALVE_STATE1 "firstSwitchCommand"  /* Switch valve1 -> Switch command topic. */
-#define SUB_SWITCH_VALVE_STATE2 "secondSwitchCommand" /* Switch valve2 -> Switch command topic. */
-#define SUB_SWITCH_VALVE_STATE3 "thirdSwitchCommand"  /* Switch valve3 -> Switch command topic. */
-#define SUB_PUMP_STATE1 "pumpCommand"                 /* Water pump1 -> Switch command topic. */
-#define SUB_RGB_STATE1 "firstLightCommand"            /* WS2812 RGB1 -> Switch command topic. */
-#define SUB_RGB_STATE2 "secondLightCommand"           /* WS2812 RGB2 -> Switch command topic. */
-#define SUB_RGB_LIGHT1 "firstBrightnessCommand"       /* WS2812 RGB1 -> Brightness command topic. */
-#define SUB_RGB_LIGHT2 "secondBrightnessCommand"      /* WS2812 RGB2 -> Brightness command topic. */
-#define SUB_RGB_COLOR1 "firstRgbCommand"              /* WS2812 RGB1 -> Color command topic. */
-#define SUB_RGB_COLOR2 "secondRgbCommand"             /* WS2812 RGB2 -> Color command topic. */
-#define SUB_FAN_STATE1 "fanCommand"                   /* Fan1 -> Switch command topic. */
-#define SUB_FAN_SPEED1 "fanSpeedCommand"              /* Fan1 -> Speed command topic. */
-#define SUB_OTA_SERVICE "OTAServiceCommand"            
-
-/** @brief MQTT publish the topic groups. */
-#define PUB_SWITCH_VALVE_STATE1 "firstSwitchState"  /* Switch valve1 -> Switch status topic. */
-#define PUB_SWITCH_VALVE_STATE2 "secondSwitchState" /* Switch valve2 -> Switch status topic. */
-#define PUB_SWITCH_VALVE_STATE3 "thirdSwitchState"  /* Switch valve3 -> Switch status topic. */
-#define PUB_PUMP_STATE1 "pumpState"                 /* Water pump1 -> Switch status topic. */
-#define PUB_RGB_STATE1 "firstLightState"            /* WS2812 RGB1 -> Switch status topic. */
-#define PUB_RGB_STATE2 "secondLightState"           /* WS2812 RGB2 -> Switch status topic. */
-#define PUB_RGB_LIGHT1 "firstBrightnessState"       /* WS2812 RGB1 -> Brightness status topic. */
-#define PUB_RGB_LIGHT2 "secondBrightnessState"      /* WS2812 RGB2 -> Brightness status topic. */
-#define PUB_RGB_COLOR1 "firstRgbState"              /* WS2812 RGB1 -> Color status topic. */
-#define PUB_RGB_COLOR2 "secondRgbState"             /* WS2812 RGB2 -> Color status topic. */
-#define PUB_FAN_STATE1 "fanState"                   /* Fan1 -> Switch status topic. */
-#define PUB_FAN_SPEED1 "fanSpeedState"              /* Fan1 -> Speed status topic. */
-#define PUB_SOIL_HUMI1 "firstSoilMoisture"          /* Soil moisture sensor1 -> Humidity information topic. */
-#define PUB_SOIL_HUMI2 "secondSoilMoisture"         /* Soil moisture sensor2 -> Humidity information topic. */
-#define PUB_SOIL_HUMI3 "thirdSoilMoisture"          /* Soil moisture sensor3 -> Humidity information topic. */
-#define PUB_ENVM_HUMI1 "environmentMoisture"        /* Environmental temperature and humidity sensor1 -> Humidity information topic. */
-#define PUB_ENVM_TEMP1 "environmentTemp"            /* Environmental temperature and humidity sensor1 -> Temperature information topic. */
-#define PUB_ENVM_TMOS1 "atmos"                      /* Atmospheric pressure sensor -> Atmospheric pressure information topic. */
-#define PUB_TDS_VALUE1 "tds"                        /* Water quality sensor -> Water quality information topic. */
-
 /** @brief MQTT publish or subscribe msg_id error check. */
 #define ESP_MQTT_MSG_ID_CHECK(x)                                                \
     do                                                                          \
@@ -91,22 +71,46 @@
         }                                                                       \
     } while (0)
 
-/** @brief MQTT message structure.  */
-typedef struct
-{
-    char * topic;
-    int topic_len;
-    char* data;
-    int data_len;
-}esp_mqtt_message_t;
+/** @brief Compare MQTT payload with a string literal, the lengths must be equal. */
+#define MQTT_DATA_EQUAL(_data, _data_len, _str) \
+    (((_data_len) == (sizeof(_str) - 1)) && (memcmp((_data), (_str), (_data_len)) == 0))
 
 /** @brief log output label. */
 static const char *TAG = "MQTT Application";
 
 /** @brief FreeRTOS MQTT handles.  */
-static QueueHandle_t mqtt_msg_queue_handle = NULL;
 static TaskHandle_t mqtt_msg_proc_task_handle = NULL;
 
+/** @brief MQTT message pool and message queue, statically allocated so no heap is used. */
+static user_mqtt_pool_t mqtt_msg_pool;
+
+/**
+ * @brief Guards the message pool.
+ * 
+ * @note The MQTT client task only writes a queued payload in place under this lock,
+ *       the processing task takes a slot out of the queue under it before reading it.
+ *       A slot held by either task is filled or read without the lock.
+ */
+static portMUX_TYPE mqtt_msg_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/** @brief Fragmented message being reassembled, only used by the MQTT client task. */
+static user_mqtt_assembly_t mqtt_msg_assembly;
+
+/**
+ * @brief Sequence number of the next stored value or queued message, only updated by the MQTT client task.
+ * 
+ * @note Last-writer-wins values and queued messages are applied in this order, so
+ *       commands of different topics that interact (a manual command and the
+ *       switch of the controller it overrides) keep their arrival order.
+ */
+static volatile uint32_t mqtt_msg_seq = 0;
+
+/** @brief MQTT ingress overflow policy. */
+static volatile user_mqtt_overflow_policy_t mqtt_overflow_policy = MQTT_DEFAULT_OVERFLOW_POLICY;
+
+/** @brief When set, means the MQTT client is connected to the broker. */
+static volatile bool mqtt_connected = false;
+
 /** @brief MQTT client handle. */
 static esp_mqtt_client_handle_t mqtt_client = NULL;
 
@@ -114,6 +118,486 @@ static esp_mqtt_client_handle_t mqtt_client = NULL;
 extern const uint8_t mqtt_server_cert_pem_start[] asm("_binary_mqtt_ca_cert_pem_start");
 extern const uint8_t mqtt_server_cert_pem_end[] asm("_binary__mqtt_ca_cert_pem_end");
 
+/**
+ * @brief  Switch valve command handler.
+ * 
+ * @param valve[IN] Switch valve number, start from 1.
+ * @param data[IN] Received MQTT data.
+ * @param data_len[IN] Received MQTT data length.
+ */
+static void mqtt_switch_valve_handler(int valve, const char *data, int data_len)
+{
+    bool on;
+
+    if (user_esp32_codec_decode_switch(data, data_len, &on) != ESP_OK)
+    {
+        ESP_LOGE(TAG, "UNKNOW DATA.");
+        return;
+    }
+
+    ESP_LOGI(TAG, "Switch valve%d %s.", valve, on ? "on" : "off");
+
+    /* A manual command takes the valve over from the irrigation control until irrigationCommand on. */
+    user_esp32_irrigation_set_manual(USER_HARDWARE_OUTPUT_VALVE1 + (valve - 1), on);
+}
+
+static void mqtt_switch_valve1_handler(const char *data, int data_len)
+{
+    mqtt_switch_valve_handler(1, data, data_len);
+}
+
+static void mqtt_switch_valve2_handler(const char *data, int data_len)
+{
+    mqtt_switch_valve_handler(2, data, data_len);
+}
+
+static void mqtt_switch_valve3_handler(const char *data, int data_len)
+{
+    mqtt_switch_valve_handler(3, data, data_len);
+}
+
+static void mqtt_pump1_handler(const char *data, int data_len)
+{
+    bool on;
+
+    if (user_esp32_codec_decode_switch(data, data_len, &on) != ESP_OK)
+    {
+        ESP_LOGE(TAG, "UNKNOW DATA.");
+        return;
+    }
+
+    ESP_LOGI(TAG, "Pump1 %s.", on ? "on" : "off");
+
+    user_esp32_irrigation_set_manual(USER_HARDWARE_OUTPUT_PUMP1, on);
+}
+
+/**
+ * @brief  Irrigation local control switch handler, "on" resumes it on every output, "off" leaves them to the manual commands.
+ */
+static void mqtt_irrigation_state_handler(const char *data, int data_len)
+{
+    bool on;
+
+    if (user_esp32_codec_decode_switch(data, data_len, &on) != ESP_OK)
+    {
+        ESP_LOGE(TAG, "UNKNOW DATA.");
+        return;
+    }
+
+    ESP_LOGI(TAG, "Irrigation %s.", on ? "on" : "off");
+
+    user_esp32_irrigation_set_active(on);
+}
+
+/**
+ * @brief  Irrigation zone parameters handler, "zone,enabled,on_below,off_above,min_on_s,min_off_s,max_on_s".
+ * 
+ * @note zone starts from 1, the moisture thresholds are in 1/USER_TELEMETRY_SCALE %.
+ *       Configuration payload, text in both payload formats.
+ */
+static void mqtt_irrigation_zone_handler(const char *data, int data_len)
+{
+    irrigation_zone_config_t config;
+    int zone = irrigation_parse_zone(data, data_len, &config);
+    esp_err_t ret = (zone < 0) ? ESP_ERR_INVALID_ARG : user_esp32_irrigation_set_zone((uint32_t)zone, &config);
+
+    if (ret == ESP_ERR_INVALID_ARG)
+    {
+        ESP_LOGE(TAG, "UNKNOW DATA.");
+        return;
+    }
+    if (ret != ESP_OK)
+    {
+        /* Not initialized, or applied but not stored in NVS. */
+        ESP_LOGE(TAG, "Irrigation zone%d failed. Error Code: (%s).", zone + 1, esp_err_to_name(ret));
+        return;
+    }
+
+    ESP_LOGI(TAG, "Irrigation zone%d %s, %" PRId32 " ~ %" PRId32 ".", zone + 1,
+             config.enabled ? "enabled" : "disabled", config.on_below, config.off_above);
+}
+
+/**
+ * @brief  WS2812 RGB switch command handler.
+ * 
+ * @param strip[IN] Grow light strip.
+ * @param data[IN] Received MQTT data.
+ * @param data_len[IN] Received MQTT data length.
+ */
+static void mqtt_rgb_state_handler(user_rmt_strip_t strip, const char *data, int data_len)
+{
+    bool on;
+
+    if (user_esp32_codec_decode_switch(data, data_len, &on) != ESP_OK)
+    {
+        ESP_LOGE(TAG, "UNKNOW DATA.");
+        return;
+    }
+
+    ESP_LOGI(TAG, "RGB%d %s.", strip + 1, on ? "on" : "off");
+
+    /* A manual command takes the strip over from its light recipe. */
+    user_esp32_light_set_active(strip, false);
+    user_esp32_rmt_set_state(strip, on);
+}
+/**
+ * @brief  WS2812 RGB brightness command handler.
+ * 
+ * @param strip[IN] Grow light strip.
+ * @param data[IN] Received MQTT data, 0 ~ 255.
+ * @param data_len[IN] Received MQTT data length.
+ */
+static void mqtt_rgb_light_handler(user_rmt_strip_t strip, const char *data, int data_len)
+{
+    uint32_t brightness;
+
+    if (user_esp32_codec_decode_level(data, data_len, UINT8_MAX, &brightness) != ESP_OK)
+    {
+        ESP_LOGE(TAG, "UNKNOW DATA.");
+        return;
+    }
+
+    ESP_LOGI(TAG, "RGB%d brightness %" PRIu32 ".", strip + 1, brightness);
+
+    user_esp32_light_set_active(strip, false);
+    user_esp32_rmt_set_brightness(strip, (uint8_t)brightness);
+}
+/**
+ * @brief  WS2812 RGB color command handler.
+ * 
+ * @param strip[IN] Grow light strip.
+ * @param data[IN] Received MQTT data.
+ * @param data_len[IN] Received MQTT data length.
+ */
+static void mqtt_rgb_color_handler(user_rmt_strip_t strip, const char *data, int data_len)
+{
+    uint8_t rgb[3];
+
+    if (user_esp32_codec_decode_rgb(data, data_len, rgb) != ESP_OK)
+    {
+        ESP_LOGE(TAG, "UNKNOW DATA.");
+        return;
+    }
+
+    ESP_LOGI(TAG, "RGB%d color %u,%u,%u.", strip + 1, rgb[0], rgb[1], rgb[2]);
+
+    user_esp32_light_set_active(strip, false);
+    user_esp32_rmt_set_color(strip, rgb);
+}
+
+/**
+ * @brief  WS2812 RGB light recipe command handler.
+ * 
+ * @param strip[IN] Grow light strip.
+ * @note Configuration payload, text in both payload formats, "on"/"off" included.
+ * 
+ * @param data[IN] Received MQTT data, "on"/"off" to resume or pause the stored recipe,
+ *                 otherwise a new recipe "minute,brightness,red,green,blue;...".
+ * @param data_len[IN] Received MQTT data length.
+ */
+static void mqtt_rgb_recipe_handler(user_rmt_strip_t strip, const char *data, int data_len)
+{
+    light_recipe_keyframe_t keyframes[LIGHT_RECIPE_MAX_KEYFRAMES];
+    int count = 0;
+    esp_err_t ret = ESP_OK;
+
+    if (MQTT_DATA_EQUAL(data, data_len, "on") || MQTT_DATA_EQUAL(data, data_len, "off"))
+    {
+        user_esp32_light_set_active(strip, MQTT_DATA_EQUAL(data, data_len, "on"));
+        return;
+    }
+
+    count = light_recipe_parse(data, data_len, keyframes, LIGHT_RECIPE_MAX_KEYFRAMES);
+    ret = (count < 0) ? ESP_ERR_INVALID_ARG : user_esp32_light_set_recipe(strip, keyframes, count);
+    if (ret == ESP_ERR_INVALID_ARG)
+    {
+        ESP_LOGE(TAG, "UNKNOW DATA.");
+        return;
+    }
+    if (ret != ESP_OK)
+    {
+        /* Not initialized, or applied but not stored in NVS. */
+        ESP_LOGE(TAG, "RGB%d recipe with %d keyframes failed. Error Code: (%s).", strip + 1, count, esp_err_to_name(ret));
+        return;
+    }
+
+    ESP_LOGI(TAG, "RGB%d recipe with %d keyframes.", strip + 1, count);
+}
+
+static void mqtt_rgb_state1_handler(const char *data, int data_len)
+{
+    mqtt_rgb_state_handler(USER_RMT_STRIP1, data, data_len);
+}
+
+static void mqtt_rgb_state2_handler(const char *data, int data_len)
+{
+    mqtt_rgb_state_handler(USER_RMT_STRIP2, data, data_len);
+}
+
+static void mqtt_rgb_light1_handler(const char *data, int data_len)
+{
+    mqtt_rgb_light_handler(USER_RMT_STRIP1, data, data_len);
+}
+
+static void mqtt_rgb_light2_handler(const char *data, int data_len)
+{
+    mqtt_rgb_light_handler(USER_RMT_STRIP2, data, data_len);
+}
+
+static void mqtt_rgb_color1_handler(const char *data, int data_len)
+{
+    mqtt_rgb_color_handler(USER_RMT_STRIP1, data, data_len);
+}
+
+static void mqtt_rgb_color2_handler(const char *data, int data_len)
+{
+    mqtt_rgb_color_handler(USER_RMT_STRIP2, data, data_len);
+}
+
+static void mqtt_rgb_recipe1_handler(const char *data, int data_len)
+{
+    mqtt_rgb_recipe_handler(USER_RMT_STRIP1, data, data_len);
+}
+
+static void mqtt_rgb_recipe2_handler(const char *data, int data_len)
+{
+    mqtt_rgb_recipe_handler(USER_RMT_STRIP2, data, data_len);
+}
+
+static void mqtt_fan_state1_handler(const char *data, int data_len)
+{
+    bool on;
+
+    if (user_esp32_codec_decode_switch(data, data_len, &on) != ESP_OK)
+    {
+        ESP_LOGE(TAG, "UNKNOW DATA.");
+        return;
+    }
+
+    ESP_LOGI(TAG, "Fan1 %s.", on ? "on" : "off");
+
+    user_esp32_hardware_set_output(USER_HARDWARE_OUTPUT_FAN1, on);
+}
+
+static void mqtt_fan_speed1_handler(const char *data, int data_len)
+{
+    uint32_t speed;
+
+    if (user_esp32_codec_decode_level(data, data_len, 100, &speed) != ESP_OK)
+    {
+        ESP_LOGE(TAG, "UNKNOW DATA.");
+        return;
+    }
+
+    ESP_LOGI(TAG, "Fan1 speed %" PRIu32 "%%.", speed);
+
+    user_esp32_fan_set_target_rpm(speed * USER_FAN_RATED_RPM / 100);
+}
+
+static void mqtt_ota_service_handler(const char *data, int data_len)
+{
+    if (MQTT_DATA_EQUAL(data, data_len, "start"))
+    {
+        /* Start HTTPS OTA Service. */
+        user_esp32_start_ota_service();
+    }
+}
+
+/**
+ * @brief  Payload format command handler, "text" or "binary".
+ * 
+ * @note Text in both payload formats, so a device can always be switched back.
+ */
+static void mqtt_codec_format_handler(const char *data, int data_len)
+{
+    if (MQTT_DATA_EQUAL(data, data_len, "text"))
+    {
+        user_esp32_codec_set_format(USER_CODEC_FORMAT_TEXT);
+    }
+    else if (MQTT_DATA_EQUAL(data, data_len, "binary"))
+    {
+        user_esp32_codec_set_format(USER_CODEC_FORMAT_BINARY);
+    }
+    else
+    {
+        ESP_LOGE(TAG, "UNKNOW DATA.");
+    }
+}
+
+/**
+ * @brief MQTT subscribe topic dispatch table.
+ * 
+ * @note The topics are found through a hash index built when the client is
+ *       created, the order of the entries does not matter. Every entry is
+ *       subscribed when the client connects, adding a topic only needs a new
+ *       entry here.
+ *       Actuator state topics are last-writer-wins, they bypass the message
+ *       queue and only their newest value is applied.
+ */
+static const mqtt_topic_entry_t mqtt_topic_table[] = {
+    MQTT_TOPIC_ENTRY(SUB_OTA_SERVICE, mqtt_ota_service_handler),
+    MQTT_TOPIC_LATEST_ENTRY(SUB_CODEC_FORMAT, mqtt_codec_format_handler),
+    MQTT_TOPIC_LATEST_ENTRY(SUB_FAN_STATE1, mqtt_fan_state1_handler),
+    MQTT_TOPIC_LATEST_ENTRY(SUB_FAN_SPEED1, mqtt_fan_speed1_handler),
+    MQTT_TOPIC_LATEST_ENTRY(SUB_RGB_LIGHT1, mqtt_rgb_light1_handler),
+    MQTT_TOPIC_LATEST_ENTRY(SUB_RGB_STATE1, mqtt_rgb_state1_handler),
+    MQTT_TOPIC_ENTRY(SUB_RGB_RECIPE1, mqtt_rgb_recipe1_handler),
+    MQTT_TOPIC_LATEST_ENTRY(SUB_RGB_COLOR1, mqtt_rgb_color1_handler),
+    MQTT_TOPIC_LATEST_ENTRY(SUB_SWITCH_VALVE_STATE1, mqtt_switch_valve1_handler),
+    MQTT_TOPIC_LATEST_ENTRY(SUB_IRRIGATION_STATE, mqtt_irrigation_state_handler),
+    MQTT_TOPIC_ENTRY(SUB_IRRIGATION_ZONE, mqtt_irrigation_zone_handler),
+    MQTT_TOPIC_LATEST_ENTRY(SUB_PUMP_STATE1, mqtt_pump1_handler),
+    MQTT_TOPIC_LATEST_ENTRY(SUB_RGB_LIGHT2, mqtt_rgb_light2_handler),
+    MQTT_TOPIC_LATEST_ENTRY(SUB_RGB_STATE2, mqtt_rgb_state2_handler),
+    MQTT_TOPIC_ENTRY(SUB_RGB_RECIPE2, mqtt_rgb_recipe2_handler),
+    MQTT_TOPIC_LATEST_ENTRY(SUB_RGB_COLOR2, mqtt_rgb_color2_handler),
+    MQTT_TOPIC_LATEST_ENTRY(SUB_SWITCH_VALVE_STATE2, mqtt_switch_valve2_handler),
+    MQTT_TOPIC_LATEST_ENTRY(SUB_SWITCH_VALVE_STATE3, mqtt_switch_valve3_handler),
+};
+
+/** @brief MQTT subscribe topic dispatch table size. */
+#define MQTT_TOPIC_TABLE_SIZE   ((int)(sizeof(mqtt_topic_table) / sizeof(mqtt_topic_table[0])))
+
+/** @brief The dirty bitmap has one bit per dispatch table entry. */
+_Static_assert(MQTT_TOPIC_TABLE_SIZE <= USER_MQTT_LATEST_SLOTS, "MQTT topic table exceeds the latest value slots");
+_Static_assert(MQTT_TOPIC_TABLE_SIZE <= MQTT_TOPIC_INDEX_SIZE / 2, "MQTT topic table exceeds the topic hash index");
+
+/** @brief Hash index of the dispatch table. */
+static mqtt_topic_index_t mqtt_topic_index;
+
+/** @brief Newest values of last-writer-wins topics, slots indexed like the dispatch table. */
+static user_mqtt_latest_t mqtt_latest;
+static portMUX_TYPE mqtt_latest_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief  Store the newest value of a last-writer-wins topic and wake the processing task.
+ * 
+ * @param entry[IN] Dispatch table entry of the topic.
+ * @param data[IN] Received MQTT data.
+ * @param data_len[IN] Received MQTT data length, at most USER_MQTT_LATEST_DATA_MAX_LENGTH.
+ */
+static void mqtt_latest_store(const mqtt_topic_entry_t *entry, const char *data, int data_len)
+{
+    uint32_t slot = entry - mqtt_topic_table;
+
+    portENTER_CRITICAL(&mqtt_latest_lock);
+    if (user_mqtt_latest_store(&mqtt_latest, slot, data, data_len, mqtt_msg_seq++) == true)
+    {
+        /* The previous value was never applied. */
+        mqtt_msg_pool.stats.superseded++;
+    }
+    portEXIT_CRITICAL(&mqtt_latest_lock);
+
+    mqtt_msg_pool.stats.latest++;
+    xTaskNotifyGive(mqtt_msg_proc_task_handle);
+}
+/**
+ * @brief  Apply, in arrival order, the newest value of every last-writer-wins topic stored before a sequence number.
+ * 
+ * @param before[IN] Sequence number, later values are left for the next call.
+ */
+static void mqtt_latest_apply(uint32_t before)
+{
+    user_mqtt_latest_value_t value;
+
+    while (1)
+    {
+        /* Take the oldest pending value, copied out so the handler runs without holding the lock. */
+        portENTER_CRITICAL(&mqtt_latest_lock);
+        int slot = user_mqtt_latest_take(&mqtt_latest, before, &value);
+        portEXIT_CRITICAL(&mqtt_latest_lock);
+
+        if (slot < 0)
+        {
+            return;
+        }
+
+        mqtt_topic_table[slot].handler(value.data, value.data_len);
+    }
+}
+/**
+ * @brief  Take the message pool lock, for the reassembly of the MQTT client task.
+ */
+static void mqtt_msg_pool_lock(void *ctx)
+{
+    portENTER_CRITICAL((portMUX_TYPE *)ctx);
+}
+/**
+ * @brief  Give the message pool lock back.
+ */
+static void mqtt_msg_pool_unlock(void *ctx)
+{
+    portEXIT_CRITICAL((portMUX_TYPE *)ctx);
+}
+/**
+ * @brief  Return a slot to the message pool.
+ * 
+ * @param index[IN] Slot index.
+ */
+static void mqtt_msg_pool_release(uint8_t index)
+{
+    portENTER_CRITICAL(&mqtt_msg_lock);
+    user_mqtt_pool_release(&mqtt_msg_pool, index);
+    portEXIT_CRITICAL(&mqtt_msg_lock);
+}
+/**
+ * @brief  Take the oldest queued message.
+ * 
+ * @param index[OUT] Slot index, held by the processing task until released.
+ * 
+ * @return - true   a message was queued.
+ *         - false  the queue is empty.
+ */
+static bool mqtt_msg_pool_receive(uint8_t *index)
+{
+    bool received;
+
+    portENTER_CRITICAL(&mqtt_msg_lock);
+    received = user_mqtt_pool_receive(&mqtt_msg_pool, index);
+    portEXIT_CRITICAL(&mqtt_msg_lock);
+
+    return received;
+}
+/**
+ * @brief  Get the number of queued messages.
+ */
+static uint32_t mqtt_msg_pool_waiting(void)
+{
+    uint32_t count;
+
+    portENTER_CRITICAL(&mqtt_msg_lock);
+    count = mqtt_msg_pool.queue_count;
+    portEXIT_CRITICAL(&mqtt_msg_lock);
+
+    return count;
+}
+/**
+ * @brief  Publish MQTT ingress statistics, at most once per MQTT_INGRESS_STATS_PERIOD_MS.
+ */
+static void mqtt_ingress_stats_publish(void)
+{
+    static TickType_t last_tick = 0;
+    TickType_t tick = xTaskGetTickCount();
+    user_mqtt_pool_stats_t stats;
+    char payload[256];
+
+    if ((mqtt_connected == false) || ((tick - last_tick) < pdMS_TO_TICKS(MQTT_INGRESS_STATS_PERIOD_MS)))
+    {
+        return;
+    }
+    last_tick = tick;
+
+    user_esp32_mqtt_get_pool_stats(&stats);
+    int len = snprintf(payload, sizeof(payload),
+                       "{\"received\":%" PRIu32 ",\"overflow\":%" PRIu32 ",\"droppedOldest\":%" PRIu32
+                       ",\"droppedNewest\":%" PRIu32 ",\"coalesced\":%" PRIu32 ",\"oversized\":%" PRIu32
+                       ",\"incomplete\":%" PRIu32 ",\"highWaterMark\":%" PRIu32 ",\"latest\":%" PRIu32
+                       ",\"superseded\":%" PRIu32 "}",
+                       stats.received, stats.overflow, stats.dropped_oldest, stats.dropped_newest,
+                       stats.coalesced, stats.oversized, stats.incomplete, stats.high_water_mark,
+                       stats.latest, stats.superseded);
+    ESP_MQTT_MSG_ID_CHECK(esp_mqtt_client_publish(mqtt_client, PUB_MQTT_INGRESS_STATE, payload, len, MQTT_QOS_LEVEL, 0));
+}
 /**
  * @brief  MQTT message processing task.
  * 
@@ -121,103 +605,57 @@ extern const uint8_t mqtt_server_cert_pem_end[] asm("_binary__mqtt_ca_cert_pem_e
  */
 static void mqtt_msg_proc_task(void * pvParameters)
 {
-    BaseType_t uxBits;
-    esp_mqtt_message_t mqtt_msg;
+    uint8_t index;
+    user_mqtt_msg_t *mqtt_msg;
+    const mqtt_topic_entry_t *entry;
+    uint32_t seq;
 
     while(1)
     {
-        uxBits = xQueueReceive(mqtt_msg_queue_handle, &mqtt_msg, portMAX_DELAY);
-        if (uxBits == pdPASS)
-        {
-            ESP_LOGI(TAG, "Message processing.");
+        /* Woken once per burst of new values or queued messages. */
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(MQTT_INGRESS_STATS_PERIOD_MS));
 
-            if (memcmp(mqtt_msg.topic, SUB_SWITCH_VALVE_STATE1, mqtt_msg.topic_len) == 0)
-            {
-                if (memcmp(mqtt_msg.data, "on", mqtt_msg.data_len) == 0)
-                {
-                    ESP_LOGI(TAG, "First switch valve on.");
-                }
-                else if (memcmp(mqtt_msg.data, "off", mqtt_msg.data_len) == 0)
-                {
-                    ESP_LOGI(TAG, "First switch valve off.");
-                }
-                else
-                {
-                    ESP_LOGE(TAG, "UNKNOW DATA.");
-                }
-            }
-            else if (memcmp(mqtt_msg.topic, SUB_SWITCH_VALVE_STATE2, mqtt_msg.topic_len) == 0)
-            {
-                if (memcmp(mqtt_msg.data, "on", mqtt_msg.data_len) == 0)
-                {
-                    ESP_LOGI(TAG, "Second switch valve on.");
-                }
-                else if (memcmp(mqtt_msg.data, "off", mqtt_msg.data_len) == 0)
-                {
-                    ESP_LOGI(TAG, "Second switch valve off.");
-                }
-            }
-            else if (memcmp(mqtt_msg.topic, SUB_SWITCH_VALVE_STATE3, mqtt_msg.topic_len) == 0)
+        while (1)
+        {
+            if (mqtt_msg_pool_receive(&index) == false)
             {
-                if (memcmp(mqtt_msg.data, "on", mqtt_msg.data_len) == 0)
+                /* Every message numbered before seq is queued by now, so an empty queue
+                   leaves only values, otherwise the new message goes first. */
+                seq = mqtt_msg_seq;
+                if (mqtt_msg_pool_waiting() != 0)
                 {
-                    ESP_LOGI(TAG, "Third switch valve on.");
+                    continue;
                 }
-                else if (memcmp(mqtt_msg.data, "off", mqtt_msg.data_len) == 0)
-                {
-                    ESP_LOGI(TAG, "Third switch valve off.");
-                }
-            }
-            else if (memcmp(mqtt_msg.topic, SUB_PUMP_STATE1, mqtt_msg.topic_len) == 0)
-            {
-            }
-            else if (memcmp(mqtt_msg.topic, SUB_RGB_STATE1, mqtt_msg.topic_len) == 0)
-            {
-            }
-            else if (memcmp(mqtt_msg.topic, SUB_RGB_STATE2, mqtt_msg.topic_len) == 0)
-            {
-            }
-            else if (memcmp(mqtt_msg.topic, SUB_RGB_LIGHT1, mqtt_msg.topic_len) == 0)
-            {
-            }
-            else if (memcmp(mqtt_msg.topic, SUB_RGB_LIGHT2, mqtt_msg.topic_len) == 0)
-            {
-            }
-            else if (memcmp(mqtt_msg.topic, SUB_RGB_COLOR1, mqtt_msg.topic_len) == 0)
-            {
-            }
-            else if (memcmp(mqtt_msg.topic, SUB_RGB_COLOR2, mqtt_msg.topic_len) == 0)
-            {
-            }
-            else if (memcmp(mqtt_msg.topic, SUB_FAN_STATE1, mqtt_msg.topic_len) == 0)
-            {
+
+                /* Apply only the newest value of each actuator. */
+                mqtt_latest_apply(seq);
+                break;
             }
-            else if (memcmp(mqtt_msg.topic, SUB_FAN_SPEED1, mqtt_msg.topic_len) == 0)
+
+            ESP_LOGI(TAG, "Message processing.");
+
+            /* Out of the queue, the MQTT client task no longer writes the slot. */
+            mqtt_msg = &mqtt_msg_pool.slots[index];
+
+            /* Actuator values that arrived before this message go first. */
+            mqtt_latest_apply(mqtt_msg->seq);
+
+            entry = mqtt_topic_index_lookup(&mqtt_topic_index, mqtt_msg->topic, mqtt_msg->topic_len);
+            if (entry != NULL)
             {
+                entry->handler(mqtt_msg->data, mqtt_msg->data_len);
             }
-            else if (memcmp(mqtt_msg.topic, SUB_OTA_SERVICE, mqtt_msg.topic_len) == 0)
+            else
             {
-                if (memcmp(mqtt_msg.data, "start", mqtt_msg.data_len) == 0)
-                {
-                    /* Start HTTPS OTA Service. */
-                    user_esp32_start_ota_service();
-                }
+                ESP_LOGE(TAG, "UNKNOW MQTT TOPIC: %.*s.", mqtt_msg->topic_len, mqtt_msg->topic);
             }
-            // else
-            // {
-            //     ESP_LOGE(TAG, "UNKNOW MQTT TOPIC.");
-            //     ESP_LOGE(TAG, "TOPIC: %s.", mqtt_msg.topic);
-            //     ESP_LOGE(TAG, "DATA: %s.", mqtt_msg.data);
-            // }
-
-            /* Release memory resources. */
-            free(mqtt_msg.topic);
-            free(mqtt_msg.data);
-        }
-        else
-        {
-            ESP_LOGE(TAG, "MQTT message queue receive failed.");
+
+            /* Return the slot to the message pool. */
+            mqtt_msg_pool_release(index);
         }
+
+        /* Publish overflow counters as telemetry. */
+        mqtt_ingress_stats_publish();
     }
 }
 /**
@@ -228,19 +666,10 @@ static void mqtt_msg_proc_task(void * pvParameters)
 static void user_mqtt_topic_init(esp_mqtt_client_handle_t client)
 {
     /* Subscribe to MQTT topics */
-    ESP_MQTT_MSG_ID_CHECK(esp_mqtt_client_subscribe(client, SUB_SWITCH_VALVE_STATE1, MQTT_QOS_LEVEL));
-    ESP_MQTT_MSG_ID_CHECK(esp_mqtt_client_subscribe(client, SUB_SWITCH_VALVE_STATE2, MQTT_QOS_LEVEL));
-    ESP_MQTT_MSG_ID_CHECK(esp_mqtt_client_subscribe(client, SUB_SWITCH_VALVE_STATE3, MQTT_QOS_LEVEL));
-    ESP_MQTT_MSG_ID_CHECK(esp_mqtt_client_subscribe(client, SUB_PUMP_STATE1, MQTT_QOS_LEVEL));
-    ESP_MQTT_MSG_ID_CHECK(esp_mqtt_client_subscribe(client, SUB_RGB_STATE1, MQTT_QOS_LEVEL));
-    ESP_MQTT_MSG_ID_CHECK(esp_mqtt_client_subscribe(client, SUB_RGB_STATE2, MQTT_QOS_LEVEL));
-    ESP_MQTT_MSG_ID_CHECK(esp_mqtt_client_subscribe(client, SUB_RGB_LIGHT1, MQTT_QOS_LEVEL));
-    ESP_MQTT_MSG_ID_CHECK(esp_mqtt_client_subscribe(client, SUB_RGB_LIGHT2, MQTT_QOS_LEVEL));
-    ESP_MQTT_MSG_ID_CHECK(esp_mqtt_client_subscribe(client, SUB_RGB_COLOR1, MQTT_QOS_LEVEL));
-    ESP_MQTT_MSG_ID_CHECK(esp_mqtt_client_subscribe(client, SUB_RGB_COLOR2, MQTT_QOS_LEVEL));
-    ESP_MQTT_MSG_ID_CHECK(esp_mqtt_client_subscribe(client, SUB_FAN_STATE1, MQTT_QOS_LEVEL));
-    ESP_MQTT_MSG_ID_CHECK(esp_mqtt_client_subscribe(client, SUB_FAN_SPEED1, MQTT_QOS_LEVEL));
-    ESP_MQTT_MSG_ID_CHECK(esp_mqtt_client_subscribe(client, SUB_OTA_SERVICE, MQTT_QOS_LEVEL));
+    for (int i = 0; i < MQTT_TOPIC_TABLE_SIZE; i++)
+    {
+        ESP_MQTT_MSG_ID_CHECK(esp_mqtt_client_subscribe(client, mqtt_topic_table[i].topic, MQTT_QOS_LEVEL));
+    }
 
     // /* Publish default values to MQTT topics */
     // ESP_MQTT_MSG_ID_CHECK(esp_mqtt_client_publish(client, PUB_SWITCH_VALVE_STATE1, "off", 0, MQTT_QOS_LEVEL, 0));
@@ -263,6 +692,72 @@ static void user_mqtt_topic_init(esp_mqtt_client_handle_t client)
     // ESP_MQTT_MSG_ID_CHECK(esp_mqtt_client_publish(client, PUB_ENVM_TMOS1, "0.0", 0, MQTT_QOS_LEVEL, 0));
     // ESP_MQTT_MSG_ID_CHECK(esp_mqtt_client_publish(client, PUB_TDS_VALUE1, "0.0", 0, MQTT_QOS_LEVEL, 0));
 }
+/**
+ * @brief  Reassemble MQTT_EVENT_DATA fragments into a message pool slot, see user_mqtt_assembly_feed.
+ * 
+ * @param event[IN] MQTT_EVENT_DATA event.
+ */
+static void mqtt_msg_reassemble(esp_mqtt_event_handle_t event)
+{
+    user_mqtt_fragment_t fragment = {
+        .topic = event->topic,
+        .topic_len = event->topic_len,
+        .data = event->data,
+        .data_len = event->data_len,
+        .offset = event->current_data_offset,
+        .total_len = event->total_data_len,
+    };
+
+    if (event->current_data_offset == 0)
+    {
+        ESP_LOGI(TAG, "Received message, Topic=%.*s.", event->topic_len, event->topic);
+
+        /* Small, unfragmented last-writer-wins values overwrite the actuator slot. */
+        const mqtt_topic_entry_t *entry = mqtt_topic_index_lookup(&mqtt_topic_index, event->topic, event->topic_len);
+        if ((entry != NULL) && (entry->latest_only == true) &&
+            (event->data_len == event->total_data_len) && (event->data_len <= USER_MQTT_LATEST_DATA_MAX_LENGTH))
+        {
+            mqtt_latest_store(entry, event->data, event->data_len);
+            return;
+        }
+
+        if (mqtt_msg_assembly.index != USER_MQTT_POOL_INDEX_NONE)
+        {
+            ESP_LOGE(TAG, "MQTT message incomplete, dropped.");
+        }
+    }
+
+    /* The sequence number is only advanced once the message is queued, see mqtt_msg_proc_task. */
+    switch (user_mqtt_assembly_feed(&mqtt_msg_assembly, &fragment, mqtt_msg_seq))
+    {
+    case USER_MQTT_ASSEMBLY_QUEUED:
+    {
+        mqtt_msg_seq++;
+        xTaskNotifyGive(mqtt_msg_proc_task_handle);
+        break;
+    }
+    case USER_MQTT_ASSEMBLY_OVERSIZED:
+    {
+        ESP_LOGE(TAG, "MQTT message too long, dropped.");
+        break;
+    }
+    case USER_MQTT_ASSEMBLY_EXHAUSTED:
+    {
+        ESP_LOGE(TAG, "MQTT message pool exhausted, dropped.");
+        break;
+    }
+    case USER_MQTT_ASSEMBLY_OUT_OF_RANGE:
+    {
+        ESP_LOGE(TAG, "MQTT message fragment out of range, dropped.");
+        break;
+    }
+    default:
+    {
+        /* Pending, merged into a queued message, or the rest of a dropped one. */
+        break;
+    }
+    }
+}
 /**
  * @brief  Wi-Fi Station Mode Event Group CallBack.
  * 
@@ -275,13 +770,16 @@ static void mqtt_event_handler(void *args, esp_event_base_t event_base, int32_t
 {
     esp_mqtt_event_handle_t event = event_data;
     esp_mqtt_client_handle_t client = event->client;
-    esp_mqtt_message_t msg;
 
     switch ((esp_mqtt_event_id_t)event_id)
     {
     case MQTT_EVENT_CONNECTED:
     {
         ESP_LOGI(TAG, "Connected to server.");
+        mqtt_connected = true;
+
+        /* Forward telemetry stored while the broker was unreachable. */
+        user_esp32_store_resume();
 
         /* Subscribe to related topics. */
         user_mqtt_topic_init(client);
@@ -290,6 +788,10 @@ static void mqtt_event_handler(void *args, esp_event_base_t event_base, int32_t
     case MQTT_EVENT_DISCONNECTED:
     {
         ESP_LOGI(TAG, "Disconnected from server.");
+        mqtt_connected = false;
+
+        /* The rest of a fragmented message will never arrive. */
+        user_mqtt_assembly_abort(&mqtt_msg_assembly);
         break;
     }
     case MQTT_EVENT_SUBSCRIBED:
@@ -309,30 +811,8 @@ static void mqtt_event_handler(void *args, esp_event_base_t event_base, int32_t
     }
     case MQTT_EVENT_DATA:
     {
-        ESP_LOGI(TAG, "Received message, Topic=%.*s.", event->topic_len, event->topic);
-
-        /* Received MQTT topic. */
-        msg.topic = calloc(event->topic_len, sizeof(char));
-        if (msg.topic == NULL)
-        {
-            ESP_LOGE(TAG, "Heap memory application failed when MQTT receiving topic.");
-            break;
-        }
-        msg.topic_len = event->topic_len;
-        memcpy(msg.topic, event->topic, msg.topic_len);
-
-        /* Received MQTT data. */
-        msg.data = calloc(event->data_len, sizeof(char));
-        if (msg.data == NULL)
-        {
-            ESP_LOGE(TAG, "Heap memory application failed when MQTT receiving data.");
-            break;
-        }
-        msg.data_len = event->data_len;
-        memcpy(msg.data, event->data, msg.data_len);
-
-        /* Send topic messages to the MQTT message queue */
-        xQueueSend(mqtt_msg_queue_handle, &msg, portMAX_DELAY);
+        /* Fragments are written into one pool slot until the message is complete. */
+        mqtt_msg_reassemble(event);
         break;
     }
     case MQTT_EVENT_ERROR:
@@ -360,6 +840,36 @@ esp_err_t user_esp32_create_mqtt_client(void)
     /* Determine whether the MQTT service is created. */
     if (mqtt_client == NULL)
     {
+        /* Index the topics before any event can arrive, a topic listed twice is only found once. */
+        if (mqtt_topic_index_build(&mqtt_topic_index, mqtt_topic_table, MQTT_TOPIC_TABLE_SIZE) >= 0)
+        {
+            ESP_LOGE(TAG, "MQTT topic table lists a topic twice.");
+            return ESP_FAIL;
+        }
+
+        /* Create MQTT message pool and queue before any event can arrive. */
+        portENTER_CRITICAL(&mqtt_msg_lock);
+        user_mqtt_pool_init(&mqtt_msg_pool, mqtt_overflow_policy);
+        portEXIT_CRITICAL(&mqtt_msg_lock);
+        user_mqtt_assembly_init(&mqtt_msg_assembly, &mqtt_msg_pool, mqtt_msg_pool_lock, mqtt_msg_pool_unlock,
+                                &mqtt_msg_lock);
+        portENTER_CRITICAL(&mqtt_latest_lock);
+        user_mqtt_latest_init(&mqtt_latest);
+        portEXIT_CRITICAL(&mqtt_latest_lock);
+
+        /* Create MQTT message processing task. */
+        BaseType_t uxBits = xTaskCreate(mqtt_msg_proc_task,             /* Pointer to the task entry function. */
+                                        "MQTT message processing task", /*  Descriptive name for the task. */
+                                        MQTT_MSG_PROC_TASK_STACK_DEPTH, /* The size of the task stack specified as the number of bytes. */
+                                        NULL,                           /* Pointer that will be used as the parameter for the task being created. */
+                                        MQTT_MSG_PROC_TASK_PRIORITY,    /* The priority at which the task should run.  */
+                                        &mqtt_msg_proc_task_handle);    /* Used to pass back a handle by which the created task can be referenced. */
+        if (uxBits != pdPASS)
+        {
+            ESP_LOGE(TAG, "Message processing task creation failed.");
+            return ESP_FAIL;
+        }
+
         /* MQTT client configuration parameters.*/
         esp_mqtt_client_config_t mqtt_config = {
             .uri = DEFAULT_MQTT_BROKER_URL,
@@ -387,29 +897,82 @@ esp_err_t user_esp32_create_mqtt_client(void)
             ESP_LOGE(TAG, "MQTT client start failure. ERROR CODE:(%s).", esp_err_to_name(ret));
             return ret;
         }
+    }
 
-        /* Create MQTT message queue. */
-        mqtt_msg_queue_handle = xQueueCreate(MAXIMUM_MQTT_MSG_LENGTH, sizeof(esp_mqtt_message_t));
-        if (mqtt_msg_queue_handle == NULL)
-        {
-            ESP_LOGE(TAG, "Message queue creation failed.");
-            return ESP_FAIL;
-        }
+    return ESP_OK;
+}
+/**
+ * @brief  Publish a message with the default Quality of Service.
+ * 
+ * @param topic[IN] Publish topic.
+ * @param data[IN] Payload.
+ * @param len[IN] Payload length, 0 means a null terminated string.
+ * 
+ * @return - message id, 0 for Quality of Service 0.
+ *         - -1 if the client is not connected or the publish failed.
+ */
+int user_esp32_mqtt_publish(const char *topic, const char *data, int len)
+{
+    if ((mqtt_client == NULL) || (mqtt_connected == false))
+    {
+        return -1;
+    }
 
-        /* Create MQTT message processing task. */
-        BaseType_t uxBits = xTaskCreate(mqtt_msg_proc_task,             /* Pointer to the task entry function. */
-                                        "MQTT message processing task", /*  Descriptive name for the task. */
-                                        MQTT_MSG_PROC_TASK_STACK_DEPTH, /* The size of the task stack specified as the number of bytes. */
-                                        NULL,                           /* Pointer that will be used as the parameter for the task being created. */
-                                        MQTT_MSG_PROC_TASK_PRIORITY,    /* The priority at which the task should run.  */
-                                        &mqtt_msg_proc_task_handle);    /* Used to pass back a handle by which the created task can be referenced. */
-        if (uxBits != pdPASS)
-        {
-            ESP_LOGE(TAG, "Message processing task creation failed.");
-            return ESP_FAIL;
-        }
+    return esp_mqtt_client_publish(mqtt_client, topic, data, len, MQTT_QOS_LEVEL, 0);
+}
+/**
+ * @brief  Get MQTT client connection status.
+ * 
+ * @return - true   connected to the broker.
+ *         - false  not connected.
+ */
+bool user_esp32_mqtt_is_connected(void)
+{
+    return mqtt_connected;
+}
+/**
+ * @brief  Get MQTT message pool statistics.
+ * 
+ * @param stats[OUT] Message pool statistics.
+ * 
+ * @return - ESP_OK              succeed
+ *         - ESP_ERR_INVALID_ARG stats is NULL
+ */
+esp_err_t user_esp32_mqtt_get_pool_stats(user_mqtt_pool_stats_t *stats)
+{
+    if (stats == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
     }
 
+    portENTER_CRITICAL(&mqtt_msg_lock);
+    *stats = mqtt_msg_pool.stats;
+    stats->in_use = (mqtt_msg_proc_task_handle == NULL) ? 0 : (USER_MQTT_POOL_SIZE - mqtt_msg_pool.free_count);
+    portEXIT_CRITICAL(&mqtt_msg_lock);
+
+    return ESP_OK;
+}
+/**
+ * @brief  Set the MQTT ingress overflow policy, applied when the message pool is exhausted.
+ * 
+ * @param policy[IN] Overflow policy.
+ * 
+ * @return - ESP_OK              succeed
+ *         - ESP_ERR_INVALID_ARG unknown policy
+ */
+esp_err_t user_esp32_mqtt_set_overflow_policy(user_mqtt_overflow_policy_t policy)
+{
+    if ((policy != USER_MQTT_OVERFLOW_DROP_OLDEST) && (policy != USER_MQTT_OVERFLOW_DROP_NEWEST) &&
+        (policy != USER_MQTT_OVERFLOW_COALESCE))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&mqtt_msg_lock);
+    mqtt_overflow_policy = policy;
+    mqtt_msg_pool.policy = policy;
+    portEXIT_CRITICAL(&mqtt_msg_lock);
+
     return ESP_OK;
 }
 /**
@@ -5,19 +5,331 @@
  * @author  : Cao Jin
  * @date    : 20-Oct-2021
  * @version : 1.0.0
+ *
+ * @note Duty changes ramp in the LEDC hardware fade engine. The fade end
+ *       interrupt defers to the timer service task, which reports completion
+ *       and starts the newest request that arrived during the ramp.
  *****************************************************************************
  */
 
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/timers.h"
+
 #include "esp_err.h"
 #include "esp_log.h"
+#include "esp_attr.h"
+#include "driver/ledc.h"
+#include "hal/cpu_hal.h"
 
 #include "user_esp32_pwm.h"
 
+/**
+ * @brief PWM channel configuration.
+ */
+typedef struct
+{
+    gpio_num_t gpio;
+    ledc_mode_t speed_mode;
+    ledc_timer_t timer;
+    ledc_channel_t channel;
+    uint32_t frequency_hz;
+    ledc_timer_bit_t resolution;
+} pwm_channel_config_t;
+
+/**
+ * @brief PWM channel duty request.
+ */
+typedef struct
+{
+    uint32_t duty;                  /* 0 ~ USER_PWM_DUTY_MAX. */
+    uint32_t ramp_ms;
+    user_pwm_done_cb_t callback;
+    void *arg;
+} pwm_request_t;
+
+/**
+ * @brief PWM channel state.
+ */
+typedef struct
+{
+    bool busy;                      /* A fade is running. */
+    bool pending;                   /* A request waits for the running fade. */
+    pwm_request_t running;
+    pwm_request_t next;
+} pwm_channel_state_t;
+
+/** @brief log output label. */
+static const char *TAG = "PWM Application";
+
+/** @brief PWM channels, indexed by user_pwm_channel_t. */
+static const pwm_channel_config_t pwm_channel_configs[USER_PWM_CHANNEL_MAX] = {
+    /* 4-wire fan, 25kHz is above the audible range, 80MHz / 25kHz leaves 11 bits. */
+    [USER_PWM_FAN1] = { GPIO_NUM_4, LEDC_LOW_SPEED_MODE, LEDC_TIMER_0, LEDC_CHANNEL_0, 25000, LEDC_TIMER_10_BIT },
+};
+
+static pwm_channel_state_t pwm_channel_states[USER_PWM_CHANNEL_MAX];
+static user_pwm_stats_t pwm_channel_stats[USER_PWM_CHANNEL_MAX];
+static portMUX_TYPE pwm_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static bool pwm_initialized = false;
+
+/**
+ * @brief  Start the hardware fade of a request, returns without waiting.
+ * 
+ * @param channel[IN] PWM channel.
+ * @param request[IN] Duty request.
+ * 
+ * @return - ESP_OK   succeed
+ *         - other    failed
+ */
+static esp_err_t pwm_fade_start(user_pwm_channel_t channel, const pwm_request_t *request)
+{
+    const pwm_channel_config_t *config = &pwm_channel_configs[channel];
+    uint32_t duty = (request->duty * ((1UL << config->resolution) - 1) + USER_PWM_DUTY_MAX / 2) / USER_PWM_DUTY_MAX;
+    esp_err_t ret = ESP_OK;
+
+    ret = ledc_set_fade_with_time(config->speed_mode, config->channel, duty, (int)request->ramp_ms);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+
+    return ledc_fade_start(config->speed_mode, config->channel, LEDC_FADE_NO_WAIT);
+}
+/**
+ * @brief  Fade end handler, runs in the timer service task.
+ * 
+ * @param param1[IN] PWM channel.
+ * @param param2[IN] Unused.
+ */
+static void pwm_fade_done(void *param1, uint32_t param2)
+{
+    user_pwm_channel_t channel = (user_pwm_channel_t)(uintptr_t)param1;
+    pwm_channel_state_t *state = &pwm_channel_states[channel];
+    pwm_request_t done;
+    bool start_next = false;
+
+    portENTER_CRITICAL(&pwm_lock);
+    done = state->running;
+    pwm_channel_stats[channel].fades++;
+    if (state->pending)
+    {
+        state->pending = false;
+        state->running = state->next;
+        start_next = true;
+    }
+    else
+    {
+        state->busy = false;
+    }
+    portEXIT_CRITICAL(&pwm_lock);
+
+    if (done.callback != NULL)
+    {
+        done.callback(channel, done.duty, done.arg);
+    }
+
+    if (start_next && (pwm_fade_start(channel, &state->running) != ESP_OK))
+    {
+        ESP_LOGE(TAG, "Channel%d fade start failed.", channel);
+        portENTER_CRITICAL(&pwm_lock);
+        state->busy = false;
+        pwm_channel_stats[channel].errors++;
+        portEXIT_CRITICAL(&pwm_lock);
+    }
+}
+/**
+ * @brief  LEDC fade end interrupt callback.
+ * 
+ * @param param[IN] LEDC event.
+ * @param user_arg[IN] PWM channel.
+ * 
+ * @return Whether a higher priority task has been woken.
+ */
+static bool IRAM_ATTR pwm_fade_end_isr(const ledc_cb_param_t *param, void *user_arg)
+{
+    BaseType_t woken = pdFALSE;
+
+    if (param->event == LEDC_FADE_END_EVT)
+    {
+        xTimerPendFunctionCallFromISR(pwm_fade_done, user_arg, 0, &woken);
+    }
+
+    return (woken == pdTRUE);
+}
+/**
+ * @brief  Initialize the PWM channels, all outputs at 0 duty.
+ * 
+ * @return - ESP_OK   succeed
+ *         - other    failed
+ */
 esp_err_t user_esp32_pwm_init(void)
 {
-    
+    esp_err_t ret = ESP_OK;
+
+    if (pwm_initialized)
+    {
+        return ESP_OK;
+    }
 
+    ret = ledc_fade_func_install(0);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "LEDC fade install failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    for (int i = 0; i < USER_PWM_CHANNEL_MAX; i++)
+    {
+        const pwm_channel_config_t *config = &pwm_channel_configs[i];
+        ledc_timer_config_t timer_config = {
+            .speed_mode = config->speed_mode,
+            .duty_resolution = config->resolution,
+            .timer_num = config->timer,
+            .freq_hz = config->frequency_hz,
+            .clk_cfg = LEDC_AUTO_CLK,
+        };
+        ledc_channel_config_t channel_config = {
+            .gpio_num = config->gpio,
+            .speed_mode = config->speed_mode,
+            .channel = config->channel,
+            .intr_type = LEDC_INTR_DISABLE,
+            .timer_sel = config->timer,
+            .duty = 0,
+            .hpoint = 0,
+        };
+        ledc_cbs_t callbacks = {
+            .fade_cb = pwm_fade_end_isr,
+        };
+
+        ret = ledc_timer_config(&timer_config);
+        if (ret != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Channel%d timer config failed: %s", i, esp_err_to_name(ret));
+            return ret;
+        }
+
+        ret = ledc_channel_config(&channel_config);
+        if (ret != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Channel%d config failed: %s", i, esp_err_to_name(ret));
+            return ret;
+        }
+
+        ret = ledc_cb_register(config->speed_mode, config->channel, &callbacks, (void *)(uintptr_t)i);
+        if (ret != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Channel%d callback register failed: %s", i, esp_err_to_name(ret));
+            return ret;
+        }
+    }
+
+    pwm_initialized = true;
+
+    return ESP_OK;
+}
+/**
+ * @brief  Ramp a PWM channel to a duty in hardware, returns immediately.
+ * 
+ * @note A request made during a ramp starts when the ramp ends. Only the newest
+ *       waiting request is kept, replaced requests never call their callback.
+ * 
+ * @param channel[IN] PWM channel.
+ * @param duty[IN] Target duty, 0 ~ USER_PWM_DUTY_MAX.
+ * @param ramp_ms[IN] Ramp time, at least 1ms.
+ * @param callback[IN] Called from the timer service task once the duty is reached, can be NULL.
+ * @param arg[IN] User argument of callback.
+ * 
+ * @return - ESP_OK                succeed
+ *         - ESP_ERR_INVALID_ARG   invalid parameters
+ *         - ESP_ERR_INVALID_STATE not initialized
+ *         - other                 failed
+ */
+esp_err_t user_esp32_pwm_set_duty(user_pwm_channel_t channel, uint32_t duty, uint32_t ramp_ms,
+                                  user_pwm_done_cb_t callback, void *arg)
+{
+    pwm_channel_state_t *state = NULL;
+    pwm_request_t request = { duty, ramp_ms, callback, arg };
+    uint32_t start_cycles = cpu_hal_get_cycle_count();
+    uint32_t cycles = 0;
+    bool start_now = false;
+    esp_err_t ret = ESP_OK;
+
+    if (((unsigned)channel >= USER_PWM_CHANNEL_MAX) || (duty > USER_PWM_DUTY_MAX) || (ramp_ms == 0))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!pwm_initialized)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    state = &pwm_channel_states[channel];
+
+    portENTER_CRITICAL(&pwm_lock);
+    pwm_channel_stats[channel].changes++;
+    if (state->busy)
+    {
+        if (state->pending)
+        {
+            pwm_channel_stats[channel].coalesced++;
+        }
+        state->pending = true;
+        state->next = request;
+    }
+    else
+    {
+        state->busy = true;
+        state->running = request;
+        start_now = true;
+    }
+    portEXIT_CRITICAL(&pwm_lock);
+
+    if (start_now)
+    {
+        ret = pwm_fade_start(channel, &request);
+    }
+
+    cycles = cpu_hal_get_cycle_count() - start_cycles;
+
+    portENTER_CRITICAL(&pwm_lock);
+    if (ret != ESP_OK)
+    {
+        state->busy = false;
+        pwm_channel_stats[channel].errors++;
+    }
+    pwm_channel_stats[channel].last_cycles = cycles;
+    if (cycles > pwm_channel_stats[channel].max_cycles)
+    {
+        pwm_channel_stats[channel].max_cycles = cycles;
+    }
+    portEXIT_CRITICAL(&pwm_lock);
+
+    return ret;
+}
+/**
+ * @brief  Get the statistics of a PWM channel.
+ * 
+ * @param channel[IN] PWM channel.
+ * @param stats[OUT] Statistics.
+ * 
+ * @return - ESP_OK              succeed
+ *         - ESP_ERR_INVALID_ARG invalid parameters
+ */
+esp_err_t user_esp32_pwm_get_stats(user_pwm_channel_t channel, user_pwm_stats_t *stats)
+{
+    if (((unsigned)channel >= USER_PWM_CHANNEL_MAX) || (stats == NULL))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
 
+    portENTER_CRITICAL(&pwm_lock);
+    *stats = pwm_channel_stats[channel];
+    portEXIT_CRITICAL(&pwm_lock);
 
     return ESP_OK;
-}
\ No newline at end of file
+}
+/******************************** End of File *********************************/
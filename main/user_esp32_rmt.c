@@ -8,14 +8,444 @@
  *****************************************************************************
  */
 
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
 #include "esp_err.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "driver/rmt.h"
+#include "hal/cpu_hal.h"
 
 #include "led_strip.h"
 
 #include "user_esp32_rmt.h"
 
+/** @brief RMT counter clock divider, 80MHz / 2 = 25ns per tick. */
+#define RMT_WS2812_CLK_DIV                  (2U)
+
+/** @brief Timeout of a blocking strip refresh. */
+#define RMT_WS2812_REFRESH_TIMEOUT_MS       (100U)
+
+/**
+ * @brief Grow light strip configuration.
+ */
+typedef struct
+{
+    rmt_channel_t channel; /* One RMT channel per strip, the strips transmit in parallel. */
+    gpio_num_t gpio;
+    uint32_t leds;
+} rmt_strip_config_t;
+
+/**
+ * @brief Grow light strip state, every LED shows the same color.
+ */
+typedef struct
+{
+    bool on;
+    uint8_t brightness;
+    uint8_t rgb[3];
+} rmt_strip_state_t;
+
+/** @brief log output label. */
+static const char *TAG = "RMT Application";
+
+/** @brief Grow light strips, indexed by user_rmt_strip_t. */
+static const rmt_strip_config_t rmt_strip_configs[USER_RMT_STRIP_MAX] = {
+    [USER_RMT_STRIP1] = { RMT_CHANNEL_0, GPIO_NUM_25, 60 },
+    [USER_RMT_STRIP2] = { RMT_CHANNEL_1, GPIO_NUM_33, 60 },
+};
+
+static led_strip_t *rmt_strips[USER_RMT_STRIP_MAX];
+
+/** @brief Grow light strip states, off at full brightness and white. */
+static rmt_strip_state_t rmt_strip_states[USER_RMT_STRIP_MAX] = {
+    [USER_RMT_STRIP1] = { false, 255, { 255, 255, 255 } },
+    [USER_RMT_STRIP2] = { false, 255, { 255, 255, 255 } },
+};
+
+/** @brief Strip state and frame lock, the MQTT and the light recipe tasks both render. */
+static SemaphoreHandle_t rmt_mutex = NULL;
+static StaticSemaphore_t rmt_mutex_buffer;
+
+/** @brief Group refresh statistics. */
+static user_rmt_stats_t rmt_stats;
+static portMUX_TYPE rmt_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief  Install the RMT channel and ws2812 driver of a grow light strip.
+ * 
+ * @param strip[IN] Strip.
+ * 
+ * @return - ESP_OK   succeed
+ *         - other    failed
+ */
+static esp_err_t rmt_strip_install(user_rmt_strip_t strip)
+{
+    esp_err_t ret = ESP_OK;
+    const rmt_strip_config_t *strip_cfg = &rmt_strip_configs[strip];
+    rmt_config_t config = RMT_DEFAULT_CONFIG_TX(strip_cfg->gpio, strip_cfg->channel);
+    led_strip_config_t strip_config = LED_STRIP_DEFAULT_CONFIG(strip_cfg->leds, (led_strip_dev_t)strip_cfg->channel);
+
+    config.clk_div = RMT_WS2812_CLK_DIV;
+
+    ret = rmt_config(&config);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Strip%d RMT config failed: %s", strip + 1, esp_err_to_name(ret));
+        return ret;
+    }
+
+    ret = rmt_driver_install(config.channel, 0, 0);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Strip%d RMT driver install failed: %s", strip + 1, esp_err_to_name(ret));
+        return ret;
+    }
+
+    rmt_strips[strip] = led_strip_new_rmt_ws2812(&strip_config);
+    if (rmt_strips[strip] == NULL)
+    {
+        ESP_LOGE(TAG, "Strip%d WS2812 install failed.", strip + 1);
+        rmt_driver_uninstall(config.channel);
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+/**
+ * @brief  Render the state of a strip into its next frame.
+ * 
+ * @note The CPU cycles of the render go to the statistics, the frame hand-over
+ *       and dithering are counted by the driver in last_prepare_cycles.
+ * 
+ * @param strip[IN] Strip.
+ */
+static void rmt_strip_render(user_rmt_strip_t strip)
+{
+    led_strip_t *handle = rmt_strips[strip];
+    const rmt_strip_state_t *state = &rmt_strip_states[strip];
+    uint32_t start = cpu_hal_get_cycle_count();
+    uint32_t cycles = 0;
+
+    /* Gamma and brightness come from the strip table, rebuilt only when the brightness changes. */
+    handle->set_brightness(handle, state->brightness);
+
+    for (uint32_t i = 0; i < rmt_strip_configs[strip].leds; i++)
+    {
+        if (state->on)
+        {
+            handle->set_pixel(handle, i, state->rgb[0], state->rgb[1], state->rgb[2]);
+        }
+        else
+        {
+            handle->set_pixel(handle, i, 0, 0, 0);
+        }
+    }
+
+    cycles = cpu_hal_get_cycle_count() - start;
+
+    portENTER_CRITICAL(&rmt_stats_lock);
+    rmt_stats.renders++;
+    rmt_stats.render_leds = rmt_strip_configs[strip].leds;
+    rmt_stats.last_render_cycles = cycles;
+    if (cycles > rmt_stats.max_render_cycles)
+    {
+        rmt_stats.max_render_cycles = cycles;
+    }
+    portEXIT_CRITICAL(&rmt_stats_lock);
+}
+/**
+ * @brief  Transmit the rendered frames of all strips in parallel, costs one frame of wall-clock time.
+ * 
+ * @note Called with rmt_mutex held.
+ * 
+ * @return - ESP_OK   succeed
+ *         - other    failed
+ */
+static esp_err_t rmt_refresh(void)
+{
+    esp_err_t ret = ESP_OK;
+    int64_t start_us = 0;
+    uint32_t elapsed_us = 0;
+
+    start_us = esp_timer_get_time();
+    ret = led_strip_rmt_ws2812_refresh_group(rmt_strips, USER_RMT_STRIP_MAX, RMT_WS2812_REFRESH_TIMEOUT_MS);
+    elapsed_us = (uint32_t)(esp_timer_get_time() - start_us);
+
+    portENTER_CRITICAL(&rmt_stats_lock);
+    if (ret == ESP_OK)
+    {
+        rmt_stats.refreshes++;
+        rmt_stats.last_refresh_us = elapsed_us;
+        if (elapsed_us > rmt_stats.max_refresh_us)
+        {
+            rmt_stats.max_refresh_us = elapsed_us;
+        }
+    }
+    else
+    {
+        rmt_stats.errors++;
+    }
+    portEXIT_CRITICAL(&rmt_stats_lock);
+
+    return ret;
+}
+/**
+ * @brief  Change part of the state of a strip, then render and refresh.
+ * 
+ * @param strip[IN] Strip.
+ * @param on[IN] New switch state, NULL keeps it.
+ * @param brightness[IN] New brightness, NULL keeps it.
+ * @param rgb[IN] New color, NULL keeps it.
+ * 
+ * @return - ESP_OK                succeed
+ *         - ESP_ERR_INVALID_STATE not initialized
+ *         - other                 failed
+ */
+static esp_err_t rmt_strip_set(user_rmt_strip_t strip, const bool *on, const uint8_t *brightness, const uint8_t *rgb)
+{
+    rmt_strip_state_t *state = &rmt_strip_states[strip];
+    esp_err_t ret = ESP_OK;
+
+    if (rmt_strips[strip] == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(rmt_mutex, portMAX_DELAY);
+    if (on != NULL)
+    {
+        state->on = *on;
+    }
+    if (brightness != NULL)
+    {
+        state->brightness = *brightness;
+    }
+    if (rgb != NULL)
+    {
+        memcpy(state->rgb, rgb, sizeof(state->rgb));
+    }
+    rmt_strip_render(strip);
+    ret = rmt_refresh();
+    xSemaphoreGive(rmt_mutex);
+
+    return ret;
+}
+/**
+ * @brief  Initialize the RMT grow light strips, all LEDs off.
+ * 
+ * @return - ESP_OK   succeed
+ *         - other    failed
+ */
 esp_err_t user_esp32_rmt_init(void)
 {
+    esp_err_t ret = ESP_OK;
+
+    if (rmt_mutex == NULL)
+    {
+        rmt_mutex = xSemaphoreCreateMutexStatic(&rmt_mutex_buffer);
+    }
+
+    for (int strip = 0; strip < USER_RMT_STRIP_MAX; strip++)
+    {
+        if (rmt_strips[strip] != NULL)
+        {
+            continue;
+        }
+
+        ret = rmt_strip_install((user_rmt_strip_t)strip);
+        if (ret != ESP_OK)
+        {
+            return ret;
+        }
+
+        rmt_strip_render((user_rmt_strip_t)strip);
+    }
+
+    return user_esp32_rmt_refresh();
+}
+/**
+ * @brief  Get a grow light strip, to render its next frame with set_pixel.
+ * 
+ * @param strip[IN] Strip.
+ * 
+ * @return Strip, NULL if not installed.
+ */
+led_strip_t *user_esp32_rmt_get_strip(user_rmt_strip_t strip)
+{
+    if ((unsigned)strip >= USER_RMT_STRIP_MAX)
+    {
+        return NULL;
+    }
+
+    return rmt_strips[strip];
+}
+/**
+ * @brief  Transmit the rendered frames of all strips in parallel, costs one frame of wall-clock time.
+ * 
+ * @return - ESP_OK   succeed
+ *         - other    failed
+ */
+esp_err_t user_esp32_rmt_refresh(void)
+{
+    esp_err_t ret = ESP_OK;
+
+    for (int strip = 0; strip < USER_RMT_STRIP_MAX; strip++)
+    {
+        if (rmt_strips[strip] == NULL)
+        {
+            return ESP_ERR_INVALID_STATE;
+        }
+    }
+
+    xSemaphoreTake(rmt_mutex, portMAX_DELAY);
+    ret = rmt_refresh();
+    xSemaphoreGive(rmt_mutex);
+
+    return ret;
+}
+/**
+ * @brief  Set the whole light of a strip and render it, the frame goes out with the next refresh.
+ * 
+ * @param strip[IN] Strip.
+ * @param brightness[IN] 0 ~ 255, 0 switches the strip off.
+ * @param rgb[IN] Red, green and blue components.
+ * 
+ * @return - ESP_OK                succeed
+ *         - ESP_ERR_INVALID_ARG   invalid parameters
+ *         - ESP_ERR_INVALID_STATE not initialized
+ */
+esp_err_t user_esp32_rmt_set_light(user_rmt_strip_t strip, uint8_t brightness, const uint8_t rgb[3])
+{
+    if (((unsigned)strip >= USER_RMT_STRIP_MAX) || (rgb == NULL))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (rmt_strips[strip] == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(rmt_mutex, portMAX_DELAY);
+    rmt_strip_states[strip].on = (brightness != 0);
+    rmt_strip_states[strip].brightness = brightness;
+    memcpy(rmt_strip_states[strip].rgb, rgb, sizeof(rmt_strip_states[strip].rgb));
+    rmt_strip_render(strip);
+    xSemaphoreGive(rmt_mutex);
+
+    return ESP_OK;
+}
+/**
+ * @brief  Switch a grow light strip on or off.
+ * 
+ * @param strip[IN] Strip.
+ * @param on[IN] true: on, false: off.
+ * 
+ * @return - ESP_OK              succeed
+ *         - ESP_ERR_INVALID_ARG unknown strip
+ *         - other               failed
+ */
+esp_err_t user_esp32_rmt_set_state(user_rmt_strip_t strip, bool on)
+{
+    if ((unsigned)strip >= USER_RMT_STRIP_MAX)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    return rmt_strip_set(strip, &on, NULL, NULL);
+}
+/**
+ * @brief  Set the brightness of a grow light strip.
+ * 
+ * @param strip[IN] Strip.
+ * @param brightness[IN] 0 ~ 255.
+ * 
+ * @return - ESP_OK              succeed
+ *         - ESP_ERR_INVALID_ARG unknown strip
+ *         - other               failed
+ */
+esp_err_t user_esp32_rmt_set_brightness(user_rmt_strip_t strip, uint8_t brightness)
+{
+    if ((unsigned)strip >= USER_RMT_STRIP_MAX)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    return rmt_strip_set(strip, NULL, &brightness, NULL);
+}
+/**
+ * @brief  Set the color of a grow light strip.
+ * 
+ * @param strip[IN] Strip.
+ * @param rgb[IN] Red, green and blue components.
+ * 
+ * @return - ESP_OK              succeed
+ *         - ESP_ERR_INVALID_ARG invalid parameters
+ *         - other               failed
+ */
+esp_err_t user_esp32_rmt_set_color(user_rmt_strip_t strip, const uint8_t rgb[3])
+{
+    if (((unsigned)strip >= USER_RMT_STRIP_MAX) || (rgb == NULL))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    return rmt_strip_set(strip, NULL, NULL, rgb);
+}
+/**
+ * @brief  Enable temporal dithering on all strips.
+ * 
+ * @note Dithering only shows when the strips are refreshed continuously, the
+ *       light task does it every frame, see user_esp32_light_set_dithering.
+ * 
+ * @param enable[IN] true: dithering on.
+ * 
+ * @return - ESP_OK                succeed
+ *         - ESP_ERR_INVALID_STATE not initialized
+ */
+esp_err_t user_esp32_rmt_set_dithering(bool enable)
+{
+    for (int strip = 0; strip < USER_RMT_STRIP_MAX; strip++)
+    {
+        if (rmt_strips[strip] == NULL)
+        {
+            return ESP_ERR_INVALID_STATE;
+        }
+    }
+
+    /* The refresh carries the dither errors, they must not be cleared in the middle of one. */
+    xSemaphoreTake(rmt_mutex, portMAX_DELAY);
+    for (int strip = 0; strip < USER_RMT_STRIP_MAX; strip++)
+    {
+        rmt_strips[strip]->set_dithering(rmt_strips[strip], enable);
+    }
+    xSemaphoreGive(rmt_mutex);
+
+    return ESP_OK;
+}
+/**
+ * @brief  Get the group refresh statistics.
+ * 
+ * @param stats[OUT] Statistics.
+ * 
+ * @return - ESP_OK              succeed
+ *         - ESP_ERR_INVALID_ARG stats is NULL
+ */
+esp_err_t user_esp32_rmt_get_stats(user_rmt_stats_t *stats)
+{
+    if (stats == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&rmt_stats_lock);
+    *stats = rmt_stats;
+    portEXIT_CRITICAL(&rmt_stats_lock);
+
     return ESP_OK;
-}
\ No newline at end of file
+}
+/******************************** End of File *********************************/
@@ -0,0 +1,169 @@
+/**
+ *****************************************************************************
+ * @file    : user_esp32_sampler.c
+ * @brief   : ESP32 sensor sampling scheduler Application
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *
+ * @note One task drives a hierarchical timer wheel and runs every sampling
+ *       callback, instead of one task with its own vTaskDelay per sensor.
+ *****************************************************************************
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include "esp_err.h"
+#include "esp_log.h"
+
+#include "user_esp32_sampler.h"
+
+/** @brief FreeRTOS sampler task configuration. */
+#define SAMPLER_TASK_STACK_DEPTH            (3 * 1024U)
+#define SAMPLER_TASK_PRIORITY               (5U)
+
+/** @brief Sampler resolution, the wheel is advanced once per period. */
+#define SAMPLER_TASK_PERIOD_MS              (10U)
+
+/** @brief log output label. */
+static const char *TAG = "Sampler Application";
+
+/** @brief Sampling timer wheel. */
+static sampler_wheel_t sampler_wheel;
+
+/** @brief Sampling timer wheel lock. */
+static SemaphoreHandle_t sampler_mutex = NULL;
+static StaticSemaphore_t sampler_mutex_buffer;
+
+/** @brief Sampler task handle. */
+static TaskHandle_t sampler_task_handle = NULL;
+
+/**
+ * @brief  Current time of the sampler in ms, wraps around with the tick count.
+ */
+static inline uint32_t sampler_now_ms(void)
+{
+    return (uint32_t)(xTaskGetTickCount() * portTICK_PERIOD_MS);
+}
+/**
+ * @brief  Sampler task, advances the timer wheel and runs the due sampling callbacks.
+ * 
+ * @param arg[IN] The parameter of the task.
+ */
+static void sampler_task(void *arg)
+{
+    TickType_t last_wake = xTaskGetTickCount();
+
+    while (1)
+    {
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(SAMPLER_TASK_PERIOD_MS));
+
+        xSemaphoreTake(sampler_mutex, portMAX_DELAY);
+        sampler_wheel_advance(&sampler_wheel, sampler_now_ms());
+        xSemaphoreGive(sampler_mutex);
+    }
+}
+/**
+ * @brief  Initialize the sensor sampling scheduler.
+ * 
+ * @return - ESP_OK   succeed
+ *         - ESP_FAIL failed
+ */
+esp_err_t user_esp32_sampler_init(void)
+{
+    if (sampler_task_handle != NULL)
+    {
+        return ESP_OK;
+    }
+
+    sampler_mutex = xSemaphoreCreateMutexStatic(&sampler_mutex_buffer);
+    sampler_wheel_init(&sampler_wheel, sampler_now_ms());
+
+    BaseType_t uxBits = xTaskCreate(sampler_task,                  /* Pointer to the task entry function. */
+                                    "Sampler task",                /* Descriptive name for the task. */
+                                    SAMPLER_TASK_STACK_DEPTH,      /* The size of the task stack specified as the number of bytes. */
+                                    NULL,                          /* Pointer that will be used as the parameter for the task being created. */
+                                    SAMPLER_TASK_PRIORITY,         /* The priority at which the task should run. */
+                                    &sampler_task_handle);         /* Used to pass back a handle by which the created task can be referenced. */
+    if (uxBits != pdPASS)
+    {
+        ESP_LOGE(TAG, "Sampler task creation failed.");
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+/**
+ * @brief  Register a sampling channel.
+ * 
+ * @note The callback first runs phase_ms after the registration, then every period_ms,
+ *       with a resolution of SAMPLER_TASK_PERIOD_MS. Sensors sharing a bus should use
+ *       different phases. Do not register from a sampling callback.
+ * 
+ * @param period_ms[IN] Sampling period in ms.
+ * @param phase_ms[IN] Offset of the first sample in ms.
+ * @param callback[IN] Sampling callback.
+ * @param arg[IN] Sampling callback argument.
+ * @param channel[OUT] Channel index for user_esp32_sampler_get_stats, may be NULL.
+ * 
+ * @return - ESP_OK                 succeed
+ *         - ESP_ERR_INVALID_STATE  the sampler is not initialized
+ *         - ESP_ERR_INVALID_ARG    invalid period or callback
+ *         - ESP_ERR_NO_MEM         every channel is used
+ */
+esp_err_t user_esp32_sampler_register(uint32_t period_ms, uint32_t phase_ms,
+                                      user_sampler_callback_t callback, void *arg, int *channel)
+{
+    if (sampler_mutex == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if ((period_ms == 0) || (callback == NULL))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(sampler_mutex, portMAX_DELAY);
+    int id = sampler_wheel_add(&sampler_wheel, period_ms, phase_ms, callback, arg);
+    xSemaphoreGive(sampler_mutex);
+
+    if (id < 0)
+    {
+        ESP_LOGE(TAG, "No free sampling channel.");
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (channel != NULL)
+    {
+        *channel = id;
+    }
+
+    return ESP_OK;
+}
+/**
+ * @brief  Get the jitter and overrun statistics of a sampling channel.
+ * 
+ * @param channel[IN] Channel index returned by user_esp32_sampler_register.
+ * @param stats[OUT] Channel statistics.
+ * 
+ * @return - ESP_OK                 succeed
+ *         - ESP_ERR_INVALID_STATE  the sampler is not initialized
+ *         - ESP_ERR_INVALID_ARG    unknown channel
+ */
+esp_err_t user_esp32_sampler_get_stats(int channel, user_sampler_stats_t *stats)
+{
+    if (sampler_mutex == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(sampler_mutex, portMAX_DELAY);
+    bool found = sampler_wheel_get_stats(&sampler_wheel, channel, stats);
+    xSemaphoreGive(sampler_mutex);
+
+    return found ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+/******************************** End of File *********************************/
@@ -0,0 +1,328 @@
+/**
+ *****************************************************************************
+ * @file    : user_esp32_store.c
+ * @brief   : ESP32 telemetry store-and-forward Application
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *****************************************************************************
+ */
+
+#include <string.h>
+#include <stddef.h>
+#include <inttypes.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+
+#include "user_store_ring.h"
+#include "user_esp32_mqtt.h"
+#include "user_esp32_codec.h"
+#include "user_esp32_telemetry.h"
+#include "user_esp32_store.h"
+
+/** @brief FreeRTOS telemetry store drain task configuration. */
+#define STORE_TASK_STACK_DEPTH          (3 * 1024U)
+#define STORE_TASK_PRIORITY             (2U)
+
+/** @brief Telemetry store data partition, see partitions.csv. */
+#define STORE_PARTITION_LABEL           "telemetry"
+#define STORE_PARTITION_SUBTYPE         (0x40)
+
+/**
+ * @brief Drain rate limit. At most 1000 / STORE_DRAIN_PERIOD_MS publishes of STORE_DRAIN_BATCH
+ *        records per second, 160 records/s, so a backlog does not flood the broker.
+ *        Append costs one 16 byte flash write, plus one 4 KB sector erase every 256 records,
+ *        which sustains well over the 100 records/s target.
+ */
+#define STORE_DRAIN_BATCH               (32U)
+#define STORE_DRAIN_PERIOD_MS           (200U)
+
+/** @brief Drain task idle check period, in case a reconnect notification was missed. */
+#define STORE_IDLE_PERIOD_MS            (10 * 1000U)
+
+/**
+ * @brief Longest text history record, ",[timestamp,\"name\",value]" with a 10 digit timestamp,
+ *        a channel name of up to STORE_NAME_MAX_LENGTH characters and a -21474836.48 value.
+ */
+#define STORE_NAME_MAX_LENGTH           (24U)
+#define STORE_RECORD_TEXT_MAX_LENGTH    (2U + 10U + 2U + STORE_NAME_MAX_LENGTH + 2U + 12U + 1U)
+
+/** @brief Drain payload buffer length, STORE_DRAIN_BATCH records and the closing bracket and NUL. */
+#define STORE_PAYLOAD_MAX_LENGTH        (STORE_DRAIN_BATCH * STORE_RECORD_TEXT_MAX_LENGTH + 2U)
+
+_Static_assert(STORE_DRAIN_BATCH <= UINT8_MAX, "STORE_DRAIN_BATCH exceeds the history record count");
+_Static_assert(STORE_PAYLOAD_MAX_LENGTH >= (3U + 9U * STORE_DRAIN_BATCH), "Drain payload too small for a binary batch");
+
+/** @brief log output label. */
+static const char *TAG = "Store Application";
+
+/** @brief Telemetry store partition. */
+static const esp_partition_t *store_partition = NULL;
+
+/** @brief Record ring on the partition, protected by the mutex. */
+static user_store_ring_t store_ring;
+
+/** @brief FreeRTOS telemetry store handles. */
+static SemaphoreHandle_t store_mutex_handle = NULL;
+static TaskHandle_t store_task_handle = NULL;
+
+/** @brief Telemetry store statistics, protected by the mutex. */
+static user_store_stats_t store_stats;
+
+/** @brief Drain payload buffer, only used by the drain task. */
+static char store_payload[STORE_PAYLOAD_MAX_LENGTH];
+
+/**
+ * @brief  Flash access of the ring.
+ */
+static esp_err_t store_flash_read(void *ctx, size_t offset, void *buf, size_t len)
+{
+    return esp_partition_read((const esp_partition_t *)ctx, offset, buf, len);
+}
+
+static esp_err_t store_flash_write(void *ctx, size_t offset, const void *buf, size_t len)
+{
+    return esp_partition_write((const esp_partition_t *)ctx, offset, buf, len);
+}
+
+static esp_err_t store_flash_erase(void *ctx, size_t offset, size_t len)
+{
+    return esp_partition_erase_range((const esp_partition_t *)ctx, offset, len);
+}
+/**
+ * @brief  Read, publish and release the oldest batch of records.
+ * 
+ * @note A batch the payload buffer can not hold is halved until it fits, a
+ *       single record that still can not be encoded is released unpublished
+ *       and counted as discarded, so it never blocks the ring.
+ * 
+ * @return Number of records released, 0 if the ring is empty or the publish failed.
+ */
+static uint32_t store_drain_batch(void)
+{
+    user_codec_record_t records[STORE_DRAIN_BATCH];
+    user_store_entry_t entries[STORE_DRAIN_BATCH];
+    uint32_t start;
+    uint32_t count;
+    uint32_t discarded = 0;
+    int valid = 0;
+
+    xSemaphoreTake(store_mutex_handle, portMAX_DELAY);
+    start = store_ring.tail;
+    count = store_ring.head - store_ring.tail;
+    xSemaphoreGive(store_mutex_handle);
+
+    if (count == 0)
+    {
+        return 0;
+    }
+    count = (count > STORE_DRAIN_BATCH) ? STORE_DRAIN_BATCH : count;
+
+    /* Torn or overwritten records are skipped. */
+    valid = user_store_ring_read(&store_ring, start, count, entries);
+    for (int i = 0; i < valid; i++)
+    {
+        records[i].timestamp = entries[i].timestamp;
+        records[i].channel = entries[i].channel;
+        records[i].value = entries[i].value;
+    }
+
+    while (valid > 0)
+    {
+        int len = user_esp32_codec_encode_history(store_payload, sizeof(store_payload),
+                                                  user_esp32_telemetry_get_topics(), records, valid);
+        if (len > 0)
+        {
+            if (user_esp32_mqtt_publish(PUB_TELEMETRY_HISTORY, store_payload, len) == -1)
+            {
+                return 0;
+            }
+            /* The records left over go with the next batch. */
+            count = entries[valid - 1].sequence - start + 1;
+            break;
+        }
+
+        if (valid == 1)
+        {
+            ESP_LOGE(TAG, "Record %" PRIu32 " can not be encoded, discarded.", entries[0].sequence);
+            count = entries[0].sequence - start + 1;
+            discarded = 1;
+            valid = 0;
+            break;
+        }
+        valid /= 2;
+    }
+
+    xSemaphoreTake(store_mutex_handle, portMAX_DELAY);
+    esp_err_t ret = user_store_ring_release(&store_ring, start, count);
+    store_stats.forwarded += valid;
+    store_stats.discarded += discarded;
+    xSemaphoreGive(store_mutex_handle);
+
+    if (ret != ESP_OK)
+    {
+        ESP_LOGW(TAG, "Consumed mark of record %" PRIu32 " failed, the batch is sent again after a reboot. Error Code: (%s).",
+                 start + count - 1, esp_err_to_name(ret));
+    }
+
+    return count;
+}
+/**
+ * @brief  Telemetry store drain task, forwards stored records while the broker is reachable.
+ * 
+ * @param pvParameters[IN] Task create accept parameters.
+ */
+static void store_drain_task(void *pvParameters)
+{
+    while (1)
+    {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(STORE_IDLE_PERIOD_MS));
+
+        while (user_esp32_mqtt_is_connected() && (store_drain_batch() > 0))
+        {
+            /* Rate limit. */
+            vTaskDelay(pdMS_TO_TICKS(STORE_DRAIN_PERIOD_MS));
+        }
+    }
+}
+/**
+ * @brief  Initialize the telemetry store and recover records left from before a reboot.
+ * 
+ * @return - ESP_OK            succeed
+ *         - ESP_ERR_NOT_FOUND no telemetry partition
+ *         - ESP_FAIL          failed
+ */
+esp_err_t user_esp32_store_init(void)
+{
+    esp_err_t ret;
+
+    if (store_partition != NULL)
+    {
+        return ESP_OK;
+    }
+
+    store_partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, STORE_PARTITION_SUBTYPE, STORE_PARTITION_LABEL);
+    if (store_partition == NULL)
+    {
+        ESP_LOGE(TAG, "Telemetry partition not found.");
+        return ESP_ERR_NOT_FOUND;
+    }
+    const user_store_flash_t flash = {
+        .read = store_flash_read,
+        .write = store_flash_write,
+        .erase = store_flash_erase,
+        .ctx = (void *)store_partition,
+    };
+
+    ret = user_store_ring_init(&store_ring, &flash, store_partition->size, SPI_FLASH_SEC_SIZE, USER_TELEMETRY_CHANNEL_MAX);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Telemetry store recovery failed. Error Code: (%s).", esp_err_to_name(ret));
+        store_partition = NULL;
+        return ret;
+    }
+    ESP_LOGI(TAG, "%u records pending.", (unsigned int)(store_ring.head - store_ring.tail));
+
+    store_mutex_handle = xSemaphoreCreateMutex();
+    if (store_mutex_handle == NULL)
+    {
+        ESP_LOGE(TAG, "Telemetry store mutex creation failed.");
+        store_partition = NULL;
+        return ESP_FAIL;
+    }
+
+    BaseType_t uxBits = xTaskCreate(store_drain_task,           /* Pointer to the task entry function. */
+                                    "Telemetry drain task",     /* Descriptive name for the task. */
+                                    STORE_TASK_STACK_DEPTH,     /* The size of the task stack specified as the number of bytes. */
+                                    NULL,                       /* Pointer that will be used as the parameter for the task being created. */
+                                    STORE_TASK_PRIORITY,        /* The priority at which the task should run. */
+                                    &store_task_handle);        /* Used to pass back a handle by which the created task can be referenced. */
+    if (uxBits != pdPASS)
+    {
+        ESP_LOGE(TAG, "Telemetry drain task creation failed.");
+        store_partition = NULL;
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+/**
+ * @brief  Append a telemetry record, the oldest sector is erased when the ring is full.
+ * 
+ * @param channel[IN] Telemetry channel.
+ * @param timestamp[IN] Seconds, from time().
+ * @param value[IN] Fixed-point value in 1/USER_TELEMETRY_SCALE units.
+ * 
+ * @return - ESP_OK                succeed
+ *         - ESP_ERR_INVALID_STATE store not initialized
+ *         - ESP_ERR_INVALID_ARG   unknown channel
+ *         - other                 flash error
+ */
+esp_err_t user_esp32_store_append(uint8_t channel, uint32_t timestamp, int32_t value)
+{
+    if (store_partition == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(store_mutex_handle, portMAX_DELAY);
+    esp_err_t ret = user_store_ring_append(&store_ring, channel, timestamp, value);
+    xSemaphoreGive(store_mutex_handle);
+
+    if ((ret != ESP_OK) && (ret != ESP_ERR_INVALID_ARG))
+    {
+        ESP_LOGE(TAG, "Record append failed. Error Code: (%s).", esp_err_to_name(ret));
+    }
+
+    return ret;
+}
+/**
+ * @brief  Wake the drain task, called when the MQTT client reconnects.
+ */
+void user_esp32_store_resume(void)
+{
+    if (store_task_handle != NULL)
+    {
+        xTaskNotifyGive(store_task_handle);
+    }
+}
+/**
+ * @brief  Get telemetry store statistics.
+ * 
+ * @param stats[OUT] Telemetry store statistics.
+ * 
+ * @return - ESP_OK                succeed
+ *         - ESP_ERR_INVALID_ARG   stats is NULL
+ *         - ESP_ERR_INVALID_STATE store not initialized
+ */
+esp_err_t user_esp32_store_get_stats(user_store_stats_t *stats)
+{
+    if (stats == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (store_partition == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(store_mutex_handle, portMAX_DELAY);
+    *stats = store_stats;
+    stats->capacity = store_ring.capacity;
+    stats->pending = store_ring.head - store_ring.tail;
+    stats->appended = store_ring.stats.appended;
+    stats->overwritten = store_ring.stats.overwritten;
+    stats->erases = store_ring.stats.erases;
+    stats->mark_failures = store_ring.stats.mark_failures;
+    xSemaphoreGive(store_mutex_handle);
+
+    return ESP_OK;
+}
+/******************************** End of File *********************************/
@@ -0,0 +1,426 @@
+/**
+ *****************************************************************************
+ * @file    : user_esp32_telemetry.c
+ * @brief   : ESP32 sensor telemetry publisher Application
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *****************************************************************************
+ */
+
+#include <string.h>
+#include <time.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_err.h"
+#include "esp_log.h"
+
+#include "user_esp32_mqtt.h"
+#include "user_esp32_codec.h"
+#include "user_esp32_store.h"
+#include "user_esp32_telemetry.h"
+
+/** @brief FreeRTOS telemetry publish task configuration. */
+#define TELEMETRY_TASK_STACK_DEPTH          (3 * 1024U)
+#define TELEMETRY_TASK_PRIORITY             (2U)
+
+/** @brief Default telemetry window, samples are averaged and published once per window. */
+#define DEFAULT_TELEMETRY_INTERVAL_MS       (60 * 1000U)
+#define MINIMUM_TELEMETRY_INTERVAL_MS       (1000U)
+
+/** @brief Default telemetry publish mode. */
+#define DEFAULT_TELEMETRY_MODE              USER_TELEMETRY_MODE_BATCH
+
+/** @brief Telemetry payload buffer length, large enough for every channel in batch mode. */
+#define TELEMETRY_PAYLOAD_MAX_LENGTH        (384U)
+
+/** @brief Telemetry channel accumulator of the current window. */
+typedef struct
+{
+    int64_t sum;    /* Sum of the samples of the window. */
+    uint32_t count; /* Number of samples of the window. */
+} telemetry_accumulator_t;
+
+/** @brief log output label. */
+static const char *TAG = "Telemetry Application";
+
+/** @brief Publish topic of every telemetry channel. */
+static const char *const telemetry_topics[USER_TELEMETRY_CHANNEL_MAX] = {
+    [USER_TELEMETRY_SOIL_HUMI1] = PUB_SOIL_HUMI1,
+    [USER_TELEMETRY_SOIL_HUMI2] = PUB_SOIL_HUMI2,
+    [USER_TELEMETRY_SOIL_HUMI3] = PUB_SOIL_HUMI3,
+    [USER_TELEMETRY_ENVM_HUMI1] = PUB_ENVM_HUMI1,
+    [USER_TELEMETRY_ENVM_TEMP1] = PUB_ENVM_TEMP1,
+    [USER_TELEMETRY_ENVM_TMOS1] = PUB_ENVM_TMOS1,
+    [USER_TELEMETRY_TDS_VALUE1] = PUB_TDS_VALUE1,
+};
+
+/**
+ * @brief Default report-by-exception filter of every telemetry channel.
+ *        { dead-band, rate per minute, minimum interval ms, maximum silence ms },
+ *        values in 1/USER_TELEMETRY_SCALE units. The rate reports a watering or
+ *        a door opened within the minimum interval.
+ */
+static user_telemetry_filter_t telemetry_filters[USER_TELEMETRY_CHANNEL_MAX] = {
+    [USER_TELEMETRY_SOIL_HUMI1] = { 50, 500, 60 * 1000U, 15 * 60 * 1000U },   /* 0.5 %, 5 %/min */
+    [USER_TELEMETRY_SOIL_HUMI2] = { 50, 500, 60 * 1000U, 15 * 60 * 1000U },   /* 0.5 %, 5 %/min */
+    [USER_TELEMETRY_SOIL_HUMI3] = { 50, 500, 60 * 1000U, 15 * 60 * 1000U },   /* 0.5 %, 5 %/min */
+    [USER_TELEMETRY_ENVM_HUMI1] = { 100, 1000, 60 * 1000U, 15 * 60 * 1000U }, /* 1 %RH, 10 %RH/min */
+    [USER_TELEMETRY_ENVM_TEMP1] = { 20, 100, 60 * 1000U, 15 * 60 * 1000U },   /* 0.2 degree Celsius, 1 degree/min */
+    [USER_TELEMETRY_ENVM_TMOS1] = { 50, 0, 60 * 1000U, 30 * 60 * 1000U },     /* 0.5 hPa */
+    [USER_TELEMETRY_TDS_VALUE1] = { 500, 0, 60 * 1000U, 30 * 60 * 1000U },    /* 5 ppm */
+};
+
+/** @brief Report-by-exception state, only used by the publish task. */
+static user_telemetry_filter_state_t telemetry_filter_states[USER_TELEMETRY_CHANNEL_MAX];
+
+/** @brief FreeRTOS telemetry handles. */
+static TaskHandle_t telemetry_task_handle = NULL;
+
+/** @brief Telemetry accumulators, written by the sampling tasks under the spinlock. */
+static telemetry_accumulator_t telemetry_accumulators[USER_TELEMETRY_CHANNEL_MAX];
+static portMUX_TYPE telemetry_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/** @brief Telemetry configuration. */
+static volatile uint32_t telemetry_interval_ms = DEFAULT_TELEMETRY_INTERVAL_MS;
+static volatile user_telemetry_mode_t telemetry_mode = DEFAULT_TELEMETRY_MODE;
+
+/** @brief Telemetry statistics. */
+static user_telemetry_stats_t telemetry_stats;
+
+/** @brief Telemetry payload buffer, only used by the publish task. */
+static char telemetry_payload[TELEMETRY_PAYLOAD_MAX_LENGTH];
+
+/**
+ * @brief  Hand a payload to the MQTT client and account for it.
+ * 
+ * @param topic[IN] Publish topic.
+ * @param len[IN] Payload length in telemetry_payload.
+ * 
+ * @return - true   handed over.
+ *         - false  the MQTT client refused it.
+ */
+static bool telemetry_publish_payload(const char *topic, int len)
+{
+    if (user_esp32_mqtt_publish(topic, telemetry_payload, len) == -1)
+    {
+        ESP_LOGE(TAG, "Publish %s failed.", topic);
+        return false;
+    }
+
+    telemetry_stats.publish_calls++;
+    telemetry_stats.payload_bytes += len;
+
+    return true;
+}
+/**
+ * @brief  Report-by-exception filter, decides whether a channel value is worth publishing.
+ * 
+ * @param ch[IN] Telemetry channel.
+ * @param value[IN] Window mean in 1/USER_TELEMETRY_SCALE units.
+ * @param now_ms[IN] Current time.
+ * 
+ * @return - true   publish the value, see user_telemetry_filter_check.
+ *         - false  suppress the value.
+ */
+static bool telemetry_filter_pass(int ch, int32_t value, uint32_t now_ms)
+{
+    user_telemetry_filter_t filter;
+
+    portENTER_CRITICAL(&telemetry_lock);
+    filter = telemetry_filters[ch];
+    portEXIT_CRITICAL(&telemetry_lock);
+
+    return user_telemetry_filter_check(&filter, &telemetry_filter_states[ch], value, now_ms);
+}
+/**
+ * @brief  Record the fate of the window values, once the hand-off is done.
+ * 
+ * @param values[IN] Window means.
+ * @param sampled[IN] Channels with samples in the window.
+ * @param handed[IN] Channels handed over, to the MQTT client or to the store.
+ * @param now_ms[IN] Current time.
+ */
+static void telemetry_filter_commit(const int32_t *values, uint32_t sampled, uint32_t handed, uint32_t now_ms)
+{
+    for (int ch = 0; ch < USER_TELEMETRY_CHANNEL_MAX; ch++)
+    {
+        if (sampled & (1UL << ch))
+        {
+            user_telemetry_filter_update(&telemetry_filter_states[ch], values[ch], now_ms, (handed & (1UL << ch)) != 0);
+        }
+    }
+
+    portENTER_CRITICAL(&telemetry_lock);
+    for (int ch = 0; ch < USER_TELEMETRY_CHANNEL_MAX; ch++)
+    {
+        if (handed & (1UL << ch))
+        {
+            telemetry_stats.reported++;
+        }
+    }
+    portEXIT_CRITICAL(&telemetry_lock);
+}
+/**
+ * @brief  Close the current window and publish the mean of every channel that has samples.
+ */
+static void telemetry_publish(void)
+{
+    telemetry_accumulator_t window[USER_TELEMETRY_CHANNEL_MAX];
+    int32_t values[USER_TELEMETRY_CHANNEL_MAX];
+    uint32_t now_ms = (uint32_t)(xTaskGetTickCount() * portTICK_PERIOD_MS);
+    uint32_t sampled = 0;
+    uint32_t mask = 0;
+    uint32_t handed = 0;
+    uint32_t suppressed = 0;
+    int len;
+
+    portENTER_CRITICAL(&telemetry_lock);
+    memcpy(window, telemetry_accumulators, sizeof(window));
+    memset(telemetry_accumulators, 0, sizeof(telemetry_accumulators));
+    portEXIT_CRITICAL(&telemetry_lock);
+
+    for (int ch = 0; ch < USER_TELEMETRY_CHANNEL_MAX; ch++)
+    {
+        if (window[ch].count == 0)
+        {
+            continue;
+        }
+
+        /* Only meaningful changes and heartbeats are published. */
+        values[ch] = (int32_t)(window[ch].sum / (int64_t)window[ch].count);
+        sampled |= (1UL << ch);
+        if (telemetry_filter_pass(ch, values[ch], now_ms))
+        {
+            mask |= (1UL << ch);
+        }
+        else
+        {
+            suppressed++;
+        }
+    }
+
+    portENTER_CRITICAL(&telemetry_lock);
+    telemetry_stats.suppressed += suppressed;
+    portEXIT_CRITICAL(&telemetry_lock);
+
+    if (mask == 0)
+    {
+        telemetry_filter_commit(values, sampled, 0, now_ms);
+        return;
+    }
+
+    if (user_esp32_mqtt_is_connected() == false)
+    {
+        /* Keep the values in flash, they are forwarded after the reconnection. */
+        uint32_t timestamp = (uint32_t)time(NULL);
+        for (int ch = 0; ch < USER_TELEMETRY_CHANNEL_MAX; ch++)
+        {
+            if ((mask & (1UL << ch)) == 0)
+            {
+                continue;
+            }
+
+            if (user_esp32_store_append(ch, timestamp, values[ch]) == ESP_OK)
+            {
+                handed |= (1UL << ch);
+            }
+            else
+            {
+                ESP_LOGE(TAG, "Store %s failed.", telemetry_topics[ch]);
+            }
+        }
+    }
+    else if (telemetry_mode == USER_TELEMETRY_MODE_BATCH)
+    {
+        /* Every channel in one message, encoded straight into the payload buffer. */
+        len = user_esp32_codec_encode_batch(telemetry_payload, sizeof(telemetry_payload), telemetry_topics, values, mask);
+        if ((len > 0) && telemetry_publish_payload(PUB_TELEMETRY_BATCH, len))
+        {
+            handed = mask;
+        }
+    }
+    else
+    {
+        /* Compatibility mode, one message per topic. */
+        for (int ch = 0; ch < USER_TELEMETRY_CHANNEL_MAX; ch++)
+        {
+            if ((mask & (1UL << ch)) == 0)
+            {
+                continue;
+            }
+
+            len = user_esp32_codec_encode_value(telemetry_payload, sizeof(telemetry_payload), values[ch]);
+            if ((len > 0) && telemetry_publish_payload(telemetry_topics[ch], len))
+            {
+                handed |= (1UL << ch);
+            }
+        }
+    }
+
+    /* A value lost on the way is not reported, the next window checks it again. */
+    telemetry_filter_commit(values, sampled, handed, now_ms);
+}
+/**
+ * @brief  Telemetry publish task, closes one window per interval.
+ * 
+ * @param pvParameters[IN] Task create accept parameters.
+ */
+static void telemetry_task(void *pvParameters)
+{
+    TickType_t last_wake = xTaskGetTickCount();
+
+    while (1)
+    {
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(telemetry_interval_ms));
+
+        telemetry_publish();
+    }
+}
+/**
+ * @brief  Initialize the telemetry publisher.
+ * 
+ * @return - ESP_OK   succeed
+ *         - ESP_FAIL failed
+ */
+esp_err_t user_esp32_telemetry_init(void)
+{
+    if (telemetry_task_handle != NULL)
+    {
+        return ESP_OK;
+    }
+
+    BaseType_t uxBits = xTaskCreate(telemetry_task,                /* Pointer to the task entry function. */
+                                    "Telemetry publish task",      /* Descriptive name for the task. */
+                                    TELEMETRY_TASK_STACK_DEPTH,    /* The size of the task stack specified as the number of bytes. */
+                                    NULL,                          /* Pointer that will be used as the parameter for the task being created. */
+                                    TELEMETRY_TASK_PRIORITY,       /* The priority at which the task should run. */
+                                    &telemetry_task_handle);       /* Used to pass back a handle by which the created task can be referenced. */
+    if (uxBits != pdPASS)
+    {
+        ESP_LOGE(TAG, "Telemetry publish task creation failed.");
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+/**
+ * @brief  Add a sensor sample to the current window, callable from any task.
+ * 
+ * @param channel[IN] Telemetry channel.
+ * @param value[IN] Fixed-point value in 1/USER_TELEMETRY_SCALE units.
+ * 
+ * @return - ESP_OK              succeed
+ *         - ESP_ERR_INVALID_ARG unknown channel
+ */
+esp_err_t user_esp32_telemetry_update(user_telemetry_channel_t channel, int32_t value)
+{
+    if (channel >= USER_TELEMETRY_CHANNEL_MAX)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&telemetry_lock);
+    telemetry_accumulators[channel].sum += value;
+    telemetry_accumulators[channel].count++;
+    telemetry_stats.samples++;
+    portEXIT_CRITICAL(&telemetry_lock);
+
+    return ESP_OK;
+}
+/**
+ * @brief  Set the telemetry publish mode.
+ * 
+ * @param mode[IN] Publish mode.
+ * 
+ * @return - ESP_OK              succeed
+ *         - ESP_ERR_INVALID_ARG unknown mode
+ */
+esp_err_t user_esp32_telemetry_set_mode(user_telemetry_mode_t mode)
+{
+    if ((mode != USER_TELEMETRY_MODE_BATCH) && (mode != USER_TELEMETRY_MODE_PER_TOPIC))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    telemetry_mode = mode;
+
+    return ESP_OK;
+}
+/**
+ * @brief  Set the telemetry window, applied after the current window closes.
+ * 
+ * @param interval_ms[IN] Window length in milliseconds.
+ * 
+ * @return - ESP_OK              succeed
+ *         - ESP_ERR_INVALID_ARG interval shorter than MINIMUM_TELEMETRY_INTERVAL_MS
+ */
+esp_err_t user_esp32_telemetry_set_interval(uint32_t interval_ms)
+{
+    if (interval_ms < MINIMUM_TELEMETRY_INTERVAL_MS)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    telemetry_interval_ms = interval_ms;
+
+    return ESP_OK;
+}
+/**
+ * @brief  Set the report-by-exception filter of a telemetry channel.
+ * 
+ * @param channel[IN] Telemetry channel.
+ * @param filter[IN] Filter configuration, a zero dead-band reports every window.
+ * 
+ * @return - ESP_OK              succeed
+ *         - ESP_ERR_INVALID_ARG unknown channel or invalid filter
+ */
+esp_err_t user_esp32_telemetry_set_filter(user_telemetry_channel_t channel, const user_telemetry_filter_t *filter)
+{
+    if ((channel >= USER_TELEMETRY_CHANNEL_MAX) || (filter == NULL) || (user_telemetry_filter_valid(filter) == false))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&telemetry_lock);
+    telemetry_filters[channel] = *filter;
+    portEXIT_CRITICAL(&telemetry_lock);
+
+    return ESP_OK;
+}
+/**
+ * @brief  Get the publish topic of every telemetry channel.
+ * 
+ * @return Topic table indexed by user_telemetry_channel_t.
+ */
+const char *const *user_esp32_telemetry_get_topics(void)
+{
+    return telemetry_topics;
+}
+/**
+ * @brief  Get telemetry publisher statistics.
+ * 
+ * @param stats[OUT] Telemetry statistics.
+ * 
+ * @return - ESP_OK              succeed
+ *         - ESP_ERR_INVALID_ARG stats is NULL
+ */
+esp_err_t user_esp32_telemetry_get_stats(user_telemetry_stats_t *stats)
+{
+    if (stats == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&telemetry_lock);
+    *stats = telemetry_stats;
+    portEXIT_CRITICAL(&telemetry_lock);
+
+    uint32_t total = stats->reported + stats->suppressed;
+    stats->suppression_permille = (total == 0) ? 0 : (uint32_t)(((uint64_t)stats->suppressed * 1000) / total);
+
+    return ESP_OK;
+}
+/******************************** End of File *********************************/
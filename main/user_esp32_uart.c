@@ -5,105 +5,819 @@
  * @author  : Cao Jin
  * @date    : 28-Oct-2021
  * @version : 1.0.0
+ *
+ * @note Each registered port has a receive task fed by the driver event queue.
+ *       Frame ports split frames on the receive timeout or the pattern character
+ *       and hand them over as buffers of a fixed pool. Stream ports move the
+ *       bytes through a lock-free single producer single consumer ring.
  *****************************************************************************
  */
 
+#include <string.h>
+
 #include "freertos/FreeRTOS.h"
-#include "freertos/event_groups.h"
+#include "freertos/task.h"
 #include "freertos/queue.h"
 #include "freertos/semphr.h"
 
 #include "esp_err.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 
 #include "driver/uart.h"
 #include "driver/gpio.h"
 
 #include "user_esp32_uart.h"
+#include "user_uart_ring.h"
+
+/** @brief Default serial sensor port, a CO2 NDIR module on UART1. */
+#define DEFAULT_UART_NUM            UART_NUM_1
+#define DEFAULT_UART_BAUD           (9600)
+#define DEFAULT_UART_TX_PIN         GPIO_NUM_26
+#define DEFAULT_UART_RX_PIN         GPIO_NUM_27
+#define DEFAULT_UART_CTS_PIN        UART_PIN_NO_CHANGE
+#define DEFAULT_UART_RTS_PIN        UART_PIN_NO_CHANGE
+
+/** @brief UART driver event queue length. */
+#define UART_EVENT_QUEUE_LENGTH     (16)
+
+/** @brief Pattern positions recorded by the driver. */
+#define UART_PATTERN_QUEUE_LENGTH   (8)
+
+/** @brief FreeRTOS UART receive task configuration. */
+#define UART_TASK_STACK_DEPTH       (3 * 1024U)
+#define UART_TASK_PRIORITY          (8U)
+
+/** @brief Buffer of the bytes discarded when no frame buffer is free. */
+#define UART_DISCARD_LENGTH         (64U)
+
+/** @brief First byte of the benchmark frames, a reserved Modbus address no slave answers. */
+#define UART_BENCHMARK_ADDRESS      (0xF8U)
 
-/** @brief   */
-#define DEFAULT_UART_NUM    ()
-#define DEFAULT_UART_BOUND  ()
-#define DEFAULT_UART_TX_PIN (GPIO_NUM_22)
-#define DEFAULT_UART_RX_PIN (GPIO_NUM_22)
-#define DEFAULT_UART_CTS_PIN    ()
-#define DEFAULT_UART_RTS_PIN    ()
+/** @brief Rate statistics window. */
+#define UART_RATE_PERIOD_MS         (1000U)
+
+_Static_assert((USER_UART_STREAM_RING_SIZE & (USER_UART_STREAM_RING_SIZE - 1)) == 0, "USER_UART_STREAM_RING_SIZE must be a power of two");
+
+/** @brief State of a managed UART port. */
+typedef struct
+{
+    bool used;                                           /* When set, means the slot holds a port. */
+    uart_port_t port;                                    /* UART port number. */
+    char pattern_chr;                                    /* Character that ends a frame, 0 if none. */
+    uart_mode_t mode;                                    /* UART mode set at registration. */
+    user_uart_rx_mode_t rx_mode;                         /* Receive mode. */
+    QueueHandle_t event_queue;                           /* UART driver events. */
+    QueueHandle_t frame_queue;                           /* Complete frames for the consumer. */
+    QueueHandle_t free_queue;                            /* Free frame buffers. */
+    SemaphoreHandle_t tx_mutex;                          /* Serializes the transmitters. */
+    SemaphoreHandle_t rx_ready;                          /* Wakes the stream consumer. */
+    TaskHandle_t task;                                   /* Receive task. */
+    user_uart_frame_t *current;                          /* Frame being received. */
+    bool rx_error;                                       /* Framing or parity error seen before the next frame started. */
+    union
+    {
+        user_uart_frame_t frames[USER_UART_FRAME_POOL_SIZE]; /* Frame buffer pool, frame mode. */
+        uint8_t ring_buffer[USER_UART_STREAM_RING_SIZE];     /* Byte ring storage, stream mode. */
+    };
+    user_uart_ring_t ring;                               /* Byte ring, the receive task writes, the consumer reads. */
+    user_uart_stats_t stats;                             /* Port statistics. */
+    uint32_t rate_rx_bytes;                              /* rx_bytes at the start of the rate window. */
+    uint32_t rate_tx_bytes;                              /* tx_bytes at the start of the rate window. */
+    TickType_t rate_tick;                                /* Start of the rate window. */
+} uart_context_t;
 
 /** @brief log output label. */
-static const char *TAG = "Wi-Fi Application";
+static const char *TAG = "UART Application";
+
+/** @brief Registered UART ports. */
+static uart_context_t uart_contexts[USER_UART_PORT_MAX];
+
+/** @brief Port statistics lock. */
+static portMUX_TYPE uart_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+#ifdef CONFIG_USER_CO2_UART
+/** @brief Default serial sensor port. */
+static const user_uart_param_t uart_default_param = {
+    .port = DEFAULT_UART_NUM,
+    .tx_io_num = DEFAULT_UART_TX_PIN,
+    .rx_io_num = DEFAULT_UART_RX_PIN,
+    .rts_io_num = DEFAULT_UART_RTS_PIN,
+    .cts_io_num = DEFAULT_UART_CTS_PIN,
+    .config = {
+        .baud_rate = DEFAULT_UART_BAUD,
+        .data_bits = UART_DATA_8_BITS,
+        .parity = UART_PARITY_DISABLE,
+        .stop_bits = UART_STOP_BITS_1,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+        .source_clk = UART_SCLK_APB,
+    },
+    .rx_buffer_size = 256,
+    .tx_buffer_size = 0,
+    .mode = UART_MODE_UART,
+    .rx_mode = USER_UART_RX_STREAM,
+};
+#endif
+
+/**
+ * @brief  Find the state of a managed port.
+ */
+static uart_context_t *uart_context_get(uart_port_t port)
+{
+    for (int i = 0; i < USER_UART_PORT_MAX; i++)
+    {
+        if (uart_contexts[i].used && (uart_contexts[i].port == port))
+        {
+            return &uart_contexts[i];
+        }
+    }
+
+    return NULL;
+}
+static void uart_discard(uart_context_t *ctx, size_t size);
 
-typedef struct 
+/**
+ * @brief  Add to a port counter.
+ */
+static inline void uart_stats_add(uint32_t *counter, uint32_t value)
+{
+    portENTER_CRITICAL(&uart_stats_lock);
+    *counter += value;
+    portEXIT_CRITICAL(&uart_stats_lock);
+}
+/**
+ * @brief  Update the byte rates once per UART_RATE_PERIOD_MS.
+ */
+static void uart_stats_rate(uart_context_t *ctx)
 {
-    uart_port_t port;      
-    gpio_num_t tx_io_num;  /* UART TX pin GPIO number. */
-    gpio_num_t rx_io_num;  /* UART RX pin GPIO number. */
-    gpio_num_t rts_io_num; /* UART RTS pin GPIO number. */
-    gpio_num_t cts_io_num; /* UART CTS pin GPIO number. */
-    uart_config_t config;  /* UART configuration parameters for uart_param_config function. */
-    int rx_buffer_size;    /* UART RX ring buffer size. */
-    int tx_buffer_size;    /* UART TX ring buffer size. */
-}user_uart_param_t;
+    TickType_t now = xTaskGetTickCount();
+    TickType_t elapsed = now - ctx->rate_tick;
+
+    if (elapsed < pdMS_TO_TICKS(UART_RATE_PERIOD_MS))
+    {
+        return;
+    }
 
+    uint32_t elapsed_ms = elapsed * portTICK_PERIOD_MS;
 
-// static esp_err_t user_esp32_rs485_transmit_start();
-// static esp_err_t user_esp32_rs485_transmit_stop();
+    portENTER_CRITICAL(&uart_stats_lock);
+    ctx->stats.rx_bytes_per_sec = (uint32_t)(((uint64_t)(ctx->stats.rx_bytes - ctx->rate_rx_bytes) * 1000U) / elapsed_ms);
+    ctx->stats.tx_bytes_per_sec = (uint32_t)(((uint64_t)(ctx->stats.tx_bytes - ctx->rate_tx_bytes) * 1000U) / elapsed_ms);
+    ctx->rate_rx_bytes = ctx->stats.rx_bytes;
+    ctx->rate_tx_bytes = ctx->stats.tx_bytes;
+    portEXIT_CRITICAL(&uart_stats_lock);
 
+    ctx->rate_tick = now;
+}
+/**
+ * @brief  Read driver bytes into free space of the stream ring.
+ */
+static int uart_ring_fill(void *arg, uint8_t *dst, size_t len)
+{
+    uart_context_t *ctx = (uart_context_t *)arg;
+
+    return uart_read_bytes(ctx->port, dst, len, 0);
+}
+/**
+ * @brief  Move received bytes from the driver into the stream ring, producer side.
+ * 
+ * @note The driver reads straight into the free space of the ring, one or two segments.
+ */
+static void uart_receive_stream(uart_context_t *ctx, size_t size)
+{
+    size_t overflow = 0;
+    size_t stored = user_uart_ring_write(&ctx->ring, size, uart_ring_fill, ctx, &overflow);
+
+    if (overflow > 0)
+    {
+        uart_stats_add(&ctx->stats.dropped, overflow);
+        uart_discard(ctx, overflow);
+    }
+
+    if (stored > 0)
+    {
+        xSemaphoreGive(ctx->rx_ready);
+    }
+}
 /**
- * @brief Initialization UART driver.
+ * @brief  Read and drop bytes from the driver ring buffer.
+ */
+static void uart_discard(uart_context_t *ctx, size_t size)
+{
+    uint8_t discard[UART_DISCARD_LENGTH];
+
+    while (size > 0)
+    {
+        int read = uart_read_bytes(ctx->port, discard, (size < sizeof(discard)) ? size : sizeof(discard), 0);
+        if (read <= 0)
+        {
+            break;
+        }
+        size -= read;
+    }
+}
+/**
+ * @brief  Drop the frame being received.
+ */
+static void uart_drop_current(uart_context_t *ctx)
+{
+    if (ctx->current != NULL)
+    {
+        xQueueSend(ctx->free_queue, &ctx->current, 0);
+        ctx->current = NULL;
+    }
+    ctx->rx_error = false;
+}
+/**
+ * @brief  Move received bytes into the current frame and hand it over when it ends.
+ * 
+ * @param ctx[IN] Port state.
+ * @param size[IN] Number of bytes buffered by the driver.
+ * @param end[IN] When set, means the bytes end a frame.
+ */
+static void uart_receive_data(uart_context_t *ctx, size_t size, bool end)
+{
+    if ((ctx->current == NULL) && (xQueueReceive(ctx->free_queue, &ctx->current, 0) == pdTRUE))
+    {
+        /* An error reported before the frame started hit bytes of this frame. */
+        ctx->current->length = 0;
+        ctx->current->error = ctx->rx_error;
+        ctx->rx_error = false;
+    }
+
+    if (ctx->current == NULL)
+    {
+        /* The consumer holds every buffer, the frame is lost. */
+        uart_stats_add(&ctx->stats.dropped, size);
+        uart_discard(ctx, size);
+        ctx->rx_error = false;
+        return;
+    }
+
+    user_uart_frame_t *frame = ctx->current;
+    size_t space = sizeof(frame->data) - frame->length;
+    size_t length = (size < space) ? size : space;
+
+    int read = uart_read_bytes(ctx->port, &frame->data[frame->length], length, 0);
+    if (read > 0)
+    {
+        frame->length += read;
+    }
+
+    if (size > length)
+    {
+        frame->error = true;
+        uart_stats_add(&ctx->stats.dropped, size - length);
+        uart_discard(ctx, size - length);
+    }
+
+    if (end)
+    {
+        if (xQueueSend(ctx->frame_queue, &frame, 0) != pdTRUE)
+        {
+            uart_stats_add(&ctx->stats.dropped, frame->length);
+            xQueueSend(ctx->free_queue, &frame, 0);
+        }
+        else
+        {
+            uart_stats_add(&ctx->stats.frames, 1);
+        }
+        ctx->current = NULL;
+    }
+}
+/**
+ * @brief  UART receive task, splits the received bytes into frames.
+ * 
+ * @param arg[IN] Port state.
+ */
+static void uart_receive_task(void *arg)
+{
+    uart_context_t *ctx = (uart_context_t *)arg;
+    uart_event_t event;
+
+    while (1)
+    {
+        BaseType_t received = xQueueReceive(ctx->event_queue, &event, pdMS_TO_TICKS(UART_RATE_PERIOD_MS));
+
+        uart_stats_rate(ctx);
+        if (received != pdTRUE)
+        {
+            continue;
+        }
+
+        switch (event.type)
+        {
+        case UART_DATA:
+            uart_stats_add(&ctx->stats.rx_bytes, event.size);
+            if (ctx->rx_mode == USER_UART_RX_STREAM)
+            {
+                uart_receive_stream(ctx, event.size);
+            }
+            else if (ctx->pattern_chr == 0)
+            {
+                /* With a pattern character, bytes stay buffered until the pattern is seen. */
+                uart_receive_data(ctx, event.size, event.timeout_flag);
+            }
+            break;
+
+        case UART_PATTERN_DET:
+        {
+            int position = uart_pattern_pop_pos(ctx->port);
+            if (position < 0)
+            {
+                /* Pattern queue overflowed, positions are lost. */
+                uart_flush_input(ctx->port);
+                uart_drop_current(ctx);
+            }
+            else
+            {
+                uart_receive_data(ctx, position + 1, true);
+            }
+            break;
+        }
+
+        case UART_FIFO_OVF:
+        case UART_BUFFER_FULL:
+            uart_stats_add(&ctx->stats.overruns, 1);
+            uart_flush_input(ctx->port);
+            xQueueReset(ctx->event_queue);
+            uart_drop_current(ctx);
+            break;
+
+        case UART_FRAME_ERR:
+        case UART_PARITY_ERR:
+            uart_stats_add((event.type == UART_FRAME_ERR) ? &ctx->stats.framing_errors : &ctx->stats.parity_errors, 1);
+            /* In pattern mode or between idle events no frame is started yet,
+             * latch the error until uart_receive_data takes the bytes. */
+            if (ctx->current != NULL)
+            {
+                ctx->current->error = true;
+            }
+            else
+            {
+                ctx->rx_error = true;
+            }
+            break;
+
+        default:
+            break;
+        }
+    }
+}
+/**
+ * @brief Transmit a frame, the RS-485 direction is switched by the UART hardware.
  *
- * @return  - ESP_OK    succeed.
- *          - ESP_FAIL  failed.
+ * @param port[IN] UART port number.
+ * @param buf[IN] Bytes to send.
+ * @param len[IN] Number of bytes.
+ * @param timeout_ms[IN] Time to wait for the transmitter and for the last bit to leave.
+ * 
+ * @return  - ESP_OK                 succeed.
+ *          - ESP_ERR_INVALID_STATE  the port is not initialized.
+ *          - ESP_ERR_TIMEOUT        the transmitter is busy or the frame did not leave in time.
+ *          - ESP_FAIL               failed.
  */
-esp_err_t user_esp32_uart_tarnsmit(user_uart_param_t uart_param, uint8_t *buf, uint32_t len)
+esp_err_t user_esp32_uart_transmit(uart_port_t port, const uint8_t *buf, size_t len, uint32_t timeout_ms)
 {
-    /* Get UART mutex semaphore. */
+    uart_context_t *ctx = uart_context_get(port);
 
-    /* UART callback function before sending. */
+    if (ctx == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
 
-    /* UART send data. */
+    /* Get UART mutex semaphore. */
+    if (xSemaphoreTake(ctx->tx_mutex, pdMS_TO_TICKS(timeout_ms)) != pdTRUE)
+    {
+        return ESP_ERR_TIMEOUT;
+    }
 
-    /* UART callback function after sending. */
+    /* UART send data, then wait until the last stop bit so the bus turns around. */
+    esp_err_t ret = ESP_OK;
+    if (uart_write_bytes(port, buf, len) != (int)len)
+    {
+        ret = ESP_FAIL;
+    }
+    else
+    {
+        uart_stats_add(&ctx->stats.tx_bytes, len);
+        ret = uart_wait_tx_done(port, pdMS_TO_TICKS(timeout_ms));
+    }
 
     /* Release UART mutex semaphore. */
+    xSemaphoreGive(ctx->tx_mutex);
+
+    return ret;
+}
+/**
+ * @brief Wait for a received frame.
+ *
+ * @param port[IN] UART port number.
+ * @param frame[OUT] Received frame, give it back with user_esp32_uart_release_frame.
+ * @param timeout_ms[IN] Time to wait.
+ * 
+ * @return  - ESP_OK                 succeed.
+ *          - ESP_ERR_INVALID_STATE  the port is not initialized.
+ *          - ESP_ERR_TIMEOUT        no frame.
+ */
+esp_err_t user_esp32_uart_receive_frame(uart_port_t port, user_uart_frame_t **frame, uint32_t timeout_ms)
+{
+    uart_context_t *ctx = uart_context_get(port);
+
+    if ((ctx == NULL) || (ctx->rx_mode != USER_UART_RX_FRAME))
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (xQueueReceive(ctx->frame_queue, frame, pdMS_TO_TICKS(timeout_ms)) != pdTRUE)
+    {
+        return ESP_ERR_TIMEOUT;
+    }
 
     return ESP_OK;
 }
+/**
+ * @brief Give a received frame back to its port.
+ *
+ * @param port[IN] UART port number.
+ * @param frame[IN] Frame returned by user_esp32_uart_receive_frame.
+ * 
+ * @return  - ESP_OK                 succeed.
+ *          - ESP_ERR_INVALID_STATE  the port is not initialized.
+ */
+esp_err_t user_esp32_uart_release_frame(uart_port_t port, user_uart_frame_t *frame)
+{
+    uart_context_t *ctx = uart_context_get(port);
+
+    if ((ctx == NULL) || (ctx->rx_mode != USER_UART_RX_FRAME))
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
 
+    xQueueSend(ctx->free_queue, &frame, 0);
+
+    return ESP_OK;
+}
 /**
- * @brief Initialization UART driver.
+ * @brief Drop the received bytes and frames not consumed yet.
  *
- * @return  - ESP_OK    succeed.
- *          - ESP_FAIL  failed.
+ * @note On a stream port this moves the ring tail, so only its consumer task
+ *       may call it, like user_esp32_uart_read.
+ * 
+ * @param port[IN] UART port number.
+ * 
+ * @return  - ESP_OK                 succeed.
+ *          - ESP_ERR_INVALID_STATE  the port is not initialized.
+ */
+esp_err_t user_esp32_uart_flush(uart_port_t port)
+{
+    uart_context_t *ctx = uart_context_get(port);
+    user_uart_frame_t *frame = NULL;
+
+    if (ctx == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uart_flush_input(port);
+    if (ctx->rx_mode == USER_UART_RX_STREAM)
+    {
+        /* Consumer side, the caller is the consumer task, drop what the ring holds. */
+        user_uart_ring_clear(&ctx->ring);
+        return ESP_OK;
+    }
+
+    while (xQueueReceive(ctx->frame_queue, &frame, 0) == pdTRUE)
+    {
+        xQueueSend(ctx->free_queue, &frame, 0);
+    }
+
+    return ESP_OK;
+}
+/**
+ * @brief Read bytes of a stream port, consumer side of its ring.
+ *
+ * @note One consumer task per port.
+ * 
+ * @param port[IN] UART port number.
+ * @param buf[OUT] Buffer of the bytes read.
+ * @param len[IN] Buffer length.
+ * @param timeout_ms[IN] Time to wait for the first byte.
+ * 
+ * @return Number of bytes read, 0 on timeout, -1 if the port is not a stream port.
+ */
+int user_esp32_uart_read(uart_port_t port, uint8_t *buf, size_t len, uint32_t timeout_ms)
+{
+    uart_context_t *ctx = uart_context_get(port);
+
+    if ((ctx == NULL) || (ctx->rx_mode != USER_UART_RX_STREAM))
+    {
+        return -1;
+    }
+
+    while ((user_uart_ring_available(&ctx->ring) == 0) &&
+           (xSemaphoreTake(ctx->rx_ready, pdMS_TO_TICKS(timeout_ms)) == pdTRUE))
+    {
+        /* Woken by the producer, check the ring again. */
+    }
+
+    return (int)user_uart_ring_read(&ctx->ring, buf, len);
+}
+/**
+ * @brief Get the statistics of a port.
+ *
+ * @param port[IN] UART port number.
+ * @param stats[OUT] Port statistics.
+ * 
+ * @return  - ESP_OK                 succeed.
+ *          - ESP_ERR_INVALID_STATE  the port is not registered.
+ */
+esp_err_t user_esp32_uart_get_stats(uart_port_t port, user_uart_stats_t *stats)
+{
+    uart_context_t *ctx = uart_context_get(port);
+
+    if (ctx == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    portENTER_CRITICAL(&uart_stats_lock);
+    *stats = ctx->stats;
+    portEXIT_CRITICAL(&uart_stats_lock);
+
+    return ESP_OK;
+}
+/**
+ * @brief Benchmark the throughput and the receive turnaround of a frame port in loopback.
+ *
+ * @note The UART echoes its own transmission, the collision detect mode keeps the
+ *       direction switched in hardware and lets the receiver listen while sending.
+ *       The frames still reach the bus, they start with a reserved Modbus address
+ *       so no slave answers. Call it before the protocol task of the port starts,
+ *       the port mode is restored at the end.
+ *
+ * @param port[IN] UART port number, a registered frame port.
+ * @param len[IN] Frame length, 2 to USER_UART_FRAME_MAX_LENGTH.
+ * @param count[IN] Number of frames.
+ * @param result[OUT] Benchmark result.
+ * 
+ * @return  - ESP_OK                 succeed.
+ *          - ESP_ERR_INVALID_ARG    invalid length or count.
+ *          - ESP_ERR_INVALID_STATE  the port is not a registered frame port.
+ *          - others                 failed.
+ */
+esp_err_t user_esp32_uart_loopback_benchmark(uart_port_t port, size_t len, uint32_t count, user_uart_benchmark_t *result)
+{
+    uart_context_t *ctx = uart_context_get(port);
+    uint8_t buf[USER_UART_FRAME_MAX_LENGTH];
+    uint64_t turnaround_sum = 0;
+    uint64_t bytes = 0;
+
+    if ((ctx == NULL) || (ctx->rx_mode != USER_UART_RX_FRAME) || (ctx->pattern_chr != 0))
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if ((len < 2) || (len > sizeof(buf)) || (count == 0) || (result == NULL))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret = uart_set_mode(port, UART_MODE_RS485_COLLISION_DETECT);
+    if (ret == ESP_OK)
+    {
+        ret = uart_set_loop_back(port, true);
+    }
+    if (ret != ESP_OK)
+    {
+        uart_set_mode(port, ctx->mode);
+        return ret;
+    }
+    user_esp32_uart_flush(port);
+
+    *result = (user_uart_benchmark_t){ .turnaround_min = UINT32_MAX };
+    int64_t start = esp_timer_get_time();
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        buf[0] = UART_BENCHMARK_ADDRESS;
+        for (size_t j = 1; j < len; j++)
+        {
+            buf[j] = (uint8_t)(i + j);
+        }
+
+        if (user_esp32_uart_transmit(port, buf, len, 1000) != ESP_OK)
+        {
+            result->lost++;
+            continue;
+        }
+        int64_t sent = esp_timer_get_time();
+
+        user_uart_frame_t *frame = NULL;
+        if (user_esp32_uart_receive_frame(port, &frame, 100) != ESP_OK)
+        {
+            result->lost++;
+            continue;
+        }
+        uint32_t turnaround = (uint32_t)(esp_timer_get_time() - sent);
+
+        if (frame->error || (frame->length != len) || (memcmp(frame->data, buf, len) != 0))
+        {
+            result->bad++;
+        }
+        else
+        {
+            result->frames++;
+            bytes += len;
+            turnaround_sum += turnaround;
+            result->turnaround_min = (turnaround < result->turnaround_min) ? turnaround : result->turnaround_min;
+            result->turnaround_max = (turnaround > result->turnaround_max) ? turnaround : result->turnaround_max;
+        }
+        user_esp32_uart_release_frame(port, frame);
+    }
+
+    int64_t elapsed = esp_timer_get_time() - start;
+
+    uart_set_loop_back(port, false);
+    uart_set_mode(port, ctx->mode);
+    user_esp32_uart_flush(port);
+
+    if (result->frames == 0)
+    {
+        result->turnaround_min = 0;
+    }
+    else
+    {
+        result->turnaround_avg = (uint32_t)(turnaround_sum / result->frames);
+    }
+    result->bytes_per_sec = (elapsed > 0) ? (uint32_t)((bytes * 1000000U) / (uint64_t)elapsed) : 0;
+
+    return ESP_OK;
+}
+/**
+ * @brief Register a UART port, install its driver and start its receive task.
+ *
+ * @param param[IN] Port configuration.
+ * 
+ * @return  - ESP_OK          succeed.
+ *          - ESP_ERR_NO_MEM  every port slot is used.
+ *          - others          failed.
  */
-esp_err_t user_esp32_uart_init(user_uart_param_t param)
+esp_err_t user_esp32_uart_register(const user_uart_param_t *param)
 {
     esp_err_t ret = ESP_OK;
+    uart_context_t *ctx = NULL;
+
+    if (uart_context_get(param->port) != NULL)
+    {
+        return ESP_OK;
+    }
+
+    for (int i = 0; (i < USER_UART_PORT_MAX) && (ctx == NULL); i++)
+    {
+        if (!uart_contexts[i].used)
+        {
+            ctx = &uart_contexts[i];
+        }
+    }
+    if (ctx == NULL)
+    {
+        ESP_LOGE(TAG, "uart_num_%d no free port slot.", param->port);
+        return ESP_ERR_NO_MEM;
+    }
     
     /* Set UART configuration parameters. */
-    ret = uart_param_config(param.port, &param.config);
+    ret = uart_param_config(param->port, &param->config);
     if(ret != ESP_OK)
     {
-        ESP_LOGE(TAG, "uart_num_%d set param configuration failed. Error Code: (%s).", param.port, esp_err_to_name(ret));
+        ESP_LOGE(TAG, "uart_num_%d set param configuration failed. Error Code: (%s).", param->port, esp_err_to_name(ret));
         return ret;
     }
     
     /* Set UART pin number. */
-    ret = uart_set_pin(param.port, param.tx_io_num, param.rx_io_num, param.rts_io_num, param.cts_io_num);
+    ret = uart_set_pin(param->port, param->tx_io_num, param->rx_io_num, param->rts_io_num, param->cts_io_num);
     if (ret != ESP_OK)
     {
-        ESP_LOGE(TAG, "uart_num_%d set pin failed. Error Code: (%s).", param.port, esp_err_to_name(ret));
+        ESP_LOGE(TAG, "uart_num_%d set pin failed. Error Code: (%s).", param->port, esp_err_to_name(ret));
         return ret;
     }
 
-    /* Install UART driver and set the UART to the default configuration. */
-    ret = uart_driver_install(param.port, param.rx_buffer_size, param.tx_buffer_size, 0, NULL, 0);
+    /* Install UART driver with an event queue. */
+    ret = uart_driver_install(param->port, param->rx_buffer_size, param->tx_buffer_size, UART_EVENT_QUEUE_LENGTH, &ctx->event_queue, 0);
     if (ret != ESP_OK)
     {
         ESP_LOGE(TAG, "Driver install failed. Error Code: (%s).", esp_err_to_name(ret));
         return ret;
     }
 
+    /* Set UART mode, RS-485 half duplex drives RTS around every transmission. */
+    ret = uart_set_mode(param->port, param->mode);
+    if ((ret == ESP_OK) && (param->rx_timeout_symbols != 0))
+    {
+        ret = uart_set_rx_timeout(param->port, param->rx_timeout_symbols);
+    }
+    if ((ret == ESP_OK) && (param->pattern_chr != 0))
+    {
+        ret = uart_enable_pattern_det_baud_intr(param->port, param->pattern_chr, 1, 9, 0, 0);
+        if (ret == ESP_OK)
+        {
+            ret = uart_pattern_queue_reset(param->port, UART_PATTERN_QUEUE_LENGTH);
+        }
+    }
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "uart_num_%d set mode failed. Error Code: (%s).", param->port, esp_err_to_name(ret));
+        goto cleanup;
+    }
+
+    ctx->port = param->port;
+    ctx->pattern_chr = param->pattern_chr;
+    ctx->rx_mode = param->rx_mode;
+    ctx->mode = param->mode;
+    ctx->current = NULL;
+    ctx->rx_error = false;
+    user_uart_ring_init(&ctx->ring, ctx->ring_buffer, USER_UART_STREAM_RING_SIZE);
+    ctx->stats = (user_uart_stats_t){ 0 };
+    ctx->rate_rx_bytes = 0;
+    ctx->rate_tx_bytes = 0;
+    ctx->rate_tick = xTaskGetTickCount();
+    ctx->tx_mutex = xSemaphoreCreateMutex();
+    ctx->rx_ready = xSemaphoreCreateBinary();
+    ctx->frame_queue = xQueueCreate(USER_UART_FRAME_POOL_SIZE, sizeof(user_uart_frame_t *));
+    ctx->free_queue = xQueueCreate(USER_UART_FRAME_POOL_SIZE, sizeof(user_uart_frame_t *));
+    if ((ctx->tx_mutex == NULL) || (ctx->rx_ready == NULL) || (ctx->frame_queue == NULL) || (ctx->free_queue == NULL))
+    {
+        ESP_LOGE(TAG, "uart_num_%d queue creation failed.", param->port);
+        ret = ESP_ERR_NO_MEM;
+        goto cleanup;
+    }
+
+    for (int i = 0; (ctx->rx_mode == USER_UART_RX_FRAME) && (i < USER_UART_FRAME_POOL_SIZE); i++)
+    {
+        user_uart_frame_t *frame = &ctx->frames[i];
+        xQueueSend(ctx->free_queue, &frame, 0);
+    }
+    ctx->used = true;
+
+    BaseType_t uxBits = xTaskCreate(uart_receive_task,             /* Pointer to the task entry function. */
+                                    "UART receive task",           /* Descriptive name for the task. */
+                                    UART_TASK_STACK_DEPTH,         /* The size of the task stack specified as the number of bytes. */
+                                    ctx,                           /* Pointer that will be used as the parameter for the task being created. */
+                                    UART_TASK_PRIORITY,            /* The priority at which the task should run. */
+                                    &ctx->task);                   /* Used to pass back a handle by which the created task can be referenced. */
+    if (uxBits != pdPASS)
+    {
+        ESP_LOGE(TAG, "uart_num_%d receive task creation failed.", param->port);
+        ret = ESP_FAIL;
+        goto cleanup;
+    }
+
     return ESP_OK;
+
+cleanup:
+    /* Leave the slot and the port free, so a later register starts over. */
+    ctx->used = false;
+    ctx->task = NULL;
+    if (ctx->tx_mutex != NULL)
+    {
+        vSemaphoreDelete(ctx->tx_mutex);
+        ctx->tx_mutex = NULL;
+    }
+    if (ctx->rx_ready != NULL)
+    {
+        vSemaphoreDelete(ctx->rx_ready);
+        ctx->rx_ready = NULL;
+    }
+    if (ctx->frame_queue != NULL)
+    {
+        vQueueDelete(ctx->frame_queue);
+        ctx->frame_queue = NULL;
+    }
+    if (ctx->free_queue != NULL)
+    {
+        vQueueDelete(ctx->free_queue);
+        ctx->free_queue = NULL;
+    }
+    uart_driver_delete(param->port);
+    ctx->event_queue = NULL;
+    return ret;
+}
+/**
+ * @brief Initialization UART driver, registers the CO2 module port when CONFIG_USER_CO2_UART is set.
+ *
+ * @note Protocol layers register their own ports with user_esp32_uart_register.
+ *       Without a consumer of the CO2 port nothing is registered, so no
+ *       receive task keeps filling a ring nobody reads.
+ * 
+ * @return  - ESP_OK    succeed.
+ *          - ESP_FAIL  failed.
+ */
+esp_err_t user_esp32_uart_init(void)
+{
+#ifdef CONFIG_USER_CO2_UART
+    return user_esp32_uart_register(&uart_default_param);
+#else
+    return ESP_OK;
+#endif
 }
 /**
  * @brief Deinitialization UART driver.
@@ -115,7 +829,3 @@ esp_err_t user_esp32_uart_deinit(void)
 {
     return ESP_OK;
 }
-
-
-
-
@@ -18,6 +18,7 @@
 #include "esp_system.h"
 #include "esp_wifi.h"
 #include "esp_smartconfig.h"
+#include "esp_sntp.h"
 #include "esp_log.h"
 
 #include "user_esp32_wifi.h"
@@ -38,6 +39,9 @@
 #define USER_WIFI_RECONNECT_SHORT_TIME  (10U)
 #define USER_WIFI_RECONNECT_LONG_TIME   (30U)
 
+/** @brief SNTP server, timestamps telemetry recorded while offline. */
+#define USER_SNTP_SERVER_NAME           "pool.ntp.org"
+
 /** @brief Longest Wi-Fi smartconfig service duration in seconds. */
 #define USER_WIFI_SC_MAXIMUM_TIME       (60U)
 
@@ -399,6 +403,14 @@ static void wifi_sta_event_handler(void *args, esp_event_base_t event_base, int3
             /* Stop Wi-Fi reconnect service.  */
             user_stop_wifi_reconnect_service();
 
+            /* Start SNTP time synchronization once. */
+            if (sntp_enabled() == 0)
+            {
+                sntp_setoperatingmode(SNTP_OPMODE_POLL);
+                sntp_setservername(0, USER_SNTP_SERVER_NAME);
+                sntp_init();
+            }
+
             /* Create MQTT client. */
             user_esp32_create_mqtt_client();
 
@@ -0,0 +1,99 @@
+/**
+ *****************************************************************************
+ * @file    : user_fan_control.c
+ * @brief   : Fixed-point fan speed controller
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *
+ * @note Plain C without FreeRTOS or ESP-IDF dependencies and without floating
+ *       point, so the controller can run against a simulated fan on the host.
+ *****************************************************************************
+ */
+
+#include <stddef.h>
+
+#include "user_fan_control.h"
+
+/**
+ * @brief  Clamp a value to a range.
+ */
+static inline int64_t fan_control_clamp(int64_t value, int64_t min, int64_t max)
+{
+    return (value < min) ? min : ((value > max) ? max : value);
+}
+/**
+ * @brief  Initialize a PI controller, output starts at output_min.
+ * 
+ * @param pi[OUT] Controller.
+ * @param kp[IN] Proportional gain, Q16.16, see FAN_CONTROL_GAIN.
+ * @param ki[IN] Integral gain per update, Q16.16.
+ * @param output_min[IN] Lowest output.
+ * @param output_max[IN] Highest output.
+ */
+void fan_control_pi_init(fan_control_pi_t *pi, int32_t kp, int32_t ki, int32_t output_min, int32_t output_max)
+{
+    pi->kp = kp;
+    pi->ki = ki;
+    pi->output_min = output_min;
+    pi->output_max = output_max;
+    fan_control_pi_reset(pi, output_min);
+}
+/**
+ * @brief  Restart the controller from an output, for a bumpless hand-over.
+ * 
+ * @param pi[IN] Controller.
+ * @param output[IN] Current output.
+ */
+void fan_control_pi_reset(fan_control_pi_t *pi, int32_t output)
+{
+    pi->output = (int32_t)fan_control_clamp(output, pi->output_min, pi->output_max);
+    pi->integral = (int64_t)pi->output << FAN_CONTROL_Q;
+}
+/**
+ * @brief  Run one controller update.
+ * 
+ * @note The integral is clamped to the output range, so a saturated fan does
+ *       not wind the integral up and the loop recovers without overshoot.
+ * 
+ * @param pi[IN] Controller.
+ * @param setpoint[IN] Target RPM.
+ * @param measured[IN] Measured RPM.
+ * 
+ * @return New output.
+ */
+int32_t fan_control_pi_update(fan_control_pi_t *pi, int32_t setpoint, int32_t measured)
+{
+    int64_t min = (int64_t)pi->output_min << FAN_CONTROL_Q;
+    int64_t max = (int64_t)pi->output_max << FAN_CONTROL_Q;
+    int64_t error = (int64_t)setpoint - measured;
+    int64_t output = 0;
+
+    pi->integral = fan_control_clamp(pi->integral + error * pi->ki, min, max);
+
+    output = fan_control_clamp(pi->integral + error * pi->kp, min, max);
+
+    /* Round to nearest. */
+    pi->output = (int32_t)((output + (1 << (FAN_CONTROL_Q - 1))) >> FAN_CONTROL_Q);
+
+    return pi->output;
+}
+/**
+ * @brief  Convert tachometer pulses counted over an interval to RPM.
+ * 
+ * @param pulses[IN] Pulses counted.
+ * @param interval_ms[IN] Counting interval.
+ * @param pulses_per_rev[IN] Tachometer pulses per revolution, 2 for most fans.
+ * 
+ * @return RPM, 0 if the interval is empty.
+ */
+uint32_t fan_control_tach_rpm(uint32_t pulses, uint32_t interval_ms, uint32_t pulses_per_rev)
+{
+    if ((interval_ms == 0) || (pulses_per_rev == 0))
+    {
+        return 0;
+    }
+
+    return (uint32_t)(((uint64_t)pulses * 60000U + (interval_ms * pulses_per_rev) / 2) / ((uint64_t)interval_ms * pulses_per_rev));
+}
+/******************************** End of File *********************************/
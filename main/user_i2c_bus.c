@@ -0,0 +1,251 @@
+/**
+ *****************************************************************************
+ * @file    : user_i2c_bus.c
+ * @brief   : I2C transaction scheduler of the sensor bus
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *
+ * @note No FreeRTOS or driver dependencies, the bus transfer and the clock are
+ *       supplied by the owner, so a host build can run it on a mock bus.
+ *****************************************************************************
+ */
+
+#include <stdbool.h>
+
+#include "user_i2c_bus.h"
+
+/**
+ * @brief  Check if a transaction must run before another one.
+ * 
+ * @note Higher priority first, then earlier deadline, then submission order.
+ */
+static bool user_i2c_bus_before(const user_i2c_transaction_t *a, const user_i2c_transaction_t *b)
+{
+    if (a->priority != b->priority)
+    {
+        return a->priority > b->priority;
+    }
+
+    if (a->timeout_ms == 0)
+    {
+        return false;
+    }
+
+    return (b->timeout_ms == 0) || ((int32_t)(a->deadline_us - b->deadline_us) < 0);
+}
+/**
+ * @brief  Get the statistics slot of a device, allocating it on first use.
+ * 
+ * @return Statistics slot, NULL if every slot is used.
+ */
+static user_i2c_device_stats_t *user_i2c_bus_device(user_i2c_bus_t *bus, uint8_t address)
+{
+    for (int i = 0; i < bus->device_count; i++)
+    {
+        if (bus->devices[i].address == address)
+        {
+            return &bus->devices[i];
+        }
+    }
+
+    if (bus->device_count >= USER_I2C_DEVICE_MAX)
+    {
+        return NULL;
+    }
+
+    user_i2c_device_stats_t *device = &bus->devices[bus->device_count++];
+    *device = (user_i2c_device_stats_t){ .address = address };
+
+    return device;
+}
+/**
+ * @brief  Complete a transaction, update the device statistics and run the callback.
+ */
+static void user_i2c_bus_complete(user_i2c_bus_t *bus, user_i2c_transaction_t *trans, esp_err_t result, bool expired)
+{
+    user_i2c_device_stats_t *device = user_i2c_bus_device(bus, trans->address);
+
+    trans->result = result;
+    trans->next = NULL;
+
+    if (device != NULL)
+    {
+        if (expired)
+        {
+            device->expired++;
+        }
+        else
+        {
+            uint32_t latency = bus->clock(bus->ctx) - trans->submit_us;
+            int bucket = 31 - __builtin_clz(latency | 1U);
+
+            if (bucket >= USER_I2C_HISTOGRAM_BUCKETS)
+            {
+                bucket = USER_I2C_HISTOGRAM_BUCKETS - 1;
+            }
+            device->histogram[bucket]++;
+
+            if (latency > device->max_latency_us)
+            {
+                device->max_latency_us = latency;
+            }
+
+            if (result == ESP_OK)
+            {
+                device->completed++;
+            }
+            else
+            {
+                device->errors++;
+            }
+        }
+    }
+
+    if (trans->callback != NULL)
+    {
+        trans->callback(trans, trans->arg);
+    }
+}
+/**
+ * @brief  Initialize an I2C transaction scheduler.
+ * 
+ * @param bus[OUT] Transaction scheduler.
+ * @param transfer[IN] Bus transfer.
+ * @param clock[IN] Microsecond clock.
+ * @param ctx[IN] Transfer and clock context.
+ */
+void user_i2c_bus_init(user_i2c_bus_t *bus, user_i2c_transfer_t transfer, user_i2c_clock_t clock, void *ctx)
+{
+    *bus = (user_i2c_bus_t){
+        .transfer = transfer,
+        .clock = clock,
+        .ctx = ctx,
+    };
+}
+/**
+ * @brief  Queue a transaction.
+ * 
+ * @param bus[IN] Transaction scheduler.
+ * @param trans[IN] Transaction, must stay valid until its callback runs.
+ */
+void user_i2c_bus_submit(user_i2c_bus_t *bus, user_i2c_transaction_t *trans)
+{
+    user_i2c_transaction_t **link = &bus->head;
+
+    trans->submit_us = bus->clock(bus->ctx);
+    trans->deadline_us = trans->submit_us + trans->timeout_ms * 1000U;
+    trans->result = ESP_ERR_INVALID_STATE;
+
+    while ((*link != NULL) && !user_i2c_bus_before(trans, *link))
+    {
+        link = &(*link)->next;
+    }
+    trans->next = *link;
+    *link = trans;
+
+    bus->stats.pending++;
+}
+/**
+ * @brief  Run the next batch of transactions.
+ * 
+ * @note Up to USER_I2C_BATCH_MAX waiting idempotent transactions share one bus transfer,
+ *       a transaction that is not idempotent runs alone. Expired transactions complete
+ *       with ESP_ERR_TIMEOUT without using the bus. When a shared transfer fails, the
+ *       transactions the bus reports as done complete, the others are repeated one by
+ *       one to find the failing one.
+ * 
+ * @param bus[IN] Transaction scheduler.
+ * 
+ * @return Number of transactions completed, 0 if none was waiting.
+ */
+int user_i2c_bus_process(user_i2c_bus_t *bus)
+{
+    user_i2c_transaction_t *batch[USER_I2C_BATCH_MAX];
+    uint32_t now = bus->clock(bus->ctx);
+    int completed = 0;
+    int count = 0;
+
+    while ((bus->head != NULL) && (count < USER_I2C_BATCH_MAX))
+    {
+        user_i2c_transaction_t *trans = bus->head;
+
+        if ((trans->timeout_ms != 0) && ((int32_t)(now - trans->deadline_us) >= 0))
+        {
+            bus->head = trans->next;
+            bus->stats.pending--;
+            user_i2c_bus_complete(bus, trans, ESP_ERR_TIMEOUT, true);
+            completed++;
+            continue;
+        }
+
+        /* A transaction that is not idempotent neither joins nor takes a batch, the order is kept. */
+        if ((count > 0) && (!trans->idempotent || !batch[0]->idempotent))
+        {
+            break;
+        }
+
+        bus->head = trans->next;
+        bus->stats.pending--;
+        batch[count++] = trans;
+    }
+
+    if (count == 0)
+    {
+        return completed;
+    }
+
+    int done = count;
+    esp_err_t ret = bus->transfer(bus->ctx, batch, count, &done);
+    bus->stats.transfers++;
+    bus->stats.transactions += count;
+    bus->stats.batched += count - 1;
+
+    if ((ret != ESP_OK) && ((done < 0) || (done >= count)))
+    {
+        done = 0;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        esp_err_t result = ret;
+
+        if ((ret != ESP_OK) && (i < done))
+        {
+            /* Already ran on the bus before the failure, never repeated. */
+            result = ESP_OK;
+        }
+        else if ((ret != ESP_OK) && (count > 1))
+        {
+            int single = 0;
+
+            result = bus->transfer(bus->ctx, &batch[i], 1, &single);
+            bus->stats.transfers++;
+            bus->stats.retried++;
+        }
+        user_i2c_bus_complete(bus, batch[i], result, false);
+    }
+
+    return completed + count;
+}
+/**
+ * @brief  Get the statistics of a device.
+ * 
+ * @param bus[IN] Transaction scheduler.
+ * @param address[IN] 7-bit device address.
+ * 
+ * @return Device statistics, NULL if the device has no statistics.
+ */
+const user_i2c_device_stats_t *user_i2c_bus_get_device_stats(const user_i2c_bus_t *bus, uint8_t address)
+{
+    for (int i = 0; i < bus->device_count; i++)
+    {
+        if (bus->devices[i].address == address)
+        {
+            return &bus->devices[i];
+        }
+    }
+
+    return NULL;
+}
+/******************************** End of File *********************************/
@@ -0,0 +1,312 @@
+/**
+ *****************************************************************************
+ * @file    : user_irrigation.c
+ * @brief   : Soil moisture irrigation controller
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ * 
+ * @note Plain C without FreeRTOS or ESP-IDF dependencies, time is passed in
+ *       by the caller, so the controller can be driven by simulated soil
+ *       moisture traces on the host.
+ *****************************************************************************
+ */
+
+#include <string.h>
+
+#include "user_irrigation.h"
+
+/** @brief Fields of a zone command, "zone,enabled,on_below,off_above,min_on_s,min_off_s,max_on_s". */
+#define IRRIGATION_PARSE_FIELDS     (7U)
+
+/** @brief Largest field value, keeps the seconds in range once converted to ms. */
+#define IRRIGATION_PARSE_MAX        (999999UL)
+
+/**
+ * @brief  Check whether a span elapsed, millisecond counter wrap-around safe.
+ */
+static inline bool irrigation_elapsed(uint32_t now_ms, uint32_t since_ms, uint32_t span_ms)
+{
+    return (uint32_t)(now_ms - since_ms) >= span_ms;
+}
+/**
+ * @brief  Open or close the valve of a zone and start its minimum on or off time.
+ */
+static void irrigation_switch_zone(irrigation_zone_t *zone, bool on, uint32_t now_ms)
+{
+    zone->on = on;
+    zone->changed_ms = now_ms;
+    zone->hold_ms = on ? zone->config.min_on_ms : zone->config.min_off_ms;
+}
+/**
+ * @brief  Initialize the controller, every zone disabled and closed, pump stopped.
+ * 
+ * @param ctrl[OUT] Controller.
+ * @param pump[IN] Pump parameters.
+ */
+void irrigation_init(irrigation_t *ctrl, const irrigation_pump_config_t *pump)
+{
+    memset(ctrl, 0, sizeof(*ctrl));
+    ctrl->pump = *pump;
+}
+/**
+ * @brief  Replace the parameters of a zone, applied at the next evaluation.
+ * 
+ * @note The valve keeps its state and its running minimum on or off time.
+ * 
+ * @param ctrl[IN] Controller.
+ * @param zone[IN] Zone, 0 ~ IRRIGATION_MAX_ZONES - 1.
+ * @param config[IN] Zone parameters.
+ * 
+ * @return false if the zone or the parameters are invalid.
+ */
+bool irrigation_set_zone(irrigation_t *ctrl, uint32_t zone, const irrigation_zone_config_t *config)
+{
+    if ((zone >= IRRIGATION_MAX_ZONES) || (config->on_below >= config->off_above) ||
+        ((config->max_on_ms != 0) && (config->max_on_ms < config->min_on_ms)))
+    {
+        return false;
+    }
+
+    ctrl->zones[zone].config = *config;
+
+    return true;
+}
+/**
+ * @brief  Set the outputs left to the manual commands.
+ * 
+ * @note An output taken over is released closed (stopped) by the controller,
+ *       the caller drives it from then on. While the pump is manual the
+ *       interlock can not be kept, so every zone stays closed. An output handed
+ *       back starts closed, the caller latches the controller outputs again.
+ * 
+ * @param ctrl[IN] Controller.
+ * @param manual[IN] IRRIGATION_ZONE_BIT() and IRRIGATION_PUMP_BIT of the manual outputs.
+ * @param now_ms[IN] Current time.
+ */
+void irrigation_set_manual(irrigation_t *ctrl, uint32_t manual, uint32_t now_ms)
+{
+    uint32_t taken = manual & ~ctrl->manual;
+
+    for (uint32_t i = 0; i < IRRIGATION_MAX_ZONES; i++)
+    {
+        if ((taken & IRRIGATION_ZONE_BIT(i)) && ctrl->zones[i].on)
+        {
+            irrigation_switch_zone(&ctrl->zones[i], false, now_ms);
+        }
+    }
+
+    if ((taken & IRRIGATION_PUMP_BIT) && ctrl->pump_on)
+    {
+        ctrl->pump_on = false;
+        ctrl->pump_changed_ms = now_ms;
+        ctrl->pump_hold_ms = ctrl->pump.pump_min_off_ms;
+    }
+
+    ctrl->manual = manual;
+}
+/**
+ * @brief  Store a soil moisture sample of a zone.
+ * 
+ * @param ctrl[IN] Controller.
+ * @param zone[IN] Zone, 0 ~ IRRIGATION_MAX_ZONES - 1.
+ * @param moisture[IN] Sample.
+ * @param now_ms[IN] Time of the sample.
+ */
+void irrigation_set_moisture(irrigation_t *ctrl, uint32_t zone, int32_t moisture, uint32_t now_ms)
+{
+    if (zone >= IRRIGATION_MAX_ZONES)
+    {
+        return;
+    }
+
+    ctrl->zones[zone].moisture = moisture;
+    ctrl->zones[zone].sample_ms = now_ms;
+    ctrl->zones[zone].sampled = true;
+}
+/**
+ * @brief  Decide the valves and the pump.
+ * 
+ * @note A valve opens at or below on_below and closes at or above off_above,
+ *       both only once its minimum on or off time elapsed. max_on_ms, a stale
+ *       probe, a manual pump and disabling the zone close it before its
+ *       minimum on time. Zones are closed first, then the driest waiting zones
+ *       open within the pump capacity. The pump only runs while a valve is
+ *       open, and a valve only opens when the pump may start. Manual outputs
+ *       are left alone.
+ * 
+ * @param ctrl[IN] Controller.
+ * @param now_ms[IN] Current time.
+ * 
+ * @return Output bits that changed, see irrigation_outputs().
+ */
+uint32_t irrigation_evaluate(irrigation_t *ctrl, uint32_t now_ms)
+{
+    uint32_t before = irrigation_outputs(ctrl);
+    uint32_t open = 0;
+    bool pump_ready = false;
+
+    for (uint32_t i = 0; i < IRRIGATION_MAX_ZONES; i++)
+    {
+        irrigation_zone_t *zone = &ctrl->zones[i];
+        bool settled = false;
+
+        if (zone->sampled && (ctrl->pump.sample_timeout_ms != 0) &&
+            irrigation_elapsed(now_ms, zone->sample_ms, ctrl->pump.sample_timeout_ms))
+        {
+            zone->sampled = false;
+        }
+
+        /* Cleared once elapsed, so a wrap of the ms counter can not bring the hold back. */
+        settled = irrigation_elapsed(now_ms, zone->changed_ms, zone->hold_ms);
+        if (settled)
+        {
+            zone->hold_ms = 0;
+        }
+
+        if (!zone->on)
+        {
+            continue;
+        }
+
+        if (!zone->config.enabled || !zone->sampled || (ctrl->manual & IRRIGATION_PUMP_BIT) ||
+            ((zone->config.max_on_ms != 0) && irrigation_elapsed(now_ms, zone->changed_ms, zone->config.max_on_ms)) ||
+            (settled && (zone->moisture >= zone->config.off_above)))
+        {
+            irrigation_switch_zone(zone, false, now_ms);
+        }
+        else
+        {
+            open++;
+        }
+    }
+
+    pump_ready = !(ctrl->manual & IRRIGATION_PUMP_BIT) &&
+                 (ctrl->pump_on || irrigation_elapsed(now_ms, ctrl->pump_changed_ms, ctrl->pump_hold_ms));
+    if (pump_ready)
+    {
+        ctrl->pump_hold_ms = 0;
+    }
+
+    while (pump_ready && (open < ctrl->pump.max_open_zones))
+    {
+        irrigation_zone_t *driest = NULL;
+
+        for (uint32_t i = 0; i < IRRIGATION_MAX_ZONES; i++)
+        {
+            irrigation_zone_t *zone = &ctrl->zones[i];
+
+            if (zone->on || (ctrl->manual & IRRIGATION_ZONE_BIT(i)) || !zone->config.enabled || !zone->sampled ||
+                (zone->hold_ms != 0) || (zone->moisture > zone->config.on_below))
+            {
+                continue;
+            }
+
+            if ((driest == NULL) ||
+                ((zone->config.on_below - zone->moisture) > (driest->config.on_below - driest->moisture)))
+            {
+                driest = zone;
+            }
+        }
+
+        if (driest == NULL)
+        {
+            break;
+        }
+
+        irrigation_switch_zone(driest, true, now_ms);
+        open++;
+    }
+
+    /* Interlock, the pump never runs against closed valves. */
+    if ((open > 0) != ctrl->pump_on)
+    {
+        ctrl->pump_on = (open > 0);
+        ctrl->pump_changed_ms = now_ms;
+        ctrl->pump_hold_ms = ctrl->pump_on ? 0 : ctrl->pump.pump_min_off_ms;
+    }
+
+    return before ^ irrigation_outputs(ctrl);
+}
+/**
+ * @brief  Current outputs.
+ * 
+ * @param ctrl[IN] Controller.
+ * 
+ * @return IRRIGATION_ZONE_BIT() of every open valve, IRRIGATION_PUMP_BIT if the pump runs.
+ */
+uint32_t irrigation_outputs(const irrigation_t *ctrl)
+{
+    uint32_t outputs = ctrl->pump_on ? IRRIGATION_PUMP_BIT : 0;
+
+    for (uint32_t i = 0; i < IRRIGATION_MAX_ZONES; i++)
+    {
+        if (ctrl->zones[i].on)
+        {
+            outputs |= IRRIGATION_ZONE_BIT(i);
+        }
+    }
+
+    return outputs;
+}
+/**
+ * @brief  Parse a zone command "zone,enabled,on_below,off_above,min_on_s,min_off_s,max_on_s".
+ * 
+ * @note zone starts from 1, enabled is 0 or 1, the thresholds are in the unit of
+ *       the samples and the times in seconds. The parameters are not checked
+ *       against each other, irrigation_set_zone() does.
+ * 
+ * @param data[IN] Command, not NUL terminated.
+ * @param data_len[IN] Command length.
+ * @param config[OUT] Zone parameters.
+ * 
+ * @return Zone, 0 ~ IRRIGATION_MAX_ZONES - 1, or -1 if the command is malformed.
+ */
+int irrigation_parse_zone(const char *data, size_t data_len, irrigation_zone_config_t *config)
+{
+    uint32_t fields[IRRIGATION_PARSE_FIELDS];
+    uint32_t field = 0;
+    bool digit = false;
+
+    memset(fields, 0, sizeof(fields));
+
+    for (size_t i = 0; i < data_len; i++)
+    {
+        char c = data[i];
+
+        if ((c >= '0') && (c <= '9'))
+        {
+            fields[field] = fields[field] * 10U + (uint32_t)(c - '0');
+            if (fields[field] > IRRIGATION_PARSE_MAX)
+            {
+                return -1;
+            }
+            digit = true;
+        }
+        else if ((c == ',') && digit && (field < IRRIGATION_PARSE_FIELDS - 1))
+        {
+            field++;
+            digit = false;
+        }
+        else if ((c != ' ') && (c != '\r') && (c != '\n'))
+        {
+            return -1;
+        }
+    }
+
+    if ((field != IRRIGATION_PARSE_FIELDS - 1) || !digit ||
+        (fields[0] == 0) || (fields[0] > IRRIGATION_MAX_ZONES) || (fields[1] > 1))
+    {
+        return -1;
+    }
+
+    config->enabled = (fields[1] != 0);
+    config->on_below = (int32_t)fields[2];
+    config->off_above = (int32_t)fields[3];
+    config->min_on_ms = fields[4] * 1000U;
+    config->min_off_ms = fields[5] * 1000U;
+    config->max_on_ms = fields[6] * 1000U;
+
+    return (int)fields[0] - 1;
+}
+/******************************** End of File *********************************/
@@ -0,0 +1,288 @@
+/**
+ *****************************************************************************
+ * @file    : user_light_recipe.c
+ * @brief   : Grow light recipe interpolation engine
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *
+ * @note Plain C without FreeRTOS or ESP-IDF dependencies. A segment between
+ *       two keyframes is set up once with a fixed-point increment per frame,
+ *       every frame then costs one addition per component.
+ *****************************************************************************
+ */
+
+#include <string.h>
+
+#include "user_light_recipe.h"
+
+/** @brief Fixed-point fraction bits of the interpolated values. */
+#define LIGHT_RECIPE_Q              (32U)
+
+/**
+ * @brief  Keyframe time of the day in ms.
+ */
+static inline uint32_t light_recipe_keyframe_ms(const light_recipe_t *recipe, int index)
+{
+    return (uint32_t)recipe->keyframes[index].minute * 60U * 1000U;
+}
+/**
+ * @brief  Length of the segment starting at a keyframe, the last one wraps past midnight.
+ */
+static uint32_t light_recipe_segment_ms(const light_recipe_t *recipe, int index)
+{
+    int next = (index + 1) % recipe->count;
+    uint32_t start = light_recipe_keyframe_ms(recipe, index);
+    uint32_t end = light_recipe_keyframe_ms(recipe, next);
+
+    return (end > start) ? (end - start) : (end + LIGHT_RECIPE_MS_PER_DAY - start);
+}
+/**
+ * @brief  Set up the remaining part of a segment from the current value.
+ * 
+ * @param recipe[IN] Recipe.
+ * @param remaining_ms[IN] Time to the end of the segment.
+ */
+static void light_recipe_load(light_recipe_t *recipe, uint32_t remaining_ms)
+{
+    const light_recipe_keyframe_t *end = &recipe->keyframes[(recipe->segment + 1) % recipe->count];
+
+    recipe->frames_left = remaining_ms / recipe->frame_ms;
+
+    for (int i = 0; i < LIGHT_RECIPE_COMPONENTS; i++)
+    {
+        int64_t target = (int64_t)end->value[i] << LIGHT_RECIPE_Q;
+
+        if (recipe->frames_left == 0)
+        {
+            recipe->value[i] = target;
+            recipe->step[i] = 0;
+        }
+        else
+        {
+            recipe->step[i] = (target - recipe->value[i]) / (int64_t)recipe->frames_left;
+        }
+    }
+}
+/**
+ * @brief  Round the current values to the output.
+ * 
+ * @return true if the output changed.
+ */
+static bool light_recipe_output(light_recipe_t *recipe)
+{
+    bool changed = false;
+
+    for (int i = 0; i < LIGHT_RECIPE_COMPONENTS; i++)
+    {
+        uint8_t out = (uint8_t)((recipe->value[i] + (1LL << (LIGHT_RECIPE_Q - 1))) >> LIGHT_RECIPE_Q);
+
+        changed |= (out != recipe->output[i]);
+        recipe->output[i] = out;
+    }
+
+    return changed;
+}
+/**
+ * @brief  Initialize a recipe, call light_recipe_seek before stepping it.
+ * 
+ * @param recipe[OUT] Recipe.
+ * @param keyframes[IN] Keyframes sorted by strictly increasing minute.
+ * @param count[IN] Keyframes, 0 disables the recipe.
+ * @param frame_ms[IN] Time between two steps.
+ * 
+ * @return true if the keyframes are valid.
+ */
+bool light_recipe_init(light_recipe_t *recipe, const light_recipe_keyframe_t *keyframes, int count, uint32_t frame_ms)
+{
+    if ((count < 0) || (count > LIGHT_RECIPE_MAX_KEYFRAMES) || (frame_ms == 0))
+    {
+        return false;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        if ((keyframes[i].minute >= LIGHT_RECIPE_MINUTES_PER_DAY) ||
+            ((i > 0) && (keyframes[i].minute <= keyframes[i - 1].minute)))
+        {
+            return false;
+        }
+    }
+
+    memset(recipe, 0, sizeof(*recipe));
+    if (count > 0)
+    {
+        memcpy(recipe->keyframes, keyframes, count * sizeof(keyframes[0]));
+    }
+    recipe->count = count;
+    recipe->frame_ms = frame_ms;
+
+    return true;
+}
+/**
+ * @brief  Jump to a time of the day, at start-up or when the clock is corrected.
+ * 
+ * @param recipe[IN] Recipe.
+ * @param ms_of_day[IN] Time of the day in ms.
+ */
+void light_recipe_seek(light_recipe_t *recipe, uint32_t ms_of_day)
+{
+    const light_recipe_keyframe_t *start = NULL;
+    uint32_t elapsed = 0;
+    uint32_t length = 0;
+
+    if (recipe->count == 0)
+    {
+        return;
+    }
+
+    ms_of_day %= LIGHT_RECIPE_MS_PER_DAY;
+
+    /* Last keyframe at or before now, the one of the previous day if now is before the first. */
+    recipe->segment = recipe->count - 1;
+    for (int i = 0; i < recipe->count; i++)
+    {
+        if (light_recipe_keyframe_ms(recipe, i) <= ms_of_day)
+        {
+            recipe->segment = i;
+        }
+    }
+
+    start = &recipe->keyframes[recipe->segment];
+    length = light_recipe_segment_ms(recipe, recipe->segment);
+    elapsed = (ms_of_day + LIGHT_RECIPE_MS_PER_DAY - light_recipe_keyframe_ms(recipe, recipe->segment)) % LIGHT_RECIPE_MS_PER_DAY;
+
+    for (int i = 0; i < LIGHT_RECIPE_COMPONENTS; i++)
+    {
+        int32_t from = start->value[i];
+        int32_t to = recipe->keyframes[(recipe->segment + 1) % recipe->count].value[i];
+
+        /* (to - from) * elapsed fits in 40 bits, the fraction is added after the division. */
+        int64_t delta = (int64_t)(to - from) * elapsed;
+
+        recipe->value[i] = ((int64_t)from << LIGHT_RECIPE_Q) + (delta / length) * (1LL << LIGHT_RECIPE_Q) +
+                           (delta % length) * (1LL << LIGHT_RECIPE_Q) / length;
+    }
+
+    light_recipe_load(recipe, length - elapsed);
+    light_recipe_output(recipe);
+}
+/**
+ * @brief  Advance the recipe by one frame.
+ * 
+ * @param recipe[IN] Recipe, output holds the new values.
+ * 
+ * @return true if the output changed, the strips only need a new frame then.
+ */
+bool light_recipe_step(light_recipe_t *recipe)
+{
+    if (recipe->count == 0)
+    {
+        return false;
+    }
+
+    if (recipe->frames_left == 0)
+    {
+        /* Segment done, the value is exactly the keyframe, start the next one. */
+        recipe->segment = (recipe->segment + 1) % recipe->count;
+        light_recipe_load(recipe, light_recipe_segment_ms(recipe, recipe->segment));
+    }
+
+    if (recipe->frames_left > 0)
+    {
+        recipe->frames_left--;
+
+        for (int i = 0; i < LIGHT_RECIPE_COMPONENTS; i++)
+        {
+            recipe->value[i] += recipe->step[i];
+        }
+
+        if (recipe->frames_left == 0)
+        {
+            /* Land on the keyframe without the rounding left by the increments. */
+            const light_recipe_keyframe_t *end = &recipe->keyframes[(recipe->segment + 1) % recipe->count];
+
+            for (int i = 0; i < LIGHT_RECIPE_COMPONENTS; i++)
+            {
+                recipe->value[i] = (int64_t)end->value[i] << LIGHT_RECIPE_Q;
+            }
+        }
+    }
+
+    return light_recipe_output(recipe);
+}
+/**
+ * @brief  Parse a text recipe, "minute,brightness,red,green,blue;..." sorted by minute.
+ * 
+ * @param data[IN] Payload, not NUL terminated.
+ * @param data_len[IN] Payload length.
+ * @param keyframes[OUT] Keyframes.
+ * @param max[IN] Keyframe capacity.
+ * 
+ * @return Keyframes parsed, -1 if the payload is malformed.
+ */
+int light_recipe_parse(const char *data, size_t data_len, light_recipe_keyframe_t *keyframes, int max)
+{
+    uint32_t fields[1 + LIGHT_RECIPE_COMPONENTS];
+    int field = 0;
+    int count = 0;
+    bool digit = false;
+
+    memset(fields, 0, sizeof(fields));
+
+    for (size_t i = 0; i <= data_len; i++)
+    {
+        char c = (i < data_len) ? data[i] : ';';
+
+        if ((c >= '0') && (c <= '9'))
+        {
+            fields[field] = fields[field] * 10U + (uint32_t)(c - '0');
+            if (fields[field] > 0xFFFFU)
+            {
+                return -1;
+            }
+            digit = true;
+        }
+        else if ((c == ',') && digit && (field < LIGHT_RECIPE_COMPONENTS))
+        {
+            field++;
+            digit = false;
+        }
+        else if (c == ';')
+        {
+            if ((field == 0) && !digit)
+            {
+                /* Empty keyframe, e.g. a trailing separator. */
+                continue;
+            }
+
+            if ((field != LIGHT_RECIPE_COMPONENTS) || !digit || (count >= max) ||
+                (fields[0] >= LIGHT_RECIPE_MINUTES_PER_DAY))
+            {
+                return -1;
+            }
+
+            keyframes[count].minute = (uint16_t)fields[0];
+            for (int j = 0; j < LIGHT_RECIPE_COMPONENTS; j++)
+            {
+                if (fields[1 + j] > UINT8_MAX)
+                {
+                    return -1;
+                }
+                keyframes[count].value[j] = (uint8_t)fields[1 + j];
+            }
+
+            count++;
+            field = 0;
+            digit = false;
+            memset(fields, 0, sizeof(fields));
+        }
+        else if ((c != ' ') && (c != '\r') && (c != '\n'))
+        {
+            return -1;
+        }
+    }
+
+    return count;
+}
+/******************************** End of File *********************************/
@@ -0,0 +1,603 @@
+/**
+ *****************************************************************************
+ * @file    : user_modbus_master.c
+ * @brief   : Modbus RTU/ASCII master polling engine
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *
+ * @note No FreeRTOS or driver dependencies, the serial transport is supplied
+ *       by the owner, so a host build can poll a simulated slave.
+ *****************************************************************************
+ */
+
+#include <string.h>
+
+#include "user_modbus_master.h"
+
+/** @brief Request ADU without checksum: slave, function, address, count. */
+#define MODBUS_REQUEST_LENGTH       (6U)
+
+/** @brief Exception flag of a response function code. */
+#define MODBUS_EXCEPTION_FLAG       (0x80U)
+
+/** @brief Exception code of a read that touches a register the slave does not have. */
+#define MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS   (0x02U)
+
+/** @brief Response length for a read of n registers. */
+#define MODBUS_RTU_RESPONSE_LENGTH(n)   (5U + 2U * (n))
+#define MODBUS_ASCII_RESPONSE_LENGTH(n) (11U + 4U * (n))
+
+_Static_assert(USER_MODBUS_REQUEST_MAX_LENGTH == 1U + 2U * (MODBUS_REQUEST_LENGTH + 1U) + 2U, "ASCII request length");
+
+/** @brief Hexadecimal digits of ASCII frames. */
+static const char modbus_hex[] = "0123456789ABCDEF";
+
+/**
+ * @brief  Calculate the Modbus RTU CRC-16.
+ * 
+ * @param data[IN] Bytes.
+ * @param length[IN] Number of bytes.
+ * 
+ * @return CRC-16, polynomial 0xA001 reflected, initial value 0xFFFF, sent low byte first.
+ */
+uint16_t user_modbus_crc16(const uint8_t *data, size_t length)
+{
+    uint16_t crc = 0xFFFF;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        crc ^= data[i];
+        for (uint8_t j = 0; j < 8; j++)
+        {
+            crc = (crc & 1U) ? (uint16_t)((crc >> 1) ^ 0xA001U) : (uint16_t)(crc >> 1);
+        }
+    }
+
+    return crc;
+}
+/**
+ * @brief  Calculate the Modbus ASCII LRC.
+ * 
+ * @param data[IN] Bytes.
+ * @param length[IN] Number of bytes.
+ * 
+ * @return Two's complement of the byte sum.
+ */
+uint8_t user_modbus_lrc(const uint8_t *data, size_t length)
+{
+    uint8_t sum = 0;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        sum += data[i];
+    }
+
+    return (uint8_t)(-sum);
+}
+/**
+ * @brief  Calculate the RTU silent intervals of a baud rate.
+ * 
+ * @note Up to 19200 baud, t1.5 and t3.5 are 1.5 and 3.5 character times. Above it the
+ *       intervals are fixed because the UART interrupt latency would dominate.
+ * 
+ * @param baud_rate[IN] Baud rate.
+ * @param t15_us[OUT] Longest silence inside a frame.
+ * @param t35_us[OUT] Silence between two frames.
+ */
+void user_modbus_rtu_timing(uint32_t baud_rate, uint32_t *t15_us, uint32_t *t35_us)
+{
+    if ((baud_rate == 0) || (baud_rate > USER_MODBUS_FIXED_TIMING_BAUD))
+    {
+        *t15_us = USER_MODBUS_FIXED_T15_US;
+        *t35_us = USER_MODBUS_FIXED_T35_US;
+        return;
+    }
+
+    *t15_us = (USER_MODBUS_CHAR_BITS * 1500000U + baud_rate - 1) / baud_rate;
+    *t35_us = (USER_MODBUS_CHAR_BITS * 3500000U + baud_rate - 1) / baud_rate;
+}
+/**
+ * @brief  Convert a hexadecimal digit, -1 if invalid.
+ */
+static int modbus_hex_value(uint8_t c)
+{
+    if ((c >= '0') && (c <= '9'))
+    {
+        return c - '0';
+    }
+    if ((c >= 'A') && (c <= 'F'))
+    {
+        return c - 'A' + 10;
+    }
+    if ((c >= 'a') && (c <= 'f'))
+    {
+        return c - 'a' + 10;
+    }
+
+    return -1;
+}
+/**
+ * @brief  Build the read request of a block.
+ * 
+ * @return Frame length.
+ */
+static size_t modbus_encode_request(const user_modbus_master_t *master, const user_modbus_block_t *block, uint8_t *frame)
+{
+    uint8_t adu[MODBUS_REQUEST_LENGTH + 2] = {
+        master->slaves[block->slave_index].address,
+        block->function,
+        (uint8_t)(block->address >> 8), (uint8_t)block->address,
+        (uint8_t)(block->count >> 8), (uint8_t)block->count,
+    };
+
+    if (master->mode == USER_MODBUS_MODE_RTU)
+    {
+        uint16_t crc = user_modbus_crc16(adu, MODBUS_REQUEST_LENGTH);
+        adu[MODBUS_REQUEST_LENGTH] = (uint8_t)crc;
+        adu[MODBUS_REQUEST_LENGTH + 1] = (uint8_t)(crc >> 8);
+        memcpy(frame, adu, sizeof(adu));
+
+        return sizeof(adu);
+    }
+
+    size_t length = 0;
+    adu[MODBUS_REQUEST_LENGTH] = user_modbus_lrc(adu, MODBUS_REQUEST_LENGTH);
+
+    frame[length++] = ':';
+    for (size_t i = 0; i <= MODBUS_REQUEST_LENGTH; i++)
+    {
+        frame[length++] = modbus_hex[adu[i] >> 4];
+        frame[length++] = modbus_hex[adu[i] & 0x0F];
+    }
+    frame[length++] = '\r';
+    frame[length++] = '\n';
+
+    return length;
+}
+/**
+ * @brief  Check the framing of a response and reduce it to its ADU without checksum.
+ * 
+ * @return ADU length, 0 if the frame is corrupted.
+ */
+static size_t modbus_unframe(const user_modbus_master_t *master, uint8_t *frame, size_t length)
+{
+    if (master->mode == USER_MODBUS_MODE_RTU)
+    {
+        if ((length < 4) || (user_modbus_crc16(frame, length) != 0))
+        {
+            return 0;
+        }
+
+        return length - 2;
+    }
+
+    /* ':' hex pairs CR LF, decoded in place. */
+    if ((length < 7) || (frame[0] != ':') || (frame[length - 2] != '\r') || (frame[length - 1] != '\n') || ((length - 3) & 1U))
+    {
+        return 0;
+    }
+
+    size_t count = (length - 3) / 2;
+    for (size_t i = 0; i < count; i++)
+    {
+        int high = modbus_hex_value(frame[1 + 2 * i]);
+        int low = modbus_hex_value(frame[2 + 2 * i]);
+        if ((high < 0) || (low < 0))
+        {
+            return 0;
+        }
+        frame[i] = (uint8_t)((high << 4) | low);
+    }
+
+    if (user_modbus_lrc(frame, count) != 0)
+    {
+        return 0;
+    }
+
+    return count - 1;
+}
+/**
+ * @brief  Learn the response latency of a slave and derive its timeout, like a TCP RTO.
+ */
+static void modbus_learn_latency(user_modbus_slave_stats_t *stats, uint32_t latency_ms)
+{
+    int32_t sample = (int32_t)(latency_ms << 4);
+
+    if (stats->timeout_ms == 0)
+    {
+        stats->srtt_q4 = sample;
+        stats->rttvar_q4 = sample / 2;
+    }
+    else
+    {
+        int32_t error = sample - (int32_t)stats->srtt_q4;
+        stats->srtt_q4 = (uint32_t)((int32_t)stats->srtt_q4 + error / 8);
+        stats->rttvar_q4 = (uint32_t)((int32_t)stats->rttvar_q4 + (((error < 0) ? -error : error) - (int32_t)stats->rttvar_q4) / 4);
+    }
+
+    stats->timeout_ms = (stats->srtt_q4 + 4 * stats->rttvar_q4 + 15) / 16 + USER_MODBUS_TIMEOUT_MARGIN_MS;
+}
+/**
+ * @brief  Run the read request of a block once.
+ * 
+ * @return - ESP_OK                   succeed, master->regs holds the registers
+ *         - ESP_ERR_TIMEOUT          no response
+ *         - ESP_ERR_INVALID_CRC      corrupted response
+ *         - ESP_ERR_NOT_FOUND        illegal data address exception
+ *         - ESP_ERR_INVALID_RESPONSE mismatched or other exception response
+ */
+static esp_err_t modbus_read_block(user_modbus_master_t *master, const user_modbus_block_t *block)
+{
+    const user_modbus_slave_config_t *slave = &master->slaves[block->slave_index];
+    user_modbus_slave_stats_t *stats = &master->slave_stats[block->slave_index];
+    uint32_t timeout_ms = slave->timeout_ms;
+
+    if ((stats->timeout_ms != 0) && (stats->timeout_ms + block->response_ms < timeout_ms))
+    {
+        timeout_ms = stats->timeout_ms + block->response_ms;
+    }
+
+    esp_err_t ret = master->transport.send(master->transport.ctx, block->request, block->request_length);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+
+    uint32_t start = master->transport.clock_ms(master->transport.ctx);
+    int length = master->transport.receive(master->transport.ctx, master->frame, sizeof(master->frame),
+                                           timeout_ms, master->stats.t35_us);
+    if (length <= 0)
+    {
+        /* Back off the learned timeout, the configured one stays the ceiling. */
+        if (stats->timeout_ms < slave->timeout_ms)
+        {
+            stats->timeout_ms *= 2;
+        }
+        return ESP_ERR_TIMEOUT;
+    }
+
+    /* Time on the wire of the frame received, an exception is shorter than the expected response. */
+    uint32_t elapsed = master->transport.clock_ms(master->transport.ctx) - start;
+    uint32_t wire_ms = ((uint32_t)length * master->char_us + 999U) / 1000U;
+    modbus_learn_latency(stats, (elapsed > wire_ms) ? (elapsed - wire_ms) : 0);
+
+    size_t adu_length = modbus_unframe(master, master->frame, (size_t)length);
+    if (adu_length == 0)
+    {
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    const uint8_t *adu = master->frame;
+    if ((adu_length == 3) && (adu[0] == slave->address) && (adu[1] == (block->function | MODBUS_EXCEPTION_FLAG)) &&
+        (adu[2] == MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS))
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if ((adu[0] != slave->address) || (adu[1] != block->function) || (adu_length != 3U + 2U * block->count) || (adu[2] != 2U * block->count))
+    {
+        /* Other exception responses (function | MODBUS_EXCEPTION_FLAG) land here as well. */
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    for (uint16_t i = 0; i < block->count; i++)
+    {
+        master->regs[i] = (uint16_t)((adu[3 + 2 * i] << 8) | adu[4 + 2 * i]);
+    }
+
+    return ESP_OK;
+}
+/**
+ * @brief  Build the request frame of a block once, it does not change between cycles.
+ */
+static void modbus_block_prepare(user_modbus_master_t *master, user_modbus_block_t *block)
+{
+    uint32_t response_length = (master->mode == USER_MODBUS_MODE_RTU) ? MODBUS_RTU_RESPONSE_LENGTH(block->count) : MODBUS_ASCII_RESPONSE_LENGTH(block->count);
+
+    block->request_length = (uint8_t)modbus_encode_request(master, block, block->request);
+    block->response_ms = (response_length * master->char_us + 999U) / 1000U;
+}
+/**
+ * @brief  Replace a merged block by one block per point, in place.
+ * 
+ * @note The blocks never outnumber the points, so the table always has room.
+ */
+static void modbus_split_block(user_modbus_master_t *master, int index)
+{
+    user_modbus_block_t merged = master->blocks[index];
+    int extra = merged.point_count - 1;
+
+    memmove(&master->blocks[index + merged.point_count], &master->blocks[index + 1],
+            (master->block_count - index - 1) * sizeof(master->blocks[0]));
+    master->block_count += extra;
+    master->stats.blocks = master->block_count;
+
+    for (int i = 0; i < merged.point_count; i++)
+    {
+        const user_modbus_point_t *point = &master->points[master->order[merged.first + i]];
+        user_modbus_block_t *block = &master->blocks[index + i];
+
+        block->slave_index = merged.slave_index;
+        block->function = merged.function;
+        block->address = point->address;
+        block->count = point->count;
+        block->first = (uint8_t)(merged.first + i);
+        block->point_count = 1;
+        modbus_block_prepare(master, block);
+    }
+}
+/**
+ * @brief  Check if a point must be read before another one.
+ */
+static bool modbus_point_before(const user_modbus_point_t *a, const user_modbus_point_t *b)
+{
+    if (a->slave != b->slave)
+    {
+        return a->slave < b->slave;
+    }
+    if (a->function != b->function)
+    {
+        return a->function < b->function;
+    }
+
+    return a->address < b->address;
+}
+/**
+ * @brief  Initialize a polling engine and merge the register map into block reads.
+ * 
+ * @note Points of the same slave and function are merged while the gap between them is
+ *       at most USER_MODBUS_MERGE_GAP registers and the read stays within
+ *       USER_MODBUS_MAX_READ_REGISTERS, one request then replaces several round trips.
+ *       A slave without the registers of a gap rejects the merged read, the poll
+ *       then splits the block again, see user_modbus_master_poll.
+ * 
+ * @param master[OUT] Polling engine.
+ * @param mode[IN] Serial transmission mode.
+ * @param baud_rate[IN] Baud rate, sets the silent intervals and the transfer times.
+ * @param transport[IN] Serial transport.
+ * @param slaves[IN] Slave configurations.
+ * @param slave_count[IN] Number of slaves.
+ * @param points[IN] Register map, must stay valid.
+ * @param point_count[IN] Number of points.
+ * 
+ * @return - ESP_OK              succeed
+ *         - ESP_ERR_INVALID_ARG invalid table, unknown slave or function, too many entries
+ */
+esp_err_t user_modbus_master_init(user_modbus_master_t *master, user_modbus_mode_t mode, uint32_t baud_rate,
+                                  const user_modbus_transport_t *transport,
+                                  const user_modbus_slave_config_t *slaves, int slave_count,
+                                  const user_modbus_point_t *points, int point_count)
+{
+    if ((baud_rate == 0) || (slave_count <= 0) || (slave_count > USER_MODBUS_MAX_SLAVES) || (point_count <= 0) || (point_count > USER_MODBUS_MAX_POINTS))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(master, 0, sizeof(*master));
+    master->mode = mode;
+    master->transport = *transport;
+    master->slave_count = slave_count;
+    memcpy(master->slaves, slaves, slave_count * sizeof(slaves[0]));
+    master->points = points;
+    master->char_us = (USER_MODBUS_CHAR_BITS * 1000000U + baud_rate - 1) / baud_rate;
+    user_modbus_rtu_timing(baud_rate, &master->stats.t15_us, &master->stats.t35_us);
+
+    /* Sort the points by slave, function and address. */
+    for (int i = 0; i < point_count; i++)
+    {
+        const user_modbus_point_t *point = &points[i];
+        if ((point->count == 0) || (point->count > USER_MODBUS_MAX_READ_REGISTERS) || (point->handler == NULL) ||
+            ((point->function != USER_MODBUS_READ_HOLDING_REGISTERS) && (point->function != USER_MODBUS_READ_INPUT_REGISTERS)))
+        {
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        int j = i;
+        while ((j > 0) && modbus_point_before(point, &points[master->order[j - 1]]))
+        {
+            master->order[j] = master->order[j - 1];
+            j--;
+        }
+        master->order[j] = (uint8_t)i;
+    }
+
+    /* Merge the sorted points into blocks. */
+    user_modbus_block_t *block = NULL;
+    for (int i = 0; i < point_count; i++)
+    {
+        const user_modbus_point_t *point = &points[master->order[i]];
+        uint32_t end = (uint32_t)point->address + point->count;
+
+        if ((block != NULL) && (master->slaves[block->slave_index].address == point->slave) && (block->function == point->function) &&
+            (point->address <= (uint32_t)block->address + block->count + USER_MODBUS_MERGE_GAP) &&
+            (end - block->address <= USER_MODBUS_MAX_READ_REGISTERS))
+        {
+            if (end > (uint32_t)block->address + block->count)
+            {
+                block->count = (uint16_t)(end - block->address);
+            }
+            block->point_count++;
+            continue;
+        }
+
+        int slave_index = 0;
+        while ((slave_index < slave_count) && (slaves[slave_index].address != point->slave))
+        {
+            slave_index++;
+        }
+        if (slave_index == slave_count)
+        {
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        block = &master->blocks[master->block_count++];
+        block->slave_index = (uint8_t)slave_index;
+        block->function = point->function;
+        block->address = point->address;
+        block->count = point->count;
+        block->first = (uint8_t)i;
+        block->point_count = 1;
+    }
+
+    for (int b = 0; b < master->block_count; b++)
+    {
+        modbus_block_prepare(master, &master->blocks[b]);
+    }
+
+    master->stats.points = point_count;
+    master->stats.blocks = master->block_count;
+
+    return ESP_OK;
+}
+/**
+ * @brief  Read a block and dispatch its registers, or account the failure of its slave.
+ * 
+ * @return - ESP_OK             succeed
+ *         - ESP_ERR_NOT_FOUND  a merged read spans a register the slave does not have, the caller splits it
+ *         - others             the read failed, the slave backs off
+ */
+static esp_err_t modbus_poll_block(user_modbus_master_t *master, const user_modbus_block_t *block)
+{
+    const user_modbus_slave_config_t *slave = &master->slaves[block->slave_index];
+    user_modbus_slave_stats_t *stats = &master->slave_stats[block->slave_index];
+    /* A slave that is already failing gets one probe, not the full retries. */
+    int attempts = (stats->failures == 0) ? (slave->retries + 1) : 1;
+    esp_err_t ret = ESP_FAIL;
+
+    for (int attempt = 0; attempt < attempts; attempt++)
+    {
+        stats->requests++;
+        ret = modbus_read_block(master, block);
+        if (ret == ESP_OK)
+        {
+            break;
+        }
+
+        if (ret == ESP_ERR_TIMEOUT)
+        {
+            stats->timeouts++;
+        }
+        else
+        {
+            stats->errors++;
+        }
+
+        if (ret == ESP_ERR_NOT_FOUND)
+        {
+            /* The slave answered, the same request gets the same exception. */
+            break;
+        }
+    }
+
+    if ((ret == ESP_ERR_NOT_FOUND) && (block->point_count > 1))
+    {
+        /* Not a failure of the slave, the merge covered a hole of its register map. */
+        return ret;
+    }
+
+    if (ret != ESP_OK)
+    {
+        uint32_t shift = (stats->failures < 6) ? stats->failures : 6;
+        uint32_t backoff = USER_MODBUS_BACKOFF_BASE_MS << shift;
+
+        stats->failures++;
+        stats->retry_at = master->transport.clock_ms(master->transport.ctx) +
+                          ((backoff < USER_MODBUS_BACKOFF_MAX_MS) ? backoff : USER_MODBUS_BACKOFF_MAX_MS);
+        return ret;
+    }
+
+    stats->responses++;
+    stats->failures = 0;
+
+    for (int i = 0; i < block->point_count; i++)
+    {
+        const user_modbus_point_t *point = &master->points[master->order[block->first + i]];
+        point->handler(point, &master->regs[point->address - block->address]);
+    }
+
+    return ESP_OK;
+}
+/**
+ * @brief  Run one poll cycle, read every block and dispatch the registers to the points.
+ * 
+ * @note Healthy slaves are read first, back to back with only the t3.5 silence between
+ *       frames, so a failing slave cannot delay them. A failed request is repeated up to
+ *       the retries of the slave. When it still fails, the slave is skipped until its
+ *       backoff expires, the backoff doubles on every failed poll up to
+ *       USER_MODBUS_BACKOFF_MAX_MS and resets on success. Its blocks then run last.
+ *       A merged read answered by an illegal data address exception is split
+ *       into one read per point for good, and those are read right away.
+ * 
+ * @param master[IN] Polling engine.
+ */
+void user_modbus_master_poll(user_modbus_master_t *master)
+{
+    uint32_t start = master->transport.clock_ms(master->transport.ctx);
+    bool recovering[USER_MODBUS_MAX_SLAVES];
+
+    for (int i = 0; i < master->slave_count; i++)
+    {
+        recovering[i] = (master->slave_stats[i].failures != 0);
+    }
+
+    /* Pass 0 reads the healthy slaves, pass 1 the slaves that were failing. */
+    for (int pass = 0; pass < 2; pass++)
+    {
+        for (int b = 0; b < master->block_count; b++)
+        {
+            const user_modbus_block_t *block = &master->blocks[b];
+            user_modbus_slave_stats_t *stats = &master->slave_stats[block->slave_index];
+
+            if (recovering[block->slave_index] != (pass == 1))
+            {
+                continue;
+            }
+
+            if ((stats->failures != 0) && ((int32_t)(master->transport.clock_ms(master->transport.ctx) - stats->retry_at) < 0))
+            {
+                stats->skipped++;
+                continue;
+            }
+
+            if ((modbus_poll_block(master, block) == ESP_ERR_NOT_FOUND) && (block->point_count > 1))
+            {
+                modbus_split_block(master, b);
+                b--;
+            }
+        }
+    }
+
+    uint32_t duration = master->transport.clock_ms(master->transport.ctx) - start;
+
+    master->stats.last_cycle_ms = duration;
+    if ((master->stats.cycles == 0) || (duration < master->stats.min_cycle_ms))
+    {
+        master->stats.min_cycle_ms = duration;
+    }
+    if (duration > master->stats.max_cycle_ms)
+    {
+        master->stats.max_cycle_ms = duration;
+    }
+    master->stats.cycles++;
+}
+/**
+ * @brief  Get the statistics of a slave.
+ * 
+ * @param master[IN] Polling engine.
+ * @param address[IN] Slave address.
+ * 
+ * @return Slave statistics, NULL if the slave is unknown.
+ */
+const user_modbus_slave_stats_t *user_modbus_master_get_slave_stats(const user_modbus_master_t *master, uint8_t address)
+{
+    for (int i = 0; i < master->slave_count; i++)
+    {
+        if (master->slaves[i].address == address)
+        {
+            return &master->slave_stats[i];
+        }
+    }
+
+    return NULL;
+}
+/******************************** End of File *********************************/
@@ -0,0 +1,171 @@
+/**
+ *****************************************************************************
+ * @file    : user_mqtt_assembly.c
+ * @brief   : Reassembly of fragmented MQTT messages into message pool slots
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *
+ * @note Payloads larger than the esp-mqtt receive buffer arrive as several
+ *       events. Only the first one carries the topic, every event carries its
+ *       offset in the payload and the total payload length. The fragments are
+ *       copied in place into a single slot, which is queued once the last
+ *       fragment is received. No FreeRTOS dependencies, the lock is supplied
+ *       by the owner.
+ *****************************************************************************
+ */
+
+#include <string.h>
+
+#include "user_mqtt_assembly.h"
+
+/**
+ * @brief  Initialize the reassembly state of a producer.
+ *
+ * @param assembly[OUT] Reassembly state.
+ * @param pool[IN] Message pool the messages are queued to.
+ * @param lock[IN] Takes the lock of the pool.
+ * @param unlock[IN] Gives the lock of the pool back.
+ * @param ctx[IN] Passed to lock and unlock.
+ */
+void user_mqtt_assembly_init(user_mqtt_assembly_t *assembly, user_mqtt_pool_t *pool, void (*lock)(void *ctx),
+                             void (*unlock)(void *ctx), void *ctx)
+{
+    assembly->pool = pool;
+    assembly->lock = lock;
+    assembly->unlock = unlock;
+    assembly->ctx = ctx;
+    assembly->index = USER_MQTT_POOL_INDEX_NONE;
+}
+/**
+ * @brief  Drop the message being reassembled, its remaining fragments are ignored.
+ *
+ * @note Called when the connection is lost, the rest of the message will never arrive.
+ *
+ * @param assembly[IN] Reassembly state.
+ *
+ * @return - true   a message was dropped and counted as incomplete.
+ *         - false  no message was being reassembled.
+ */
+bool user_mqtt_assembly_abort(user_mqtt_assembly_t *assembly)
+{
+    if (assembly->index == USER_MQTT_POOL_INDEX_NONE)
+    {
+        return false;
+    }
+
+    assembly->lock(assembly->ctx);
+    user_mqtt_pool_release(assembly->pool, assembly->index);
+    assembly->pool->stats.incomplete++;
+    assembly->unlock(assembly->ctx);
+    assembly->index = USER_MQTT_POOL_INDEX_NONE;
+
+    return true;
+}
+/**
+ * @brief  Take a slot for the message a first fragment starts.
+ */
+static user_mqtt_assembly_result_t mqtt_assembly_start(user_mqtt_assembly_t *assembly,
+                                                       const user_mqtt_fragment_t *fragment)
+{
+    user_mqtt_msg_t *msg;
+    esp_err_t ret;
+
+    /* A new message starts, abandon the unfinished one. */
+    user_mqtt_assembly_abort(assembly);
+
+    /* Messages that do not fit a pool slot are dropped. */
+    if ((fragment->topic_len < 0) || (fragment->topic_len > (int)USER_MQTT_POOL_TOPIC_MAX_LENGTH) ||
+        (fragment->total_len < 0) || (fragment->total_len > (int)USER_MQTT_POOL_DATA_MAX_LENGTH))
+    {
+        assembly->lock(assembly->ctx);
+        assembly->pool->stats.oversized++;
+        assembly->unlock(assembly->ctx);
+        return USER_MQTT_ASSEMBLY_OVERSIZED;
+    }
+
+    assembly->lock(assembly->ctx);
+    ret = user_mqtt_pool_acquire(assembly->pool, fragment->topic, fragment->topic_len, fragment->data,
+                                 fragment->data_len, fragment->total_len, &assembly->index);
+    assembly->unlock(assembly->ctx);
+    if (ret != ESP_OK)
+    {
+        assembly->index = USER_MQTT_POOL_INDEX_NONE;
+        return USER_MQTT_ASSEMBLY_EXHAUSTED;
+    }
+
+    /* Merged into a queued message, the consumer will apply it. */
+    if (assembly->index == USER_MQTT_POOL_INDEX_NONE)
+    {
+        return USER_MQTT_ASSEMBLY_MERGED;
+    }
+
+    /* The slot is held by this producer, it is filled without the lock. */
+    msg = &assembly->pool->slots[assembly->index];
+    msg->topic_len = fragment->topic_len;
+    memcpy(msg->topic, fragment->topic, fragment->topic_len);
+    msg->data_len = fragment->total_len;
+
+    return USER_MQTT_ASSEMBLY_PENDING;
+}
+/**
+ * @brief  Copy a fragment into the slot of its message, and queue the message once complete.
+ *
+ * @param assembly[IN] Reassembly state.
+ * @param fragment[IN] Received fragment.
+ * @param seq[IN] Arrival order given to the message if this fragment completes it.
+ *
+ * @return Outcome of the fragment, see user_mqtt_assembly_result_t.
+ */
+user_mqtt_assembly_result_t user_mqtt_assembly_feed(user_mqtt_assembly_t *assembly,
+                                                    const user_mqtt_fragment_t *fragment, uint32_t seq)
+{
+    user_mqtt_assembly_result_t result;
+    user_mqtt_msg_t *msg;
+    esp_err_t ret;
+
+    if (fragment->offset == 0)
+    {
+        result = mqtt_assembly_start(assembly, fragment);
+        if (result != USER_MQTT_ASSEMBLY_PENDING)
+        {
+            return result;
+        }
+    }
+    else if (assembly->index == USER_MQTT_POOL_INDEX_NONE)
+    {
+        /* Remaining fragments of a dropped message. */
+        return USER_MQTT_ASSEMBLY_IGNORED;
+    }
+
+    msg = &assembly->pool->slots[assembly->index];
+
+    /* Fragments must stay inside the announced payload. */
+    if ((fragment->total_len != msg->data_len) || (fragment->offset < 0) || (fragment->data_len < 0) ||
+        (fragment->offset > msg->data_len - fragment->data_len))
+    {
+        user_mqtt_assembly_abort(assembly);
+        return USER_MQTT_ASSEMBLY_OUT_OF_RANGE;
+    }
+
+    memcpy(msg->data + fragment->offset, fragment->data, fragment->data_len);
+    if (fragment->offset + fragment->data_len != msg->data_len)
+    {
+        return USER_MQTT_ASSEMBLY_PENDING;
+    }
+
+    /* Send the slot index to the message queue once the payload is complete. */
+    assembly->lock(assembly->ctx);
+    ret = user_mqtt_pool_queue(assembly->pool, assembly->index, seq);
+    if (ret != ESP_OK)
+    {
+        /* Never expected, the queue is as deep as the pool. */
+        user_mqtt_pool_release(assembly->pool, assembly->index);
+        assembly->pool->stats.dropped_newest++;
+    }
+    assembly->unlock(assembly->ctx);
+    assembly->index = USER_MQTT_POOL_INDEX_NONE;
+
+    return (ret == ESP_OK) ? USER_MQTT_ASSEMBLY_QUEUED : USER_MQTT_ASSEMBLY_EXHAUSTED;
+}
+/******************************** End of File *********************************/
@@ -0,0 +1,88 @@
+/**
+ *****************************************************************************
+ * @file    : user_mqtt_latest.c
+ * @brief   : Newest value slots of last-writer-wins MQTT topics
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *
+ * @note No FreeRTOS dependencies and no heap. A new value overwrites the one
+ *       its topic still has pending, so a burst of slider updates costs one
+ *       handler call per topic. The owner serializes the calls.
+ *****************************************************************************
+ */
+
+#include <string.h>
+
+#include "user_mqtt_latest.h"
+
+/**
+ * @brief  Initialize the value slots, none is pending.
+ *
+ * @param latest[OUT] Value slots.
+ */
+void user_mqtt_latest_init(user_mqtt_latest_t *latest)
+{
+    memset(latest, 0, sizeof(*latest));
+}
+/**
+ * @brief  Store the newest value of a topic, over its pending value if any.
+ *
+ * @param latest[IN] Value slots.
+ * @param slot[IN] Slot of the topic, below USER_MQTT_LATEST_SLOTS.
+ * @param data[IN] Received MQTT data.
+ * @param data_len[IN] Received MQTT data length, at most USER_MQTT_LATEST_DATA_MAX_LENGTH.
+ * @param seq[IN] Sequence number of the value.
+ *
+ * @return - true   a pending value was overwritten before it was applied
+ *         - false  the slot had no pending value
+ */
+bool user_mqtt_latest_store(user_mqtt_latest_t *latest, uint32_t slot, const char *data, int data_len, uint32_t seq)
+{
+    uint32_t mask = (1UL << slot);
+    bool superseded = ((latest->dirty & mask) != 0);
+
+    memcpy(latest->values[slot].data, data, data_len);
+    latest->values[slot].data_len = data_len;
+    latest->values[slot].seq = seq;
+    latest->dirty |= mask;
+
+    return superseded;
+}
+/**
+ * @brief  Take the oldest pending value stored before a sequence number.
+ *
+ * @note Called in a loop, the values come out in arrival order. The value is
+ *       copied out, so the handler can run after the owner released its lock.
+ *
+ * @param latest[IN] Value slots.
+ * @param before[IN] Sequence number, later values are left pending.
+ * @param value[OUT] Copy of the value.
+ *
+ * @return - Slot of the value.
+ *         - -1 if no value stored before the sequence number is pending.
+ */
+int user_mqtt_latest_take(user_mqtt_latest_t *latest, uint32_t before, user_mqtt_latest_value_t *value)
+{
+    int slot = -1;
+
+    for (uint32_t dirty = latest->dirty; dirty != 0; dirty &= (dirty - 1))
+    {
+        int i = __builtin_ctz(dirty);
+
+        if (((int32_t)(latest->values[i].seq - before) < 0) &&
+            ((slot < 0) || ((int32_t)(latest->values[i].seq - latest->values[slot].seq) < 0)))
+        {
+            slot = i;
+        }
+    }
+
+    if (slot >= 0)
+    {
+        *value = latest->values[slot];
+        latest->dirty &= ~(1UL << slot);
+    }
+
+    return slot;
+}
+/******************************** End of File *********************************/
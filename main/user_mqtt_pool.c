@@ -0,0 +1,210 @@
+/**
+ *****************************************************************************
+ * @file    : user_mqtt_pool.c
+ * @brief   : Static MQTT message pool and message queue
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *
+ * @note No FreeRTOS dependencies and no heap, every message lives in a slot of
+ *       the pool. The owner serializes the calls, a producer and a consumer
+ *       may then fill and read the slots they hold without the lock.
+ *****************************************************************************
+ */
+
+#include <string.h>
+
+#include "user_mqtt_pool.h"
+
+_Static_assert(USER_MQTT_POOL_SIZE < USER_MQTT_POOL_INDEX_NONE, "Message pool slot indexes are uint8_t");
+
+/**
+ * @brief  Initialize a message pool, every slot starts free.
+ *
+ * @param pool[OUT] Message pool.
+ * @param policy[IN] Overflow policy.
+ */
+void user_mqtt_pool_init(user_mqtt_pool_t *pool, user_mqtt_overflow_policy_t policy)
+{
+    memset(pool, 0, sizeof(*pool));
+    for (uint32_t i = 0; i < USER_MQTT_POOL_SIZE; i++)
+    {
+        pool->free_slots[i] = (uint8_t)(USER_MQTT_POOL_SIZE - 1 - i);
+    }
+    pool->free_count = USER_MQTT_POOL_SIZE;
+    pool->policy = policy;
+}
+/**
+ * @brief  Take the oldest message out of the message queue.
+ */
+static bool mqtt_pool_dequeue(user_mqtt_pool_t *pool, uint8_t *index)
+{
+    if (pool->queue_count == 0)
+    {
+        return false;
+    }
+
+    *index = pool->queue[pool->queue_head];
+    pool->queue_head = (pool->queue_head + 1) % USER_MQTT_POOL_SIZE;
+    pool->queue_count--;
+    pool->slots[*index].queued = false;
+
+    return true;
+}
+/**
+ * @brief  Replace the payload of the newest queued message with the same topic.
+ *
+ * @note The replaced message keeps its place and sequence number, so the queue
+ *       stays in arrival order. Only a complete payload is written in one step,
+ *       fragmented payloads are never merged.
+ *
+ * @return - ESP_OK             succeed
+ *         - ESP_ERR_NOT_FOUND  no queued message has the same topic
+ */
+static esp_err_t mqtt_pool_coalesce(user_mqtt_pool_t *pool, const char *topic, int topic_len, const char *data,
+                                    int data_len, int total_data_len)
+{
+    user_mqtt_msg_t *found = NULL;
+
+    if (data_len != total_data_len)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    for (uint32_t i = 0; i < pool->queue_count; i++)
+    {
+        user_mqtt_msg_t *msg = &pool->slots[pool->queue[(pool->queue_head + i) % USER_MQTT_POOL_SIZE]];
+
+        if ((msg->topic_len == topic_len) && (memcmp(msg->topic, topic, topic_len) == 0))
+        {
+            /* The queue is in arrival order, the last match is the newest. */
+            found = msg;
+        }
+    }
+    if (found == NULL)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    memcpy(found->data, data, data_len);
+    found->data_len = data_len;
+
+    return ESP_OK;
+}
+/**
+ * @brief  Take a slot for an incoming message without blocking.
+ *
+ * @note When the pool is exhausted the overflow policy decides which message is lost.
+ *       The caller fills the slot, topic and payload, then queues it.
+ *
+ * @param pool[IN] Message pool.
+ * @param topic[IN] Topic of the incoming message.
+ * @param topic_len[IN] Topic length.
+ * @param data[IN] First part of the payload, only used to coalesce.
+ * @param data_len[IN] First part length.
+ * @param total_data_len[IN] Payload length.
+ * @param index[OUT] Slot index, USER_MQTT_POOL_INDEX_NONE when the payload replaced the one of a queued message.
+ *
+ * @return - ESP_OK          succeed
+ *         - ESP_ERR_NO_MEM  the incoming message is dropped
+ */
+esp_err_t user_mqtt_pool_acquire(user_mqtt_pool_t *pool, const char *topic, int topic_len, const char *data,
+                                 int data_len, int total_data_len, uint8_t *index)
+{
+    if (pool->free_count == 0)
+    {
+        pool->stats.overflow++;
+
+        switch (pool->policy)
+        {
+        case USER_MQTT_OVERFLOW_DROP_NEWEST:
+        {
+            pool->stats.dropped_newest++;
+            return ESP_ERR_NO_MEM;
+        }
+        case USER_MQTT_OVERFLOW_COALESCE:
+        {
+            if (mqtt_pool_coalesce(pool, topic, topic_len, data, data_len, total_data_len) == ESP_OK)
+            {
+                pool->stats.coalesced++;
+                pool->stats.received++;
+                *index = USER_MQTT_POOL_INDEX_NONE;
+                return ESP_OK;
+            }
+            /* No queued message of the same topic, fall back to drop the oldest one. */
+        }
+        /* fall through */
+        case USER_MQTT_OVERFLOW_DROP_OLDEST:
+        default:
+        {
+            if (mqtt_pool_dequeue(pool, index) == false)
+            {
+                pool->stats.dropped_newest++;
+                return ESP_ERR_NO_MEM;
+            }
+            pool->stats.dropped_oldest++;
+            pool->stats.received++;
+            return ESP_OK;
+        }
+        }
+    }
+
+    *index = pool->free_slots[--pool->free_count];
+    pool->stats.received++;
+
+    uint32_t in_use = USER_MQTT_POOL_SIZE - pool->free_count;
+    if (in_use > pool->stats.high_water_mark)
+    {
+        pool->stats.high_water_mark = in_use;
+    }
+
+    return ESP_OK;
+}
+/**
+ * @brief  Queue a filled slot behind the messages that arrived before it.
+ *
+ * @param pool[IN] Message pool.
+ * @param index[IN] Slot index, from user_mqtt_pool_acquire.
+ * @param seq[IN] Arrival order.
+ *
+ * @return - ESP_OK          succeed
+ *         - ESP_ERR_NO_MEM  never expected, the queue is as deep as the pool
+ */
+esp_err_t user_mqtt_pool_queue(user_mqtt_pool_t *pool, uint8_t index, uint32_t seq)
+{
+    if (pool->queue_count >= USER_MQTT_POOL_SIZE)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    pool->slots[index].seq = seq;
+    pool->slots[index].queued = true;
+    pool->queue[(pool->queue_head + pool->queue_count) % USER_MQTT_POOL_SIZE] = index;
+    pool->queue_count++;
+
+    return ESP_OK;
+}
+/**
+ * @brief  Take the oldest queued message, the slot is then held by the consumer until released.
+ *
+ * @param pool[IN] Message pool.
+ * @param index[OUT] Slot index.
+ *
+ * @return - true   a message was queued.
+ *         - false  the queue is empty.
+ */
+bool user_mqtt_pool_receive(user_mqtt_pool_t *pool, uint8_t *index)
+{
+    return mqtt_pool_dequeue(pool, index);
+}
+/**
+ * @brief  Return a slot to the message pool.
+ *
+ * @param pool[IN] Message pool.
+ * @param index[IN] Slot index, held by the caller.
+ */
+void user_mqtt_pool_release(user_mqtt_pool_t *pool, uint8_t index)
+{
+    pool->free_slots[pool->free_count++] = index;
+}
+/******************************** End of File *********************************/
@@ -0,0 +1,112 @@
+/**
+ *****************************************************************************
+ * @file    : user_mqtt_topic.c
+ * @brief   : MQTT subscribe topic dispatch table
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *
+ * @note Plain C without FreeRTOS or ESP-IDF dependencies, the table is owned by
+ *       the caller, so the lookup can be checked on the host. A lookup hashes
+ *       the received topic once and compares it with a single entry in the
+ *       common case, whatever the table size and order.
+ *****************************************************************************
+ */
+
+#include <stddef.h>
+#include <string.h>
+
+#include "user_mqtt_topic.h"
+
+_Static_assert((MQTT_TOPIC_INDEX_SIZE & (MQTT_TOPIC_INDEX_SIZE - 1)) == 0, "MQTT_TOPIC_INDEX_SIZE must be a power of two");
+_Static_assert(MQTT_TOPIC_INDEX_SIZE <= 256, "Topic index slots are uint8_t");
+
+/**
+ * @brief  Hash a topic from its length and three sampled characters.
+ *
+ * @note Every subscribe topic ends in "Command", so the samples are taken
+ *       from the front and the middle. Topics that hash alike are told apart
+ *       by the probe, only the cost of a lookup depends on the samples.
+ */
+static uint32_t mqtt_topic_hash(const char *topic, int topic_len)
+{
+    uint32_t hash = (uint32_t)topic_len * 2654435761U;
+
+    if (topic_len > 0)
+    {
+        hash ^= (uint32_t)(uint8_t)topic[0] * 40503U;
+        hash ^= (uint32_t)(uint8_t)topic[topic_len / 4] * 9973U;
+        hash ^= (uint32_t)(uint8_t)topic[topic_len / 2];
+        hash *= 2654435761U;
+    }
+
+    return hash >> 16;
+}
+/**
+ * @brief  Find the slot of a topic, or the free slot that ends its probe sequence.
+ */
+static uint32_t mqtt_topic_probe(const mqtt_topic_index_t *index, const char *topic, int topic_len)
+{
+    uint32_t slot = mqtt_topic_hash(topic, topic_len) & (MQTT_TOPIC_INDEX_SIZE - 1);
+
+    while (index->slots[slot] != 0)
+    {
+        const mqtt_topic_entry_t *entry = &index->table[index->slots[slot] - 1];
+
+        if ((entry->topic_len == topic_len) && (memcmp(entry->topic, topic, topic_len) == 0))
+        {
+            break;
+        }
+        slot = (slot + 1) & (MQTT_TOPIC_INDEX_SIZE - 1);
+    }
+
+    return slot;
+}
+/**
+ * @brief  Build the hash index of a dispatch table, the table may be in any order.
+ * 
+ * @note At most half of the slots are used, so the probe sequences stay short
+ *       and always end on a free slot.
+ * 
+ * @param index[OUT] Hash index.
+ * @param table[IN] Dispatch table, must outlive the index.
+ * @param count[IN] Number of table entries.
+ * 
+ * @return - -1 if every entry is indexed.
+ *         - Index of the first entry listed twice, or of the first one over half the slots.
+ */
+int mqtt_topic_index_build(mqtt_topic_index_t *index, const mqtt_topic_entry_t *table, int count)
+{
+    memset(index->slots, 0, sizeof(index->slots));
+    index->table = table;
+
+    for (int i = 0; i < count; i++)
+    {
+        uint32_t slot = mqtt_topic_probe(index, table[i].topic, table[i].topic_len);
+
+        if ((i >= (int)(MQTT_TOPIC_INDEX_SIZE / 2)) || (index->slots[slot] != 0))
+        {
+            return i;
+        }
+        index->slots[slot] = (uint8_t)(i + 1);
+    }
+
+    return -1;
+}
+/**
+ * @brief  Find the dispatch table entry of a received topic.
+ * 
+ * @param index[IN] Hash index of the dispatch table.
+ * @param topic[IN] Received MQTT topic, not null terminated.
+ * @param topic_len[IN] Received MQTT topic length.
+ * 
+ * @return - Dispatch table entry.
+ *         - NULL if the topic is not in the table.
+ */
+const mqtt_topic_entry_t *mqtt_topic_index_lookup(const mqtt_topic_index_t *index, const char *topic, int topic_len)
+{
+    uint32_t slot = mqtt_topic_probe(index, topic, topic_len);
+
+    return (index->slots[slot] != 0) ? &index->table[index->slots[slot] - 1] : NULL;
+}
+/******************************** End of File *********************************/
@@ -0,0 +1,224 @@
+/**
+ *****************************************************************************
+ * @file    : user_sampler_wheel.c
+ * @brief   : Hierarchical timer wheel of the sensor sampling scheduler
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *
+ * @note Plain C without FreeRTOS or ESP-IDF dependencies, the caller supplies
+ *       the clock, so the scheduler can run against a simulated clock.
+ *****************************************************************************
+ */
+
+#include <stddef.h>
+
+#include "user_sampler_wheel.h"
+
+/** @brief Empty slot list. */
+#define SAMPLER_WHEEL_NONE      (-1)
+
+/**
+ * @brief  Put a channel in the slot matching its expiry.
+ * 
+ * @note Level L holds the channels expiring within 64^(L+1) ms. Expiries beyond the
+ *       last level are clamped to it and cascaded again until they are in range.
+ * 
+ * @param wheel[IN] Timer wheel.
+ * @param id[IN] Channel index.
+ */
+static void sampler_wheel_insert(sampler_wheel_t *wheel, int id)
+{
+    sampler_wheel_channel_t *ch = &wheel->channels[id];
+    int32_t delta = (int32_t)(ch->expiry - wheel->now);
+    uint32_t expiry = ch->expiry;
+    uint32_t level = 0;
+
+    if (delta <= 0)
+    {
+        /* Due now, the cascade runs before the current level 0 slot is expired. */
+        expiry = wheel->now;
+    }
+    else
+    {
+        while ((level < (SAMPLER_WHEEL_LEVELS - 1)) && ((uint32_t)delta >= (1UL << ((level + 1) * SAMPLER_WHEEL_BITS))))
+        {
+            level++;
+        }
+
+        if ((uint32_t)delta >= (1UL << ((level + 1) * SAMPLER_WHEEL_BITS)))
+        {
+            expiry = wheel->now + (1UL << ((level + 1) * SAMPLER_WHEEL_BITS)) - 1;
+        }
+    }
+
+    uint32_t index = (expiry >> (level * SAMPLER_WHEEL_BITS)) & SAMPLER_WHEEL_MASK;
+    ch->next = wheel->slots[level][index];
+    wheel->slots[level][index] = id;
+}
+/**
+ * @brief  Move the channels of an upper level slot down to the levels below.
+ */
+static void sampler_wheel_cascade(sampler_wheel_t *wheel, uint32_t level)
+{
+    uint32_t index = (wheel->now >> (level * SAMPLER_WHEEL_BITS)) & SAMPLER_WHEEL_MASK;
+    int id = wheel->slots[level][index];
+
+    wheel->slots[level][index] = SAMPLER_WHEEL_NONE;
+    while (id != SAMPLER_WHEEL_NONE)
+    {
+        int next = wheel->channels[id].next;
+        sampler_wheel_insert(wheel, id);
+        id = next;
+    }
+}
+/**
+ * @brief  Run a due channel and schedule its next run, keeping its phase.
+ */
+static void sampler_wheel_run(sampler_wheel_t *wheel, int id, uint32_t now_ms)
+{
+    sampler_wheel_channel_t *ch = &wheel->channels[id];
+    uint32_t jitter = now_ms - ch->expiry;
+
+    ch->stats.runs++;
+    ch->stats.last_jitter_ms = jitter;
+    ch->stats.total_jitter_ms += jitter;
+    if (jitter > ch->stats.max_jitter_ms)
+    {
+        ch->stats.max_jitter_ms = jitter;
+    }
+
+    ch->callback(ch->arg);
+
+    ch->expiry += ch->period;
+    if ((int32_t)(ch->expiry - now_ms) <= 0)
+    {
+        /* Whole periods were missed, skip them rather than bursting. */
+        uint32_t missed = (now_ms - ch->expiry) / ch->period + 1;
+        ch->stats.overruns += missed;
+        ch->expiry += missed * ch->period;
+    }
+
+    sampler_wheel_insert(wheel, id);
+}
+/**
+ * @brief  Initialize a timer wheel.
+ * 
+ * @param wheel[OUT] Timer wheel.
+ * @param now_ms[IN] Current time in ms.
+ */
+void sampler_wheel_init(sampler_wheel_t *wheel, uint32_t now_ms)
+{
+    wheel->now = now_ms;
+    wheel->channel_count = 0;
+
+    for (uint32_t level = 0; level < SAMPLER_WHEEL_LEVELS; level++)
+    {
+        for (uint32_t index = 0; index < SAMPLER_WHEEL_SLOTS; index++)
+        {
+            wheel->slots[level][index] = SAMPLER_WHEEL_NONE;
+        }
+    }
+}
+/**
+ * @brief  Register a sampling channel.
+ * 
+ * @note The first run happens phase_ms after the registration, then every period_ms.
+ *       Give channels on the same bus different phases to stagger the transactions.
+ * 
+ * @param wheel[IN] Timer wheel.
+ * @param period_ms[IN] Sampling period in ms, not 0.
+ * @param phase_ms[IN] Offset of the first run in ms.
+ * @param callback[IN] Sampling callback.
+ * @param arg[IN] Sampling callback argument.
+ * 
+ * @return Channel index, -1 if the arguments are invalid or every channel is used.
+ */
+int sampler_wheel_add(sampler_wheel_t *wheel, uint32_t period_ms, uint32_t phase_ms,
+                      sampler_wheel_callback_t callback, void *arg)
+{
+    if ((period_ms == 0) || (callback == NULL) || (wheel->channel_count >= SAMPLER_WHEEL_MAX_CHANNELS))
+    {
+        return -1;
+    }
+
+    int id = wheel->channel_count++;
+    sampler_wheel_channel_t *ch = &wheel->channels[id];
+
+    ch->callback = callback;
+    ch->arg = arg;
+    ch->period = period_ms;
+    ch->expiry = wheel->now + ((phase_ms == 0) ? 1 : phase_ms);
+    ch->stats = (sampler_wheel_stats_t){ 0 };
+    sampler_wheel_insert(wheel, id);
+
+    return id;
+}
+/**
+ * @brief  Advance the wheel to the current time and run every channel that became due.
+ * 
+ * @note Each elapsed ms is processed in turn, so a late call catches up in order.
+ *       The cost per ms is one slot lookup, cascades happen once every 64 ms.
+ * 
+ * @param wheel[IN] Timer wheel.
+ * @param now_ms[IN] Current time in ms, wraps around like a FreeRTOS tick count.
+ */
+void sampler_wheel_advance(sampler_wheel_t *wheel, uint32_t now_ms)
+{
+    while ((int32_t)(now_ms - wheel->now) > 0)
+    {
+        wheel->now++;
+
+        /* Cascade every upper level whose lower bits just wrapped, highest first. */
+        uint32_t level = 1;
+        while ((level < SAMPLER_WHEEL_LEVELS) && ((wheel->now & ((1UL << (level * SAMPLER_WHEEL_BITS)) - 1)) == 0))
+        {
+            level++;
+        }
+        while (--level > 0)
+        {
+            sampler_wheel_cascade(wheel, level);
+        }
+
+        uint32_t index = wheel->now & SAMPLER_WHEEL_MASK;
+        int id = wheel->slots[0][index];
+
+        wheel->slots[0][index] = SAMPLER_WHEEL_NONE;
+        while (id != SAMPLER_WHEEL_NONE)
+        {
+            int next = wheel->channels[id].next;
+
+            if ((int32_t)(wheel->channels[id].expiry - wheel->now) > 0)
+            {
+                sampler_wheel_insert(wheel, id);
+            }
+            else
+            {
+                sampler_wheel_run(wheel, id, now_ms);
+            }
+            id = next;
+        }
+    }
+}
+/**
+ * @brief  Get the statistics of a sampling channel.
+ * 
+ * @param wheel[IN] Timer wheel.
+ * @param channel[IN] Channel index.
+ * @param stats[OUT] Channel statistics.
+ * 
+ * @return - true   succeed.
+ *         - false  unknown channel.
+ */
+bool sampler_wheel_get_stats(const sampler_wheel_t *wheel, int channel, sampler_wheel_stats_t *stats)
+{
+    if ((channel < 0) || (channel >= wheel->channel_count) || (stats == NULL))
+    {
+        return false;
+    }
+
+    *stats = wheel->channels[channel].stats;
+
+    return true;
+}
+/******************************** End of File *********************************/
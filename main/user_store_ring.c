@@ -0,0 +1,323 @@
+/**
+ *****************************************************************************
+ * @file    : user_store_ring.c
+ * @brief   : Flash record ring of the telemetry store
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *
+ * @note No FreeRTOS or driver dependencies, the flash access is supplied by
+ *       the owner, so a host build can run the ring on an emulated partition.
+ *       The owner serializes the calls that change the ring.
+ *****************************************************************************
+ */
+
+#include <string.h>
+
+#include "user_store_ring.h"
+
+/** @brief Record states, NOR flash bits only go from 1 to 0 without an erase. */
+#define STORE_STATE_ERASED              (0xFFU)
+#define STORE_STATE_VALID               (0xFEU)
+#define STORE_STATE_CONSUMED            (0xFCU)
+
+/** @brief Flash record. */
+typedef struct
+{
+    uint8_t state;      /* STORE_STATE_*, not covered by the CRC. */
+    uint8_t channel;    /* Telemetry channel. */
+    uint16_t crc;       /* CRC16 of the channel and the fields below. */
+    uint32_t sequence;  /* Monotonic sequence number. */
+    uint32_t timestamp; /* Seconds, from time(). */
+    int32_t value;      /* Fixed-point value. */
+} store_record_t;
+
+_Static_assert(sizeof(store_record_t) == USER_STORE_RECORD_SIZE, "Flash record layout");
+
+/**
+ * @brief  Calculate the CRC-16 of the records, same as esp_rom_crc16_le.
+ *
+ * @param crc[IN] CRC of the previous bytes, 0 to start.
+ * @param data[IN] Bytes.
+ * @param length[IN] Number of bytes.
+ *
+ * @return CRC-16/X-25, polynomial 0x1021 reflected, the register is inverted in and out.
+ */
+uint16_t user_store_crc16(uint16_t crc, const uint8_t *data, size_t length)
+{
+    crc = (uint16_t)~crc;
+    for (size_t i = 0; i < length; i++)
+    {
+        crc ^= data[i];
+        for (uint8_t j = 0; j < 8; j++)
+        {
+            crc = (crc & 1U) ? (uint16_t)((crc >> 1) ^ 0x8408U) : (uint16_t)(crc >> 1);
+        }
+    }
+
+    return (uint16_t)~crc;
+}
+/**
+ * @brief  Compute the CRC of a record.
+ */
+static uint16_t store_record_crc(const store_record_t *record)
+{
+    uint16_t crc = user_store_crc16(0, &record->channel, sizeof(record->channel));
+
+    return user_store_crc16(crc, (const uint8_t *)&record->sequence,
+                            sizeof(store_record_t) - offsetof(store_record_t, sequence));
+}
+/**
+ * @brief  Check that a record read from flash is intact.
+ */
+static bool store_record_valid(const user_store_ring_t *ring, const store_record_t *record)
+{
+    if ((record->state != STORE_STATE_VALID) && (record->state != STORE_STATE_CONSUMED))
+    {
+        return false;
+    }
+
+    return (record->crc == store_record_crc(record)) && (record->channel < ring->channel_max);
+}
+/**
+ * @brief  Rebuild the ring pointers from the records found in flash.
+ *
+ * @return - ESP_OK  succeed
+ *         - other   flash read failed
+ */
+static esp_err_t store_recover(user_store_ring_t *ring)
+{
+    store_record_t records[USER_STORE_RECOVER_CHUNK];
+    uint32_t max_sequence = 0;
+    uint32_t min_sequence = UINT32_MAX;
+    uint32_t next_unconsumed = 0;
+    bool found = false;
+
+    for (uint32_t slot = 0; slot < ring->capacity; slot += USER_STORE_RECOVER_CHUNK)
+    {
+        uint32_t chunk = ring->capacity - slot;
+        chunk = (chunk < USER_STORE_RECOVER_CHUNK) ? chunk : USER_STORE_RECOVER_CHUNK;
+
+        esp_err_t ret = ring->flash.read(ring->flash.ctx, slot * sizeof(store_record_t), records, chunk * sizeof(store_record_t));
+        if (ret != ESP_OK)
+        {
+            return ret;
+        }
+
+        for (uint32_t i = 0; i < chunk; i++)
+        {
+            if (store_record_valid(ring, &records[i]) == false)
+            {
+                continue;
+            }
+
+            uint32_t sequence = records[i].sequence;
+            if ((found == false) || (sequence > max_sequence))
+            {
+                max_sequence = sequence;
+            }
+            if (sequence < min_sequence)
+            {
+                min_sequence = sequence;
+            }
+            if ((records[i].state == STORE_STATE_CONSUMED) && (sequence + 1 > next_unconsumed))
+            {
+                /* A consumed mark covers every older record. */
+                next_unconsumed = sequence + 1;
+            }
+            found = true;
+        }
+    }
+
+    ring->head = 0;
+    ring->tail = 0;
+    if (found)
+    {
+        ring->head = max_sequence + 1;
+        ring->tail = (next_unconsumed > min_sequence) ? next_unconsumed : min_sequence;
+    }
+
+    /* A write torn by a power loss leaves programmed bits behind the head, a new
+     * record can not be written over them. Skip such slots up to the next sector,
+     * which is erased before use anyway. */
+    while ((ring->head % ring->records_per_sector) != 0)
+    {
+        static const uint8_t blank[sizeof(store_record_t)] = {
+            0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+        };
+
+        esp_err_t ret = ring->flash.read(ring->flash.ctx, (ring->head % ring->capacity) * sizeof(store_record_t), records, sizeof(records[0]));
+        if (ret != ESP_OK)
+        {
+            return ret;
+        }
+        if (memcmp(&records[0], blank, sizeof(blank)) == 0)
+        {
+            break;
+        }
+        ring->head++;
+    }
+
+    return ESP_OK;
+}
+/**
+ * @brief  Initialize a ring on a partition and recover the records it holds.
+ *
+ * @param ring[OUT] Record ring.
+ * @param flash[IN] Flash access.
+ * @param size[IN] Partition size, whole sectors are used.
+ * @param sector_size[IN] Erase unit, a multiple of USER_STORE_RECORD_SIZE.
+ * @param channel_max[IN] Number of channels, records of other channels are not valid.
+ *
+ * @return - ESP_OK              succeed
+ *         - ESP_ERR_INVALID_ARG less than two sectors or a bad sector size
+ *         - other               flash read failed
+ */
+esp_err_t user_store_ring_init(user_store_ring_t *ring, const user_store_flash_t *flash, uint32_t size,
+                               uint32_t sector_size, uint8_t channel_max)
+{
+    if ((sector_size < USER_STORE_RECORD_SIZE) || ((sector_size % USER_STORE_RECORD_SIZE) != 0) || (size / sector_size < 2))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(ring, 0, sizeof(*ring));
+    ring->flash = *flash;
+    ring->sector_size = sector_size;
+    ring->records_per_sector = sector_size / USER_STORE_RECORD_SIZE;
+    ring->capacity = (size / sector_size) * ring->records_per_sector;
+    ring->channel_max = channel_max;
+
+    return store_recover(ring);
+}
+/**
+ * @brief  Append a record, the oldest sector is erased when the ring is full.
+ *
+ * @param ring[IN] Record ring.
+ * @param channel[IN] Telemetry channel.
+ * @param timestamp[IN] Seconds, from time().
+ * @param value[IN] Fixed-point value.
+ *
+ * @return - ESP_OK              succeed
+ *         - ESP_ERR_INVALID_ARG unknown channel
+ *         - other               flash error, the record and its slot are lost
+ */
+esp_err_t user_store_ring_append(user_store_ring_t *ring, uint8_t channel, uint32_t timestamp, int32_t value)
+{
+    store_record_t record;
+
+    if (channel >= ring->channel_max)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint32_t slot = ring->head % ring->capacity;
+    if ((slot % ring->records_per_sector) == 0)
+    {
+        /* Entering a sector, erase it. Sectors are used in turn, so wear is levelled over the partition. */
+        esp_err_t ret = ring->flash.erase(ring->flash.ctx, slot * sizeof(store_record_t), ring->sector_size);
+        if (ret != ESP_OK)
+        {
+            return ret;
+        }
+        ring->stats.erases++;
+
+        /* The erased sector held the oldest records. */
+        if (ring->head >= ring->capacity)
+        {
+            uint32_t oldest = ring->head - ring->capacity + ring->records_per_sector;
+            if ((int32_t)(oldest - ring->tail) > 0)
+            {
+                ring->stats.overwritten += oldest - ring->tail;
+                ring->tail = oldest;
+            }
+        }
+    }
+
+    record.state = STORE_STATE_VALID;
+    record.channel = channel;
+    record.sequence = ring->head;
+    record.timestamp = timestamp;
+    record.value = value;
+    record.crc = store_record_crc(&record);
+
+    /* A failed write may have programmed part of the slot, it is never written again. */
+    esp_err_t ret = ring->flash.write(ring->flash.ctx, slot * sizeof(store_record_t), &record, sizeof(record));
+    ring->head++;
+    if (ret == ESP_OK)
+    {
+        ring->stats.appended++;
+    }
+
+    return ret;
+}
+/**
+ * @brief  Read the intact records of a range of sequence numbers.
+ *
+ * @note Only reads the flash, so it may run without the lock of the owner
+ *       while the range stays pending. Torn and overwritten records are skipped.
+ *
+ * @param ring[IN] Record ring.
+ * @param start[IN] First sequence number, usually the tail.
+ * @param count[IN] Number of sequence numbers.
+ * @param entries[OUT] Intact records, in sequence order, count entries at most.
+ *
+ * @return Number of entries.
+ */
+int user_store_ring_read(const user_store_ring_t *ring, uint32_t start, uint32_t count, user_store_entry_t *entries)
+{
+    store_record_t record;
+    int valid = 0;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t slot = (start + i) % ring->capacity;
+
+        if ((ring->flash.read(ring->flash.ctx, slot * sizeof(store_record_t), &record, sizeof(record)) != ESP_OK) ||
+            (store_record_valid(ring, &record) == false) || (record.sequence != start + i))
+        {
+            continue;
+        }
+
+        entries[valid].sequence = record.sequence;
+        entries[valid].timestamp = record.timestamp;
+        entries[valid].channel = record.channel;
+        entries[valid].value = record.value;
+        valid++;
+    }
+
+    return valid;
+}
+/**
+ * @brief  Release the records [start, start + count) once they are forwarded.
+ *
+ * @note The last record of the range is marked consumed, the mark releases the
+ *       whole range after a reboot. When the mark can not be written the range
+ *       is still released now, and forwarded again after a reboot.
+ *
+ * @param ring[IN] Record ring.
+ * @param start[IN] First sequence number, read before the tail could move.
+ * @param count[IN] Number of sequence numbers.
+ *
+ * @return - ESP_OK              succeed, or the ring wrapped past the range meanwhile
+ *         - other               the consumed mark could not be written
+ */
+esp_err_t user_store_ring_release(user_store_ring_t *ring, uint32_t start, uint32_t count)
+{
+    if ((count == 0) || (ring->tail != start))
+    {
+        return ESP_OK;
+    }
+
+    uint8_t state = STORE_STATE_CONSUMED;
+    uint32_t slot = (start + count - 1) % ring->capacity;
+    esp_err_t ret = ring->flash.write(ring->flash.ctx, slot * sizeof(store_record_t), &state, sizeof(state));
+    if (ret != ESP_OK)
+    {
+        ring->stats.mark_failures++;
+    }
+    ring->tail = start + count;
+
+    return ret;
+}
+/******************************** End of File *********************************/
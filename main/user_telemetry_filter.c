@@ -0,0 +1,104 @@
+/**
+ *****************************************************************************
+ * @file    : user_telemetry_filter.c
+ * @brief   : Telemetry report-by-exception filter
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *
+ * @note Plain C without FreeRTOS or ESP-IDF dependencies, time is passed in
+ *       by the caller, so recorded sensor traces can be replayed on the host.
+ *       Integer arithmetic only.
+ *****************************************************************************
+ */
+
+#include "user_telemetry_filter.h"
+
+/**
+ * @brief  Absolute difference of two values, without overflow.
+ */
+static inline int64_t telemetry_filter_distance(int32_t a, int32_t b)
+{
+    int64_t delta = (int64_t)a - b;
+
+    return (delta < 0) ? -delta : delta;
+}
+/**
+ * @brief  Check a filter configuration.
+ *
+ * @param filter[IN] Filter configuration.
+ *
+ * @return false if a threshold is negative or the heartbeat is shorter than the minimum interval.
+ */
+bool user_telemetry_filter_valid(const user_telemetry_filter_t *filter)
+{
+    return (filter->deadband >= 0) && (filter->rate_per_min >= 0) && (filter->max_silence_ms >= filter->min_interval_ms);
+}
+/**
+ * @brief  Decide whether a channel value is worth reporting, the state is not changed.
+ *
+ * @note A value is reported when it is the first one, when the heartbeat expired,
+ *       when it changed since the previous window at least at rate_per_min, or
+ *       when it moved by at least the dead-band and the minimum interval elapsed
+ *       since the last report.
+ *
+ * @param filter[IN] Filter configuration.
+ * @param state[IN] Channel state.
+ * @param value[IN] Window value.
+ * @param now_ms[IN] Millisecond clock, wraps around.
+ *
+ * @return - true   report the value.
+ *         - false  suppress the value.
+ */
+bool user_telemetry_filter_check(const user_telemetry_filter_t *filter, const user_telemetry_filter_state_t *state,
+                                 int32_t value, uint32_t now_ms)
+{
+    uint32_t elapsed = now_ms - state->last_ms;
+
+    if ((state->reported == false) || (elapsed >= filter->max_silence_ms))
+    {
+        return true;
+    }
+
+    if ((filter->rate_per_min > 0) && state->sampled)
+    {
+        /* |change| / window >= rate / 60 s, cross-multiplied. */
+        uint32_t window = now_ms - state->prev_ms;
+        if ((window > 0) && (telemetry_filter_distance(value, state->prev_value) * 60000 >= (int64_t)filter->rate_per_min * window))
+        {
+            return true;
+        }
+    }
+
+    if (elapsed < filter->min_interval_ms)
+    {
+        return false;
+    }
+
+    return telemetry_filter_distance(value, state->last_value) >= filter->deadband;
+}
+/**
+ * @brief  Record a window value once its fate is known.
+ *
+ * @note Call it with reported set only after the value was handed over, a value
+ *       lost on the way is not taken as reported and is checked again next window.
+ *
+ * @param state[IN] Channel state.
+ * @param value[IN] Window value.
+ * @param now_ms[IN] Millisecond clock, wraps around.
+ * @param reported[IN] When set, means the value was handed over.
+ */
+void user_telemetry_filter_update(user_telemetry_filter_state_t *state, int32_t value, uint32_t now_ms, bool reported)
+{
+    state->prev_value = value;
+    state->prev_ms = now_ms;
+    state->sampled = true;
+
+    if (reported)
+    {
+        state->last_value = value;
+        state->last_ms = now_ms;
+        state->reported = true;
+    }
+}
+/******************************** End of File *********************************/
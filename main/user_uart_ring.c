@@ -0,0 +1,142 @@
+/**
+ *****************************************************************************
+ * @file    : user_uart_ring.c
+ * @brief   : Single producer single consumer byte ring of the UART stream ports
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *
+ * @note Lock-free: the producer publishes head with a release store after the
+ *       bytes are written, the consumer publishes tail the same way after the
+ *       bytes are copied out. No FreeRTOS or driver dependencies, the producer
+ *       supplies the bytes through a fill callback.
+ *****************************************************************************
+ */
+
+#include <string.h>
+
+#include "user_uart_ring.h"
+
+/**
+ * @brief  Initialize an empty ring.
+ *
+ * @param ring[OUT] Byte ring.
+ * @param buffer[IN] Storage of the bytes.
+ * @param size[IN] Buffer length, a power of two.
+ *
+ * @return - ESP_OK               succeed
+ *         - ESP_ERR_INVALID_ARG  size is not a power of two
+ */
+esp_err_t user_uart_ring_init(user_uart_ring_t *ring, uint8_t *buffer, uint32_t size)
+{
+    if ((size == 0) || ((size & (size - 1)) != 0))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    ring->head = 0;
+    ring->tail = 0;
+    ring->size = size;
+    ring->buffer = buffer;
+
+    return ESP_OK;
+}
+/**
+ * @brief  Store received bytes, producer side.
+ *
+ * @note The fill callback writes straight into the free space of the ring, one
+ *       or two segments. Bytes beyond the free space are not requested, the
+ *       caller has to drop them.
+ *
+ * @param ring[IN] Byte ring.
+ * @param size[IN] Number of bytes the producer has.
+ * @param fill[IN] Writes the bytes.
+ * @param ctx[IN] Passed to fill.
+ * @param overflow[OUT] Number of bytes that did not fit.
+ *
+ * @return Number of bytes stored, less than size - overflow when fill ran short.
+ */
+size_t user_uart_ring_write(user_uart_ring_t *ring, size_t size, user_uart_ring_fill_t fill, void *ctx,
+                            size_t *overflow)
+{
+    uint32_t head = ring->head;
+    uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    size_t space = ring->size - (head - tail);
+    size_t length = (size < space) ? size : space;
+    size_t stored = 0;
+
+    while (stored < length)
+    {
+        uint32_t offset = (head + stored) & (ring->size - 1);
+        size_t segment = ring->size - offset;
+        if (segment > length - stored)
+        {
+            segment = length - stored;
+        }
+
+        int read = fill(ctx, &ring->buffer[offset], segment);
+        if (read <= 0)
+        {
+            break;
+        }
+        stored += ((size_t)read < segment) ? (size_t)read : segment;
+    }
+
+    __atomic_store_n(&ring->head, head + (uint32_t)stored, __ATOMIC_RELEASE);
+    *overflow = size - length;
+
+    return stored;
+}
+/**
+ * @brief  Number of bytes the consumer can read.
+ *
+ * @param ring[IN] Byte ring.
+ *
+ * @return Stored bytes.
+ */
+size_t user_uart_ring_available(const user_uart_ring_t *ring)
+{
+    return __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) - ring->tail;
+}
+/**
+ * @brief  Copy stored bytes out of the ring, consumer side.
+ *
+ * @param ring[IN] Byte ring.
+ * @param buf[OUT] Buffer of the bytes read.
+ * @param len[IN] Buffer length.
+ *
+ * @return Number of bytes read, 0 when the ring is empty.
+ */
+size_t user_uart_ring_read(user_uart_ring_t *ring, uint8_t *buf, size_t len)
+{
+    uint32_t tail = ring->tail;
+    size_t available = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) - tail;
+    size_t length = (len < available) ? len : available;
+
+    for (size_t copied = 0; copied < length;)
+    {
+        uint32_t offset = (tail + copied) & (ring->size - 1);
+        size_t segment = ring->size - offset;
+        if (segment > length - copied)
+        {
+            segment = length - copied;
+        }
+
+        memcpy(&buf[copied], &ring->buffer[offset], segment);
+        copied += segment;
+    }
+
+    __atomic_store_n(&ring->tail, tail + (uint32_t)length, __ATOMIC_RELEASE);
+
+    return length;
+}
+/**
+ * @brief  Drop every stored byte, consumer side.
+ *
+ * @param ring[IN] Byte ring.
+ */
+void user_uart_ring_clear(user_uart_ring_t *ring)
+{
+    __atomic_store_n(&ring->tail, __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE), __ATOMIC_RELEASE);
+}
+/******************************** End of File *********************************/
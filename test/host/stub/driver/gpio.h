@@ -0,0 +1,33 @@
+/**
+ *****************************************************************************
+ * @file    : gpio.h
+ * @brief   : ESP-IDF GPIO driver types of the host test build
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *
+ * @note Only the pins named by the drivers built on the host.
+ *****************************************************************************
+ */
+
+#ifndef DRIVER_GPIO_H
+#define DRIVER_GPIO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum
+{
+    GPIO_NUM_NC = -1,
+    GPIO_NUM_18 = 18,
+    GPIO_NUM_19 = 19,
+    GPIO_NUM_32 = 32,
+} gpio_num_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DRIVER_GPIO_H */
+/******************************** End of File *********************************/
@@ -0,0 +1,82 @@
+/**
+ *****************************************************************************
+ * @file    : spi_master.h
+ * @brief   : ESP-IDF SPI master driver interface of the host test build
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *
+ * @note The fields and values used by the drivers built on the host, with the
+ *       ESP-IDF layout. The functions are implemented by the test, as a model
+ *       of the device on the bus.
+ *****************************************************************************
+ */
+
+#ifndef DRIVER_SPI_MASTER_H
+#define DRIVER_SPI_MASTER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum
+{
+    SPI1_HOST = 0,
+    SPI2_HOST = 1,
+    SPI3_HOST = 2,
+} spi_host_device_t;
+
+#define SPI_DMA_CH_AUTO         (3)
+#define SPI_TRANS_USE_TXDATA    (1U << 3)
+
+typedef struct
+{
+    int mosi_io_num;
+    int miso_io_num;
+    int sclk_io_num;
+    int quadwp_io_num;
+    int quadhd_io_num;
+    int max_transfer_sz;
+} spi_bus_config_t;
+
+typedef struct
+{
+    uint8_t mode;
+    uint8_t cs_ena_posttrans;
+    int clock_speed_hz;
+    int spics_io_num;
+    int queue_size;
+} spi_device_interface_config_t;
+
+typedef struct
+{
+    uint32_t flags;
+    size_t length; /* Bits. */
+    union
+    {
+        const void *tx_buffer;
+        uint8_t tx_data[4];
+    };
+} spi_transaction_t;
+
+typedef struct spi_device_t *spi_device_handle_t;
+
+esp_err_t spi_bus_initialize(spi_host_device_t host, const spi_bus_config_t *bus_config, int dma_chan);
+esp_err_t spi_bus_free(spi_host_device_t host);
+esp_err_t spi_bus_add_device(spi_host_device_t host, const spi_device_interface_config_t *dev_config,
+                             spi_device_handle_t *handle);
+esp_err_t spi_bus_remove_device(spi_device_handle_t handle);
+esp_err_t spi_device_transmit(spi_device_handle_t handle, spi_transaction_t *trans);
+esp_err_t spi_device_polling_transmit(spi_device_handle_t handle, spi_transaction_t *trans);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DRIVER_SPI_MASTER_H */
+/******************************** End of File *********************************/
@@ -0,0 +1,54 @@
+/**
+ *****************************************************************************
+ * @file    : esp_err.h
+ * @brief   : ESP-IDF error codes of the host test build
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *
+ * @note Only the codes used by the plain C modules, with the ESP-IDF values.
+ *       esp_err_to_name gives the value, for the log lines of the drivers.
+ *****************************************************************************
+ */
+
+#ifndef ESP_ERR_H
+#define ESP_ERR_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int esp_err_t;
+
+#define ESP_OK                      0
+#define ESP_FAIL                    -1
+
+#define ESP_ERR_NO_MEM              0x101
+#define ESP_ERR_INVALID_ARG         0x102
+#define ESP_ERR_INVALID_STATE       0x103
+#define ESP_ERR_INVALID_SIZE        0x104
+#define ESP_ERR_NOT_FOUND           0x105
+#define ESP_ERR_NOT_SUPPORTED       0x106
+#define ESP_ERR_TIMEOUT             0x107
+#define ESP_ERR_INVALID_RESPONSE    0x108
+#define ESP_ERR_INVALID_CRC         0x109
+#define ESP_ERR_INVALID_VERSION     0x10A
+
+static inline const char *esp_err_to_name(esp_err_t code)
+{
+    static char name[16];
+
+    snprintf(name, sizeof(name), "0x%x", (unsigned int)code);
+
+    return name;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ESP_ERR_H */
+/******************************** End of File *********************************/
@@ -0,0 +1,33 @@
+/**
+ *****************************************************************************
+ * @file    : esp_heap_caps.h
+ * @brief   : ESP-IDF capability heap of the host test build
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *
+ * @note Implemented by the test, so it can check the capabilities asked for.
+ *****************************************************************************
+ */
+
+#ifndef ESP_HEAP_CAPS_H
+#define ESP_HEAP_CAPS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MALLOC_CAP_DMA          (1U << 3)
+
+void *heap_caps_malloc(size_t size, uint32_t caps);
+void heap_caps_free(void *ptr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ESP_HEAP_CAPS_H */
+/******************************** End of File *********************************/
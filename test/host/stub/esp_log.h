@@ -0,0 +1,32 @@
+/**
+ *****************************************************************************
+ * @file    : esp_log.h
+ * @brief   : ESP-IDF logging of the host test build
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *
+ * @note Errors and warnings go to stderr, the other levels are dropped.
+ *****************************************************************************
+ */
+
+#ifndef ESP_LOG_H
+#define ESP_LOG_H
+
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ESP_LOGE(tag, format, ...)  fprintf(stderr, "E %s: " format "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...)  fprintf(stderr, "W %s: " format "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...)  do { (void)(tag); } while (0)
+#define ESP_LOGD(tag, format, ...)  do { (void)(tag); } while (0)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ESP_LOG_H */
+/******************************** End of File *********************************/
@@ -0,0 +1,29 @@
+/**
+ *****************************************************************************
+ * @file    : esp_timer.h
+ * @brief   : ESP-IDF high resolution timer of the host test build
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *
+ * @note Implemented by the test, so the time follows its model.
+ *****************************************************************************
+ */
+
+#ifndef ESP_TIMER_H
+#define ESP_TIMER_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int64_t esp_timer_get_time(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ESP_TIMER_H */
+/******************************** End of File *********************************/
@@ -0,0 +1,345 @@
+/**
+ *****************************************************************************
+ * @file    : test_74hc595.c
+ * @brief   : Host tests of the 74hc595 chain driver against a shift register model
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *
+ * @note The SPI master functions are a model of the bus: every transaction is
+ *       clocked bit by bit, MSB first, into a chain of 74HC595 shift registers,
+ *       SER to QA, QH' to the SER of the next device. The rising RCK edge at the
+ *       end of the transaction copies the shift registers to the outputs.
+ *****************************************************************************
+ */
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_host.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "74hc595.h"
+
+/** @brief Longest chain of the model. */
+#define TEST_CHAIN_MAX          (16U)
+
+/** @brief Random images sent per chain length. */
+#define TEST_IMAGES             (1000U)
+
+/** @brief SPI device of the model. */
+struct spi_device_t
+{
+    spi_device_interface_config_t config;
+};
+
+/** @brief Bus, chain and heap of the model. */
+typedef struct
+{
+    struct spi_device_t device;
+    bool bus_used;
+    bool device_used;
+    spi_bus_config_t bus_config;
+    int dma_chan;
+    esp_err_t bus_init_result;          /* Returned by the next spi_bus_initialize. */
+    esp_err_t add_device_result;        /* Returned by the next spi_bus_add_device. */
+    esp_err_t transmit_result;          /* Returned by the next transmissions. */
+    size_t chain_length;                /* Devices on the bus. */
+    uint8_t shift[TEST_CHAIN_MAX];      /* Shift registers, [0] is wired to the ESP32. */
+    uint8_t outputs[TEST_CHAIN_MAX];    /* Storage registers, bit n drives Qn. */
+    uint32_t latches;
+    uint32_t polling;                   /* Polling transmissions. */
+    uint32_t interrupt;                 /* Interrupt transmissions. */
+    uint32_t bad_buffers;               /* Transactions from a buffer that is not DMA capable. */
+    void *dma_buffer;                   /* Last DMA capable allocation. */
+    int allocations;                    /* Heap blocks not freed. */
+    int64_t now_us;
+} test_model_t;
+
+static test_model_t test_model;
+
+static uint32_t test_seed = 1;
+
+/**
+ * @brief  Pseudo-random number, the same sequence every run.
+ */
+static uint32_t test_random(void)
+{
+    test_seed = test_seed * 1103515245U + 12345U;
+
+    return test_seed >> 8;
+}
+
+void *heap_caps_malloc(size_t size, uint32_t caps)
+{
+    void *ptr = malloc(size);
+
+    test_model.allocations += (ptr != NULL) ? 1 : 0;
+    if ((caps & MALLOC_CAP_DMA) != 0)
+    {
+        test_model.dma_buffer = ptr;
+    }
+
+    return ptr;
+}
+
+void heap_caps_free(void *ptr)
+{
+    test_model.allocations -= (ptr != NULL) ? 1 : 0;
+    free(ptr);
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return test_model.now_us;
+}
+
+esp_err_t spi_bus_initialize(spi_host_device_t host, const spi_bus_config_t *bus_config, int dma_chan)
+{
+    TEST_CHECK(host == SN74HC595_SPI_HOST);
+    TEST_CHECK(test_model.bus_used == false);
+    if (test_model.bus_init_result != ESP_OK)
+    {
+        return test_model.bus_init_result;
+    }
+
+    test_model.bus_used = true;
+    test_model.bus_config = *bus_config;
+    test_model.dma_chan = dma_chan;
+
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_free(spi_host_device_t host)
+{
+    TEST_CHECK(test_model.bus_used && (test_model.device_used == false));
+    test_model.bus_used = false;
+
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_add_device(spi_host_device_t host, const spi_device_interface_config_t *dev_config,
+                             spi_device_handle_t *handle)
+{
+    TEST_CHECK(test_model.bus_used && (test_model.device_used == false));
+    if (test_model.add_device_result != ESP_OK)
+    {
+        return test_model.add_device_result;
+    }
+
+    test_model.device_used = true;
+    test_model.device.config = *dev_config;
+    *handle = &test_model.device;
+
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_remove_device(spi_device_handle_t handle)
+{
+    TEST_CHECK((handle == &test_model.device) && test_model.device_used);
+    test_model.device_used = false;
+
+    return ESP_OK;
+}
+
+/**
+ * @brief  Clock a transaction into the chain, then latch it.
+ */
+static esp_err_t test_model_transmit(spi_device_handle_t handle, spi_transaction_t *trans)
+{
+    const uint8_t *bytes = ((trans->flags & SPI_TRANS_USE_TXDATA) != 0) ? trans->tx_data : trans->tx_buffer;
+
+    TEST_CHECK((handle == &test_model.device) && test_model.device_used);
+    TEST_CHECK((trans->length % 8) == 0);
+    TEST_CHECK(trans->length / 8 <= (size_t)test_model.bus_config.max_transfer_sz);
+    if (((trans->flags & SPI_TRANS_USE_TXDATA) == 0) && (bytes != test_model.dma_buffer))
+    {
+        test_model.bad_buffers++;
+    }
+    if (test_model.transmit_result != ESP_OK)
+    {
+        return test_model.transmit_result;
+    }
+
+    /* SPI mode 0 samples MOSI on the rising SCK edge, the same edge shifts the 74HC595. */
+    for (size_t bit = 0; bit < trans->length; bit++)
+    {
+        uint8_t in = (bytes[bit / 8] >> (7 - bit % 8)) & 1U;
+
+        for (size_t k = 0; k < test_model.chain_length; k++)
+        {
+            uint8_t out = test_model.shift[k] >> 7;
+
+            test_model.shift[k] = (uint8_t)((test_model.shift[k] << 1) | in);
+            in = out;
+        }
+    }
+    test_model.now_us += (int64_t)trans->length * 1000000 / test_model.device.config.clock_speed_hz;
+
+    /* RCK is the chip select, it rises after the last bit. */
+    memcpy(test_model.outputs, test_model.shift, sizeof(test_model.outputs));
+    test_model.latches++;
+
+    return ESP_OK;
+}
+
+esp_err_t spi_device_transmit(spi_device_handle_t handle, spi_transaction_t *trans)
+{
+    test_model.interrupt++;
+
+    return test_model_transmit(handle, trans);
+}
+
+esp_err_t spi_device_polling_transmit(spi_device_handle_t handle, spi_transaction_t *trans)
+{
+    test_model.polling++;
+
+    return test_model_transmit(handle, trans);
+}
+/**
+ * @brief  Start a chain of the model with every register cleared.
+ */
+static void test_model_reset(size_t chain_length)
+{
+    memset(&test_model, 0, sizeof(test_model));
+    test_model.chain_length = chain_length;
+}
+/**
+ * @brief  Calls before init, or with bad arguments, change nothing.
+ */
+static void test_arguments(void)
+{
+    uint8_t image[2] = { 0xFF, 0xFF };
+    sn74hc595_stats_t stats;
+
+    test_model_reset(2);
+    TEST_CHECK_EQUAL(ESP_ERR_INVALID_ARG, sn74hc595_init(0));
+    TEST_CHECK_EQUAL(ESP_ERR_INVALID_STATE, sn74hc595_send_data(image, sizeof(image)));
+    TEST_CHECK_EQUAL(ESP_ERR_INVALID_STATE, sn74hc595_deinit());
+    TEST_CHECK_EQUAL(ESP_ERR_INVALID_ARG, sn74hc595_get_stats(NULL));
+    TEST_CHECK_EQUAL(ESP_OK, sn74hc595_get_stats(&stats));
+
+    TEST_CHECK_EQUAL(ESP_OK, sn74hc595_init(2));
+    TEST_CHECK_EQUAL(ESP_ERR_INVALID_STATE, sn74hc595_init(2));
+    TEST_CHECK_EQUAL(ESP_ERR_INVALID_ARG, sn74hc595_send_data(NULL, sizeof(image)));
+    TEST_CHECK_EQUAL(ESP_ERR_INVALID_ARG, sn74hc595_send_data(image, 0));
+    TEST_CHECK_EQUAL(ESP_ERR_INVALID_ARG, sn74hc595_send_data(image, 1));
+    TEST_CHECK_EQUAL(0, test_model.latches);
+    TEST_CHECK_EQUAL(ESP_OK, sn74hc595_deinit());
+    TEST_CHECK(test_model.bus_used == false);
+}
+/**
+ * @brief  A failed SPI setup releases what it took, a later init starts over.
+ */
+static void test_init_failures(void)
+{
+    test_model_reset(8);
+    test_model.bus_init_result = ESP_ERR_INVALID_STATE;
+    TEST_CHECK_EQUAL(ESP_ERR_INVALID_STATE, sn74hc595_init(8));
+    TEST_CHECK_EQUAL(0, test_model.allocations);
+
+    test_model.bus_init_result = ESP_OK;
+    test_model.add_device_result = ESP_ERR_NO_MEM;
+    TEST_CHECK_EQUAL(ESP_ERR_NO_MEM, sn74hc595_init(8));
+    TEST_CHECK_EQUAL(0, test_model.allocations);
+    TEST_CHECK(test_model.bus_used == false);
+
+    test_model.add_device_result = ESP_OK;
+    TEST_CHECK_EQUAL(ESP_OK, sn74hc595_init(8));
+    TEST_CHECK_EQUAL(ESP_OK, sn74hc595_deinit());
+    TEST_CHECK_EQUAL(0, test_model.allocations);
+}
+/**
+ * @brief  Random images reach the outputs of every device, for short and DMA chains.
+ */
+static void test_images(void)
+{
+    static const size_t lengths[] = { 1, 3, 4, 5, 8, TEST_CHAIN_MAX };
+
+    for (size_t n = 0; n < sizeof(lengths) / sizeof(lengths[0]); n++)
+    {
+        size_t length = lengths[n];
+        uint8_t image[TEST_CHAIN_MAX];
+        uint32_t mismatches = 0;
+        sn74hc595_stats_t stats;
+
+        test_model_reset(length);
+        TEST_CHECK_EQUAL(ESP_OK, sn74hc595_init(length));
+
+        /* RCK as chip select, released after the transaction so its rising edge latches. */
+        TEST_CHECK_EQUAL(0, test_model.device.config.mode);
+        TEST_CHECK_EQUAL(SN74HC595_RCK_PIN, test_model.device.config.spics_io_num);
+        TEST_CHECK_EQUAL(SN74HC595_SPI_CLOCK_HZ, test_model.device.config.clock_speed_hz);
+        TEST_CHECK_EQUAL(SN74HC595_SDA_PIN, test_model.bus_config.mosi_io_num);
+        TEST_CHECK_EQUAL(SN74HC595_SCK_PIN, test_model.bus_config.sclk_io_num);
+
+        /* Output Q0 of the device wired to the ESP32, then Q7 of the far one. */
+        memset(image, 0, sizeof(image));
+        image[0] = 0x01;
+        TEST_CHECK_EQUAL(ESP_OK, sn74hc595_send_data(image, length));
+        TEST_CHECK_EQUAL(0x01, test_model.outputs[0]);
+        image[0] = 0;
+        image[length - 1] = 0x80;
+        TEST_CHECK_EQUAL(ESP_OK, sn74hc595_send_data(image, length));
+        TEST_CHECK_EQUAL(0x80, test_model.outputs[length - 1]);
+        TEST_CHECK((length == 1) || (test_model.outputs[0] == 0));
+
+        for (uint32_t i = 0; i < TEST_IMAGES; i++)
+        {
+            for (size_t k = 0; k < length; k++)
+            {
+                image[k] = (uint8_t)test_random();
+            }
+            TEST_CHECK_EQUAL(ESP_OK, sn74hc595_send_data(image, length));
+            mismatches += (memcmp(test_model.outputs, image, length) != 0) ? 1 : 0;
+        }
+        TEST_CHECK_EQUAL(0, mismatches);
+
+        /* One latch per image, the short chains without DMA. */
+        TEST_CHECK_EQUAL(TEST_IMAGES + 2, test_model.latches);
+        TEST_CHECK_EQUAL((length <= 4) ? TEST_IMAGES + 2 : 0, test_model.polling);
+        TEST_CHECK_EQUAL(0, test_model.bad_buffers);
+
+        TEST_CHECK_EQUAL(ESP_OK, sn74hc595_get_stats(&stats));
+        TEST_CHECK_EQUAL(TEST_IMAGES + 2, stats.updates);
+        TEST_CHECK_EQUAL(0, stats.errors);
+        TEST_CHECK_EQUAL(length * 8 * 1000000 / SN74HC595_SPI_CLOCK_HZ, stats.last_us);
+
+        TEST_CHECK_EQUAL(ESP_OK, sn74hc595_deinit());
+        TEST_CHECK_EQUAL(0, test_model.allocations);
+    }
+}
+/**
+ * @brief  A failed transfer is counted and leaves the outputs latched before.
+ */
+static void test_transfer_failure(void)
+{
+    uint8_t image[6] = { 1, 2, 3, 4, 5, 6 };
+    uint8_t other[6] = { 6, 5, 4, 3, 2, 1 };
+    sn74hc595_stats_t stats;
+
+    test_model_reset(sizeof(image));
+    TEST_CHECK_EQUAL(ESP_OK, sn74hc595_init(sizeof(image)));
+    TEST_CHECK_EQUAL(ESP_OK, sn74hc595_send_data(image, sizeof(image)));
+
+    test_model.transmit_result = ESP_ERR_TIMEOUT;
+    TEST_CHECK_EQUAL(ESP_ERR_TIMEOUT, sn74hc595_send_data(other, sizeof(other)));
+    TEST_CHECK(memcmp(test_model.outputs, image, sizeof(image)) == 0);
+
+    TEST_CHECK_EQUAL(ESP_OK, sn74hc595_get_stats(&stats));
+    TEST_CHECK_EQUAL(1, stats.updates);
+    TEST_CHECK_EQUAL(1, stats.errors);
+    TEST_CHECK_EQUAL(ESP_OK, sn74hc595_deinit());
+}
+
+int main(void)
+{
+    TEST_CASE(test_arguments);
+    TEST_CASE(test_init_failures);
+    TEST_CASE(test_images);
+    TEST_CASE(test_transfer_failure);
+
+    return TEST_RESULT();
+}
+/******************************** End of File *********************************/
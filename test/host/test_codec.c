@@ -0,0 +1,336 @@
+/**
+ *****************************************************************************
+ * @file    : test_codec.c
+ * @brief   : Host tests of the MQTT payload codec
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *
+ * @note Every decoder is fed random payloads in both formats, the sanitizer
+ *       build catches any read outside them. Encoders are checked byte for
+ *       byte, and never write past the buffer size they are given.
+ *****************************************************************************
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "test_host.h"
+#include "user_codec.h"
+
+/** @brief Random payloads per decoder and format. */
+#define TEST_FUZZ_ROUNDS        (200000U)
+
+/** @brief Batch payloads encoded by the throughput case. */
+#define TEST_THROUGHPUT_ROUNDS  (200000U)
+
+/** @brief Guard byte after the buffer handed to an encoder. */
+#define TEST_CANARY             ((char)0xA5)
+
+static const char *const test_names[] = {
+    "soilHumi1", "soilHumi2", "soilHumi3", "envmHumi1", "envmTemp1", "envmTmos1", "tdsValue1",
+};
+
+static uint32_t test_seed = 1;
+
+/**
+ * @brief  Pseudo-random number, the same sequence every run.
+ */
+static uint32_t test_random(void)
+{
+    test_seed = test_seed * 1103515245U + 12345U;
+
+    return test_seed >> 8;
+}
+/**
+ * @brief  Text and binary command payloads decode to the expected values.
+ */
+static void test_decode(void)
+{
+    bool on = false;
+    uint32_t level = 0;
+    uint8_t rgb[3] = { 0 };
+
+    TEST_CHECK_EQUAL(ESP_OK, user_codec_decode_switch(USER_CODEC_FORMAT_TEXT, "on", 2, &on));
+    TEST_CHECK(on);
+    TEST_CHECK_EQUAL(ESP_OK, user_codec_decode_switch(USER_CODEC_FORMAT_TEXT, "off", 3, &on));
+    TEST_CHECK(on == false);
+    TEST_CHECK_EQUAL(ESP_ERR_INVALID_ARG, user_codec_decode_switch(USER_CODEC_FORMAT_TEXT, "onx", 2 + 1, &on));
+    TEST_CHECK_EQUAL(ESP_ERR_INVALID_ARG, user_codec_decode_switch(USER_CODEC_FORMAT_TEXT, "o", 1, &on));
+    TEST_CHECK_EQUAL(ESP_OK, user_codec_decode_switch(USER_CODEC_FORMAT_BINARY, "\x01\x01", 2, &on));
+    TEST_CHECK(on);
+    TEST_CHECK_EQUAL(ESP_ERR_INVALID_ARG, user_codec_decode_switch(USER_CODEC_FORMAT_BINARY, "\x01\x02", 2, &on));
+    TEST_CHECK_EQUAL(ESP_ERR_INVALID_VERSION, user_codec_decode_switch(USER_CODEC_FORMAT_BINARY, "\x02\x01", 2, &on));
+    TEST_CHECK_EQUAL(ESP_ERR_INVALID_SIZE, user_codec_decode_switch(USER_CODEC_FORMAT_BINARY, "\x01", 1, &on));
+
+    TEST_CHECK_EQUAL(ESP_OK, user_codec_decode_level(USER_CODEC_FORMAT_TEXT, "255", 3, 255, &level));
+    TEST_CHECK_EQUAL(255, level);
+    TEST_CHECK_EQUAL(ESP_OK, user_codec_decode_level(USER_CODEC_FORMAT_TEXT, "007", 3, 100, &level));
+    TEST_CHECK_EQUAL(7, level);
+    TEST_CHECK_EQUAL(ESP_ERR_INVALID_ARG, user_codec_decode_level(USER_CODEC_FORMAT_TEXT, "101", 3, 100, &level));
+    TEST_CHECK_EQUAL(ESP_ERR_INVALID_ARG, user_codec_decode_level(USER_CODEC_FORMAT_TEXT, "-1", 2, 100, &level));
+    TEST_CHECK_EQUAL(ESP_ERR_INVALID_ARG, user_codec_decode_level(USER_CODEC_FORMAT_TEXT, "", 0, 100, &level));
+    TEST_CHECK_EQUAL(ESP_ERR_INVALID_ARG,
+                     user_codec_decode_level(USER_CODEC_FORMAT_TEXT, "99999999999", 11, UINT32_MAX, &level));
+    TEST_CHECK_EQUAL(ESP_OK, user_codec_decode_level(USER_CODEC_FORMAT_BINARY, "\x01\x64", 2, 100, &level));
+    TEST_CHECK_EQUAL(100, level);
+    TEST_CHECK_EQUAL(ESP_ERR_INVALID_ARG, user_codec_decode_level(USER_CODEC_FORMAT_BINARY, "\x01\x65", 2, 100, &level));
+
+    TEST_CHECK_EQUAL(ESP_OK, user_codec_decode_rgb(USER_CODEC_FORMAT_TEXT, "255,0,17", 8, rgb));
+    TEST_CHECK(memcmp(rgb, "\xFF\x00\x11", 3) == 0);
+    TEST_CHECK_EQUAL(ESP_ERR_INVALID_ARG, user_codec_decode_rgb(USER_CODEC_FORMAT_TEXT, "255,0", 5, rgb));
+    TEST_CHECK_EQUAL(ESP_ERR_INVALID_ARG, user_codec_decode_rgb(USER_CODEC_FORMAT_TEXT, "1,2,3,", 6, rgb));
+    TEST_CHECK_EQUAL(ESP_ERR_INVALID_ARG, user_codec_decode_rgb(USER_CODEC_FORMAT_TEXT, "1,,3", 4, rgb));
+    TEST_CHECK_EQUAL(ESP_ERR_INVALID_ARG, user_codec_decode_rgb(USER_CODEC_FORMAT_TEXT, "1,2,256", 7, rgb));
+    TEST_CHECK_EQUAL(ESP_OK, user_codec_decode_rgb(USER_CODEC_FORMAT_BINARY, "\x01\x0A\x0B\x0C", 4, rgb));
+    TEST_CHECK(memcmp(rgb, "\x0A\x0B\x0C", 3) == 0);
+    TEST_CHECK_EQUAL(ESP_ERR_INVALID_SIZE, user_codec_decode_rgb(USER_CODEC_FORMAT_BINARY, "\x01\x0A\x0B", 3, rgb));
+}
+/**
+ * @brief  Random payloads never crash a decoder, and what is accepted is in range.
+ */
+static void test_decode_fuzz(void)
+{
+    static const char alphabet[] = "0123456789,onf\x01\x00\xFF";
+    uint32_t accepted = 0;
+
+    for (uint32_t round = 0; round < TEST_FUZZ_ROUNDS; round++)
+    {
+        user_codec_format_t format = (round & 1) ? USER_CODEC_FORMAT_BINARY : USER_CODEC_FORMAT_TEXT;
+        int len = (int)(test_random() % 13);
+        uint32_t max = test_random() % 256;
+        uint8_t rgb[3];
+        uint32_t level = UINT32_MAX;
+        bool on;
+        char *data;
+
+        /* Exactly len bytes on the heap, so a read past them is caught. */
+        data = malloc((len > 0) ? (size_t)len : 1);
+        for (int i = 0; i < len; i++)
+        {
+            /* Mostly characters the decoders look for, sometimes anything. */
+            data[i] = (test_random() & 3) ? alphabet[test_random() % (sizeof(alphabet) - 1)] : (char)test_random();
+        }
+
+        if (user_codec_decode_switch(format, data, len, &on) == ESP_OK)
+        {
+            TEST_CHECK_EQUAL((format == USER_CODEC_FORMAT_BINARY) ? 2 : (on ? 2 : 3), len);
+            accepted++;
+        }
+        if (user_codec_decode_level(format, data, len, max, &level) == ESP_OK)
+        {
+            TEST_CHECK(level <= max);
+            accepted++;
+        }
+        if (user_codec_decode_rgb(format, data, len, rgb) == ESP_OK)
+        {
+            TEST_CHECK((format == USER_CODEC_FORMAT_TEXT) || (len == 4));
+            accepted++;
+        }
+
+        free(data);
+    }
+
+    /* The alphabet makes valid payloads common enough to reach the success paths. */
+    TEST_CHECK(accepted > TEST_FUZZ_ROUNDS / 100);
+}
+/**
+ * @brief  Encoded commands decode back to the same values, in both formats.
+ */
+static void test_round_trip(void)
+{
+    char buf[16];
+
+    for (uint32_t format = USER_CODEC_FORMAT_TEXT; format <= USER_CODEC_FORMAT_BINARY; format++)
+    {
+        bool on;
+        int len = user_codec_encode_switch(format, buf, sizeof(buf), true);
+
+        TEST_CHECK_EQUAL(ESP_OK, user_codec_decode_switch(format, buf, len, &on));
+        TEST_CHECK(on);
+        len = user_codec_encode_switch(format, buf, sizeof(buf), false);
+        TEST_CHECK_EQUAL(ESP_OK, user_codec_decode_switch(format, buf, len, &on));
+        TEST_CHECK(on == false);
+    }
+
+    for (uint32_t round = 0; round < 10000; round++)
+    {
+        uint8_t rgb[3] = { (uint8_t)test_random(), (uint8_t)test_random(), (uint8_t)test_random() };
+        uint8_t decoded[3];
+        int len = snprintf(buf, sizeof(buf), "%u,%u,%u", rgb[0], rgb[1], rgb[2]);
+
+        TEST_CHECK_EQUAL(ESP_OK, user_codec_decode_rgb(USER_CODEC_FORMAT_TEXT, buf, len, decoded));
+        TEST_CHECK(memcmp(rgb, decoded, 3) == 0);
+    }
+}
+/**
+ * @brief  Values are encoded with two decimals in text and as int32 little-endian in binary.
+ */
+static void test_encode_value(void)
+{
+    static const struct
+    {
+        int32_t value;
+        const char *text;
+    } vectors[] = {
+        { 0, "0.00" }, { 1, "0.01" }, { -1, "-0.01" }, { 2508, "25.08" }, { -2508, "-25.08" },
+        { INT32_MAX, "21474836.47" }, { INT32_MIN, "-21474836.48" },
+    };
+    char buf[16];
+
+    for (size_t i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++)
+    {
+        int len = user_codec_encode_value(USER_CODEC_FORMAT_TEXT, buf, sizeof(buf), vectors[i].value);
+
+        TEST_CHECK_EQUAL(strlen(vectors[i].text), len);
+        TEST_CHECK(strcmp(buf, vectors[i].text) == 0);
+    }
+
+    TEST_CHECK_EQUAL(5, user_codec_encode_value(USER_CODEC_FORMAT_BINARY, buf, sizeof(buf), -2));
+    TEST_CHECK(memcmp(buf, "\x01\xFE\xFF\xFF\xFF", 5) == 0);
+}
+/**
+ * @brief  Batch and history payloads match their documented layout.
+ */
+static void test_encode_frames(void)
+{
+    static const int32_t values[] = { 4012, 0, 0, 6550, -125, 0, 0 };
+    static const user_codec_record_t records[] = { { 1760000000U, 4, -125 }, { 1760000060U, 0, 4012 } };
+    static const char history_binary[] = "\x01\x02\x02"
+                                         "\x00\x78\xE7\x68" "\x04" "\x83\xFF\xFF\xFF"
+                                         "\x3C\x78\xE7\x68" "\x00" "\xAC\x0F\x00\x00";
+    char buf[128];
+    int len;
+
+    len = user_codec_encode_batch(USER_CODEC_FORMAT_TEXT, buf, sizeof(buf), test_names, values, 0x19);
+    TEST_CHECK(strcmp(buf, "{\"soilHumi1\":40.12,\"envmHumi1\":65.50,\"envmTemp1\":-1.25}") == 0);
+    TEST_CHECK_EQUAL(strlen(buf), len);
+
+    len = user_codec_encode_batch(USER_CODEC_FORMAT_BINARY, buf, sizeof(buf), test_names, values, 0x19);
+    TEST_CHECK_EQUAL(16, len);
+    TEST_CHECK(memcmp(buf, "\x01\x01\x19\x00" "\xAC\x0F\x00\x00" "\x96\x19\x00\x00" "\x83\xFF\xFF\xFF", 16) == 0);
+
+    TEST_CHECK_EQUAL(0, user_codec_encode_batch(USER_CODEC_FORMAT_TEXT, buf, sizeof(buf), test_names, values, 0));
+    TEST_CHECK_EQUAL(-1, user_codec_encode_batch(USER_CODEC_FORMAT_BINARY, buf, sizeof(buf), test_names, values, 0x10000));
+
+    len = user_codec_encode_history(USER_CODEC_FORMAT_TEXT, buf, sizeof(buf), test_names, records, 2);
+    TEST_CHECK(strcmp(buf, "[[1760000000,\"envmTemp1\",-1.25],[1760000060,\"soilHumi1\",40.12]]") == 0);
+    TEST_CHECK_EQUAL(strlen(buf), len);
+
+    len = user_codec_encode_history(USER_CODEC_FORMAT_BINARY, buf, sizeof(buf), test_names, records, 2);
+    TEST_CHECK_EQUAL(sizeof(history_binary) - 1, len);
+    TEST_CHECK(memcmp(buf, history_binary, sizeof(history_binary) - 1) == 0);
+}
+/**
+ * @brief  Every encoder fails cleanly in every buffer too small for its payload, and writes nothing past it.
+ */
+static void test_encode_truncation(void)
+{
+    static const int32_t values[] = { 4012, -99999, 1, 6550, -125, INT32_MIN, INT32_MAX };
+    static const user_codec_record_t records[] = { { 1, 0, 1 }, { UINT32_MAX, 6, INT32_MIN }, { 7, 3, 0 } };
+    char full[160];
+    char buf[160 + 1];
+
+    for (uint32_t format = USER_CODEC_FORMAT_TEXT; format <= USER_CODEC_FORMAT_BINARY; format++)
+    {
+        for (uint32_t kind = 0; kind < 4; kind++)
+        {
+            int expected;
+
+            switch (kind)
+            {
+            case 0:
+                expected = user_codec_encode_switch(format, full, sizeof(full), false);
+                break;
+            case 1:
+                expected = user_codec_encode_value(format, full, sizeof(full), INT32_MIN);
+                break;
+            case 2:
+                expected = user_codec_encode_batch(format, full, sizeof(full), test_names, values, 0x7F);
+                break;
+            default:
+                expected = user_codec_encode_history(format, full, sizeof(full), test_names, records, 3);
+                break;
+            }
+            TEST_CHECK(expected > 0);
+
+            for (size_t size = 0; size < sizeof(full); size++)
+            {
+                int len;
+
+                memset(buf, TEST_CANARY, sizeof(buf));
+                switch (kind)
+                {
+                case 0:
+                    len = user_codec_encode_switch(format, buf, size, false);
+                    break;
+                case 1:
+                    len = user_codec_encode_value(format, buf, size, INT32_MIN);
+                    break;
+                case 2:
+                    len = user_codec_encode_batch(format, buf, size, test_names, values, 0x7F);
+                    break;
+                default:
+                    len = user_codec_encode_history(format, buf, size, test_names, records, 3);
+                    break;
+                }
+
+                /* Text payloads are null terminated, so they need one more byte. */
+                if (size < (size_t)expected + ((format == USER_CODEC_FORMAT_TEXT) ? 1 : 0))
+                {
+                    TEST_CHECK_EQUAL(-1, len);
+                }
+                else
+                {
+                    TEST_CHECK_EQUAL(expected, len);
+                    TEST_CHECK(memcmp(buf, full, (size_t)expected) == 0);
+                }
+                TEST_CHECK(buf[size] == TEST_CANARY);
+            }
+        }
+    }
+}
+/**
+ * @brief  Batch encoding throughput, one telemetry window of every channel per payload.
+ */
+static void test_throughput(void)
+{
+    static const int32_t values[] = { 4012, 3987, 4150, 6550, 2508, 100653, 32000 };
+    static const char *const labels[] = { "text", "binary" };
+    char buf[160];
+
+    for (uint32_t format = USER_CODEC_FORMAT_TEXT; format <= USER_CODEC_FORMAT_BINARY; format++)
+    {
+        struct timespec start;
+        struct timespec end;
+        uint64_t bytes = 0;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (uint32_t round = 0; round < TEST_THROUGHPUT_ROUNDS; round++)
+        {
+            int len = user_codec_encode_batch(format, buf, sizeof(buf), test_names, values, 0x7F);
+            TEST_CHECK(len > 0);
+            bytes += (uint64_t)len;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        uint64_t ns = (uint64_t)(end.tv_sec - start.tv_sec) * 1000000000U + (uint64_t)end.tv_nsec - (uint64_t)start.tv_nsec;
+        printf("batch %-6s %3" PRIu64 " bytes, %5" PRIu64 " ns per payload\n", labels[format],
+               bytes / TEST_THROUGHPUT_ROUNDS, ns / TEST_THROUGHPUT_ROUNDS);
+    }
+}
+
+int main(void)
+{
+    TEST_CASE(test_decode);
+    TEST_CASE(test_decode_fuzz);
+    TEST_CASE(test_round_trip);
+    TEST_CASE(test_encode_value);
+    TEST_CASE(test_encode_frames);
+    TEST_CASE(test_encode_truncation);
+    TEST_CASE(test_throughput);
+
+    return TEST_RESULT();
+}
+/******************************** End of File *********************************/
@@ -0,0 +1,217 @@
+/**
+ *****************************************************************************
+ * @file    : test_fan_control.c
+ * @brief   : Host tests of the fixed-point fan speed controller
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *
+ * @note The PI controller runs against a fan model with a start-up dead zone,
+ *       a first-order lag and a quantizing tachometer, at the gains and the
+ *       period of user_esp32_fan.c.
+ *****************************************************************************
+ */
+
+#include <string.h>
+
+#include "test_host.h"
+#include "user_fan_control.h"
+
+/** @brief Controller as configured in user_esp32_fan.c. */
+#define TEST_PERIOD_MS          (1000U)
+#define TEST_KP                 FAN_CONTROL_GAIN(0.2)
+#define TEST_KI                 FAN_CONTROL_GAIN(0.2)
+#define TEST_DUTY_MAX           (1000)
+#define TEST_PULSES_PER_REV     (2U)
+
+/** @brief Fan model. */
+typedef struct
+{
+    int32_t dead_duty;      /* The fan stands still at or below this duty. */
+    int32_t max_rpm;        /* Speed at full duty. */
+    int32_t lag_percent;    /* Part of the speed error closed per period. */
+    int64_t rpm_q8;         /* Speed, 1/256 RPM. */
+    int64_t pulse_q8;       /* Tachometer pulses not counted yet, 1/256 pulse. */
+} test_fan_t;
+
+/**
+ * @brief  Advance the fan by one control period at a duty, return the RPM read from the tachometer.
+ */
+static uint32_t test_fan_run(test_fan_t *fan, int32_t duty)
+{
+    int64_t target = 0;
+    uint32_t pulses = 0;
+
+    if (duty > fan->dead_duty)
+    {
+        target = ((int64_t)(duty - fan->dead_duty) * fan->max_rpm << 8) / (TEST_DUTY_MAX - fan->dead_duty);
+    }
+    fan->rpm_q8 += (target - fan->rpm_q8) * fan->lag_percent / 100;
+
+    /* Pulses of the period, the fraction carries over like on a free running counter. */
+    fan->pulse_q8 += fan->rpm_q8 * TEST_PULSES_PER_REV * TEST_PERIOD_MS / 60000;
+    pulses = (uint32_t)(fan->pulse_q8 >> 8);
+    fan->pulse_q8 -= (int64_t)pulses << 8;
+
+    return fan_control_tach_rpm(pulses, TEST_PERIOD_MS, TEST_PULSES_PER_REV);
+}
+/**
+ * @brief  A new fan, 3300 RPM at full duty, stands still below 15 %.
+ */
+static void test_fan_init(test_fan_t *fan)
+{
+    memset(fan, 0, sizeof(*fan));
+    fan->dead_duty = 150;
+    fan->max_rpm = 3300;
+    fan->lag_percent = 40;
+}
+/**
+ * @brief  Run the loop for a number of periods, return the worst overshoot and the last RPM.
+ */
+static void test_loop(fan_control_pi_t *pi, test_fan_t *fan, uint32_t *rpm, int32_t target, uint32_t periods,
+                      int32_t *overshoot)
+{
+    for (uint32_t i = 0; i < periods; i++)
+    {
+        int32_t duty = fan_control_pi_update(pi, target, (int32_t)*rpm);
+
+        TEST_CHECK((duty >= 0) && (duty <= TEST_DUTY_MAX));
+        *rpm = test_fan_run(fan, duty);
+        if ((overshoot != NULL) && ((int32_t)*rpm - target > *overshoot))
+        {
+            *overshoot = (int32_t)*rpm - target;
+        }
+    }
+}
+/**
+ * @brief  Tachometer pulses convert to RPM with rounding.
+ */
+static void test_tach_rpm(void)
+{
+    TEST_CHECK_EQUAL(0, fan_control_tach_rpm(0, 1000, 2));
+    TEST_CHECK_EQUAL(1500, fan_control_tach_rpm(50, 1000, 2));
+    TEST_CHECK_EQUAL(30, fan_control_tach_rpm(1, 1000, 2));
+    TEST_CHECK_EQUAL(1500, fan_control_tach_rpm(25, 500, 2));
+    TEST_CHECK_EQUAL(1475, fan_control_tach_rpm(48, 976, 2));
+    TEST_CHECK_EQUAL(0, fan_control_tach_rpm(50, 0, 2));
+    TEST_CHECK_EQUAL(0, fan_control_tach_rpm(50, 1000, 0));
+}
+/**
+ * @brief  A step from standstill settles within two tachometer counts in 15 s, with little overshoot.
+ */
+static void test_step(void)
+{
+    fan_control_pi_t pi;
+    test_fan_t fan;
+    uint32_t rpm = 0;
+    int32_t overshoot = 0;
+
+    fan_control_pi_init(&pi, TEST_KP, TEST_KI, 0, TEST_DUTY_MAX);
+    test_fan_init(&fan);
+
+    test_loop(&pi, &fan, &rpm, 1500, 15, &overshoot);
+    TEST_CHECK(((int32_t)rpm >= 1440) && (rpm <= 1560));
+    TEST_CHECK(overshoot <= 150);
+
+    /* Holds the speed. */
+    for (int i = 0; i < 60; i++)
+    {
+        test_loop(&pi, &fan, &rpm, 1500, 1, NULL);
+        TEST_CHECK(((int32_t)rpm >= 1440) && (rpm <= 1560));
+    }
+}
+/**
+ * @brief  A worn fan needs more duty for the same speed, the integral finds it.
+ */
+static void test_worn_fan(void)
+{
+    fan_control_pi_t pi;
+    test_fan_t fan;
+    uint32_t rpm = 0;
+
+    fan_control_pi_init(&pi, TEST_KP, TEST_KI, 0, TEST_DUTY_MAX);
+    test_fan_init(&fan);
+    test_loop(&pi, &fan, &rpm, 2000, 30, NULL);
+    int32_t new_duty = pi.output;
+
+    fan.max_rpm = 2600;
+    fan.dead_duty = 250;
+    test_loop(&pi, &fan, &rpm, 2000, 30, NULL);
+
+    TEST_CHECK(((int32_t)rpm >= 1940) && (rpm <= 2060));
+    TEST_CHECK(pi.output > new_duty);
+}
+/**
+ * @brief  An unreachable target saturates without winding up, the next target is reached without overshoot.
+ */
+static void test_saturation(void)
+{
+    fan_control_pi_t pi;
+    test_fan_t fan;
+    uint32_t rpm = 0;
+    int32_t overshoot = 0;
+
+    fan_control_pi_init(&pi, TEST_KP, TEST_KI, 0, TEST_DUTY_MAX);
+    test_fan_init(&fan);
+
+    test_loop(&pi, &fan, &rpm, 6000, 120, NULL);
+    TEST_CHECK_EQUAL(TEST_DUTY_MAX, pi.output);
+    TEST_CHECK(pi.integral <= ((int64_t)TEST_DUTY_MAX << FAN_CONTROL_Q));
+
+    /* From full speed down to 1500 RPM, the fan only coasts down to it. */
+    test_loop(&pi, &fan, &rpm, 1500, 20, NULL);
+    TEST_CHECK(((int32_t)rpm >= 1440) && (rpm <= 1560));
+
+    /* And back up, without the overshoot of a wound up integral. */
+    test_loop(&pi, &fan, &rpm, 2500, 20, &overshoot);
+    TEST_CHECK(((int32_t)rpm >= 2440) && (rpm <= 2560));
+    TEST_CHECK(overshoot <= 200);
+}
+/**
+ * @brief  A fan held off while the controller runs would wind the integral up, a reset restarts from standstill.
+ */
+static void test_reset(void)
+{
+    fan_control_pi_t pi;
+    test_fan_t fan;
+    uint32_t rpm = 0;
+    int32_t overshoot = 0;
+
+    fan_control_pi_init(&pi, TEST_KP, TEST_KI, 0, TEST_DUTY_MAX);
+    TEST_CHECK_EQUAL(0, pi.output);
+
+    /* Relay off: the fan does not turn whatever the duty. */
+    for (int i = 0; i < 30; i++)
+    {
+        fan_control_pi_update(&pi, 1500, 0);
+    }
+    TEST_CHECK_EQUAL(TEST_DUTY_MAX, pi.output);
+
+    /* The glue resets while the relay is off, the loop starts over from 0. */
+    fan_control_pi_reset(&pi, 0);
+    TEST_CHECK_EQUAL(0, pi.output);
+    TEST_CHECK_EQUAL(0, pi.integral);
+
+    test_fan_init(&fan);
+    test_loop(&pi, &fan, &rpm, 1500, 15, &overshoot);
+    TEST_CHECK(((int32_t)rpm >= 1440) && (rpm <= 1560));
+    TEST_CHECK(overshoot <= 150);
+
+    /* Out of range reset values are clamped. */
+    fan_control_pi_reset(&pi, TEST_DUTY_MAX + 500);
+    TEST_CHECK_EQUAL(TEST_DUTY_MAX, pi.output);
+    fan_control_pi_reset(&pi, -5);
+    TEST_CHECK_EQUAL(0, pi.output);
+}
+
+int main(void)
+{
+    TEST_CASE(test_tach_rpm);
+    TEST_CASE(test_step);
+    TEST_CASE(test_worn_fan);
+    TEST_CASE(test_saturation);
+    TEST_CASE(test_reset);
+
+    return TEST_RESULT();
+}
+/******************************** End of File *********************************/
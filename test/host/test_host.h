@@ -0,0 +1,61 @@
+/**
+ *****************************************************************************
+ * @file    : test_host.h
+ * @brief   : Host test assertions
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *
+ * @note A failed check is reported and counted, the test case goes on so one
+ *       run shows every failure. TEST_RESULT() is the process exit code.
+ *****************************************************************************
+ */
+
+#ifndef TEST_HOST_H
+#define TEST_HOST_H
+
+#include <stdio.h>
+#include <inttypes.h>
+
+/** @brief Failed checks of the test program. */
+static int test_failures = 0;
+
+/** @brief Check a condition. */
+#define TEST_CHECK(_cond)                                                       \
+    do                                                                          \
+    {                                                                           \
+        if (!(_cond))                                                           \
+        {                                                                       \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #_cond); \
+            test_failures++;                                                    \
+        }                                                                       \
+    } while (0)
+
+/** @brief Check that two integers are equal. */
+#define TEST_CHECK_EQUAL(_expected, _actual)                                    \
+    do                                                                          \
+    {                                                                           \
+        int64_t _e = (int64_t)(_expected);                                      \
+        int64_t _a = (int64_t)(_actual);                                        \
+        if (_e != _a)                                                           \
+        {                                                                       \
+            fprintf(stderr, "%s:%d: %s is %" PRId64 ", expected %" PRId64 "\n", \
+                    __FILE__, __LINE__, #_actual, _a, _e);                      \
+            test_failures++;                                                    \
+        }                                                                       \
+    } while (0)
+
+/** @brief Run a test case and report it. */
+#define TEST_CASE(_fn)                                                          \
+    do                                                                          \
+    {                                                                           \
+        int _before = test_failures;                                            \
+        _fn();                                                                  \
+        printf("%s %s\n", (test_failures == _before) ? "PASS" : "FAIL", #_fn);  \
+    } while (0)
+
+/** @brief Exit code of the test program. */
+#define TEST_RESULT()   ((test_failures == 0) ? 0 : 1)
+
+#endif /* TEST_HOST_H */
+/******************************** End of File *********************************/
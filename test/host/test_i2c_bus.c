@@ -0,0 +1,393 @@
+/**
+ *****************************************************************************
+ * @file    : test_i2c_bus.c
+ * @brief   : Host tests of the I2C transaction scheduler
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *
+ * @note The scheduler runs on a mock bus that records every transfer, costs a
+ *       fixed time per transaction and can fail the transfers of one device.
+ *       Like a command link, a failing transfer stops at the failing device.
+ *****************************************************************************
+ */
+
+#include <string.h>
+
+#include "test_host.h"
+#include "user_i2c_bus.h"
+
+/** @brief Recorded transfers. */
+#define TEST_TRANSFER_MAX       (32)
+
+/** @brief Bus time of one transaction. */
+#define TEST_TRANSACTION_US     (100U)
+
+/** @brief Mock bus. */
+typedef struct
+{
+    uint32_t now_us;                                        /* Clock. */
+    uint8_t fail_address;                                   /* Transfers with this device fail, 0 none. */
+    bool report_done;                                       /* Report where a failed transfer stopped. */
+    int transfers;                                          /* Transfers recorded. */
+    int counts[TEST_TRANSFER_MAX];                          /* Transactions of every transfer. */
+    uint8_t addresses[TEST_TRANSFER_MAX][USER_I2C_BATCH_MAX]; /* Devices of every transfer, in bus order. */
+} test_bus_t;
+
+/** @brief Completion record of a transaction. */
+typedef struct
+{
+    int calls;
+    int order;
+    esp_err_t result;
+} test_done_t;
+
+/** @brief Completion order counter. */
+static int test_done_order = 0;
+
+static esp_err_t test_bus_transfer(void *ctx, user_i2c_transaction_t *const *batch, int count, int *done)
+{
+    test_bus_t *bus = (test_bus_t *)ctx;
+    esp_err_t ret = ESP_OK;
+
+    TEST_CHECK((count > 0) && (count <= USER_I2C_BATCH_MAX));
+
+    for (int i = 0; (i < count) && (ret == ESP_OK); i++)
+    {
+        if (bus->transfers < TEST_TRANSFER_MAX)
+        {
+            bus->addresses[bus->transfers][i] = batch[i]->address;
+        }
+        if ((bus->fail_address != 0) && (batch[i]->address == bus->fail_address))
+        {
+            *done = bus->report_done ? i : 0;
+            ret = ESP_FAIL;
+        }
+    }
+
+    if (bus->transfers < TEST_TRANSFER_MAX)
+    {
+        bus->counts[bus->transfers] = count;
+    }
+    bus->transfers++;
+    bus->now_us += TEST_TRANSACTION_US * (uint32_t)count;
+
+    return ret;
+}
+
+static uint32_t test_bus_clock(void *ctx)
+{
+    return ((test_bus_t *)ctx)->now_us;
+}
+
+static void test_done(user_i2c_transaction_t *trans, void *arg)
+{
+    test_done_t *done = (test_done_t *)arg;
+
+    done->calls++;
+    done->order = test_done_order++;
+    done->result = trans->result;
+}
+/**
+ * @brief  Set up a transaction completing into a record.
+ */
+static void test_transaction(user_i2c_transaction_t *trans, test_done_t *done, uint8_t address, uint8_t priority,
+                             uint32_t timeout_ms)
+{
+    memset(trans, 0, sizeof(*trans));
+    memset(done, 0, sizeof(*done));
+    trans->address = address;
+    trans->priority = priority;
+    trans->read_len = 2;
+    trans->timeout_ms = timeout_ms;
+    trans->idempotent = true;
+    trans->callback = test_done;
+    trans->arg = done;
+}
+/**
+ * @brief  Higher priority first, then earlier deadline, then submission order, no deadline last.
+ */
+static void test_order(void)
+{
+    static const struct
+    {
+        uint8_t address;
+        uint8_t priority;
+        uint32_t timeout_ms;
+    } submitted[] = {
+        { 0x10, 0, 0 },
+        { 0x11, 0, 50 },
+        { 0x12, 1, 0 },
+        { 0x13, 0, 20 },
+        { 0x14, 0, 50 },
+        { 0x15, 1, 100 },
+        { 0x16, 0, 0 },
+    };
+    static const uint8_t expected[] = { 0x15, 0x12, 0x13, 0x11, 0x14, 0x10, 0x16 };
+    user_i2c_transaction_t trans[7];
+    test_done_t done[7];
+    user_i2c_bus_t sched;
+    test_bus_t bus = { .now_us = 1000 };
+
+    test_done_order = 0;
+    user_i2c_bus_init(&sched, test_bus_transfer, test_bus_clock, &bus);
+
+    for (int i = 0; i < 7; i++)
+    {
+        test_transaction(&trans[i], &done[i], submitted[i].address, submitted[i].priority, submitted[i].timeout_ms);
+        user_i2c_bus_submit(&sched, &trans[i]);
+    }
+    TEST_CHECK_EQUAL(7, sched.stats.pending);
+
+    TEST_CHECK_EQUAL(USER_I2C_BATCH_MAX, user_i2c_bus_process(&sched));
+    TEST_CHECK_EQUAL(7 - USER_I2C_BATCH_MAX, user_i2c_bus_process(&sched));
+    TEST_CHECK_EQUAL(0, user_i2c_bus_process(&sched));
+
+    TEST_CHECK_EQUAL(2, bus.transfers);
+    TEST_CHECK_EQUAL(USER_I2C_BATCH_MAX, bus.counts[0]);
+    for (int i = 0; i < 7; i++)
+    {
+        TEST_CHECK_EQUAL(expected[i], bus.addresses[i / USER_I2C_BATCH_MAX][i % USER_I2C_BATCH_MAX]);
+        TEST_CHECK_EQUAL(1, done[i].calls);
+        TEST_CHECK_EQUAL(ESP_OK, done[i].result);
+    }
+
+    TEST_CHECK_EQUAL(0, sched.stats.pending);
+    TEST_CHECK_EQUAL(7, sched.stats.transactions);
+    TEST_CHECK_EQUAL(7 - 2, sched.stats.batched);
+}
+/**
+ * @brief  A transaction whose deadline passed in the queue expires without using the bus.
+ */
+static void test_deadline(void)
+{
+    user_i2c_transaction_t late;
+    user_i2c_transaction_t urgent;
+    user_i2c_transaction_t patient;
+    test_done_t late_done;
+    test_done_t urgent_done;
+    test_done_t patient_done;
+    user_i2c_bus_t sched;
+    test_bus_t bus = { .now_us = 0 };
+    const user_i2c_device_stats_t *stats = NULL;
+
+    test_done_order = 0;
+    user_i2c_bus_init(&sched, test_bus_transfer, test_bus_clock, &bus);
+
+    test_transaction(&late, &late_done, 0x40, 0, 5);
+    test_transaction(&urgent, &urgent_done, 0x41, 0, 10);
+    test_transaction(&patient, &patient_done, 0x42, 0, 0);
+    user_i2c_bus_submit(&sched, &late);
+    user_i2c_bus_submit(&sched, &urgent);
+    user_i2c_bus_submit(&sched, &patient);
+
+    /* The bus was busy elsewhere for 5 ms, the deadline itself already counts as late. */
+    bus.now_us += 5000;
+    TEST_CHECK_EQUAL(3, user_i2c_bus_process(&sched));
+
+    TEST_CHECK_EQUAL(ESP_ERR_TIMEOUT, late_done.result);
+    TEST_CHECK_EQUAL(0, late_done.order);
+    TEST_CHECK_EQUAL(ESP_OK, urgent_done.result);
+    TEST_CHECK_EQUAL(ESP_OK, patient_done.result);
+    TEST_CHECK_EQUAL(1, bus.transfers);
+    TEST_CHECK_EQUAL(2, bus.counts[0]);
+
+    stats = user_i2c_bus_get_device_stats(&sched, 0x40);
+    TEST_CHECK((stats != NULL) && (stats->expired == 1) && (stats->completed == 0));
+
+    /* 5 ms in the queue and 200 us of bus time, histogram bucket 12 is [4096, 8192) us. */
+    stats = user_i2c_bus_get_device_stats(&sched, 0x41);
+    TEST_CHECK(stats != NULL);
+    if (stats != NULL)
+    {
+        TEST_CHECK_EQUAL(1, stats->completed);
+        TEST_CHECK_EQUAL(5200, stats->max_latency_us);
+        TEST_CHECK_EQUAL(1, stats->histogram[12]);
+    }
+}
+/**
+ * @brief  A shared transfer failing at an unknown position is repeated per transaction, only the failing device fails.
+ */
+static void test_retry(void)
+{
+    user_i2c_transaction_t trans[3];
+    test_done_t done[3];
+    user_i2c_bus_t sched;
+    test_bus_t bus = { .now_us = 0, .fail_address = 0x21 };
+
+    test_done_order = 0;
+    user_i2c_bus_init(&sched, test_bus_transfer, test_bus_clock, &bus);
+
+    for (int i = 0; i < 3; i++)
+    {
+        test_transaction(&trans[i], &done[i], (uint8_t)(0x20 + i), 0, 0);
+        user_i2c_bus_submit(&sched, &trans[i]);
+    }
+
+    TEST_CHECK_EQUAL(3, user_i2c_bus_process(&sched));
+
+    TEST_CHECK_EQUAL(ESP_OK, done[0].result);
+    TEST_CHECK_EQUAL(ESP_FAIL, done[1].result);
+    TEST_CHECK_EQUAL(ESP_OK, done[2].result);
+    TEST_CHECK_EQUAL(1 + 3, bus.transfers);
+    TEST_CHECK_EQUAL(3, sched.stats.retried);
+    TEST_CHECK_EQUAL(1, user_i2c_bus_get_device_stats(&sched, 0x21)->errors);
+    TEST_CHECK_EQUAL(1, user_i2c_bus_get_device_stats(&sched, 0x20)->completed);
+
+    /* A lone transaction is not repeated. */
+    test_transaction(&trans[0], &done[0], 0x21, 0, 0);
+    user_i2c_bus_submit(&sched, &trans[0]);
+    TEST_CHECK_EQUAL(1, user_i2c_bus_process(&sched));
+    TEST_CHECK_EQUAL(ESP_FAIL, done[0].result);
+    TEST_CHECK_EQUAL(1 + 3 + 1, bus.transfers);
+    TEST_CHECK_EQUAL(3, sched.stats.retried);
+}
+/**
+ * @brief  When the bus reports where a shared transfer stopped, the transactions before it are not sent again.
+ */
+static void test_retry_from_failure(void)
+{
+    user_i2c_transaction_t trans[3];
+    test_done_t done[3];
+    user_i2c_bus_t sched;
+    test_bus_t bus = { .now_us = 0, .fail_address = 0x21, .report_done = true };
+
+    test_done_order = 0;
+    user_i2c_bus_init(&sched, test_bus_transfer, test_bus_clock, &bus);
+
+    for (int i = 0; i < 3; i++)
+    {
+        test_transaction(&trans[i], &done[i], (uint8_t)(0x20 + i), 0, 0);
+        user_i2c_bus_submit(&sched, &trans[i]);
+    }
+
+    TEST_CHECK_EQUAL(3, user_i2c_bus_process(&sched));
+
+    /* The second transaction of the batch failed: 0x20 ran once, 0x21 and 0x22 run alone. */
+    TEST_CHECK_EQUAL(3, bus.transfers);
+    TEST_CHECK_EQUAL(3, bus.counts[0]);
+    TEST_CHECK_EQUAL(0x20, bus.addresses[0][0]);
+    TEST_CHECK_EQUAL(0x21, bus.addresses[1][0]);
+    TEST_CHECK_EQUAL(0x22, bus.addresses[2][0]);
+    TEST_CHECK_EQUAL(2, sched.stats.retried);
+
+    TEST_CHECK_EQUAL(ESP_OK, done[0].result);
+    TEST_CHECK_EQUAL(ESP_FAIL, done[1].result);
+    TEST_CHECK_EQUAL(ESP_OK, done[2].result);
+    for (int i = 0; i < 3; i++)
+    {
+        TEST_CHECK_EQUAL(1, done[i].calls);
+        TEST_CHECK_EQUAL(i, done[i].order);
+    }
+}
+/**
+ * @brief  A transaction that is not idempotent always runs alone and is never repeated.
+ */
+static void test_not_idempotent(void)
+{
+    user_i2c_transaction_t trans[4];
+    test_done_t done[4];
+    user_i2c_bus_t sched;
+    test_bus_t bus = { .now_us = 0 };
+
+    test_done_order = 0;
+    user_i2c_bus_init(&sched, test_bus_transfer, test_bus_clock, &bus);
+
+    /* A register read, a fetch, two register reads. */
+    for (int i = 0; i < 4; i++)
+    {
+        test_transaction(&trans[i], &done[i], (uint8_t)(0x60 + i), 0, 0);
+        user_i2c_bus_submit(&sched, &trans[i]);
+    }
+    trans[1].idempotent = false;
+
+    TEST_CHECK_EQUAL(1, user_i2c_bus_process(&sched));
+    TEST_CHECK_EQUAL(1, user_i2c_bus_process(&sched));
+    TEST_CHECK_EQUAL(2, user_i2c_bus_process(&sched));
+    TEST_CHECK_EQUAL(3, bus.transfers);
+    TEST_CHECK_EQUAL(1, bus.counts[0]);
+    TEST_CHECK_EQUAL(0x61, bus.addresses[1][0]);
+    TEST_CHECK_EQUAL(1, bus.counts[1]);
+    TEST_CHECK_EQUAL(2, bus.counts[2]);
+
+    /* The fetch fails alone: its error is its own and the data is not fetched twice. */
+    bus.fail_address = 0x61;
+    test_transaction(&trans[1], &done[1], 0x61, 0, 0);
+    trans[1].idempotent = false;
+    user_i2c_bus_submit(&sched, &trans[1]);
+    TEST_CHECK_EQUAL(1, user_i2c_bus_process(&sched));
+    TEST_CHECK_EQUAL(ESP_FAIL, done[1].result);
+    TEST_CHECK_EQUAL(4, bus.transfers);
+    TEST_CHECK_EQUAL(0, sched.stats.retried);
+}
+/**
+ * @brief  Deadlines keep their order across a wrap of the microsecond clock.
+ */
+static void test_clock_wrap(void)
+{
+    user_i2c_transaction_t later;
+    user_i2c_transaction_t sooner;
+    test_done_t later_done;
+    test_done_t sooner_done;
+    user_i2c_bus_t sched;
+    test_bus_t bus = { .now_us = UINT32_MAX - 3000 };
+
+    test_done_order = 0;
+    user_i2c_bus_init(&sched, test_bus_transfer, test_bus_clock, &bus);
+
+    /* Deadline past the wrap, then one before it. */
+    test_transaction(&later, &later_done, 0x30, 0, 10);
+    test_transaction(&sooner, &sooner_done, 0x31, 0, 2);
+    user_i2c_bus_submit(&sched, &later);
+    user_i2c_bus_submit(&sched, &sooner);
+
+    bus.now_us += 2500;
+    TEST_CHECK_EQUAL(2, user_i2c_bus_process(&sched));
+    TEST_CHECK_EQUAL(ESP_ERR_TIMEOUT, sooner_done.result);
+    TEST_CHECK_EQUAL(ESP_OK, later_done.result);
+
+    test_transaction(&later, &later_done, 0x30, 0, 10);
+    test_transaction(&sooner, &sooner_done, 0x31, 0, 2);
+    user_i2c_bus_submit(&sched, &later);
+    user_i2c_bus_submit(&sched, &sooner);
+    TEST_CHECK_EQUAL(2, user_i2c_bus_process(&sched));
+    TEST_CHECK_EQUAL(0x31, bus.addresses[1][0]);
+    TEST_CHECK_EQUAL(0x30, bus.addresses[1][1]);
+}
+/**
+ * @brief  Statistics are kept for the first USER_I2C_DEVICE_MAX devices only.
+ */
+static void test_device_slots(void)
+{
+    user_i2c_transaction_t trans;
+    test_done_t done;
+    user_i2c_bus_t sched;
+    test_bus_t bus = { .now_us = 0 };
+
+    user_i2c_bus_init(&sched, test_bus_transfer, test_bus_clock, &bus);
+
+    for (int i = 0; i <= USER_I2C_DEVICE_MAX; i++)
+    {
+        test_transaction(&trans, &done, (uint8_t)(0x50 + i), 0, 0);
+        user_i2c_bus_submit(&sched, &trans);
+        TEST_CHECK_EQUAL(1, user_i2c_bus_process(&sched));
+        TEST_CHECK_EQUAL(1, done.calls);
+    }
+
+    TEST_CHECK(user_i2c_bus_get_device_stats(&sched, 0x50 + USER_I2C_DEVICE_MAX - 1) != NULL);
+    TEST_CHECK(user_i2c_bus_get_device_stats(&sched, 0x50 + USER_I2C_DEVICE_MAX) == NULL);
+}
+
+int main(void)
+{
+    TEST_CASE(test_order);
+    TEST_CASE(test_deadline);
+    TEST_CASE(test_retry);
+    TEST_CASE(test_retry_from_failure);
+    TEST_CASE(test_not_idempotent);
+    TEST_CASE(test_clock_wrap);
+    TEST_CASE(test_device_slots);
+
+    return TEST_RESULT();
+}
+/******************************** End of File *********************************/
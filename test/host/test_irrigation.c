@@ -0,0 +1,405 @@
+/**
+ *****************************************************************************
+ * @file    : test_irrigation.c
+ * @brief   : Host tests of the soil moisture irrigation controller
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *
+ * @note The controller is driven by simulated soil: an open valve wets its
+ *       zone, a closed one dries, and the probes are sampled every few seconds.
+ *****************************************************************************
+ */
+
+#include <string.h>
+
+#include "test_host.h"
+#include "user_irrigation.h"
+
+/** @brief Simulation step and probe sample period. */
+#define TEST_TICK_MS            (1000U)
+#define TEST_SAMPLE_MS          (5000U)
+
+/** @brief Soil model, moisture change per tick. */
+#define TEST_WET_RATE           (3)
+#define TEST_DRY_RATE           (1)
+
+/** @brief Every zone output bit. */
+#define TEST_ZONE_MASK          (IRRIGATION_PUMP_BIT - 1)
+
+static const irrigation_pump_config_t test_pump = {
+    .max_open_zones = 2,
+    .pump_min_off_ms = 30 * 1000U,
+    .sample_timeout_ms = 30 * 1000U,
+};
+
+static const irrigation_zone_config_t test_zone = {
+    .enabled = true,
+    .on_below = 3000,
+    .off_above = 4000,
+    .min_on_ms = 60 * 1000U,
+    .min_off_ms = 10 * 60 * 1000U,
+    .max_on_ms = 30 * 60 * 1000U,
+};
+
+/** @brief Simulated greenhouse. */
+typedef struct
+{
+    irrigation_t ctrl;
+    int32_t moisture[IRRIGATION_MAX_ZONES];
+    bool probe[IRRIGATION_MAX_ZONES];       /* When cleared, the probe of the zone stops sampling. */
+    bool wets[IRRIGATION_MAX_ZONES];        /* When cleared, watering does not reach the probe. */
+    uint32_t now;
+    uint32_t switched[IRRIGATION_MAX_ZONES + 1]; /* Time of the last change of every output bit. */
+    uint32_t violations;                    /* Interlock or capacity violations. */
+} test_farm_t;
+
+/**
+ * @brief  Set up the controller with every zone configured and the soil at the given moisture.
+ */
+static void test_farm_init(test_farm_t *farm, uint32_t start_ms, int32_t moisture)
+{
+    memset(farm, 0, sizeof(*farm));
+    irrigation_init(&farm->ctrl, &test_pump);
+
+    for (uint32_t zone = 0; zone < IRRIGATION_MAX_ZONES; zone++)
+    {
+        TEST_CHECK(irrigation_set_zone(&farm->ctrl, zone, &test_zone));
+        farm->moisture[zone] = moisture;
+        farm->probe[zone] = true;
+        farm->wets[zone] = true;
+    }
+    farm->now = start_ms;
+}
+/**
+ * @brief  Run the simulation for a time, checking the interlock and the pump capacity on every tick.
+ */
+static void test_farm_run(test_farm_t *farm, uint32_t duration_ms)
+{
+    for (uint32_t elapsed = 0; elapsed < duration_ms; elapsed += TEST_TICK_MS)
+    {
+        uint32_t outputs = irrigation_outputs(&farm->ctrl);
+        uint32_t changed = 0;
+
+        for (uint32_t zone = 0; zone < IRRIGATION_MAX_ZONES; zone++)
+        {
+            bool wet = (outputs & IRRIGATION_ZONE_BIT(zone)) && farm->wets[zone];
+
+            farm->moisture[zone] += wet ? TEST_WET_RATE : -TEST_DRY_RATE;
+            if (farm->probe[zone] && ((elapsed % TEST_SAMPLE_MS) == 0))
+            {
+                irrigation_set_moisture(&farm->ctrl, zone, farm->moisture[zone], farm->now);
+            }
+        }
+
+        changed = irrigation_evaluate(&farm->ctrl, farm->now);
+        TEST_CHECK_EQUAL(changed, outputs ^ irrigation_outputs(&farm->ctrl));
+
+        outputs = irrigation_outputs(&farm->ctrl);
+        for (uint32_t bit = 0; bit <= IRRIGATION_MAX_ZONES; bit++)
+        {
+            if (changed & (1UL << bit))
+            {
+                farm->switched[bit] = farm->now;
+            }
+        }
+
+        /* The pump runs exactly while a valve is open, and feeds at most max_open_zones. */
+        if ((((outputs & TEST_ZONE_MASK) != 0) != ((outputs & IRRIGATION_PUMP_BIT) != 0)) ||
+            (__builtin_popcount(outputs & TEST_ZONE_MASK) > (int)test_pump.max_open_zones))
+        {
+            farm->violations++;
+        }
+
+        farm->now += TEST_TICK_MS;
+    }
+}
+/**
+ * @brief  Dry soil is watered back into the band, no zone runs dry and the interlock always holds.
+ */
+static void test_band(void)
+{
+    test_farm_t farm;
+    int32_t low = INT32_MAX;
+    int32_t high = INT32_MIN;
+
+    test_farm_init(&farm, 0, 3200);
+    farm.moisture[1] = 2600;
+    farm.moisture[2] = 3900;
+
+    /* Settle, then watch the band for a day. */
+    test_farm_run(&farm, 3600 * 1000U);
+    for (uint32_t hour = 0; hour < 24; hour++)
+    {
+        for (uint32_t minute = 0; minute < 60; minute++)
+        {
+            test_farm_run(&farm, 60 * 1000U);
+            for (uint32_t zone = 0; zone < IRRIGATION_MAX_ZONES; zone++)
+            {
+                low = (farm.moisture[zone] < low) ? farm.moisture[zone] : low;
+                high = (farm.moisture[zone] > high) ? farm.moisture[zone] : high;
+            }
+        }
+    }
+
+    TEST_CHECK_EQUAL(0, farm.violations);
+    /* One sample period of drying below on_below, one of wetting above off_above. */
+    TEST_CHECK(low >= test_zone.on_below - (int32_t)(TEST_SAMPLE_MS / TEST_TICK_MS) * TEST_DRY_RATE - TEST_DRY_RATE);
+    TEST_CHECK(high <= test_zone.off_above + (int32_t)(TEST_SAMPLE_MS / TEST_TICK_MS) * TEST_WET_RATE + TEST_WET_RATE);
+}
+/**
+ * @brief  Three dry zones share a pump of two, the driest ones go first.
+ */
+static void test_capacity(void)
+{
+    test_farm_t farm;
+
+    test_farm_init(&farm, 0, 2900);
+    farm.moisture[0] = 2950;
+    farm.moisture[1] = 2500;
+    farm.moisture[2] = 2700;
+
+    test_farm_run(&farm, TEST_TICK_MS);
+
+    TEST_CHECK_EQUAL(IRRIGATION_ZONE_BIT(1) | IRRIGATION_ZONE_BIT(2) | IRRIGATION_PUMP_BIT, irrigation_outputs(&farm.ctrl));
+    TEST_CHECK_EQUAL(0, farm.violations);
+}
+/**
+ * @brief  Hysteresis: a wet zone stays closed, a valve keeps its minimum on time even once the probe is wet.
+ */
+static void test_min_on(void)
+{
+    irrigation_t ctrl;
+    irrigation_zone_config_t zone = test_zone;
+
+    irrigation_init(&ctrl, &test_pump);
+    TEST_CHECK(irrigation_set_zone(&ctrl, 0, &zone));
+
+    irrigation_set_moisture(&ctrl, 0, 3500, 0);
+    TEST_CHECK_EQUAL(0, irrigation_evaluate(&ctrl, 0));
+
+    irrigation_set_moisture(&ctrl, 0, 3000, 1000);
+    TEST_CHECK_EQUAL(IRRIGATION_ZONE_BIT(0) | IRRIGATION_PUMP_BIT, irrigation_evaluate(&ctrl, 1000));
+
+    /* Wet already, but within min_on. */
+    irrigation_set_moisture(&ctrl, 0, 4100, 2000);
+    TEST_CHECK_EQUAL(0, irrigation_evaluate(&ctrl, 2000));
+    irrigation_set_moisture(&ctrl, 0, 4100, 1000 + zone.min_on_ms - 1);
+    TEST_CHECK_EQUAL(0, irrigation_evaluate(&ctrl, 1000 + zone.min_on_ms - 1));
+    TEST_CHECK_EQUAL(IRRIGATION_ZONE_BIT(0) | IRRIGATION_PUMP_BIT, irrigation_evaluate(&ctrl, 1000 + zone.min_on_ms));
+
+    /* Dry again right away, but within min_off. */
+    irrigation_set_moisture(&ctrl, 0, 2000, 1000 + zone.min_on_ms + 1000);
+    TEST_CHECK_EQUAL(0, irrigation_evaluate(&ctrl, 1000 + zone.min_on_ms + 1000));
+}
+/**
+ * @brief  A probe that never sees the water closes the valve at max_on_ms.
+ */
+static void test_max_on(void)
+{
+    test_farm_t farm;
+
+    test_farm_init(&farm, 0, 2900);
+    farm.wets[0] = false;
+    farm.moisture[1] = 3500;
+    farm.moisture[2] = 3500;
+
+    test_farm_run(&farm, TEST_TICK_MS);
+    TEST_CHECK(irrigation_outputs(&farm.ctrl) & IRRIGATION_ZONE_BIT(0));
+
+    test_farm_run(&farm, test_zone.max_on_ms);
+    TEST_CHECK(!(irrigation_outputs(&farm.ctrl) & IRRIGATION_ZONE_BIT(0)));
+    TEST_CHECK_EQUAL(test_zone.max_on_ms, farm.switched[0]);
+    TEST_CHECK_EQUAL(0, farm.violations);
+}
+/**
+ * @brief  A probe that stops sampling closes its valve at the sample timeout, even within min_on.
+ */
+static void test_stale_probe(void)
+{
+    test_farm_t farm;
+    irrigation_zone_config_t zone = test_zone;
+
+    test_farm_init(&farm, 0, 2900);
+    zone.min_on_ms = 10 * 60 * 1000U;
+    TEST_CHECK(irrigation_set_zone(&farm.ctrl, 0, &zone));
+    farm.moisture[1] = 3500;
+    farm.moisture[2] = 3500;
+
+    test_farm_run(&farm, TEST_TICK_MS);
+    TEST_CHECK(irrigation_outputs(&farm.ctrl) & IRRIGATION_ZONE_BIT(0));
+
+    farm.probe[0] = false;
+    test_farm_run(&farm, test_pump.sample_timeout_ms + TEST_TICK_MS);
+    TEST_CHECK_EQUAL(0, irrigation_outputs(&farm.ctrl));
+    TEST_CHECK(farm.switched[0] < zone.min_on_ms);
+
+    /* Never reopened without a fresh sample. */
+    test_farm_run(&farm, zone.min_off_ms * 2);
+    TEST_CHECK(!(irrigation_outputs(&farm.ctrl) & IRRIGATION_ZONE_BIT(0)));
+}
+/**
+ * @brief  The pump keeps its restart delay, no valve opens before it elapsed.
+ */
+static void test_pump_restart(void)
+{
+    irrigation_t ctrl;
+    irrigation_zone_config_t zone = test_zone;
+
+    zone.min_on_ms = 0;
+    zone.min_off_ms = 0;
+    irrigation_init(&ctrl, &test_pump);
+    TEST_CHECK(irrigation_set_zone(&ctrl, 0, &zone));
+    TEST_CHECK(irrigation_set_zone(&ctrl, 1, &zone));
+
+    irrigation_set_moisture(&ctrl, 0, 2000, 0);
+    irrigation_set_moisture(&ctrl, 1, 3500, 0);
+    irrigation_evaluate(&ctrl, 0);
+    irrigation_set_moisture(&ctrl, 0, 4000, 1000);
+    TEST_CHECK_EQUAL(IRRIGATION_ZONE_BIT(0) | IRRIGATION_PUMP_BIT, irrigation_evaluate(&ctrl, 1000));
+
+    irrigation_set_moisture(&ctrl, 1, 2000, 2000);
+    TEST_CHECK_EQUAL(0, irrigation_evaluate(&ctrl, 2000));
+    TEST_CHECK_EQUAL(0, irrigation_evaluate(&ctrl, 1000 + test_pump.pump_min_off_ms - 1));
+    irrigation_set_moisture(&ctrl, 1, 2000, 1000 + test_pump.pump_min_off_ms);
+    TEST_CHECK_EQUAL(IRRIGATION_ZONE_BIT(1) | IRRIGATION_PUMP_BIT, irrigation_evaluate(&ctrl, 1000 + test_pump.pump_min_off_ms));
+}
+/**
+ * @brief  A manual valve is closed by the controller and left alone, the other zones keep their control.
+ */
+static void test_manual_zone(void)
+{
+    test_farm_t farm;
+
+    test_farm_init(&farm, 0, 2900);
+    farm.moisture[2] = 3500;
+    test_farm_run(&farm, TEST_TICK_MS);
+    TEST_CHECK_EQUAL(IRRIGATION_ZONE_BIT(0) | IRRIGATION_ZONE_BIT(1) | IRRIGATION_PUMP_BIT, irrigation_outputs(&farm.ctrl));
+
+    irrigation_set_manual(&farm.ctrl, IRRIGATION_ZONE_BIT(0), farm.now);
+    TEST_CHECK_EQUAL(IRRIGATION_ZONE_BIT(1) | IRRIGATION_PUMP_BIT, irrigation_outputs(&farm.ctrl));
+
+    /* Zone1 stays dry but is never reopened, zone2 still opens when it dries. */
+    farm.wets[0] = false;
+    test_farm_run(&farm, 12 * 3600 * 1000U);
+    TEST_CHECK(!(irrigation_outputs(&farm.ctrl) & IRRIGATION_ZONE_BIT(0)));
+    TEST_CHECK(farm.switched[2] > 0);
+    TEST_CHECK(farm.moisture[1] >= test_zone.on_below - 10);
+    TEST_CHECK(farm.moisture[2] >= test_zone.on_below - 10);
+    TEST_CHECK_EQUAL(0, farm.violations);
+
+    /* Handed back, the dry zone is watered again. */
+    irrigation_set_manual(&farm.ctrl, 0, farm.now);
+    test_farm_run(&farm, 2 * TEST_SAMPLE_MS);
+    TEST_CHECK(irrigation_outputs(&farm.ctrl) & IRRIGATION_ZONE_BIT(0));
+}
+/**
+ * @brief  A manual pump closes every zone, the controller restarts the pump only after its delay once handed back.
+ */
+static void test_manual_pump(void)
+{
+    test_farm_t farm;
+    uint32_t released = 0;
+
+    test_farm_init(&farm, 0, 2900);
+    test_farm_run(&farm, TEST_TICK_MS);
+    TEST_CHECK(irrigation_outputs(&farm.ctrl) & IRRIGATION_PUMP_BIT);
+
+    irrigation_set_manual(&farm.ctrl, IRRIGATION_PUMP_BIT, farm.now);
+    test_farm_run(&farm, TEST_TICK_MS);
+    TEST_CHECK_EQUAL(0, irrigation_outputs(&farm.ctrl));
+
+    test_farm_run(&farm, 3600 * 1000U);
+    TEST_CHECK_EQUAL(0, irrigation_outputs(&farm.ctrl));
+
+    released = farm.now;
+    irrigation_set_manual(&farm.ctrl, 0, farm.now);
+    test_farm_run(&farm, test_pump.pump_min_off_ms + TEST_TICK_MS);
+    TEST_CHECK(irrigation_outputs(&farm.ctrl) & IRRIGATION_PUMP_BIT);
+    TEST_CHECK(farm.switched[IRRIGATION_MAX_ZONES] >= released);
+    TEST_CHECK_EQUAL(0, farm.violations);
+}
+/**
+ * @brief  The minimum times and the timeouts survive a wrap of the ms counter.
+ */
+static void test_wrap(void)
+{
+    test_farm_t farm;
+
+    test_farm_init(&farm, UINT32_MAX - 10 * 60 * 1000U, 3200);
+    farm.moisture[0] = 2900;
+    test_farm_run(&farm, 24 * 3600 * 1000U);
+
+    TEST_CHECK_EQUAL(0, farm.violations);
+    for (uint32_t zone = 0; zone < IRRIGATION_MAX_ZONES; zone++)
+    {
+        TEST_CHECK(farm.moisture[zone] >= test_zone.on_below - 10);
+        TEST_CHECK(farm.moisture[zone] <= test_zone.off_above + 20);
+    }
+}
+/**
+ * @brief  Zone commands parse to the parameters, malformed ones are rejected.
+ */
+static void test_parse(void)
+{
+    static const char *const malformed[] = {
+        "4,1,3000,4000,60,600,1800",    /* Unknown zone. */
+        "0,1,3000,4000,60,600,1800",    /* Zones start from 1. */
+        "1,2,3000,4000,60,600,1800",    /* enabled is 0 or 1. */
+        "1,1,3000,4000,60,600",         /* Missing field. */
+        "1,1,3000,4000,60,600,1800,1",  /* Extra field. */
+        "1,1,-3000,4000,60,600,1800",   /* Negative. */
+        "1,1,3000,4000,60,600,9999999", /* Out of range. */
+    };
+    static const char command[] = "2, 1, 3000, 4000, 60, 600, 1800\r\n";
+    irrigation_zone_config_t config;
+
+    TEST_CHECK_EQUAL(1, irrigation_parse_zone(command, sizeof(command) - 1, &config));
+    TEST_CHECK(config.enabled);
+    TEST_CHECK_EQUAL(3000, config.on_below);
+    TEST_CHECK_EQUAL(4000, config.off_above);
+    TEST_CHECK_EQUAL(60 * 1000, config.min_on_ms);
+    TEST_CHECK_EQUAL(600 * 1000, config.min_off_ms);
+    TEST_CHECK_EQUAL(1800 * 1000, config.max_on_ms);
+
+    for (size_t i = 0; i < sizeof(malformed) / sizeof(malformed[0]); i++)
+    {
+        TEST_CHECK_EQUAL(-1, irrigation_parse_zone(malformed[i], strlen(malformed[i]), &config));
+    }
+}
+/**
+ * @brief  Inconsistent zone parameters are refused.
+ */
+static void test_set_zone_invalid(void)
+{
+    irrigation_t ctrl;
+    irrigation_zone_config_t zone = test_zone;
+
+    irrigation_init(&ctrl, &test_pump);
+    TEST_CHECK(!irrigation_set_zone(&ctrl, IRRIGATION_MAX_ZONES, &zone));
+
+    zone.off_above = zone.on_below;
+    TEST_CHECK(!irrigation_set_zone(&ctrl, 0, &zone));
+
+    zone = test_zone;
+    zone.max_on_ms = zone.min_on_ms - 1;
+    TEST_CHECK(!irrigation_set_zone(&ctrl, 0, &zone));
+}
+
+int main(void)
+{
+    TEST_CASE(test_band);
+    TEST_CASE(test_capacity);
+    TEST_CASE(test_min_on);
+    TEST_CASE(test_max_on);
+    TEST_CASE(test_stale_probe);
+    TEST_CASE(test_pump_restart);
+    TEST_CASE(test_manual_zone);
+    TEST_CASE(test_manual_pump);
+    TEST_CASE(test_wrap);
+    TEST_CASE(test_parse);
+    TEST_CASE(test_set_zone_invalid);
+
+    return TEST_RESULT();
+}
+/******************************** End of File *********************************/
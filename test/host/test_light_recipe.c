@@ -0,0 +1,252 @@
+/**
+ *****************************************************************************
+ * @file    : test_light_recipe.c
+ * @brief   : Host tests of the grow light recipe engine
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *****************************************************************************
+ */
+
+#include <string.h>
+
+#include "test_host.h"
+#include "user_light_recipe.h"
+
+/** @brief Recipe frame period, 20 frames per second. */
+#define TEST_FRAME_MS       (50U)
+
+/** @brief Sunrise, day, sunset and night, the brightness wraps past midnight. */
+static const light_recipe_keyframe_t test_day[] = {
+    { 6 * 60, { 0, 255, 120, 40 } },
+    { 7 * 60, { 200, 255, 255, 255 } },
+    { 19 * 60, { 200, 255, 255, 255 } },
+    { 20 * 60 + 30, { 10, 255, 60, 0 } },
+};
+
+#define TEST_DAY_COUNT      ((int)(sizeof(test_day) / sizeof(test_day[0])))
+
+/**
+ * @brief  Exact interpolated value of a component at a time of the day, rounded to nearest.
+ */
+static int test_expected(const light_recipe_keyframe_t *keyframes, int count, int component, uint32_t ms_of_day)
+{
+    int segment = count - 1;
+
+    for (int i = 0; i < count; i++)
+    {
+        if ((uint32_t)keyframes[i].minute * 60000U <= ms_of_day)
+        {
+            segment = i;
+        }
+    }
+
+    int next = (segment + 1) % count;
+    int64_t start = (int64_t)keyframes[segment].minute * 60000;
+    int64_t end = (int64_t)keyframes[next].minute * 60000;
+    int64_t length = (end > start) ? (end - start) : (end + LIGHT_RECIPE_MS_PER_DAY - start);
+    int64_t elapsed = ((int64_t)ms_of_day - start + LIGHT_RECIPE_MS_PER_DAY) % LIGHT_RECIPE_MS_PER_DAY;
+    int64_t from = keyframes[segment].value[component];
+    int64_t to = keyframes[next].value[component];
+
+    /* from + (to - from) * elapsed / length, rounded half up like the engine, with a floor division. */
+    int64_t numerator = (to - from) * elapsed * 2 + length;
+    int64_t quotient = numerator / (2 * length);
+
+    if ((numerator % (2 * length)) < 0)
+    {
+        quotient--;
+    }
+
+    return (int)(from + quotient);
+}
+/**
+ * @brief  A valid payload parses to its keyframes, separators and blanks are tolerated.
+ */
+static void test_parse_valid(void)
+{
+    static const char payload[] = "360,0,255,120,40; 420,200,255,255,255;\r\n1230,10,255,60,0;";
+    light_recipe_keyframe_t keyframes[LIGHT_RECIPE_MAX_KEYFRAMES];
+
+    TEST_CHECK_EQUAL(3, light_recipe_parse(payload, sizeof(payload) - 1, keyframes, LIGHT_RECIPE_MAX_KEYFRAMES));
+    TEST_CHECK_EQUAL(360, keyframes[0].minute);
+    TEST_CHECK_EQUAL(0, keyframes[0].value[0]);
+    TEST_CHECK_EQUAL(40, keyframes[0].value[3]);
+    TEST_CHECK_EQUAL(420, keyframes[1].minute);
+    TEST_CHECK_EQUAL(200, keyframes[1].value[0]);
+    TEST_CHECK_EQUAL(1230, keyframes[2].minute);
+    TEST_CHECK_EQUAL(60, keyframes[2].value[2]);
+
+    TEST_CHECK_EQUAL(0, light_recipe_parse("", 0, keyframes, LIGHT_RECIPE_MAX_KEYFRAMES));
+}
+/**
+ * @brief  Malformed payloads are rejected as a whole.
+ */
+static void test_parse_malformed(void)
+{
+    static const char *const payloads[] = {
+        "360,0,255,120",            /* Missing component. */
+        "360,0,255,120,40,1",       /* Extra component. */
+        "360,0,256,120,40",         /* Component out of range. */
+        "1440,0,255,120,40",        /* Minute out of range. */
+        "360,,255,120,40",          /* Empty field. */
+        "360,0,255,120,4a",         /* Not a number. */
+        "99999999,0,0,0,0",         /* Overflow. */
+    };
+    light_recipe_keyframe_t keyframes[LIGHT_RECIPE_MAX_KEYFRAMES];
+
+    for (size_t i = 0; i < sizeof(payloads) / sizeof(payloads[0]); i++)
+    {
+        TEST_CHECK_EQUAL(-1, light_recipe_parse(payloads[i], strlen(payloads[i]), keyframes, LIGHT_RECIPE_MAX_KEYFRAMES));
+    }
+
+    /* More keyframes than the caller can hold. */
+    TEST_CHECK_EQUAL(-1, light_recipe_parse("1,0,0,0,0;2,0,0,0,0;3,0,0,0,0", 29, keyframes, 2));
+}
+/**
+ * @brief  Unsorted keyframes and a zero frame period are rejected.
+ */
+static void test_init_invalid(void)
+{
+    light_recipe_keyframe_t keyframes[2] = { test_day[1], test_day[0] };
+    light_recipe_t recipe;
+
+    TEST_CHECK(!light_recipe_init(&recipe, keyframes, 2, TEST_FRAME_MS));
+
+    keyframes[1] = keyframes[0];
+    TEST_CHECK(!light_recipe_init(&recipe, keyframes, 2, TEST_FRAME_MS));
+
+    TEST_CHECK(!light_recipe_init(&recipe, test_day, TEST_DAY_COUNT, 0));
+    TEST_CHECK(!light_recipe_init(&recipe, test_day, LIGHT_RECIPE_MAX_KEYFRAMES + 1, TEST_FRAME_MS));
+    TEST_CHECK(light_recipe_init(&recipe, test_day, TEST_DAY_COUNT, TEST_FRAME_MS));
+}
+/**
+ * @brief  Seeking lands on the interpolated value, before the first keyframe it wraps from the last one.
+ */
+static void test_seek(void)
+{
+    static const uint32_t times[] = {
+        0,                              /* Night, segment of the previous day. */
+        6 * 3600000U,                   /* On a keyframe. */
+        6 * 3600000U + 30 * 60000U,     /* Middle of the sunrise. */
+        12 * 3600000U,                  /* Flat day segment. */
+        20 * 3600000U,                  /* Sunset. */
+        LIGHT_RECIPE_MS_PER_DAY - 1,    /* Just before midnight. */
+    };
+    light_recipe_t recipe;
+
+    TEST_CHECK(light_recipe_init(&recipe, test_day, TEST_DAY_COUNT, TEST_FRAME_MS));
+
+    for (size_t i = 0; i < sizeof(times) / sizeof(times[0]); i++)
+    {
+        light_recipe_seek(&recipe, times[i]);
+        for (int c = 0; c < LIGHT_RECIPE_COMPONENTS; c++)
+        {
+            TEST_CHECK_EQUAL(test_expected(test_day, TEST_DAY_COUNT, c, times[i]), recipe.output[c]);
+        }
+    }
+
+    light_recipe_seek(&recipe, 6 * 3600000U + 30 * 60000U);
+    TEST_CHECK_EQUAL(100, recipe.output[0]);
+}
+/**
+ * @brief  A whole day of steps follows the exact line within one count and lands exactly on every keyframe.
+ */
+static void test_step_drift(void)
+{
+    light_recipe_t recipe;
+    uint32_t frames = LIGHT_RECIPE_MS_PER_DAY / TEST_FRAME_MS;
+    int max_error = 0;
+    int landed = 0;
+
+    TEST_CHECK(light_recipe_init(&recipe, test_day, TEST_DAY_COUNT, TEST_FRAME_MS));
+    light_recipe_seek(&recipe, 0);
+
+    for (uint32_t frame = 1; frame <= frames; frame++)
+    {
+        uint32_t ms_of_day = (frame * TEST_FRAME_MS) % LIGHT_RECIPE_MS_PER_DAY;
+        bool keyframe = false;
+
+        light_recipe_step(&recipe);
+
+        for (int k = 0; k < TEST_DAY_COUNT; k++)
+        {
+            keyframe |= ((uint32_t)test_day[k].minute * 60000U == ms_of_day);
+        }
+
+        for (int c = 0; c < LIGHT_RECIPE_COMPONENTS; c++)
+        {
+            int error = recipe.output[c] - test_expected(test_day, TEST_DAY_COUNT, c, ms_of_day);
+
+            error = (error < 0) ? -error : error;
+            max_error = (error > max_error) ? error : max_error;
+            if (keyframe && (error != 0))
+            {
+                TEST_CHECK_EQUAL(test_expected(test_day, TEST_DAY_COUNT, c, ms_of_day), recipe.output[c]);
+            }
+        }
+        landed += keyframe;
+    }
+
+    TEST_CHECK(max_error <= 1);
+    TEST_CHECK_EQUAL(TEST_DAY_COUNT, landed);
+
+    /* Back at midnight without any correction. */
+    for (int c = 0; c < LIGHT_RECIPE_COMPONENTS; c++)
+    {
+        TEST_CHECK_EQUAL(test_expected(test_day, TEST_DAY_COUNT, c, 0), recipe.output[c]);
+    }
+}
+/**
+ * @brief  A flat segment never reports a change, a ramp reports one per output count.
+ */
+static void test_step_changes(void)
+{
+    light_recipe_t recipe;
+    uint32_t changes = 0;
+
+    TEST_CHECK(light_recipe_init(&recipe, test_day, TEST_DAY_COUNT, TEST_FRAME_MS));
+
+    light_recipe_seek(&recipe, 8 * 3600000U);
+    for (uint32_t frame = 0; frame < 3600000U / TEST_FRAME_MS; frame++)
+    {
+        changes += light_recipe_step(&recipe);
+    }
+    TEST_CHECK_EQUAL(0, changes);
+
+    /* Sunrise: brightness 0 to 200 and green 120 to 255 change together at most once per frame. */
+    light_recipe_seek(&recipe, 6 * 3600000U);
+    for (uint32_t frame = 0; frame < 3600000U / TEST_FRAME_MS; frame++)
+    {
+        changes += light_recipe_step(&recipe);
+    }
+    TEST_CHECK(changes >= 200);
+    TEST_CHECK(changes <= 200 + 135 + 215);
+    TEST_CHECK_EQUAL(200, recipe.output[0]);
+}
+/**
+ * @brief  An empty recipe neither steps nor changes its output.
+ */
+static void test_empty(void)
+{
+    light_recipe_t recipe;
+
+    TEST_CHECK(light_recipe_init(&recipe, NULL, 0, TEST_FRAME_MS));
+    light_recipe_seek(&recipe, 12 * 3600000U);
+    TEST_CHECK(!light_recipe_step(&recipe));
+    TEST_CHECK_EQUAL(0, recipe.output[0]);
+}
+
+int main(void)
+{
+    TEST_CASE(test_parse_valid);
+    TEST_CASE(test_parse_malformed);
+    TEST_CASE(test_init_invalid);
+    TEST_CASE(test_seek);
+    TEST_CASE(test_step_drift);
+    TEST_CASE(test_step_changes);
+    TEST_CASE(test_empty);
+
+    return TEST_RESULT();
+}
+/******************************** End of File *********************************/
@@ -0,0 +1,739 @@
+/**
+ *****************************************************************************
+ * @file    : test_modbus_master.c
+ * @brief   : Host tests of the Modbus RTU/ASCII master polling engine
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *
+ * @note The master polls simulated slaves on a mock serial bus. The bus decodes
+ *       every request, answers it from the register bank of the slave and moves
+ *       the clock by the response latency and the time on the wire.
+ *****************************************************************************
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_host.h"
+#include "user_modbus_master.h"
+
+/** @brief Bus speed of user_esp32_modbus.c. */
+#define TEST_BAUD_RATE          (9600U)
+
+/** @brief Requests kept by the bus. */
+#define TEST_REQUEST_MAX        (64)
+
+/** @brief Fault of a simulated slave. */
+typedef enum
+{
+    TEST_FAULT_NONE,
+    TEST_FAULT_SILENT,      /* No response. */
+    TEST_FAULT_CORRUPT,     /* Response with a bad checksum. */
+    TEST_FAULT_EXCEPTION    /* Exception response, illegal data address. */
+} test_fault_t;
+
+/** @brief Simulated slave. */
+typedef struct
+{
+    uint8_t address;
+    uint16_t holding[64];
+    uint16_t input[64];
+    uint64_t holding_holes; /* Holding registers the slave does not have, one bit per register. */
+    uint32_t latency_ms;
+    test_fault_t fault;
+} test_slave_t;
+
+/** @brief Read request seen on the bus. */
+typedef struct
+{
+    uint8_t slave;
+    uint8_t function;
+    uint16_t address;
+    uint16_t count;
+} test_request_t;
+
+/** @brief Mock serial bus. */
+typedef struct
+{
+    user_modbus_mode_t mode;
+    uint32_t char_us;
+    uint32_t now_ms;
+    test_slave_t *slaves;
+    int slave_count;
+    uint8_t response[USER_MODBUS_FRAME_MAX_LENGTH];
+    size_t response_length;
+    uint32_t latency_ms;                        /* Latency of the pending response. */
+    uint32_t timed_out_ms;                      /* Time the last receive timed out. */
+    uint32_t last_timeout_ms;                   /* Timeout of the last receive. */
+    uint32_t last_gap_us;                       /* Silent interval of the last receive. */
+    int requests;
+    test_request_t log[TEST_REQUEST_MAX];      /* Last requests, by request number modulo TEST_REQUEST_MAX. */
+} test_bus_t;
+
+/** @brief Registers received by a point handler. */
+typedef struct
+{
+    int calls;
+    uint16_t regs[8];
+} test_capture_t;
+
+/**
+ * @brief  Frame an ADU like the slave would, with a CRC-16 or a LRC.
+ */
+static size_t test_frame(user_modbus_mode_t mode, uint8_t *adu, size_t length, uint8_t *frame, bool corrupt)
+{
+    static const char hex[] = "0123456789ABCDEF";
+
+    if (mode == USER_MODBUS_MODE_RTU)
+    {
+        uint16_t crc = user_modbus_crc16(adu, length);
+
+        memcpy(frame, adu, length);
+        frame[length++] = (uint8_t)crc;
+        frame[length++] = (uint8_t)((crc >> 8) ^ (corrupt ? 0x01U : 0U));
+
+        return length;
+    }
+
+    size_t out = 0;
+
+    adu[length] = (uint8_t)(user_modbus_lrc(adu, length) ^ (corrupt ? 0x01U : 0U));
+    frame[out++] = ':';
+    for (size_t i = 0; i <= length; i++)
+    {
+        frame[out++] = hex[adu[i] >> 4];
+        frame[out++] = hex[adu[i] & 0x0F];
+    }
+    frame[out++] = '\r';
+    frame[out++] = '\n';
+
+    return out;
+}
+/**
+ * @brief  Decode a request frame, checking its framing, return false if it is not a valid read request.
+ */
+static bool test_decode(user_modbus_mode_t mode, const uint8_t *frame, size_t length, uint8_t *adu)
+{
+    if (mode == USER_MODBUS_MODE_RTU)
+    {
+        if ((length != 8) || (user_modbus_crc16(frame, length) != 0))
+        {
+            return false;
+        }
+        memcpy(adu, frame, 6);
+
+        return true;
+    }
+
+    if ((length != USER_MODBUS_REQUEST_MAX_LENGTH) || (frame[0] != ':') || (frame[15] != '\r') || (frame[16] != '\n'))
+    {
+        return false;
+    }
+    for (size_t i = 0; i < 7; i++)
+    {
+        char digits[3] = { (char)frame[1 + 2 * i], (char)frame[2 + 2 * i], '\0' };
+
+        adu[i] = (uint8_t)strtoul(digits, NULL, 16);
+    }
+
+    return user_modbus_lrc(adu, 7) == 0;
+}
+
+static esp_err_t test_bus_send(void *ctx, const uint8_t *frame, size_t length)
+{
+    test_bus_t *bus = (test_bus_t *)ctx;
+    uint8_t adu[USER_MODBUS_FRAME_MAX_LENGTH];
+    test_slave_t *slave = NULL;
+
+    bus->response_length = 0;
+    /* The request is on the wire before the master starts its timeout. */
+    bus->now_ms += (uint32_t)((length * bus->char_us + 999U) / 1000U);
+
+    TEST_CHECK(test_decode(bus->mode, frame, length, adu));
+
+    test_request_t request = {
+        adu[0], adu[1], (uint16_t)((adu[2] << 8) | adu[3]), (uint16_t)((adu[4] << 8) | adu[5])
+    };
+    bus->log[bus->requests % TEST_REQUEST_MAX] = request;
+    bus->requests++;
+
+    for (int i = 0; i < bus->slave_count; i++)
+    {
+        if (bus->slaves[i].address == request.slave)
+        {
+            slave = &bus->slaves[i];
+        }
+    }
+    if ((slave == NULL) || (slave->fault == TEST_FAULT_SILENT))
+    {
+        return ESP_OK;
+    }
+
+    /* A read touching a register the slave does not have gets an illegal data address exception. */
+    bool hole = false;
+    for (uint16_t i = 0; (request.function == USER_MODBUS_READ_HOLDING_REGISTERS) && (i < request.count) && (request.address + i < 64); i++)
+    {
+        hole |= ((slave->holding_holes >> (request.address + i)) & 1U) != 0;
+    }
+
+    size_t adu_length = 0;
+    adu[adu_length++] = slave->address;
+    if ((slave->fault == TEST_FAULT_EXCEPTION) || hole)
+    {
+        adu[adu_length++] = request.function | 0x80U;
+        adu[adu_length++] = 0x02;
+    }
+    else
+    {
+        const uint16_t *bank = (request.function == USER_MODBUS_READ_INPUT_REGISTERS) ? slave->input : slave->holding;
+
+        TEST_CHECK(request.address + request.count <= 64);
+        adu[adu_length++] = request.function;
+        adu[adu_length++] = (uint8_t)(2 * request.count);
+        for (uint16_t i = 0; i < request.count; i++)
+        {
+            adu[adu_length++] = (uint8_t)(bank[request.address + i] >> 8);
+            adu[adu_length++] = (uint8_t)bank[request.address + i];
+        }
+    }
+
+    bus->response_length = test_frame(bus->mode, adu, adu_length, bus->response, slave->fault == TEST_FAULT_CORRUPT);
+    bus->latency_ms = slave->latency_ms;
+
+    return ESP_OK;
+}
+
+static int test_bus_receive(void *ctx, uint8_t *frame, size_t size, uint32_t timeout_ms, uint32_t gap_us)
+{
+    test_bus_t *bus = (test_bus_t *)ctx;
+    uint32_t wire_ms = (uint32_t)((bus->response_length * bus->char_us + 999U) / 1000U);
+
+    bus->last_timeout_ms = timeout_ms;
+    bus->last_gap_us = gap_us;
+
+    if ((bus->response_length == 0) || (bus->latency_ms + wire_ms > timeout_ms) || (bus->response_length > size))
+    {
+        bus->now_ms += timeout_ms;
+        bus->timed_out_ms = bus->now_ms;
+        return 0;
+    }
+
+    bus->now_ms += bus->latency_ms + wire_ms;
+    memcpy(frame, bus->response, bus->response_length);
+
+    return (int)bus->response_length;
+}
+
+static uint32_t test_bus_clock(void *ctx)
+{
+    return ((test_bus_t *)ctx)->now_ms;
+}
+
+static void test_capture(const user_modbus_point_t *point, const uint16_t *regs)
+{
+    test_capture_t *capture = (test_capture_t *)point->arg;
+
+    capture->calls++;
+    memcpy(capture->regs, regs, point->count * sizeof(regs[0]));
+}
+/**
+ * @brief  Set up a bus and a master polling it.
+ */
+static esp_err_t test_master_init(user_modbus_master_t *master, test_bus_t *bus, user_modbus_mode_t mode,
+                                  test_slave_t *slaves, int slave_count,
+                                  const user_modbus_slave_config_t *configs, int config_count,
+                                  const user_modbus_point_t *points, int point_count)
+{
+    user_modbus_transport_t transport = {
+        .send = test_bus_send,
+        .receive = test_bus_receive,
+        .clock_ms = test_bus_clock,
+        .ctx = bus,
+    };
+
+    memset(bus, 0, sizeof(*bus));
+    bus->mode = mode;
+    bus->char_us = (USER_MODBUS_CHAR_BITS * 1000000U + TEST_BAUD_RATE - 1) / TEST_BAUD_RATE;
+    bus->now_ms = 1000;
+    bus->slaves = slaves;
+    bus->slave_count = slave_count;
+
+    return user_modbus_master_init(master, mode, TEST_BAUD_RATE, &transport, configs, config_count,
+                                   points, point_count);
+}
+/**
+ * @brief  Fill the register banks of a slave with values telling the slave, bank and register apart.
+ */
+static void test_slave_init(test_slave_t *slave, uint8_t address, uint32_t latency_ms)
+{
+    memset(slave, 0, sizeof(*slave));
+    slave->address = address;
+    slave->latency_ms = latency_ms;
+    for (uint16_t i = 0; i < 64; i++)
+    {
+        slave->holding[i] = (uint16_t)((address << 12) | i);
+        slave->input[i] = (uint16_t)((address << 12) | 0x800U | i);
+    }
+}
+/**
+ * @brief  Checksums match the reference frames of the Modbus specification.
+ */
+static void test_checksums(void)
+{
+    static const uint8_t request[] = { 0x01, 0x03, 0x00, 0x00, 0x00, 0x0A };
+    uint8_t frame[8];
+
+    TEST_CHECK_EQUAL(0xCDC5, user_modbus_crc16(request, sizeof(request)));
+    TEST_CHECK_EQUAL(0xF2, user_modbus_lrc(request, sizeof(request)));
+    TEST_CHECK_EQUAL(0xFFFF, user_modbus_crc16(request, 0));
+
+    /* A frame with its CRC, low byte first, checks to 0. */
+    memcpy(frame, request, sizeof(request));
+    frame[6] = 0xC5;
+    frame[7] = 0xCD;
+    TEST_CHECK_EQUAL(0, user_modbus_crc16(frame, sizeof(frame)));
+    frame[3] ^= 0x10;
+    TEST_CHECK(user_modbus_crc16(frame, sizeof(frame)) != 0);
+}
+/**
+ * @brief  Adjacent points of a slave and function share a read, gaps beyond the limit split it.
+ */
+static void test_merge(void)
+{
+    test_capture_t captures[7];
+    const user_modbus_point_t points[] = {
+        { 2, USER_MODBUS_READ_HOLDING_REGISTERS, 0, 1, test_capture, &captures[0] },
+        { 1, USER_MODBUS_READ_HOLDING_REGISTERS, 6, 2, test_capture, &captures[1] },
+        { 1, USER_MODBUS_READ_HOLDING_REGISTERS, 0, 2, test_capture, &captures[2] },
+        { 1, USER_MODBUS_READ_INPUT_REGISTERS, 0, 1, test_capture, &captures[3] },
+        { 1, USER_MODBUS_READ_HOLDING_REGISTERS, 13, 1, test_capture, &captures[4] },
+        { 1, USER_MODBUS_READ_HOLDING_REGISTERS, 1, 1, test_capture, &captures[5] },
+        { 1, USER_MODBUS_READ_INPUT_REGISTERS, 60, 4, test_capture, &captures[6] },
+    };
+    const user_modbus_slave_config_t configs[] = { { 1, 200, 1 }, { 2, 200, 1 } };
+    static const test_request_t expected[] = {
+        { 1, USER_MODBUS_READ_HOLDING_REGISTERS, 0, 8 },    /* 0-1, 1 and 6-7, a gap of 4. */
+        { 1, USER_MODBUS_READ_HOLDING_REGISTERS, 13, 1 },   /* A gap of 5. */
+        { 1, USER_MODBUS_READ_INPUT_REGISTERS, 0, 1 },
+        { 1, USER_MODBUS_READ_INPUT_REGISTERS, 60, 4 },
+        { 2, USER_MODBUS_READ_HOLDING_REGISTERS, 0, 1 },
+    };
+    test_slave_t slaves[2];
+    test_bus_t bus;
+    user_modbus_master_t master;
+
+    memset(captures, 0, sizeof(captures));
+    test_slave_init(&slaves[0], 1, 10);
+    test_slave_init(&slaves[1], 2, 10);
+    TEST_CHECK_EQUAL(ESP_OK, test_master_init(&master, &bus, USER_MODBUS_MODE_RTU, slaves, 2, configs, 2, points, 7));
+    TEST_CHECK_EQUAL(7, master.stats.points);
+    TEST_CHECK_EQUAL(5, master.stats.blocks);
+
+    user_modbus_master_poll(&master);
+
+    TEST_CHECK_EQUAL(5, bus.requests);
+    for (int i = 0; i < 5; i++)
+    {
+        TEST_CHECK_EQUAL(expected[i].slave, bus.log[i].slave);
+        TEST_CHECK_EQUAL(expected[i].function, bus.log[i].function);
+        TEST_CHECK_EQUAL(expected[i].address, bus.log[i].address);
+        TEST_CHECK_EQUAL(expected[i].count, bus.log[i].count);
+    }
+
+    /* Every point gets its own registers out of the merged read. */
+    for (int i = 0; i < 7; i++)
+    {
+        TEST_CHECK_EQUAL(1, captures[i].calls);
+        for (uint16_t r = 0; r < points[i].count; r++)
+        {
+            const uint16_t *bank = (points[i].function == USER_MODBUS_READ_INPUT_REGISTERS) ?
+                                   slaves[points[i].slave - 1].input : slaves[points[i].slave - 1].holding;
+
+            TEST_CHECK_EQUAL(bank[points[i].address + r], captures[i].regs[r]);
+        }
+    }
+
+    TEST_CHECK_EQUAL(1, master.stats.cycles);
+    TEST_CHECK_EQUAL(4, user_modbus_master_get_slave_stats(&master, 1)->requests);
+    TEST_CHECK(user_modbus_master_get_slave_stats(&master, 3) == NULL);
+}
+/**
+ * @brief  The same poll works over ASCII frames.
+ */
+static void test_ascii(void)
+{
+    test_capture_t captures[2];
+    const user_modbus_point_t points[] = {
+        { 7, USER_MODBUS_READ_HOLDING_REGISTERS, 3, 2, test_capture, &captures[0] },
+        { 7, USER_MODBUS_READ_INPUT_REGISTERS, 40, 8, test_capture, &captures[1] },
+    };
+    const user_modbus_slave_config_t configs[] = { { 7, 500, 0 } };
+    test_slave_t slave;
+    test_bus_t bus;
+    user_modbus_master_t master;
+
+    memset(captures, 0, sizeof(captures));
+    test_slave_init(&slave, 7, 15);
+    TEST_CHECK_EQUAL(ESP_OK, test_master_init(&master, &bus, USER_MODBUS_MODE_ASCII, &slave, 1, configs, 1, points, 2));
+
+    user_modbus_master_poll(&master);
+
+    TEST_CHECK_EQUAL(2, bus.requests);
+    TEST_CHECK_EQUAL(1, captures[0].calls);
+    TEST_CHECK_EQUAL(slave.holding[4], captures[0].regs[1]);
+    TEST_CHECK_EQUAL(1, captures[1].calls);
+    TEST_CHECK_EQUAL(slave.input[47], captures[1].regs[7]);
+    TEST_CHECK_EQUAL(2, user_modbus_master_get_slave_stats(&master, 7)->responses);
+}
+/**
+ * @brief  Corrupted and exception responses are errors, no handler sees their registers.
+ */
+static void test_bad_response(void)
+{
+    test_capture_t capture;
+    const user_modbus_point_t points[] = {
+        { 1, USER_MODBUS_READ_HOLDING_REGISTERS, 0, 1, test_capture, &capture },
+    };
+    const user_modbus_slave_config_t configs[] = { { 1, 200, 1 } };
+    const user_modbus_slave_stats_t *stats = NULL;
+    test_slave_t slave;
+    test_bus_t bus;
+    user_modbus_master_t master;
+
+    memset(&capture, 0, sizeof(capture));
+    test_slave_init(&slave, 1, 10);
+    TEST_CHECK_EQUAL(ESP_OK, test_master_init(&master, &bus, USER_MODBUS_MODE_RTU, &slave, 1, configs, 1, points, 1));
+    stats = user_modbus_master_get_slave_stats(&master, 1);
+
+    slave.fault = TEST_FAULT_CORRUPT;
+    user_modbus_master_poll(&master);
+    TEST_CHECK_EQUAL(2, stats->requests);
+    TEST_CHECK_EQUAL(2, stats->errors);
+    TEST_CHECK_EQUAL(0, stats->timeouts);
+    TEST_CHECK_EQUAL(1, stats->failures);
+    TEST_CHECK_EQUAL(0, capture.calls);
+
+    slave.fault = TEST_FAULT_EXCEPTION;
+    bus.now_ms = stats->retry_at;
+    user_modbus_master_poll(&master);
+    TEST_CHECK_EQUAL(3, stats->errors);
+    TEST_CHECK_EQUAL(2, stats->failures);
+    TEST_CHECK_EQUAL(0, capture.calls);
+}
+/**
+ * @brief  A merged read rejected with an illegal data address is split into the reads of its points.
+ */
+static void test_merge_exception(void)
+{
+    test_capture_t captures[3];
+    const user_modbus_point_t points[] = {
+        { 1, USER_MODBUS_READ_HOLDING_REGISTERS, 0, 2, test_capture, &captures[0] },
+        { 1, USER_MODBUS_READ_HOLDING_REGISTERS, 4, 1, test_capture, &captures[1] },
+        { 1, USER_MODBUS_READ_INPUT_REGISTERS, 8, 1, test_capture, &captures[2] },
+    };
+    const user_modbus_slave_config_t configs[] = { { 1, 200, 2 } };
+    static const test_request_t expected[] = {
+        { 1, USER_MODBUS_READ_HOLDING_REGISTERS, 0, 5 },    /* Merged across the hole, rejected once. */
+        { 1, USER_MODBUS_READ_HOLDING_REGISTERS, 0, 2 },
+        { 1, USER_MODBUS_READ_HOLDING_REGISTERS, 4, 1 },
+        { 1, USER_MODBUS_READ_INPUT_REGISTERS, 8, 1 },
+        { 1, USER_MODBUS_READ_HOLDING_REGISTERS, 0, 2 },    /* Next cycle, the split reads only. */
+        { 1, USER_MODBUS_READ_HOLDING_REGISTERS, 4, 1 },
+        { 1, USER_MODBUS_READ_INPUT_REGISTERS, 8, 1 },
+    };
+    const user_modbus_slave_stats_t *stats = NULL;
+    test_slave_t slave;
+    test_bus_t bus;
+    user_modbus_master_t master;
+
+    memset(captures, 0, sizeof(captures));
+    test_slave_init(&slave, 1, 10);
+    slave.holding_holes = 1U << 3;
+    TEST_CHECK_EQUAL(ESP_OK, test_master_init(&master, &bus, USER_MODBUS_MODE_RTU, &slave, 1, configs, 1, points, 3));
+    TEST_CHECK_EQUAL(2, master.stats.blocks);
+    stats = user_modbus_master_get_slave_stats(&master, 1);
+
+    user_modbus_master_poll(&master);
+
+    /* The exception is not repeated, and the slave is not failing. */
+    TEST_CHECK_EQUAL(4, bus.requests);
+    TEST_CHECK_EQUAL(3, master.stats.blocks);
+    TEST_CHECK_EQUAL(1, stats->errors);
+    TEST_CHECK_EQUAL(3, stats->responses);
+    TEST_CHECK_EQUAL(0, stats->failures);
+    for (int i = 0; i < 3; i++)
+    {
+        TEST_CHECK_EQUAL(1, captures[i].calls);
+    }
+    TEST_CHECK_EQUAL(slave.holding[1], captures[0].regs[1]);
+    TEST_CHECK_EQUAL(slave.holding[4], captures[1].regs[0]);
+    TEST_CHECK_EQUAL(slave.input[8], captures[2].regs[0]);
+
+    user_modbus_master_poll(&master);
+
+    TEST_CHECK_EQUAL(7, bus.requests);
+    for (int i = 0; i < 7; i++)
+    {
+        TEST_CHECK_EQUAL(expected[i].function, bus.log[i].function);
+        TEST_CHECK_EQUAL(expected[i].address, bus.log[i].address);
+        TEST_CHECK_EQUAL(expected[i].count, bus.log[i].count);
+    }
+    TEST_CHECK_EQUAL(1, stats->errors);
+    TEST_CHECK_EQUAL(2, captures[1].calls);
+
+    /* A point that is itself in the hole fails like any other read, the slave backs off. */
+    slave.holding_holes = 1U << 4;
+    user_modbus_master_poll(&master);
+    TEST_CHECK_EQUAL(9, bus.requests);
+    TEST_CHECK_EQUAL(2, stats->errors);
+    TEST_CHECK_EQUAL(1, stats->failures);
+    TEST_CHECK_EQUAL(1, stats->skipped);
+    TEST_CHECK_EQUAL(3, master.stats.blocks);
+    TEST_CHECK_EQUAL(2, captures[1].calls);
+}
+/**
+ * @brief  A silent slave backs off exponentially, gets one probe per attempt and never delays the healthy ones.
+ */
+static void test_backoff(void)
+{
+    test_capture_t captures[2];
+    const user_modbus_point_t points[] = {
+        { 1, USER_MODBUS_READ_HOLDING_REGISTERS, 0, 1, test_capture, &captures[0] },
+        { 2, USER_MODBUS_READ_HOLDING_REGISTERS, 0, 1, test_capture, &captures[1] },
+    };
+    const user_modbus_slave_config_t configs[] = { { 1, 200, 2 }, { 2, 200, 2 } };
+    const user_modbus_slave_stats_t *stats = NULL;
+    test_slave_t slaves[2];
+    test_bus_t bus;
+    user_modbus_master_t master;
+
+    memset(captures, 0, sizeof(captures));
+    test_slave_init(&slaves[0], 1, 10);
+    test_slave_init(&slaves[1], 2, 10);
+    TEST_CHECK_EQUAL(ESP_OK, test_master_init(&master, &bus, USER_MODBUS_MODE_RTU, slaves, 2, configs, 2, points, 2));
+    stats = user_modbus_master_get_slave_stats(&master, 1);
+
+    /* Slave 1 stops answering: 1 request and 2 retries, then a backoff of 1 s. */
+    slaves[0].fault = TEST_FAULT_SILENT;
+    user_modbus_master_poll(&master);
+    TEST_CHECK_EQUAL(3, stats->requests);
+    TEST_CHECK_EQUAL(3, stats->timeouts);
+    TEST_CHECK_EQUAL(1, stats->failures);
+    TEST_CHECK_EQUAL(bus.timed_out_ms + USER_MODBUS_BACKOFF_BASE_MS, stats->retry_at);
+    TEST_CHECK_EQUAL(1, captures[1].calls);
+
+    /* Skipped while backing off, slave 2 is read alone. */
+    int requests = bus.requests;
+    user_modbus_master_poll(&master);
+    TEST_CHECK_EQUAL(requests + 1, bus.requests);
+    TEST_CHECK_EQUAL(1, stats->skipped);
+    TEST_CHECK_EQUAL(2, captures[1].calls);
+
+    /* Every later attempt is a single probe, after the healthy slave, and doubles the backoff. */
+    for (uint32_t failures = 2; failures <= 9; failures++)
+    {
+        uint32_t backoff = USER_MODBUS_BACKOFF_BASE_MS << ((failures <= 7) ? (failures - 1) : 6);
+
+        bus.now_ms = stats->retry_at;
+        requests = bus.requests;
+        user_modbus_master_poll(&master);
+        TEST_CHECK_EQUAL(requests + 2, bus.requests);
+        TEST_CHECK_EQUAL(2, bus.log[requests % TEST_REQUEST_MAX].slave);
+        TEST_CHECK_EQUAL(failures, stats->failures);
+        backoff = (backoff < USER_MODBUS_BACKOFF_MAX_MS) ? backoff : USER_MODBUS_BACKOFF_MAX_MS;
+        TEST_CHECK_EQUAL(bus.timed_out_ms + backoff, stats->retry_at);
+    }
+
+    /* The slave answers again: the backoff resets and it is read first again. */
+    slaves[0].fault = TEST_FAULT_NONE;
+    bus.now_ms = stats->retry_at;
+    user_modbus_master_poll(&master);
+    TEST_CHECK_EQUAL(0, stats->failures);
+    TEST_CHECK_EQUAL(1, captures[0].calls);
+
+    requests = bus.requests;
+    user_modbus_master_poll(&master);
+    TEST_CHECK_EQUAL(1, bus.log[requests % TEST_REQUEST_MAX].slave);
+    TEST_CHECK_EQUAL(2, captures[0].calls);
+}
+/**
+ * @brief  The RTU silent intervals follow the character time up to 19200 baud and are fixed above.
+ */
+static void test_rtu_timing(void)
+{
+    static const struct
+    {
+        uint32_t baud_rate;
+        uint32_t t15_us;
+        uint32_t t35_us;
+    } expected[] = {
+        { 1200, 13750, 32084 },
+        { 9600, 1719, 4011 },
+        { 19200, 860, 2006 },
+        { 38400, USER_MODBUS_FIXED_T15_US, USER_MODBUS_FIXED_T35_US },
+        { 115200, USER_MODBUS_FIXED_T15_US, USER_MODBUS_FIXED_T35_US },
+        { 0, USER_MODBUS_FIXED_T15_US, USER_MODBUS_FIXED_T35_US },
+    };
+    uint32_t t15_us = 0;
+    uint32_t t35_us = 0;
+
+    for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); i++)
+    {
+        user_modbus_rtu_timing(expected[i].baud_rate, &t15_us, &t35_us);
+        TEST_CHECK_EQUAL(expected[i].t15_us, t15_us);
+        TEST_CHECK_EQUAL(expected[i].t35_us, t35_us);
+    }
+}
+/**
+ * @brief  The response timeout shrinks from the configured one to the learned latency, plus the time on the wire.
+ */
+static void test_learn_latency(void)
+{
+    test_capture_t capture;
+    const user_modbus_point_t points[] = {
+        { 1, USER_MODBUS_READ_HOLDING_REGISTERS, 0, 1, test_capture, &capture },
+    };
+    const user_modbus_slave_config_t configs[] = { { 1, 200, 1 } };
+    const user_modbus_slave_stats_t *stats = NULL;
+    test_slave_t slave;
+    test_bus_t bus;
+    user_modbus_master_t master;
+    /* Response of one register, 7 characters of 11 bits at 9600 baud. */
+    uint32_t wire_ms = (7U * 1146U + 999U) / 1000U;
+
+    memset(&capture, 0, sizeof(capture));
+    test_slave_init(&slave, 1, 20);
+    TEST_CHECK_EQUAL(ESP_OK, test_master_init(&master, &bus, USER_MODBUS_MODE_RTU, &slave, 1, configs, 1, points, 1));
+    stats = user_modbus_master_get_slave_stats(&master, 1);
+    TEST_CHECK_EQUAL(1146, master.char_us);
+    TEST_CHECK_EQUAL(wire_ms, master.blocks[0].response_ms);
+
+    /* Nothing learned yet: the configured timeout, frames delimited by t3.5. */
+    user_modbus_master_poll(&master);
+    TEST_CHECK_EQUAL(200, bus.last_timeout_ms);
+    TEST_CHECK_EQUAL(master.stats.t35_us, bus.last_gap_us);
+    TEST_CHECK_EQUAL(20 * 16, stats->srtt_q4);
+
+    /* First sample: srtt + 4 * srtt / 2, rounded up, plus the margin. */
+    TEST_CHECK_EQUAL(20 * 3 + USER_MODBUS_TIMEOUT_MARGIN_MS, stats->timeout_ms);
+    user_modbus_master_poll(&master);
+    TEST_CHECK_EQUAL(20 * 3 + USER_MODBUS_TIMEOUT_MARGIN_MS + wire_ms, bus.last_timeout_ms);
+
+    /* A steady latency: the deviation decays and the timeout closes in on it. */
+    for (int i = 0; i < 40; i++)
+    {
+        user_modbus_master_poll(&master);
+    }
+    TEST_CHECK_EQUAL(20 * 16, stats->srtt_q4);
+    TEST_CHECK(stats->timeout_ms >= 20 + USER_MODBUS_TIMEOUT_MARGIN_MS);
+    TEST_CHECK(stats->timeout_ms <= 20 + USER_MODBUS_TIMEOUT_MARGIN_MS + 2);
+    TEST_CHECK_EQUAL(42, capture.calls);
+    TEST_CHECK_EQUAL(0, stats->timeouts);
+
+    /* The slave slows down past the learned timeout: it doubles on every timeout until the response fits. */
+    slave.latency_ms = 60;
+    for (int i = 0; (i < 10) && (capture.calls == 42); i++)
+    {
+        if (stats->failures != 0)
+        {
+            bus.now_ms = stats->retry_at;
+        }
+        user_modbus_master_poll(&master);
+        TEST_CHECK(bus.last_timeout_ms <= 200);
+    }
+    TEST_CHECK_EQUAL(43, capture.calls);
+    TEST_CHECK(stats->timeouts >= 1);
+    TEST_CHECK(stats->timeouts <= 2);
+    TEST_CHECK_EQUAL(0, stats->failures);
+
+    /* Then it settles on the new latency. */
+    for (int i = 0; i < 40; i++)
+    {
+        user_modbus_master_poll(&master);
+    }
+    TEST_CHECK(stats->timeout_ms >= 60 + USER_MODBUS_TIMEOUT_MARGIN_MS);
+    TEST_CHECK(stats->timeout_ms <= 60 + USER_MODBUS_TIMEOUT_MARGIN_MS + 4);
+}
+/**
+ * @brief  A slave that stops answering is waited for no longer than its configured timeout.
+ */
+static void test_timeout_ceiling(void)
+{
+    test_capture_t capture;
+    const user_modbus_point_t points[] = {
+        { 1, USER_MODBUS_READ_HOLDING_REGISTERS, 0, 1, test_capture, &capture },
+    };
+    const user_modbus_slave_config_t configs[] = { { 1, 100, 0 } };
+    const user_modbus_slave_stats_t *stats = NULL;
+    test_slave_t slave;
+    test_bus_t bus;
+    user_modbus_master_t master;
+
+    test_slave_init(&slave, 1, 5);
+    TEST_CHECK_EQUAL(ESP_OK, test_master_init(&master, &bus, USER_MODBUS_MODE_RTU, &slave, 1, configs, 1, points, 1));
+    stats = user_modbus_master_get_slave_stats(&master, 1);
+    for (int i = 0; i < 20; i++)
+    {
+        user_modbus_master_poll(&master);
+    }
+    TEST_CHECK(bus.last_timeout_ms < 100);
+
+    slave.fault = TEST_FAULT_SILENT;
+    for (int i = 0; i < 10; i++)
+    {
+        if (stats->failures != 0)
+        {
+            bus.now_ms = stats->retry_at;
+        }
+        user_modbus_master_poll(&master);
+        TEST_CHECK(bus.last_timeout_ms <= 100);
+    }
+    TEST_CHECK_EQUAL(100, bus.last_timeout_ms);
+    TEST_CHECK_EQUAL(10, stats->timeouts);
+}
+/**
+ * @brief  Register maps the engine cannot poll are refused.
+ */
+static void test_init_invalid(void)
+{
+    test_capture_t capture;
+    const user_modbus_slave_config_t configs[] = { { 1, 200, 1 } };
+    const user_modbus_point_t points[] = {
+        { 2, USER_MODBUS_READ_HOLDING_REGISTERS, 0, 1, test_capture, &capture },    /* Unknown slave. */
+        { 1, 0x06, 0, 1, test_capture, &capture },                                  /* Not a read. */
+        { 1, USER_MODBUS_READ_HOLDING_REGISTERS, 0, 0, test_capture, &capture },    /* No register. */
+        { 1, USER_MODBUS_READ_HOLDING_REGISTERS, 0, USER_MODBUS_MAX_READ_REGISTERS + 1, test_capture, &capture },
+        { 1, USER_MODBUS_READ_HOLDING_REGISTERS, 0, 1, NULL, NULL },                /* No handler. */
+    };
+    const user_modbus_point_t valid = { 1, USER_MODBUS_READ_HOLDING_REGISTERS, 0, 1, test_capture, &capture };
+    test_bus_t bus;
+    user_modbus_master_t master;
+
+    for (size_t i = 0; i < sizeof(points) / sizeof(points[0]); i++)
+    {
+        TEST_CHECK_EQUAL(ESP_ERR_INVALID_ARG,
+                         test_master_init(&master, &bus, USER_MODBUS_MODE_RTU, NULL, 0, configs, 1, &points[i], 1));
+    }
+
+    TEST_CHECK_EQUAL(ESP_ERR_INVALID_ARG, test_master_init(&master, &bus, USER_MODBUS_MODE_RTU, NULL, 0, configs, 0, &valid, 1));
+    TEST_CHECK_EQUAL(ESP_ERR_INVALID_ARG, test_master_init(&master, &bus, USER_MODBUS_MODE_RTU, NULL, 0, configs, 1, &valid, 0));
+    TEST_CHECK_EQUAL(ESP_OK, test_master_init(&master, &bus, USER_MODBUS_MODE_RTU, NULL, 0, configs, 1, &valid, 1));
+}
+
+int main(void)
+{
+    TEST_CASE(test_checksums);
+    TEST_CASE(test_merge);
+    TEST_CASE(test_ascii);
+    TEST_CASE(test_bad_response);
+    TEST_CASE(test_merge_exception);
+    TEST_CASE(test_backoff);
+    TEST_CASE(test_rtu_timing);
+    TEST_CASE(test_learn_latency);
+    TEST_CASE(test_timeout_ceiling);
+    TEST_CASE(test_init_invalid);
+
+    return TEST_RESULT();
+}
+/******************************** End of File *********************************/
@@ -0,0 +1,335 @@
+/**
+ *****************************************************************************
+ * @file    : test_mqtt_assembly.c
+ * @brief   : Host tests of the MQTT message reassembly
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *
+ * @note Payloads are split at random points the way esp-mqtt delivers them,
+ *       only the first fragment carries the topic. Delivered messages must be
+ *       byte exact, and no pool slot may leak whatever the fragments do.
+ *****************************************************************************
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "test_host.h"
+#include "user_mqtt_assembly.h"
+
+/** @brief Messages of the random split test. */
+#define TEST_SPLIT_MESSAGES     (20000U)
+
+/** @brief Fragment streams of the fault test. */
+#define TEST_FAULT_MESSAGES     (20000U)
+
+/** @brief Lock state, checked by every lock and unlock. */
+typedef struct
+{
+    int depth;
+    uint32_t taken;
+    uint32_t errors; /* Nested locks or unbalanced unlocks. */
+} test_lock_t;
+
+static uint32_t test_seed = 1;
+
+/**
+ * @brief  Pseudo-random number, the same sequence every run.
+ */
+static uint32_t test_random(void)
+{
+    test_seed = test_seed * 1103515245U + 12345U;
+
+    return test_seed >> 8;
+}
+
+static void test_lock(void *ctx)
+{
+    test_lock_t *lock = ctx;
+
+    lock->errors += (lock->depth != 0) ? 1 : 0;
+    lock->depth++;
+    lock->taken++;
+}
+
+static void test_unlock(void *ctx)
+{
+    test_lock_t *lock = ctx;
+
+    lock->errors += (lock->depth != 1) ? 1 : 0;
+    lock->depth--;
+}
+/**
+ * @brief  Fill a payload with bytes that depend on the message and the position.
+ */
+static void test_payload(uint32_t number, char *data, int len)
+{
+    for (int i = 0; i < len; i++)
+    {
+        data[i] = (char)((number * 131U + (uint32_t)i * 7U) & 0xFF);
+    }
+}
+/**
+ * @brief  Feed a whole payload split at random points, every fragment is checked against the expected outcome.
+ *
+ * @return Outcome of the last fragment.
+ */
+static user_mqtt_assembly_result_t test_feed_split(user_mqtt_assembly_t *assembly, const char *topic,
+                                                   const char *data, int len, uint32_t seq)
+{
+    user_mqtt_assembly_result_t result;
+    int offset = 0;
+
+    do
+    {
+        user_mqtt_fragment_t fragment = { NULL, 0, &data[offset], 0, offset, len };
+        int chunk = (len - offset > 0) ? 1 + (int)(test_random() % (uint32_t)(len - offset)) : 0;
+
+        /* Mostly a few large fragments, like the esp-mqtt receive buffer gives. */
+        if ((test_random() % 4) != 0)
+        {
+            chunk = (len - offset < 300) ? (len - offset) : 300;
+        }
+        if (offset == 0)
+        {
+            fragment.topic = topic;
+            fragment.topic_len = (int)strlen(topic);
+        }
+        fragment.data_len = chunk;
+        offset += chunk;
+
+        result = user_mqtt_assembly_feed(assembly, &fragment, seq);
+        if (offset < len)
+        {
+            TEST_CHECK_EQUAL(USER_MQTT_ASSEMBLY_PENDING, result);
+        }
+    } while (offset < len);
+
+    return result;
+}
+/**
+ * @brief  Randomly split payloads of every length come out whole and in order.
+ */
+static void test_random_split(void)
+{
+    static user_mqtt_pool_t pool;
+    static char data[USER_MQTT_POOL_DATA_MAX_LENGTH];
+    user_mqtt_assembly_t assembly;
+    test_lock_t lock = { 0 };
+    uint32_t delivered = 0;
+
+    user_mqtt_pool_init(&pool, USER_MQTT_OVERFLOW_DROP_NEWEST);
+    user_mqtt_assembly_init(&assembly, &pool, test_lock, test_unlock, &lock);
+
+    for (uint32_t number = 0; number < TEST_SPLIT_MESSAGES; number++)
+    {
+        int len = (int)(test_random() % (USER_MQTT_POOL_DATA_MAX_LENGTH + 1));
+        char topic[32];
+        uint8_t index;
+
+        snprintf(topic, sizeof(topic), "recipe/%u", (unsigned int)(number % 7));
+        test_payload(number, data, len);
+        TEST_CHECK_EQUAL(USER_MQTT_ASSEMBLY_QUEUED, test_feed_split(&assembly, topic, data, len, number));
+
+        /* The consumer drains now and then, at the latest when the pool is full. */
+        if ((pool.free_count != 0) && ((test_random() % 4) != 0))
+        {
+            continue;
+        }
+        while (user_mqtt_pool_receive(&pool, &index))
+        {
+            user_mqtt_msg_t *msg = &pool.slots[index];
+            char expected[USER_MQTT_POOL_DATA_MAX_LENGTH];
+            char expected_topic[32];
+
+            snprintf(expected_topic, sizeof(expected_topic), "recipe/%u", (unsigned int)(msg->seq % 7));
+            test_payload(msg->seq, expected, msg->data_len);
+            TEST_CHECK_EQUAL(delivered, msg->seq);
+            TEST_CHECK((msg->topic_len == (int)strlen(expected_topic)) &&
+                       (memcmp(msg->topic, expected_topic, msg->topic_len) == 0));
+            TEST_CHECK(memcmp(msg->data, expected, msg->data_len) == 0);
+            delivered++;
+            user_mqtt_pool_release(&pool, index);
+        }
+    }
+
+    TEST_CHECK_EQUAL(TEST_SPLIT_MESSAGES, delivered + pool.queue_count);
+    TEST_CHECK_EQUAL(0, pool.stats.incomplete);
+    TEST_CHECK_EQUAL(0, pool.stats.dropped_newest);
+    TEST_CHECK_EQUAL(0, lock.errors);
+    TEST_CHECK_EQUAL(0, lock.depth);
+}
+/**
+ * @brief  Every way a fragment stream can go wrong drops the message and frees its slot.
+ */
+static void test_faults(void)
+{
+    static user_mqtt_pool_t pool;
+    user_mqtt_assembly_t assembly;
+    test_lock_t lock = { 0 };
+    char data[64];
+    char topic[USER_MQTT_POOL_TOPIC_MAX_LENGTH + 1];
+    uint8_t index;
+
+    memset(data, 'x', sizeof(data));
+    memset(topic, 't', sizeof(topic));
+    user_mqtt_pool_init(&pool, USER_MQTT_OVERFLOW_DROP_NEWEST);
+    user_mqtt_assembly_init(&assembly, &pool, test_lock, test_unlock, &lock);
+
+    /* A new message before the last fragment, the unfinished one is dropped. */
+    user_mqtt_fragment_t first = { "a", 1, data, 10, 0, 20 };
+    TEST_CHECK_EQUAL(USER_MQTT_ASSEMBLY_PENDING, user_mqtt_assembly_feed(&assembly, &first, 0));
+    user_mqtt_fragment_t other = { "b", 1, data, 5, 0, 5 };
+    TEST_CHECK_EQUAL(USER_MQTT_ASSEMBLY_QUEUED, user_mqtt_assembly_feed(&assembly, &other, 0));
+    TEST_CHECK_EQUAL(1, pool.stats.incomplete);
+
+    /* The rest of it is ignored. */
+    user_mqtt_fragment_t rest = { NULL, 0, data, 10, 10, 20 };
+    TEST_CHECK_EQUAL(USER_MQTT_ASSEMBLY_IGNORED, user_mqtt_assembly_feed(&assembly, &rest, 1));
+
+    /* Past the announced length, or a different announced length. */
+    TEST_CHECK_EQUAL(USER_MQTT_ASSEMBLY_PENDING, user_mqtt_assembly_feed(&assembly, &first, 1));
+    user_mqtt_fragment_t beyond = { NULL, 0, data, 11, 10, 20 };
+    TEST_CHECK_EQUAL(USER_MQTT_ASSEMBLY_OUT_OF_RANGE, user_mqtt_assembly_feed(&assembly, &beyond, 1));
+    TEST_CHECK_EQUAL(USER_MQTT_ASSEMBLY_IGNORED, user_mqtt_assembly_feed(&assembly, &rest, 1));
+    TEST_CHECK_EQUAL(USER_MQTT_ASSEMBLY_PENDING, user_mqtt_assembly_feed(&assembly, &first, 1));
+    user_mqtt_fragment_t resized = { NULL, 0, data, 10, 10, 30 };
+    TEST_CHECK_EQUAL(USER_MQTT_ASSEMBLY_OUT_OF_RANGE, user_mqtt_assembly_feed(&assembly, &resized, 1));
+    user_mqtt_fragment_t longer = { "a", 1, data, 21, 0, 20 };
+    TEST_CHECK_EQUAL(USER_MQTT_ASSEMBLY_OUT_OF_RANGE, user_mqtt_assembly_feed(&assembly, &longer, 1));
+    TEST_CHECK_EQUAL(4, pool.stats.incomplete);
+
+    /* Too long for a slot. */
+    user_mqtt_fragment_t long_topic = { topic, (int)sizeof(topic), data, 1, 0, 1 };
+    TEST_CHECK_EQUAL(USER_MQTT_ASSEMBLY_OVERSIZED, user_mqtt_assembly_feed(&assembly, &long_topic, 1));
+    user_mqtt_fragment_t long_data = { "a", 1, data, 10, 0, USER_MQTT_POOL_DATA_MAX_LENGTH + 1 };
+    TEST_CHECK_EQUAL(USER_MQTT_ASSEMBLY_OVERSIZED, user_mqtt_assembly_feed(&assembly, &long_data, 1));
+    TEST_CHECK_EQUAL(USER_MQTT_ASSEMBLY_IGNORED, user_mqtt_assembly_feed(&assembly, &rest, 1));
+    TEST_CHECK_EQUAL(2, pool.stats.oversized);
+
+    /* A disconnect in the middle. */
+    TEST_CHECK_EQUAL(USER_MQTT_ASSEMBLY_PENDING, user_mqtt_assembly_feed(&assembly, &first, 1));
+    TEST_CHECK(user_mqtt_assembly_abort(&assembly));
+    TEST_CHECK(user_mqtt_assembly_abort(&assembly) == false);
+    TEST_CHECK_EQUAL(USER_MQTT_ASSEMBLY_IGNORED, user_mqtt_assembly_feed(&assembly, &rest, 1));
+    TEST_CHECK_EQUAL(5, pool.stats.incomplete);
+
+    /* Only the one complete message is queued, every other slot is free. */
+    TEST_CHECK(user_mqtt_pool_receive(&pool, &index));
+    TEST_CHECK((pool.slots[index].topic_len == 1) && (pool.slots[index].topic[0] == 'b'));
+    user_mqtt_pool_release(&pool, index);
+    TEST_CHECK_EQUAL(USER_MQTT_POOL_SIZE, pool.free_count);
+
+    /* An exhausted pool drops the message, its fragments are ignored. */
+    for (uint32_t i = 0; i < USER_MQTT_POOL_SIZE; i++)
+    {
+        TEST_CHECK_EQUAL(USER_MQTT_ASSEMBLY_QUEUED, user_mqtt_assembly_feed(&assembly, &other, i));
+    }
+    TEST_CHECK_EQUAL(USER_MQTT_ASSEMBLY_EXHAUSTED, user_mqtt_assembly_feed(&assembly, &first, 10));
+    TEST_CHECK_EQUAL(USER_MQTT_ASSEMBLY_IGNORED, user_mqtt_assembly_feed(&assembly, &rest, 10));
+
+    TEST_CHECK_EQUAL(0, lock.errors);
+    TEST_CHECK_EQUAL(0, lock.depth);
+}
+/**
+ * @brief  Random fragment streams with random faults never leak a slot or deliver a damaged message.
+ */
+static void test_fault_fuzz(void)
+{
+    static user_mqtt_pool_t pool;
+    static char data[USER_MQTT_POOL_DATA_MAX_LENGTH];
+    user_mqtt_assembly_t assembly;
+    test_lock_t lock = { 0 };
+    uint32_t seq = 0;
+    uint32_t queued = 0;
+    uint32_t delivered = 0;
+    uint32_t leaks = 0;
+
+    user_mqtt_pool_init(&pool, USER_MQTT_OVERFLOW_COALESCE);
+    user_mqtt_assembly_init(&assembly, &pool, test_lock, test_unlock, &lock);
+
+    for (uint32_t number = 0; number < TEST_FAULT_MESSAGES; number++)
+    {
+        int len = (int)(test_random() % 600);
+        int offset = 0;
+        uint8_t index;
+
+        /* A merged payload keeps the sequence number of the message it replaced, the bytes follow the length. */
+        test_payload((uint32_t)len, data, len);
+
+        while (offset < len || (len == 0 && offset == 0))
+        {
+            user_mqtt_fragment_t fragment = { NULL, 0, &data[offset], 0, offset, len };
+            uint32_t fault = test_random() % 64;
+
+            fragment.data_len = 1 + (int)(test_random() % 200);
+            fragment.data_len = (fragment.data_len > len - offset) ? (len - offset) : fragment.data_len;
+            if (offset == 0)
+            {
+                fragment.topic = "zone";
+                fragment.topic_len = 4;
+            }
+
+            /* Now and then, a fragment too long, a changed length, or a lost connection. */
+            if (fault == 0)
+            {
+                fragment.data_len++;
+            }
+            else if (fault == 1)
+            {
+                fragment.total_len++;
+            }
+            else if (fault == 2)
+            {
+                user_mqtt_assembly_abort(&assembly);
+            }
+
+            user_mqtt_assembly_result_t result = user_mqtt_assembly_feed(&assembly, &fragment, seq);
+            if (result == USER_MQTT_ASSEMBLY_QUEUED)
+            {
+                seq++;
+                queued++;
+            }
+            offset += (fragment.data_len > 0) ? fragment.data_len : 1;
+        }
+
+        if ((test_random() % 3) == 0)
+        {
+            while (user_mqtt_pool_receive(&pool, &index))
+            {
+                user_mqtt_msg_t *msg = &pool.slots[index];
+                char expected[USER_MQTT_POOL_DATA_MAX_LENGTH];
+
+                test_payload((uint32_t)msg->data_len, expected, msg->data_len);
+                TEST_CHECK(msg->seq < seq);
+                TEST_CHECK(memcmp(msg->data, expected, msg->data_len) == 0);
+                delivered++;
+                user_mqtt_pool_release(&pool, index);
+            }
+        }
+
+        /* Every slot is free, queued or held by the reassembly. */
+        if (pool.free_count + pool.queue_count + ((assembly.index != USER_MQTT_POOL_INDEX_NONE) ? 1 : 0) !=
+            USER_MQTT_POOL_SIZE)
+        {
+            leaks++;
+        }
+    }
+
+    TEST_CHECK_EQUAL(0, leaks);
+    TEST_CHECK(delivered > TEST_FAULT_MESSAGES / 2);
+    TEST_CHECK(pool.stats.incomplete > 0);
+    TEST_CHECK_EQUAL(0, lock.errors);
+    TEST_CHECK_EQUAL(0, lock.depth);
+}
+
+int main(void)
+{
+    TEST_CASE(test_random_split);
+    TEST_CASE(test_faults);
+    TEST_CASE(test_fault_fuzz);
+
+    return TEST_RESULT();
+}
+/******************************** End of File *********************************/
@@ -0,0 +1,346 @@
+/**
+ *****************************************************************************
+ * @file    : test_mqtt_latest.c
+ * @brief   : Host tests of the last-writer-wins MQTT value slots
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *
+ * @note The slider storm runs on a simulated millisecond clock: dashboard
+ *       sliders send 50 updates a second each to a processing task whose
+ *       handler takes longer than the updates are apart. The same storm goes
+ *       through the message queue, as before the value slots, and through
+ *       the value slots, so the latency numbers do not depend on the host.
+ *****************************************************************************
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "test_host.h"
+#include "user_mqtt_latest.h"
+#include "user_mqtt_pool.h"
+
+/** @brief Random stores and takes of the reference test. */
+#define TEST_OPERATIONS         (200000U)
+
+/** @brief Slider storm: sliders moved at the same time, update period, duration and handler time in ms. */
+#define TEST_STORM_TOPICS       (3U)
+#define TEST_STORM_PERIOD_MS    (20U)
+#define TEST_STORM_DURATION_MS  (2000U)
+#define TEST_STORM_HANDLER_MS   (8U)
+
+/** @brief Updates each slider sends during the storm. */
+#define TEST_STORM_UPDATES      (TEST_STORM_DURATION_MS / TEST_STORM_PERIOD_MS)
+
+/** @brief Store and take pairs of the throughput benchmark. */
+#define TEST_BENCHMARK_ROUNDS   (2000000U)
+
+/** @brief Paths of the storm, in the order they are printed. */
+typedef enum
+{
+    TEST_PATH_QUEUE,    /* Message queue, drop the oldest message when full. */
+    TEST_PATH_COALESCE, /* Message queue, coalesce the same topic when full. */
+    TEST_PATH_LATEST,   /* Value slots. */
+    TEST_PATH_MAX
+} test_path_t;
+
+/** @brief Outcome of a storm. */
+typedef struct
+{
+    uint32_t calls;                         /* Handler calls. */
+    uint32_t stale;                         /* Handler calls with a value its slider had already moved past. */
+    uint64_t latency_sum;                   /* Arrival to end of the handler, summed over the calls. */
+    uint32_t latency_max;
+    uint32_t settled;                       /* Last update to the slider showing it, worst slider. */
+    uint32_t final_value[TEST_STORM_TOPICS]; /* Last value each handler got. */
+} test_storm_t;
+
+static uint32_t test_seed = 1;
+
+/**
+ * @brief  Pseudo-random number, the same sequence every run.
+ */
+static uint32_t test_random(void)
+{
+    test_seed = test_seed * 1103515245U + 12345U;
+
+    return test_seed >> 8;
+}
+/**
+ * @brief  A new value replaces the pending one, values come out in arrival order up to the bound.
+ */
+static void test_store_take(void)
+{
+    user_mqtt_latest_t latest;
+    user_mqtt_latest_value_t value;
+
+    user_mqtt_latest_init(&latest);
+    TEST_CHECK_EQUAL(-1, user_mqtt_latest_take(&latest, 100, &value));
+
+    TEST_CHECK(user_mqtt_latest_store(&latest, 5, "10", 2, 1) == false);
+    TEST_CHECK(user_mqtt_latest_store(&latest, 31, "on", 2, 2) == false);
+    TEST_CHECK(user_mqtt_latest_store(&latest, 5, "75", 2, 3) == true);
+    TEST_CHECK(user_mqtt_latest_store(&latest, 0, "off", 3, 4) == false);
+
+    /* Slot 5 now holds seq 3, the oldest pending value is slot 31. */
+    TEST_CHECK_EQUAL(31, user_mqtt_latest_take(&latest, 4, &value));
+    TEST_CHECK((value.data_len == 2) && (memcmp(value.data, "on", 2) == 0) && (value.seq == 2));
+    TEST_CHECK_EQUAL(5, user_mqtt_latest_take(&latest, 4, &value));
+    TEST_CHECK((value.data_len == 2) && (memcmp(value.data, "75", 2) == 0));
+
+    /* Seq 4 is not before 4, it waits for the next bound. */
+    TEST_CHECK_EQUAL(-1, user_mqtt_latest_take(&latest, 4, &value));
+    TEST_CHECK_EQUAL(0, user_mqtt_latest_take(&latest, 5, &value));
+    TEST_CHECK_EQUAL(0, latest.dirty);
+
+    /* Sequence numbers wrap at 2^32. */
+    TEST_CHECK(user_mqtt_latest_store(&latest, 1, "a", 1, 0xFFFFFFFFU) == false);
+    TEST_CHECK(user_mqtt_latest_store(&latest, 2, "b", 1, 0) == false);
+    TEST_CHECK_EQUAL(1, user_mqtt_latest_take(&latest, 1, &value));
+    TEST_CHECK_EQUAL(2, user_mqtt_latest_take(&latest, 1, &value));
+    TEST_CHECK_EQUAL(-1, user_mqtt_latest_take(&latest, 1, &value));
+}
+/**
+ * @brief  Random stores and takes against a reference of the newest value per slot.
+ */
+static void test_against_reference(void)
+{
+    user_mqtt_latest_t latest;
+    user_mqtt_latest_value_t value;
+    uint32_t reference[USER_MQTT_LATEST_SLOTS];
+    bool pending[USER_MQTT_LATEST_SLOTS] = { false };
+    uint32_t seq = 0xFFFF0000U;
+    uint32_t mismatches = 0;
+
+    user_mqtt_latest_init(&latest);
+
+    for (uint32_t i = 0; i < TEST_OPERATIONS; i++)
+    {
+        if ((test_random() % 3) != 0)
+        {
+            uint32_t slot = test_random() % USER_MQTT_LATEST_SLOTS;
+            char data[USER_MQTT_LATEST_DATA_MAX_LENGTH];
+
+            memset(data, (int)(seq & 0xFF), sizeof(data));
+            mismatches += (user_mqtt_latest_store(&latest, slot, data, 1 + seq % sizeof(data), seq) != pending[slot]);
+            reference[slot] = seq++;
+            pending[slot] = true;
+        }
+        else
+        {
+            uint32_t before = seq - test_random() % 8;
+            int expected = -1;
+
+            for (uint32_t slot = 0; slot < USER_MQTT_LATEST_SLOTS; slot++)
+            {
+                if ((pending[slot] == true) && ((int32_t)(reference[slot] - before) < 0) &&
+                    ((expected < 0) || ((int32_t)(reference[slot] - reference[expected]) < 0)))
+                {
+                    expected = (int)slot;
+                }
+            }
+
+            int slot = user_mqtt_latest_take(&latest, before, &value);
+            TEST_CHECK_EQUAL(expected, slot);
+            if (slot >= 0)
+            {
+                pending[slot] = false;
+                mismatches += (value.seq != reference[slot]);
+                mismatches += (value.data_len != (int)(1 + value.seq % sizeof(value.data)));
+                mismatches += ((uint8_t)value.data[value.data_len - 1] != (uint8_t)(value.seq & 0xFF));
+            }
+        }
+    }
+
+    TEST_CHECK_EQUAL(0, mismatches);
+}
+/**
+ * @brief  Run the slider storm through one path.
+ */
+static void test_storm_run(test_path_t path, test_storm_t *storm)
+{
+    static user_mqtt_pool_t pool;
+    static uint32_t arrival[TEST_STORM_TOPICS][TEST_STORM_UPDATES];
+    user_mqtt_latest_t latest;
+    uint32_t sent[TEST_STORM_TOPICS] = { 0 };
+    uint32_t seq = 0;
+    uint32_t busy_until = 0;
+    uint32_t pending = 0;
+
+    memset(storm, 0, sizeof(*storm));
+    user_mqtt_pool_init(&pool, (path == TEST_PATH_COALESCE) ? USER_MQTT_OVERFLOW_COALESCE :
+                                                              USER_MQTT_OVERFLOW_DROP_OLDEST);
+    user_mqtt_latest_init(&latest);
+
+    for (uint32_t now = 0; (now < TEST_STORM_DURATION_MS) || (pending != 0) || (now < busy_until); now++)
+    {
+        /* Each slider sends its next position every period, the sliders are out of phase. */
+        for (uint32_t topic = 0; topic < TEST_STORM_TOPICS; topic++)
+        {
+            uint32_t offset = topic * 7;
+            char name[] = { 's', 'l', 'i', 'd', 'e', 'r', (char)('0' + topic) };
+            char data[16];
+
+            if ((now < offset) || (((now - offset) % TEST_STORM_PERIOD_MS) != 0) ||
+                (sent[topic] >= TEST_STORM_UPDATES))
+            {
+                continue;
+            }
+
+            int data_len = snprintf(data, sizeof(data), "%u", (unsigned)sent[topic]);
+            arrival[topic][sent[topic]++] = now;
+
+            if (path == TEST_PATH_LATEST)
+            {
+                user_mqtt_latest_store(&latest, topic, data, data_len, seq++);
+                continue;
+            }
+
+            uint8_t index;
+            if (user_mqtt_pool_acquire(&pool, name, sizeof(name), data, data_len, data_len, &index) == ESP_OK &&
+                index != USER_MQTT_POOL_INDEX_NONE)
+            {
+                memcpy(pool.slots[index].topic, name, sizeof(name));
+                pool.slots[index].topic_len = sizeof(name);
+                memcpy(pool.slots[index].data, data, data_len);
+                pool.slots[index].data_len = data_len;
+                user_mqtt_pool_queue(&pool, index, seq++);
+            }
+        }
+
+        /* The processing task takes the next command once the previous handler returned. */
+        pending = (path == TEST_PATH_LATEST) ? (latest.dirty != 0) : pool.queue_count;
+        if ((now < busy_until) || (pending == 0))
+        {
+            continue;
+        }
+
+        uint32_t topic;
+        uint32_t value;
+        if (path == TEST_PATH_LATEST)
+        {
+            user_mqtt_latest_value_t latest_value;
+
+            topic = user_mqtt_latest_take(&latest, seq, &latest_value);
+            latest_value.data[latest_value.data_len] = '\0';
+            value = strtoul(latest_value.data, NULL, 10);
+        }
+        else
+        {
+            uint8_t index;
+
+            user_mqtt_pool_receive(&pool, &index);
+            topic = pool.slots[index].topic[6] - '0';
+            pool.slots[index].data[pool.slots[index].data_len] = '\0';
+            value = strtoul(pool.slots[index].data, NULL, 10);
+            user_mqtt_pool_release(&pool, index);
+        }
+
+        busy_until = now + TEST_STORM_HANDLER_MS;
+        uint32_t latency = busy_until - arrival[topic][value];
+
+        storm->calls++;
+        storm->stale += (value + 1 < sent[topic]) ? 1 : 0;
+        storm->latency_sum += latency;
+        storm->latency_max = (latency > storm->latency_max) ? latency : storm->latency_max;
+        storm->final_value[topic] = value;
+        if (value == TEST_STORM_UPDATES - 1)
+        {
+            storm->settled = (latency > storm->settled) ? latency : storm->settled;
+        }
+        pending = (path == TEST_PATH_LATEST) ? (latest.dirty != 0) : pool.queue_count;
+    }
+}
+/**
+ * @brief  Slider storm latency, message queue against value slots.
+ */
+static void test_slider_storm(void)
+{
+    static const char *const labels[TEST_PATH_MAX] = { "queue", "coalesce", "latest" };
+    test_storm_t storms[TEST_PATH_MAX];
+
+    for (int path = 0; path < TEST_PATH_MAX; path++)
+    {
+        test_storm_t *storm = &storms[path];
+
+        test_storm_run((test_path_t)path, storm);
+        printf("storm %-8s %4u calls, %4u stale, latency mean %4u ms max %4u ms, settled %4u ms\n", labels[path],
+               (unsigned)storm->calls, (unsigned)storm->stale, (unsigned)(storm->latency_sum / storm->calls),
+               (unsigned)storm->latency_max, (unsigned)storm->settled);
+
+        /* Every slider ends on its last position. */
+        for (uint32_t topic = 0; topic < TEST_STORM_TOPICS; topic++)
+        {
+            TEST_CHECK_EQUAL(TEST_STORM_UPDATES - 1, storm->final_value[topic]);
+        }
+    }
+
+    /* One handler call per slider and handler time at most, nothing stale is applied. */
+    test_storm_t *latest = &storms[TEST_PATH_LATEST];
+    TEST_CHECK_EQUAL(0, latest->stale);
+    TEST_CHECK(latest->calls < storms[TEST_PATH_QUEUE].calls);
+    TEST_CHECK(latest->latency_max <= (TEST_STORM_TOPICS + 1) * TEST_STORM_HANDLER_MS);
+    TEST_CHECK(latest->latency_max < storms[TEST_PATH_QUEUE].latency_max);
+    TEST_CHECK(latest->settled < storms[TEST_PATH_QUEUE].settled);
+}
+/**
+ * @brief  Time of a store and a take, against acquire, queue, receive and release of the message pool.
+ */
+static void test_throughput(void)
+{
+    static user_mqtt_pool_t pool;
+    static const char *const labels[] = { "queue", "latest" };
+    user_mqtt_latest_t latest;
+    user_mqtt_latest_value_t value;
+    uint64_t taken[2] = { 0 };
+
+    user_mqtt_pool_init(&pool, USER_MQTT_OVERFLOW_DROP_OLDEST);
+    user_mqtt_latest_init(&latest);
+
+    for (int method = 0; method < 2; method++)
+    {
+        struct timespec start;
+        struct timespec end;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (uint32_t round = 0; round < TEST_BENCHMARK_ROUNDS; round++)
+        {
+            uint8_t index;
+
+            if (method == 0)
+            {
+                user_mqtt_pool_acquire(&pool, "fanSpeedCommand", 15, "42", 2, 2, &index);
+                memcpy(pool.slots[index].topic, "fanSpeedCommand", 15);
+                memcpy(pool.slots[index].data, "42", 2);
+                user_mqtt_pool_queue(&pool, index, round);
+                taken[method] += user_mqtt_pool_receive(&pool, &index);
+                user_mqtt_pool_release(&pool, index);
+            }
+            else
+            {
+                user_mqtt_latest_store(&latest, round % 18, "42", 2, round);
+                taken[method] += (user_mqtt_latest_take(&latest, round + 1, &value) >= 0);
+            }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        uint64_t ns = (uint64_t)(end.tv_sec - start.tv_sec) * 1000000000U + (uint64_t)end.tv_nsec - (uint64_t)start.tv_nsec;
+        printf("value %-6s %5.1f ns per command\n", labels[method], (double)ns / TEST_BENCHMARK_ROUNDS);
+    }
+
+    TEST_CHECK_EQUAL(TEST_BENCHMARK_ROUNDS, taken[0]);
+    TEST_CHECK_EQUAL(TEST_BENCHMARK_ROUNDS, taken[1]);
+}
+
+int main(void)
+{
+    TEST_CASE(test_store_take);
+    TEST_CASE(test_against_reference);
+    TEST_CASE(test_slider_storm);
+    TEST_CASE(test_throughput);
+
+    return TEST_RESULT();
+}
+/******************************** End of File *********************************/
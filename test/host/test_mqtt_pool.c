@@ -0,0 +1,316 @@
+/**
+ *****************************************************************************
+ * @file    : test_mqtt_pool.c
+ * @brief   : Host tests of the static MQTT message pool
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *
+ * @note The test is linked with malloc, calloc and realloc wrapped, so any
+ *       heap allocation made by the pool is counted. A producer and a slower
+ *       consumer with a random lag push the pool into every overflow policy.
+ *****************************************************************************
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_host.h"
+#include "user_mqtt_pool.h"
+
+/** @brief Messages of the stress test. */
+#define TEST_STRESS_MESSAGES    (100000U)
+
+/** @brief Topics of the stress test. */
+#define TEST_TOPIC_COUNT        (12U)
+
+/** @brief Heap calls made by the code under test, counted by the wrappers below. */
+static uint32_t test_heap_calls = 0;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size)
+{
+    test_heap_calls++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size)
+{
+    test_heap_calls++;
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    test_heap_calls++;
+    return __real_realloc(ptr, size);
+}
+
+static uint32_t test_seed = 1;
+
+/**
+ * @brief  Pseudo-random number, the same sequence every run.
+ */
+static uint32_t test_random(void)
+{
+    test_seed = test_seed * 1103515245U + 12345U;
+
+    return test_seed >> 8;
+}
+/**
+ * @brief  Build a self-describing message, the payload names its topic and number.
+ */
+static int test_message(uint32_t number, char *topic, int *topic_len, char *data)
+{
+    uint32_t id = test_random() % TEST_TOPIC_COUNT;
+    int len;
+
+    *topic_len = snprintf(topic, USER_MQTT_POOL_TOPIC_MAX_LENGTH, "greenhouse/actuator%02u", (unsigned int)id);
+    len = snprintf(data, USER_MQTT_POOL_DATA_MAX_LENGTH, "%u:%u;", (unsigned int)id, (unsigned int)number);
+
+    /* Pad to a random length, up to a full slot. */
+    int padding = (int)(test_random() % (USER_MQTT_POOL_DATA_MAX_LENGTH - (uint32_t)len + 1));
+    memset(data + len, 'a' + (int)(number % 26), padding);
+
+    return len + padding;
+}
+/**
+ * @brief  Check a delivered message against what its payload claims to be.
+ */
+static bool test_message_intact(const user_mqtt_msg_t *msg, uint32_t *topic_id, uint32_t *number)
+{
+    char topic[USER_MQTT_POOL_TOPIC_MAX_LENGTH];
+    char prefix[24];
+    unsigned int id;
+    unsigned int n;
+    int head = 0;
+
+    /* The payload is not null terminated. */
+    int prefix_len = (msg->data_len < (int)sizeof(prefix)) ? msg->data_len : (int)sizeof(prefix) - 1;
+    memcpy(prefix, msg->data, prefix_len);
+    prefix[prefix_len] = '\0';
+    if ((sscanf(prefix, "%u:%u;%n", &id, &n, &head) != 2) || (head == 0))
+    {
+        return false;
+    }
+
+    int topic_len = snprintf(topic, sizeof(topic), "greenhouse/actuator%02u", id);
+    if ((topic_len != msg->topic_len) || (memcmp(topic, msg->topic, topic_len) != 0) || (id >= TEST_TOPIC_COUNT))
+    {
+        return false;
+    }
+
+    for (int i = head; i < msg->data_len; i++)
+    {
+        if (msg->data[i] != 'a' + (int)(n % 26))
+        {
+            return false;
+        }
+    }
+
+    *topic_id = id;
+    *number = n;
+    return true;
+}
+/**
+ * @brief  The slots come back to the free list, the queue keeps arrival order.
+ */
+static void test_queue_order(void)
+{
+    static user_mqtt_pool_t pool;
+    uint8_t index;
+
+    user_mqtt_pool_init(&pool, USER_MQTT_OVERFLOW_DROP_NEWEST);
+
+    for (uint32_t i = 0; i < USER_MQTT_POOL_SIZE; i++)
+    {
+        TEST_CHECK_EQUAL(ESP_OK, user_mqtt_pool_acquire(&pool, "t", 1, "x", 1, 1, &index));
+        TEST_CHECK_EQUAL(ESP_OK, user_mqtt_pool_queue(&pool, index, 100 + i));
+    }
+    TEST_CHECK_EQUAL(ESP_ERR_NO_MEM, user_mqtt_pool_acquire(&pool, "t", 1, "x", 1, 1, &index));
+    TEST_CHECK_EQUAL(USER_MQTT_POOL_SIZE, pool.stats.high_water_mark);
+
+    for (uint32_t i = 0; i < USER_MQTT_POOL_SIZE; i++)
+    {
+        TEST_CHECK(user_mqtt_pool_receive(&pool, &index));
+        TEST_CHECK_EQUAL(100 + i, pool.slots[index].seq);
+        TEST_CHECK(pool.slots[index].queued == false);
+        user_mqtt_pool_release(&pool, index);
+    }
+    TEST_CHECK(user_mqtt_pool_receive(&pool, &index) == false);
+    TEST_CHECK_EQUAL(USER_MQTT_POOL_SIZE, pool.free_count);
+    TEST_CHECK_EQUAL(USER_MQTT_POOL_SIZE, pool.stats.received);
+    TEST_CHECK_EQUAL(1, pool.stats.dropped_newest);
+}
+/**
+ * @brief  A coalesce replaces the newest queued message of the topic, in place.
+ */
+static void test_coalesce(void)
+{
+    static user_mqtt_pool_t pool;
+    uint8_t index;
+
+    user_mqtt_pool_init(&pool, USER_MQTT_OVERFLOW_COALESCE);
+
+    for (uint32_t i = 0; i < USER_MQTT_POOL_SIZE; i++)
+    {
+        const char *topic = (i % 2) ? "fan" : "light";
+
+        TEST_CHECK_EQUAL(ESP_OK, user_mqtt_pool_acquire(&pool, topic, (int)strlen(topic), "0", 1, 1, &index));
+        pool.slots[index].topic_len = (int)strlen(topic);
+        memcpy(pool.slots[index].topic, topic, strlen(topic));
+        pool.slots[index].data[0] = (char)('0' + i);
+        pool.slots[index].data_len = 1;
+        TEST_CHECK_EQUAL(ESP_OK, user_mqtt_pool_queue(&pool, index, i));
+    }
+
+    /* The newest "fan" message is the last one queued. */
+    TEST_CHECK_EQUAL(ESP_OK, user_mqtt_pool_acquire(&pool, "fan", 3, "new", 3, 3, &index));
+    TEST_CHECK_EQUAL(USER_MQTT_POOL_INDEX_NONE, index);
+    TEST_CHECK_EQUAL(1, pool.stats.coalesced);
+
+    /* A fragment can not be merged, the oldest message makes room instead. */
+    TEST_CHECK_EQUAL(ESP_OK, user_mqtt_pool_acquire(&pool, "fan", 3, "ne", 2, 3, &index));
+    TEST_CHECK(index != USER_MQTT_POOL_INDEX_NONE);
+    TEST_CHECK_EQUAL(1, pool.stats.dropped_oldest);
+    user_mqtt_pool_release(&pool, index);
+
+    /* The abandoned slot is free again, then an unknown topic falls back to drop the oldest one too. */
+    TEST_CHECK_EQUAL(ESP_OK, user_mqtt_pool_acquire(&pool, "pump", 4, "on", 2, 2, &index));
+    TEST_CHECK_EQUAL(1, pool.stats.dropped_oldest);
+    pool.slots[index].data[0] = (char)('0' + USER_MQTT_POOL_SIZE);
+    TEST_CHECK_EQUAL(ESP_OK, user_mqtt_pool_queue(&pool, index, USER_MQTT_POOL_SIZE));
+    TEST_CHECK_EQUAL(ESP_OK, user_mqtt_pool_acquire(&pool, "door", 4, "on", 2, 2, &index));
+    TEST_CHECK_EQUAL(2, pool.stats.dropped_oldest);
+    user_mqtt_pool_release(&pool, index);
+
+    for (uint32_t i = 2; i <= USER_MQTT_POOL_SIZE; i++)
+    {
+        TEST_CHECK(user_mqtt_pool_receive(&pool, &index));
+        TEST_CHECK_EQUAL(i, pool.slots[index].seq);
+        if (i == USER_MQTT_POOL_SIZE - 1)
+        {
+            TEST_CHECK((pool.slots[index].data_len == 3) && (memcmp(pool.slots[index].data, "new", 3) == 0));
+        }
+        else
+        {
+            TEST_CHECK_EQUAL('0' + i, pool.slots[index].data[0]);
+        }
+        user_mqtt_pool_release(&pool, index);
+    }
+}
+/**
+ * @brief  100k messages through a pool drained by a lagging consumer, without one heap allocation.
+ */
+static void test_stress(void)
+{
+    static const user_mqtt_overflow_policy_t policies[] = {
+        USER_MQTT_OVERFLOW_DROP_OLDEST, USER_MQTT_OVERFLOW_DROP_NEWEST, USER_MQTT_OVERFLOW_COALESCE,
+    };
+    static user_mqtt_pool_t pool;
+    static char data[USER_MQTT_POOL_DATA_MAX_LENGTH];
+    uint32_t last_number[TEST_TOPIC_COUNT];
+    char topic[USER_MQTT_POOL_TOPIC_MAX_LENGTH];
+    uint32_t delivered = 0;
+    uint32_t corrupted = 0;
+    uint32_t reordered = 0;
+    uint32_t seq = 0;
+    uint32_t last_seq = 0;
+    uint32_t heap_calls;
+
+    user_mqtt_pool_init(&pool, USER_MQTT_OVERFLOW_DROP_OLDEST);
+    memset(last_number, 0xFF, sizeof(last_number));
+
+    for (uint32_t number = 0; number < TEST_STRESS_MESSAGES; number++)
+    {
+        int topic_len;
+        int data_len = test_message(number, topic, &topic_len, data);
+        uint8_t index;
+
+        /* A new policy every 10k messages. */
+        pool.policy = policies[(number / 10000) % 3];
+
+        heap_calls = test_heap_calls;
+        if (user_mqtt_pool_acquire(&pool, topic, topic_len, data, data_len, data_len, &index) == ESP_OK)
+        {
+            if (index != USER_MQTT_POOL_INDEX_NONE)
+            {
+                user_mqtt_msg_t *msg = &pool.slots[index];
+
+                msg->topic_len = topic_len;
+                memcpy(msg->topic, topic, topic_len);
+                msg->data_len = data_len;
+                memcpy(msg->data, data, data_len);
+                TEST_CHECK_EQUAL(ESP_OK, user_mqtt_pool_queue(&pool, index, seq++));
+            }
+        }
+
+        /* The consumer keeps up in bursts, and falls behind in between. */
+        uint32_t lag = ((number / 1000) % 2) ? (test_random() % 2) : (test_random() % 4);
+        for (uint32_t n = 0; (n < lag) && user_mqtt_pool_receive(&pool, &index); n++)
+        {
+            user_mqtt_msg_t *msg = &pool.slots[index];
+            uint32_t id = 0;
+            uint32_t received;
+
+            if (test_message_intact(msg, &id, &received) == false)
+            {
+                corrupted++;
+            }
+            else
+            {
+                if ((last_number[id] != UINT32_MAX) && (received <= last_number[id]))
+                {
+                    reordered++;
+                }
+                last_number[id] = received;
+            }
+            if ((delivered > 0) && (msg->seq <= last_seq))
+            {
+                reordered++;
+            }
+            last_seq = msg->seq;
+            delivered++;
+
+            user_mqtt_pool_release(&pool, index);
+        }
+        TEST_CHECK_EQUAL(heap_calls, test_heap_calls);
+    }
+
+    /* Drain what is left. */
+    for (uint8_t index; user_mqtt_pool_receive(&pool, &index); delivered++)
+    {
+        user_mqtt_pool_release(&pool, index);
+    }
+
+    TEST_CHECK_EQUAL(0, test_heap_calls);
+    TEST_CHECK_EQUAL(0, corrupted);
+    TEST_CHECK_EQUAL(0, reordered);
+    TEST_CHECK_EQUAL(USER_MQTT_POOL_SIZE, pool.free_count);
+
+    /* Every message is accounted for. */
+    TEST_CHECK_EQUAL(TEST_STRESS_MESSAGES, pool.stats.received + pool.stats.dropped_newest);
+    TEST_CHECK_EQUAL(pool.stats.received, delivered + pool.stats.dropped_oldest + pool.stats.coalesced);
+    TEST_CHECK_EQUAL(pool.stats.overflow, pool.stats.dropped_newest + pool.stats.dropped_oldest + pool.stats.coalesced);
+    TEST_CHECK(pool.stats.dropped_oldest > 0);
+    TEST_CHECK(pool.stats.dropped_newest > 0);
+    TEST_CHECK(pool.stats.coalesced > 0);
+    TEST_CHECK_EQUAL(USER_MQTT_POOL_SIZE, pool.stats.high_water_mark);
+
+    printf("%u messages, %u delivered, %u dropped oldest, %u dropped newest, %u coalesced, %u heap calls\n",
+           (unsigned int)TEST_STRESS_MESSAGES, (unsigned int)delivered, (unsigned int)pool.stats.dropped_oldest,
+           (unsigned int)pool.stats.dropped_newest, (unsigned int)pool.stats.coalesced, (unsigned int)test_heap_calls);
+}
+
+int main(void)
+{
+    TEST_CASE(test_queue_order);
+    TEST_CASE(test_coalesce);
+    TEST_CASE(test_stress);
+
+    return TEST_RESULT();
+}
+/******************************** End of File *********************************/
@@ -0,0 +1,342 @@
+/**
+ *****************************************************************************
+ * @file    : test_mqtt_topic.c
+ * @brief   : Host tests of the MQTT subscribe topic dispatch table
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *
+ * @note The table holds the subscribe topics of user_esp32_mqtt.c in the same
+ *       order, every entry is told apart by its handler. The benchmark compares
+ *       the hash index with the binary search and the strcmp chain it replaced.
+ *****************************************************************************
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "esp_err.h"
+
+#include "test_host.h"
+#include "user_esp32_mqtt.h"
+#include "user_mqtt_topic.h"
+
+/** @brief Handler called by the last dispatch. */
+static const char *test_handled = NULL;
+
+#define TEST_HANDLER(_name)                                 \
+    static void test_##_name(const char *data, int data_len) \
+    {                                                       \
+        (void)data;                                         \
+        (void)data_len;                                     \
+        test_handled = #_name;                              \
+    }
+
+TEST_HANDLER(ota_service)
+TEST_HANDLER(codec_format)
+TEST_HANDLER(fan_state1)
+TEST_HANDLER(fan_speed1)
+TEST_HANDLER(rgb_light1)
+TEST_HANDLER(rgb_state1)
+TEST_HANDLER(rgb_recipe1)
+TEST_HANDLER(rgb_color1)
+TEST_HANDLER(switch_valve1)
+TEST_HANDLER(irrigation_state)
+TEST_HANDLER(irrigation_zone)
+TEST_HANDLER(pump1)
+TEST_HANDLER(rgb_light2)
+TEST_HANDLER(rgb_state2)
+TEST_HANDLER(rgb_recipe2)
+TEST_HANDLER(rgb_color2)
+TEST_HANDLER(switch_valve2)
+TEST_HANDLER(switch_valve3)
+
+/** @brief Dispatch table of user_esp32_mqtt.c. */
+static const mqtt_topic_entry_t test_table[] = {
+    MQTT_TOPIC_ENTRY(SUB_OTA_SERVICE, test_ota_service),
+    MQTT_TOPIC_LATEST_ENTRY(SUB_CODEC_FORMAT, test_codec_format),
+    MQTT_TOPIC_LATEST_ENTRY(SUB_FAN_STATE1, test_fan_state1),
+    MQTT_TOPIC_LATEST_ENTRY(SUB_FAN_SPEED1, test_fan_speed1),
+    MQTT_TOPIC_LATEST_ENTRY(SUB_RGB_LIGHT1, test_rgb_light1),
+    MQTT_TOPIC_LATEST_ENTRY(SUB_RGB_STATE1, test_rgb_state1),
+    MQTT_TOPIC_ENTRY(SUB_RGB_RECIPE1, test_rgb_recipe1),
+    MQTT_TOPIC_LATEST_ENTRY(SUB_RGB_COLOR1, test_rgb_color1),
+    MQTT_TOPIC_LATEST_ENTRY(SUB_SWITCH_VALVE_STATE1, test_switch_valve1),
+    MQTT_TOPIC_LATEST_ENTRY(SUB_IRRIGATION_STATE, test_irrigation_state),
+    MQTT_TOPIC_ENTRY(SUB_IRRIGATION_ZONE, test_irrigation_zone),
+    MQTT_TOPIC_LATEST_ENTRY(SUB_PUMP_STATE1, test_pump1),
+    MQTT_TOPIC_LATEST_ENTRY(SUB_RGB_LIGHT2, test_rgb_light2),
+    MQTT_TOPIC_LATEST_ENTRY(SUB_RGB_STATE2, test_rgb_state2),
+    MQTT_TOPIC_ENTRY(SUB_RGB_RECIPE2, test_rgb_recipe2),
+    MQTT_TOPIC_LATEST_ENTRY(SUB_RGB_COLOR2, test_rgb_color2),
+    MQTT_TOPIC_LATEST_ENTRY(SUB_SWITCH_VALVE_STATE2, test_switch_valve2),
+    MQTT_TOPIC_LATEST_ENTRY(SUB_SWITCH_VALVE_STATE3, test_switch_valve3),
+};
+
+#define TEST_TABLE_SIZE     ((int)(sizeof(test_table) / sizeof(test_table[0])))
+
+/** @brief Lookups per method of the benchmark. */
+#define TEST_BENCHMARK_ROUNDS   (2000000U)
+
+/** @brief Hash index of test_table. */
+static mqtt_topic_index_t test_index;
+
+/**
+ * @brief  Look a topic up from a buffer that is not null terminated, like the MQTT client delivers it.
+ */
+static const mqtt_topic_entry_t *test_lookup(const mqtt_topic_index_t *index, const char *topic)
+{
+    char buffer[64];
+    int len = (int)strlen(topic);
+
+    memset(buffer, '#', sizeof(buffer));
+    memcpy(buffer, topic, len);
+
+    return mqtt_topic_index_lookup(index, buffer, len);
+}
+/**
+ * @brief  The table of the firmware is indexed whole, the client creation would fail otherwise.
+ */
+static void test_table_indexed(void)
+{
+    TEST_CHECK_EQUAL(-1, mqtt_topic_index_build(&test_index, test_table, TEST_TABLE_SIZE));
+    TEST_CHECK(TEST_TABLE_SIZE <= (int)(MQTT_TOPIC_INDEX_SIZE / 2));
+}
+/**
+ * @brief  Every subscribed topic dispatches to its own handler.
+ */
+static void test_lookup_all(void)
+{
+    static const struct
+    {
+        const char *topic;
+        const char *handler;
+        bool latest_only;
+    } expected[] = {
+        { "firstSwitchCommand", "switch_valve1", true },
+        { "secondSwitchCommand", "switch_valve2", true },
+        { "thirdSwitchCommand", "switch_valve3", true },
+        { "pumpCommand", "pump1", true },
+        { "firstLightCommand", "rgb_state1", true },
+        { "secondLightCommand", "rgb_state2", true },
+        { "firstBrightnessCommand", "rgb_light1", true },
+        { "secondBrightnessCommand", "rgb_light2", true },
+        { "firstRgbCommand", "rgb_color1", true },
+        { "secondRgbCommand", "rgb_color2", true },
+        { "firstLightRecipeCommand", "rgb_recipe1", false },
+        { "secondLightRecipeCommand", "rgb_recipe2", false },
+        { "irrigationCommand", "irrigation_state", true },
+        { "irrigationZoneCommand", "irrigation_zone", false },
+        { "fanCommand", "fan_state1", true },
+        { "fanSpeedCommand", "fan_speed1", true },
+        { "OTAServiceCommand", "ota_service", false },
+        { "codecFormatCommand", "codec_format", true },
+    };
+
+    TEST_CHECK_EQUAL(TEST_TABLE_SIZE, (int)(sizeof(expected) / sizeof(expected[0])));
+
+    for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); i++)
+    {
+        const mqtt_topic_entry_t *entry = test_lookup(&test_index, expected[i].topic);
+
+        TEST_CHECK(entry != NULL);
+        if (entry == NULL)
+        {
+            continue;
+        }
+
+        test_handled = NULL;
+        entry->handler("", 0);
+        TEST_CHECK((test_handled != NULL) && (strcmp(test_handled, expected[i].handler) == 0));
+        TEST_CHECK(entry->latest_only == expected[i].latest_only);
+    }
+}
+/**
+ * @brief  Prefixes, extensions and near misses of subscribed topics are not dispatched.
+ */
+static void test_lookup_unknown(void)
+{
+    static const char *const topics[] = {
+        "",
+        "fan",                          /* Prefix of two topics. */
+        "fanCommand2",                  /* Extension of a topic. */
+        "fanSpeed",                     /* Prefix of a topic, extension of another one. */
+        "FanCommand",                   /* Case differs. */
+        "otaServiceCommand",
+        "AAA",                          /* Before the first entry. */
+        "zzz",                          /* After the last entry. */
+        "firstSwitchState",             /* A publish topic. */
+    };
+
+    mqtt_topic_index_t empty;
+
+    for (size_t i = 0; i < sizeof(topics) / sizeof(topics[0]); i++)
+    {
+        TEST_CHECK(test_lookup(&test_index, topics[i]) == NULL);
+    }
+
+    TEST_CHECK_EQUAL(-1, mqtt_topic_index_build(&empty, test_table, 0));
+    TEST_CHECK(test_lookup(&empty, SUB_FAN_STATE1) == NULL);
+}
+/**
+ * @brief  Any order is indexed, entries listed twice or over half the slots are reported at the first bad entry.
+ */
+static void test_table_order_and_duplicates(void)
+{
+    static const mqtt_topic_entry_t swapped[] = {
+        MQTT_TOPIC_ENTRY(SUB_FAN_STATE1, test_fan_state1),
+        MQTT_TOPIC_ENTRY(SUB_FAN_SPEED1, test_fan_speed1),
+        MQTT_TOPIC_ENTRY(SUB_RGB_LIGHT1, test_rgb_light1),
+        MQTT_TOPIC_ENTRY(SUB_OTA_SERVICE, test_ota_service),
+    };
+    static const mqtt_topic_entry_t twice[] = {
+        MQTT_TOPIC_ENTRY(SUB_FAN_STATE1, test_fan_state1),
+        MQTT_TOPIC_ENTRY(SUB_FAN_SPEED1, test_fan_speed1),
+        MQTT_TOPIC_ENTRY(SUB_FAN_STATE1, test_fan_state1),
+    };
+    /* Only topic_len bytes of the name count, both entries are "fanCommand". */
+    static const mqtt_topic_entry_t prefix[] = {
+        { "fanCommandX", 10, test_fan_state1, true },
+        { "fanCommand", 10, test_fan_state1, true },
+    };
+    static char names[MQTT_TOPIC_INDEX_SIZE][8];
+    static mqtt_topic_entry_t many[MQTT_TOPIC_INDEX_SIZE];
+    mqtt_topic_index_t index;
+
+    TEST_CHECK_EQUAL(-1, mqtt_topic_index_build(&index, swapped, 4));
+    for (int i = 0; i < 4; i++)
+    {
+        TEST_CHECK(test_lookup(&index, swapped[i].topic) == &swapped[i]);
+    }
+
+    TEST_CHECK_EQUAL(2, mqtt_topic_index_build(&index, twice, 3));
+    TEST_CHECK_EQUAL(1, mqtt_topic_index_build(&index, prefix, 2));
+    TEST_CHECK_EQUAL(-1, mqtt_topic_index_build(&index, prefix, 1));
+    TEST_CHECK(test_lookup(&index, "fanCommand") == &prefix[0]);
+
+    /* Half the slots at most, so every probe ends on a free slot. */
+    for (int i = 0; i < (int)MQTT_TOPIC_INDEX_SIZE; i++)
+    {
+        many[i].topic = names[i];
+        many[i].topic_len = snprintf(names[i], sizeof(names[i]), "t%d", i);
+        many[i].handler = test_fan_state1;
+    }
+    TEST_CHECK_EQUAL(-1, mqtt_topic_index_build(&index, many, MQTT_TOPIC_INDEX_SIZE / 2));
+    for (int i = 0; i < (int)(MQTT_TOPIC_INDEX_SIZE / 2); i++)
+    {
+        TEST_CHECK(test_lookup(&index, names[i]) == &many[i]);
+    }
+    TEST_CHECK(test_lookup(&index, "t99") == NULL);
+    TEST_CHECK_EQUAL(MQTT_TOPIC_INDEX_SIZE / 2, mqtt_topic_index_build(&index, many, MQTT_TOPIC_INDEX_SIZE / 2 + 1));
+}
+
+/**
+ * @brief  Binary search of a table sorted in strcmp() order, the lookup the hash index replaced.
+ */
+static const mqtt_topic_entry_t *test_binary_lookup(const mqtt_topic_entry_t *table, int count, const char *topic,
+                                                    int topic_len)
+{
+    int low = 0;
+    int high = count - 1;
+
+    while (low <= high)
+    {
+        int mid = (low + high) / 2;
+        int len = (topic_len < table[mid].topic_len) ? topic_len : table[mid].topic_len;
+        int ret = memcmp(topic, table[mid].topic, len);
+
+        ret = (ret == 0) ? topic_len - table[mid].topic_len : ret;
+        if (ret == 0)
+        {
+            return &table[mid];
+        }
+        low = (ret > 0) ? mid + 1 : low;
+        high = (ret < 0) ? mid - 1 : high;
+    }
+
+    return NULL;
+}
+/**
+ * @brief  Compare one entry after the other, the strcmp chain of the first firmware.
+ */
+static const mqtt_topic_entry_t *test_linear_lookup(const mqtt_topic_entry_t *table, int count, const char *topic,
+                                                    int topic_len)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if ((table[i].topic_len == topic_len) && (memcmp(table[i].topic, topic, topic_len) == 0))
+        {
+            return &table[i];
+        }
+    }
+
+    return NULL;
+}
+/**
+ * @brief  Lookup time of every subscribed topic and a miss, hash index against the lookups it replaced.
+ */
+static void test_benchmark(void)
+{
+    static const char *const labels[] = { "hash", "binary", "linear" };
+    const char *topics[TEST_TABLE_SIZE + 1];
+    int lengths[TEST_TABLE_SIZE + 1];
+    uint64_t found[3] = { 0 };
+
+    for (int i = 0; i < TEST_TABLE_SIZE; i++)
+    {
+        topics[i] = test_table[i].topic;
+        lengths[i] = test_table[i].topic_len;
+    }
+    topics[TEST_TABLE_SIZE] = "firstSwitchState";
+    lengths[TEST_TABLE_SIZE] = (int)strlen(topics[TEST_TABLE_SIZE]);
+
+    for (int method = 0; method < 3; method++)
+    {
+        struct timespec start;
+        struct timespec end;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (uint32_t round = 0; round < TEST_BENCHMARK_ROUNDS; round++)
+        {
+            uint32_t i = round % (TEST_TABLE_SIZE + 1);
+            const mqtt_topic_entry_t *entry;
+
+            if (method == 0)
+            {
+                entry = mqtt_topic_index_lookup(&test_index, topics[i], lengths[i]);
+            }
+            else if (method == 1)
+            {
+                entry = test_binary_lookup(test_table, TEST_TABLE_SIZE, topics[i], lengths[i]);
+            }
+            else
+            {
+                entry = test_linear_lookup(test_table, TEST_TABLE_SIZE, topics[i], lengths[i]);
+            }
+            found[method] += (entry != NULL) ? 1 : 0;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        uint64_t ns = (uint64_t)(end.tv_sec - start.tv_sec) * 1000000000U + (uint64_t)end.tv_nsec - (uint64_t)start.tv_nsec;
+        printf("lookup %-6s %5.1f ns per topic\n", labels[method], (double)ns / TEST_BENCHMARK_ROUNDS);
+    }
+
+    /* The three methods agree, the miss is never found. */
+    TEST_CHECK_EQUAL(found[1], found[0]);
+    TEST_CHECK_EQUAL(found[2], found[0]);
+    TEST_CHECK(found[0] < TEST_BENCHMARK_ROUNDS);
+}
+
+int main(void)
+{
+    TEST_CASE(test_table_indexed);
+    TEST_CASE(test_lookup_all);
+    TEST_CASE(test_lookup_unknown);
+    TEST_CASE(test_table_order_and_duplicates);
+    TEST_CASE(test_benchmark);
+
+    return TEST_RESULT();
+}
+/******************************** End of File *********************************/
@@ -0,0 +1,210 @@
+/**
+ *****************************************************************************
+ * @file    : test_sampler_wheel.c
+ * @brief   : Host tests of the sensor sampling timer wheel
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *
+ * @note Every channel checks, when it runs, that the wheel time is the one its
+ *       period and phase predict.
+ *****************************************************************************
+ */
+
+#include <string.h>
+
+#include "test_host.h"
+#include "user_sampler_wheel.h"
+
+/** @brief Sampling channel under test. */
+typedef struct
+{
+    const sampler_wheel_t *wheel;
+    uint32_t period;
+    uint32_t expected;  /* Wheel time of the next run. */
+    uint32_t runs;
+    uint32_t misses;    /* Runs at another time than expected. */
+} test_channel_t;
+
+static void test_sample(void *arg)
+{
+    test_channel_t *ch = (test_channel_t *)arg;
+
+    if (ch->wheel->now != ch->expected)
+    {
+        ch->misses++;
+    }
+    ch->expected = ch->wheel->now + ch->period;
+    ch->runs++;
+}
+/**
+ * @brief  Register a channel checking its own schedule.
+ */
+static int test_add(sampler_wheel_t *wheel, test_channel_t *ch, uint32_t period, uint32_t phase)
+{
+    memset(ch, 0, sizeof(*ch));
+    ch->wheel = wheel;
+    ch->period = period;
+    ch->expected = wheel->now + ((phase == 0) ? 1 : phase);
+
+    return sampler_wheel_add(wheel, period, phase, test_sample, ch);
+}
+/**
+ * @brief  Advance the wheel one ms at a time, like the sampler task on every tick.
+ */
+static void test_run(sampler_wheel_t *wheel, uint32_t ms)
+{
+    uint32_t end = wheel->now + ms;
+
+    while (wheel->now != end)
+    {
+        sampler_wheel_advance(wheel, wheel->now + 1);
+    }
+}
+/**
+ * @brief  Periods within and beyond every wheel level run on time, without jitter.
+ */
+static void test_periods(void)
+{
+    static const uint32_t periods[] = { 1, 7, 63, 64, 65, 1000, 4095, 4096, 5000, 300000 };
+    test_channel_t channels[10];
+    sampler_wheel_t wheel;
+    sampler_wheel_stats_t stats;
+
+    sampler_wheel_init(&wheel, 12345);
+    for (int i = 0; i < 10; i++)
+    {
+        TEST_CHECK_EQUAL(i, test_add(&wheel, &channels[i], periods[i], (uint32_t)(i * 3)));
+    }
+
+    test_run(&wheel, 20 * 60 * 1000);
+
+    for (int i = 0; i < 10; i++)
+    {
+        uint32_t first = (i == 0) ? 1 : (uint32_t)(i * 3);
+
+        TEST_CHECK_EQUAL(0, channels[i].misses);
+        TEST_CHECK_EQUAL((20 * 60 * 1000 - first) / periods[i] + 1, channels[i].runs);
+        TEST_CHECK(sampler_wheel_get_stats(&wheel, i, &stats));
+        TEST_CHECK_EQUAL(channels[i].runs, stats.runs);
+        TEST_CHECK_EQUAL(0, stats.max_jitter_ms);
+        TEST_CHECK_EQUAL(0, stats.overruns);
+    }
+}
+/**
+ * @brief  Channels with the same period and different phases never run in the same ms.
+ */
+static void test_phase(void)
+{
+    test_channel_t channels[4];
+    sampler_wheel_t wheel;
+    uint32_t runs = 0;
+
+    sampler_wheel_init(&wheel, 0);
+    for (int i = 0; i < 4; i++)
+    {
+        test_add(&wheel, &channels[i], 1000, (uint32_t)(250 * i));
+    }
+
+    for (uint32_t ms = 0; ms < 10000; ms++)
+    {
+        uint32_t before = channels[0].runs + channels[1].runs + channels[2].runs + channels[3].runs;
+
+        test_run(&wheel, 1);
+        runs = channels[0].runs + channels[1].runs + channels[2].runs + channels[3].runs;
+        TEST_CHECK(runs - before <= 1);
+    }
+
+    TEST_CHECK_EQUAL(40, runs);
+    for (int i = 0; i < 4; i++)
+    {
+        TEST_CHECK_EQUAL(0, channels[i].misses);
+    }
+}
+/**
+ * @brief  A late advance runs the due channels once with their delay, whole periods missed are skipped.
+ */
+static void test_late(void)
+{
+    test_channel_t ch;
+    sampler_wheel_t wheel;
+    sampler_wheel_stats_t stats;
+
+    sampler_wheel_init(&wheel, 0);
+    test_add(&wheel, &ch, 100, 100);
+
+    /* The task was blocked for 350 ms: one run at 350 for the one due at 100, 200 and 300 are skipped. */
+    sampler_wheel_advance(&wheel, 350);
+    TEST_CHECK_EQUAL(1, ch.runs);
+    TEST_CHECK(sampler_wheel_get_stats(&wheel, 0, &stats));
+    TEST_CHECK_EQUAL(250, stats.last_jitter_ms);
+    TEST_CHECK_EQUAL(2, stats.overruns);
+
+    /* The phase is kept: the next run is at 400, not 450. */
+    ch.expected = 400;
+    test_run(&wheel, 1000 - 350);
+    TEST_CHECK_EQUAL(0, ch.misses);
+    TEST_CHECK_EQUAL(1 + 7, ch.runs);
+
+    /* A delay shorter than a period is only jitter. */
+    sampler_wheel_advance(&wheel, 1130);
+    TEST_CHECK(sampler_wheel_get_stats(&wheel, 0, &stats));
+    TEST_CHECK_EQUAL(30, stats.last_jitter_ms);
+    TEST_CHECK_EQUAL(250, stats.max_jitter_ms);
+    TEST_CHECK_EQUAL(250 + 30, stats.total_jitter_ms);
+    TEST_CHECK_EQUAL(2, stats.overruns);
+}
+/**
+ * @brief  The schedule is kept across a wrap of the tick count.
+ */
+static void test_wrap(void)
+{
+    test_channel_t channels[2];
+    sampler_wheel_t wheel;
+
+    sampler_wheel_init(&wheel, UINT32_MAX - 5000);
+    test_add(&wheel, &channels[0], 300, 17);
+    test_add(&wheel, &channels[1], 70000, 5);
+
+    test_run(&wheel, 200000);
+
+    TEST_CHECK_EQUAL(0, channels[0].misses);
+    TEST_CHECK_EQUAL((200000 - 17) / 300 + 1, channels[0].runs);
+    TEST_CHECK_EQUAL(0, channels[1].misses);
+    TEST_CHECK_EQUAL(3, channels[1].runs);
+}
+/**
+ * @brief  Invalid channels and a full wheel are refused.
+ */
+static void test_add_invalid(void)
+{
+    test_channel_t ch;
+    sampler_wheel_t wheel;
+    sampler_wheel_stats_t stats;
+
+    sampler_wheel_init(&wheel, 0);
+    TEST_CHECK_EQUAL(-1, sampler_wheel_add(&wheel, 0, 0, test_sample, &ch));
+    TEST_CHECK_EQUAL(-1, sampler_wheel_add(&wheel, 100, 0, NULL, &ch));
+
+    for (int i = 0; i < SAMPLER_WHEEL_MAX_CHANNELS; i++)
+    {
+        TEST_CHECK_EQUAL(i, test_add(&wheel, &ch, 100, 0));
+    }
+    TEST_CHECK_EQUAL(-1, test_add(&wheel, &ch, 100, 0));
+
+    TEST_CHECK(!sampler_wheel_get_stats(&wheel, -1, &stats));
+    TEST_CHECK(!sampler_wheel_get_stats(&wheel, SAMPLER_WHEEL_MAX_CHANNELS, &stats));
+    TEST_CHECK(!sampler_wheel_get_stats(&wheel, 0, NULL));
+}
+
+int main(void)
+{
+    TEST_CASE(test_periods);
+    TEST_CASE(test_phase);
+    TEST_CASE(test_late);
+    TEST_CASE(test_wrap);
+    TEST_CASE(test_add_invalid);
+
+    return TEST_RESULT();
+}
+/******************************** End of File *********************************/
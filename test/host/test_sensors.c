@@ -0,0 +1,177 @@
+/**
+ *****************************************************************************
+ * @file    : test_sensors.c
+ * @brief   : Host tests of the SHT3x and BMP280 conversions
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *
+ * @note The expected values are the worked examples of the Sensirion SHT3x
+ *       and the Bosch BMP280 datasheets.
+ *****************************************************************************
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "esp_err.h"
+#include "test_host.h"
+#include "sht3x.h"
+#include "bmp280.h"
+
+/** @brief Calibration of the BMP280 datasheet example, section 3.12. */
+static const int32_t test_bmp280_dig[12] = {
+    27504, 26435, -1000,                                    /* dig_T1 .. dig_T3. */
+    36477, -10685, 3024, 2855, 140, -7, 15500, -14600, 6000 /* dig_P1 .. dig_P9. */
+};
+
+/** @brief Raw readings of the same example. */
+#define TEST_BMP280_ADC_T       (519888)
+#define TEST_BMP280_ADC_P       (415148)
+
+/**
+ * @brief  Build an SHT3x measurement, each word followed by its CRC.
+ */
+static void test_sht3x_raw(uint16_t temperature, uint16_t humidity, uint8_t *raw)
+{
+    raw[0] = (uint8_t)(temperature >> 8);
+    raw[1] = (uint8_t)temperature;
+    raw[2] = sht3x_crc8(&raw[0], 2);
+    raw[3] = (uint8_t)(humidity >> 8);
+    raw[4] = (uint8_t)humidity;
+    raw[5] = sht3x_crc8(&raw[3], 2);
+}
+
+/**
+ * @brief  Build the BMP280 calibration registers, little endian words.
+ */
+static void test_bmp280_calib_raw(uint8_t *raw)
+{
+    for (int i = 0; i < 12; i++)
+    {
+        raw[2 * i] = (uint8_t)test_bmp280_dig[i];
+        raw[2 * i + 1] = (uint8_t)((uint32_t)test_bmp280_dig[i] >> 8);
+    }
+}
+
+/**
+ * @brief  Build a BMP280 burst read, 20-bit readings MSB first.
+ */
+static void test_bmp280_data_raw(int32_t adc_p, int32_t adc_t, uint8_t *raw)
+{
+    raw[0] = (uint8_t)(adc_p >> 12);
+    raw[1] = (uint8_t)(adc_p >> 4);
+    raw[2] = (uint8_t)(adc_p << 4);
+    raw[3] = (uint8_t)(adc_t >> 12);
+    raw[4] = (uint8_t)(adc_t >> 4);
+    raw[5] = (uint8_t)(adc_t << 4);
+}
+
+/**
+ * @brief  CRC-8 example of the SHT3x datasheet: 0xBEEF gives 0x92.
+ */
+static void test_sht3x_crc(void)
+{
+    const uint8_t word[2] = { 0xBE, 0xEF };
+
+    TEST_CHECK_EQUAL(0x92, sht3x_crc8(word, sizeof(word)));
+    TEST_CHECK_EQUAL(0xFF, sht3x_crc8(word, 0));
+}
+
+/**
+ * @brief  Conversion formulas at the ends and the middle of the range.
+ */
+static void test_sht3x_decode(void)
+{
+    uint8_t raw[SHT3X_DATA_LENGTH];
+    sht3x_data_t data;
+
+    test_sht3x_raw(0x0000, 0x0000, raw);
+    TEST_CHECK_EQUAL(ESP_OK, sht3x_decode(raw, &data));
+    TEST_CHECK_EQUAL(-4500, data.temperature);
+    TEST_CHECK_EQUAL(0, data.humidity);
+
+    test_sht3x_raw(0xFFFF, 0xFFFF, raw);
+    TEST_CHECK_EQUAL(ESP_OK, sht3x_decode(raw, &data));
+    TEST_CHECK_EQUAL(13000, data.temperature);
+    TEST_CHECK_EQUAL(10000, data.humidity);
+
+    /* 0x6666 is 70/175 of the range, 25 degrees, 0x8000 is 50.0008 %RH. */
+    test_sht3x_raw(0x6666, 0x8000, raw);
+    TEST_CHECK_EQUAL(ESP_OK, sht3x_decode(raw, &data));
+    TEST_CHECK_EQUAL(2500, data.temperature);
+    TEST_CHECK_EQUAL(5000, data.humidity);
+}
+
+/**
+ * @brief  A corrupted word or CRC is rejected.
+ */
+static void test_sht3x_bad_crc(void)
+{
+    uint8_t raw[SHT3X_DATA_LENGTH];
+    sht3x_data_t data = { 0 };
+
+    test_sht3x_raw(0x6666, 0x8000, raw);
+    raw[1] ^= 0x01;
+    TEST_CHECK_EQUAL(ESP_ERR_INVALID_CRC, sht3x_decode(raw, &data));
+
+    test_sht3x_raw(0x6666, 0x8000, raw);
+    raw[5] ^= 0x80;
+    TEST_CHECK_EQUAL(ESP_ERR_INVALID_CRC, sht3x_decode(raw, &data));
+    TEST_CHECK_EQUAL(0, data.temperature);
+}
+
+/**
+ * @brief  Compensation example of the BMP280 datasheet: 25.08 degrees, 100653.27 Pa.
+ */
+static void test_bmp280_decode(void)
+{
+    uint8_t calib_raw[BMP280_CALIB_LENGTH];
+    uint8_t raw[BMP280_DATA_LENGTH];
+    bmp280_calib_t calib;
+    bmp280_data_t data;
+
+    test_bmp280_calib_raw(calib_raw);
+    TEST_CHECK_EQUAL(ESP_OK, bmp280_parse_calib(calib_raw, &calib));
+
+    test_bmp280_data_raw(TEST_BMP280_ADC_P, TEST_BMP280_ADC_T, raw);
+    TEST_CHECK_EQUAL(ESP_OK, bmp280_decode(&calib, raw, &data));
+    TEST_CHECK_EQUAL(2508, data.temperature);
+    TEST_CHECK_EQUAL(100653, data.pressure);
+}
+
+/**
+ * @brief  Blank calibration and readings before the first measurement are rejected.
+ */
+static void test_bmp280_invalid(void)
+{
+    uint8_t calib_raw[BMP280_CALIB_LENGTH];
+    uint8_t raw[BMP280_DATA_LENGTH];
+    bmp280_calib_t calib;
+    bmp280_data_t data;
+
+    memset(calib_raw, 0, sizeof(calib_raw));
+    TEST_CHECK_EQUAL(ESP_ERR_INVALID_RESPONSE, bmp280_parse_calib(calib_raw, &calib));
+
+    test_bmp280_calib_raw(calib_raw);
+    TEST_CHECK_EQUAL(ESP_OK, bmp280_parse_calib(calib_raw, &calib));
+
+    /* Reset value of the data registers, the measurement was skipped. */
+    test_bmp280_data_raw(0x80000, TEST_BMP280_ADC_T, raw);
+    TEST_CHECK_EQUAL(ESP_ERR_INVALID_STATE, bmp280_decode(&calib, raw, &data));
+    test_bmp280_data_raw(TEST_BMP280_ADC_P, 0x80000, raw);
+    TEST_CHECK_EQUAL(ESP_ERR_INVALID_STATE, bmp280_decode(&calib, raw, &data));
+}
+
+int main(void)
+{
+    TEST_CASE(test_sht3x_crc);
+    TEST_CASE(test_sht3x_decode);
+    TEST_CASE(test_sht3x_bad_crc);
+    TEST_CASE(test_bmp280_decode);
+    TEST_CASE(test_bmp280_invalid);
+
+    return TEST_RESULT();
+}
+/******************************** End of File *********************************/
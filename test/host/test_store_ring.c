@@ -0,0 +1,352 @@
+/**
+ *****************************************************************************
+ * @file    : test_store_ring.c
+ * @brief   : Host tests of the telemetry store flash ring
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *
+ * @note The ring runs on a partition emulated in a temporary file with NOR
+ *       semantics: a write only clears bits, an erase sets a sector to 0xFF.
+ *       A reboot is a new ring on the same file. Writes can be made to fail,
+ *       or to stop half way like on a power loss.
+ *****************************************************************************
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "test_host.h"
+#include "user_store_ring.h"
+
+/** @brief Emulated partition, 4 sectors of 16 records. */
+#define TEST_SECTOR_SIZE        (256U)
+#define TEST_SECTORS            (4U)
+#define TEST_PARTITION_SIZE     (TEST_SECTORS * TEST_SECTOR_SIZE)
+#define TEST_CAPACITY           (TEST_PARTITION_SIZE / USER_STORE_RECORD_SIZE)
+#define TEST_PER_SECTOR         (TEST_SECTOR_SIZE / USER_STORE_RECORD_SIZE)
+#define TEST_CHANNELS           (8U)
+
+/** @brief File backed flash. */
+typedef struct
+{
+    FILE *file;
+    int fail_writes;        /* Writes that fail from now on, without touching the flash. */
+    size_t torn_bytes;      /* When not 0, the next write stops after this many bytes and fails. */
+    uint32_t writes;
+    uint32_t erases;
+} test_flash_t;
+
+static esp_err_t test_flash_read(void *ctx, size_t offset, void *buf, size_t len)
+{
+    test_flash_t *flash = (test_flash_t *)ctx;
+
+    TEST_CHECK(offset + len <= TEST_PARTITION_SIZE);
+    if ((fseek(flash->file, (long)offset, SEEK_SET) != 0) || (fread(buf, 1, len, flash->file) != len))
+    {
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+
+static esp_err_t test_flash_write(void *ctx, size_t offset, const void *buf, size_t len)
+{
+    test_flash_t *flash = (test_flash_t *)ctx;
+    uint8_t cells[TEST_SECTOR_SIZE];
+    esp_err_t ret = ESP_OK;
+
+    TEST_CHECK((offset + len <= TEST_PARTITION_SIZE) && (len <= sizeof(cells)));
+    flash->writes++;
+    if (flash->fail_writes > 0)
+    {
+        flash->fail_writes--;
+        return ESP_FAIL;
+    }
+    if (flash->torn_bytes != 0)
+    {
+        len = (flash->torn_bytes < len) ? flash->torn_bytes : len;
+        flash->torn_bytes = 0;
+        ret = ESP_FAIL;
+    }
+
+    /* NOR cells only go from 1 to 0. */
+    test_flash_read(ctx, offset, cells, len);
+    for (size_t i = 0; i < len; i++)
+    {
+        cells[i] &= ((const uint8_t *)buf)[i];
+    }
+    fseek(flash->file, (long)offset, SEEK_SET);
+    fwrite(cells, 1, len, flash->file);
+
+    return ret;
+}
+
+static esp_err_t test_flash_erase(void *ctx, size_t offset, size_t len)
+{
+    test_flash_t *flash = (test_flash_t *)ctx;
+    uint8_t blank[TEST_SECTOR_SIZE];
+
+    TEST_CHECK(((offset % TEST_SECTOR_SIZE) == 0) && (len == TEST_SECTOR_SIZE));
+    flash->erases++;
+    memset(blank, 0xFF, sizeof(blank));
+    fseek(flash->file, (long)offset, SEEK_SET);
+    fwrite(blank, 1, sizeof(blank), flash->file);
+
+    return ESP_OK;
+}
+/**
+ * @brief  Create a blank partition, like a new device.
+ */
+static void test_flash_open(test_flash_t *flash)
+{
+    memset(flash, 0, sizeof(*flash));
+    flash->file = tmpfile();
+    TEST_CHECK(flash->file != NULL);
+    for (uint32_t offset = 0; offset < TEST_PARTITION_SIZE; offset += TEST_SECTOR_SIZE)
+    {
+        test_flash_erase(flash, offset, TEST_SECTOR_SIZE);
+    }
+    flash->erases = 0;
+}
+/**
+ * @brief  Start a ring on the partition, also used to reboot.
+ */
+static esp_err_t test_ring_boot(user_store_ring_t *ring, test_flash_t *flash)
+{
+    const user_store_flash_t access = {
+        .read = test_flash_read,
+        .write = test_flash_write,
+        .erase = test_flash_erase,
+        .ctx = flash,
+    };
+
+    return user_store_ring_init(ring, &access, TEST_PARTITION_SIZE, TEST_SECTOR_SIZE, TEST_CHANNELS);
+}
+/**
+ * @brief  Append records whose value is their sequence number.
+ */
+static void test_ring_fill(user_store_ring_t *ring, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t sequence = ring->head;
+
+        TEST_CHECK_EQUAL(ESP_OK, user_store_ring_append(ring, (uint8_t)(sequence % TEST_CHANNELS), 1000U + sequence, (int32_t)sequence * -3));
+    }
+}
+/**
+ * @brief  Check that the entries are the records of their sequence numbers.
+ */
+static void test_check_entries(const user_store_entry_t *entries, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        TEST_CHECK_EQUAL(entries[i].sequence % TEST_CHANNELS, entries[i].channel);
+        TEST_CHECK_EQUAL(1000U + entries[i].sequence, entries[i].timestamp);
+        TEST_CHECK_EQUAL((int32_t)entries[i].sequence * -3, entries[i].value);
+    }
+}
+/**
+ * @brief  The record CRC is esp_rom_crc16_le, CRC-16/X-25, check value 0x906E.
+ */
+static void test_crc(void)
+{
+    const uint8_t check[] = "123456789";
+
+    TEST_CHECK_EQUAL(0x906E, user_store_crc16(0, check, 9));
+    /* Chaining gives the CRC of the whole. */
+    TEST_CHECK_EQUAL(0x906E, user_store_crc16(user_store_crc16(0, check, 4), &check[4], 5));
+    TEST_CHECK_EQUAL(0, user_store_crc16(0, check, 0));
+}
+/**
+ * @brief  Records come back in order, released records stay released across a reboot.
+ */
+static void test_append_release(void)
+{
+    user_store_entry_t entries[TEST_CAPACITY];
+    user_store_ring_t ring;
+    test_flash_t flash;
+
+    test_flash_open(&flash);
+    TEST_CHECK_EQUAL(ESP_OK, test_ring_boot(&ring, &flash));
+    TEST_CHECK_EQUAL(TEST_CAPACITY, ring.capacity);
+    TEST_CHECK_EQUAL(0, ring.head - ring.tail);
+
+    test_ring_fill(&ring, 20);
+    TEST_CHECK_EQUAL(20, ring.head - ring.tail);
+    TEST_CHECK_EQUAL(2, ring.stats.erases);
+    TEST_CHECK_EQUAL(ESP_ERR_INVALID_ARG, user_store_ring_append(&ring, TEST_CHANNELS, 0, 0));
+
+    TEST_CHECK_EQUAL(8, user_store_ring_read(&ring, ring.tail, 8, entries));
+    TEST_CHECK_EQUAL(0, entries[0].sequence);
+    TEST_CHECK_EQUAL(7, entries[7].sequence);
+    test_check_entries(entries, 8);
+    TEST_CHECK_EQUAL(ESP_OK, user_store_ring_release(&ring, 0, 8));
+    TEST_CHECK_EQUAL(8, ring.tail);
+
+    /* A stale release, the tail moved since the range was read, changes nothing. */
+    TEST_CHECK_EQUAL(ESP_OK, user_store_ring_release(&ring, 0, 8));
+    TEST_CHECK_EQUAL(8, ring.tail);
+
+    TEST_CHECK_EQUAL(ESP_OK, test_ring_boot(&ring, &flash));
+    TEST_CHECK_EQUAL(20, ring.head);
+    TEST_CHECK_EQUAL(8, ring.tail);
+    TEST_CHECK_EQUAL(12, user_store_ring_read(&ring, ring.tail, 12, entries));
+    TEST_CHECK_EQUAL(8, entries[0].sequence);
+    test_check_entries(entries, 12);
+
+    /* Appends go on after the recovered head. */
+    test_ring_fill(&ring, 1);
+    TEST_CHECK_EQUAL(20, ring.head - 1);
+    TEST_CHECK_EQUAL(1, user_store_ring_read(&ring, 20, 1, entries));
+    TEST_CHECK_EQUAL(20, entries[0].sequence);
+
+    fclose(flash.file);
+}
+/**
+ * @brief  A full ring erases its oldest sector, the lost records are counted and recovery agrees.
+ */
+static void test_wrap(void)
+{
+    user_store_entry_t entries[TEST_CAPACITY];
+    user_store_ring_t ring;
+    test_flash_t flash;
+
+    test_flash_open(&flash);
+    TEST_CHECK_EQUAL(ESP_OK, test_ring_boot(&ring, &flash));
+
+    /* One full lap and a sector more, nothing released. */
+    test_ring_fill(&ring, TEST_CAPACITY + TEST_PER_SECTOR + 3);
+    TEST_CHECK_EQUAL(TEST_SECTORS + 2, ring.stats.erases);
+    TEST_CHECK_EQUAL(2 * TEST_PER_SECTOR, ring.stats.overwritten);
+    TEST_CHECK_EQUAL(2 * TEST_PER_SECTOR, ring.tail);
+    TEST_CHECK_EQUAL(TEST_CAPACITY - TEST_PER_SECTOR + 3, ring.head - ring.tail);
+
+    int count = user_store_ring_read(&ring, ring.tail, ring.head - ring.tail, entries);
+    TEST_CHECK_EQUAL(ring.head - ring.tail, count);
+    TEST_CHECK_EQUAL(2 * TEST_PER_SECTOR, entries[0].sequence);
+    TEST_CHECK_EQUAL(ring.head - 1, entries[count - 1].sequence);
+    test_check_entries(entries, count);
+
+    /* An overwritten range reads back empty. */
+    TEST_CHECK_EQUAL(0, user_store_ring_read(&ring, 0, TEST_PER_SECTOR, entries));
+
+    uint32_t head = ring.head;
+    uint32_t tail = ring.tail;
+    TEST_CHECK_EQUAL(ESP_OK, test_ring_boot(&ring, &flash));
+    TEST_CHECK_EQUAL(head, ring.head);
+    TEST_CHECK_EQUAL(tail, ring.tail);
+
+    /* Release across the wrap of the slots. */
+    TEST_CHECK_EQUAL(ESP_OK, user_store_ring_release(&ring, tail, TEST_CAPACITY - TEST_PER_SECTOR));
+    TEST_CHECK_EQUAL(ESP_OK, test_ring_boot(&ring, &flash));
+    TEST_CHECK_EQUAL(head, ring.head);
+    TEST_CHECK_EQUAL(tail + TEST_CAPACITY - TEST_PER_SECTOR, ring.tail);
+    TEST_CHECK_EQUAL(3, ring.head - ring.tail);
+
+    fclose(flash.file);
+}
+/**
+ * @brief  A consumed mark that fails to write is counted, the batch comes back after a reboot.
+ */
+static void test_mark_failure(void)
+{
+    user_store_entry_t entries[TEST_CAPACITY];
+    user_store_ring_t ring;
+    test_flash_t flash;
+
+    test_flash_open(&flash);
+    TEST_CHECK_EQUAL(ESP_OK, test_ring_boot(&ring, &flash));
+    test_ring_fill(&ring, 10);
+    TEST_CHECK_EQUAL(ESP_OK, user_store_ring_release(&ring, 0, 4));
+
+    flash.fail_writes = 1;
+    TEST_CHECK_EQUAL(ESP_FAIL, user_store_ring_release(&ring, 4, 4));
+    TEST_CHECK_EQUAL(1, ring.stats.mark_failures);
+    /* Released for this boot, the records were forwarded. */
+    TEST_CHECK_EQUAL(8, ring.tail);
+
+    TEST_CHECK_EQUAL(ESP_OK, test_ring_boot(&ring, &flash));
+    TEST_CHECK_EQUAL(4, ring.tail);
+    TEST_CHECK_EQUAL(6, user_store_ring_read(&ring, ring.tail, ring.head - ring.tail, entries));
+    TEST_CHECK_EQUAL(4, entries[0].sequence);
+
+    /* A failed append loses its slot, the reads skip it. */
+    flash.fail_writes = 1;
+    TEST_CHECK_EQUAL(ESP_FAIL, user_store_ring_append(&ring, 1, 0, 0));
+    TEST_CHECK_EQUAL(11, ring.head);
+    TEST_CHECK_EQUAL(0, ring.stats.appended);
+    test_ring_fill(&ring, 1);
+    TEST_CHECK_EQUAL(7, user_store_ring_read(&ring, ring.tail, ring.head - ring.tail, entries));
+    TEST_CHECK_EQUAL(11, entries[6].sequence);
+
+    fclose(flash.file);
+}
+/**
+ * @brief  A record torn by a power loss is skipped by the reads and by the recovery.
+ */
+static void test_torn_record(void)
+{
+    user_store_entry_t entries[TEST_CAPACITY];
+    user_store_ring_t ring;
+    test_flash_t flash;
+
+    test_flash_open(&flash);
+    TEST_CHECK_EQUAL(ESP_OK, test_ring_boot(&ring, &flash));
+    test_ring_fill(&ring, 5);
+
+    /* Power lost half way through the sixth record. */
+    flash.torn_bytes = USER_STORE_RECORD_SIZE / 2;
+    TEST_CHECK_EQUAL(ESP_FAIL, user_store_ring_append(&ring, 1, 0, 0));
+
+    /* The programmed half of the slot can not take a record, the recovery skips it. */
+    TEST_CHECK_EQUAL(ESP_OK, test_ring_boot(&ring, &flash));
+    TEST_CHECK_EQUAL(6, ring.head);
+    TEST_CHECK_EQUAL(0, ring.tail);
+
+    /* A record corrupted in the middle of the range: the reads go around it. */
+    test_ring_fill(&ring, 3);
+    uint8_t garbage = 0x00;
+    test_flash_write(&flash, 7 * USER_STORE_RECORD_SIZE + 8, &garbage, 1);
+    int count = user_store_ring_read(&ring, 0, ring.head, entries);
+    TEST_CHECK_EQUAL(7, count);
+    TEST_CHECK_EQUAL(6, entries[5].sequence);
+    TEST_CHECK_EQUAL(8, entries[6].sequence);
+    test_check_entries(entries, count);
+
+    TEST_CHECK_EQUAL(ESP_OK, test_ring_boot(&ring, &flash));
+    TEST_CHECK_EQUAL(9, ring.head);
+
+    fclose(flash.file);
+}
+/**
+ * @brief  Geometries the ring can not use are rejected.
+ */
+static void test_init_invalid(void)
+{
+    const user_store_flash_t access = {
+        .read = test_flash_read,
+        .write = test_flash_write,
+        .erase = test_flash_erase,
+        .ctx = NULL,
+    };
+    user_store_ring_t ring;
+
+    TEST_CHECK_EQUAL(ESP_ERR_INVALID_ARG, user_store_ring_init(&ring, &access, TEST_SECTOR_SIZE, TEST_SECTOR_SIZE, TEST_CHANNELS));
+    TEST_CHECK_EQUAL(ESP_ERR_INVALID_ARG, user_store_ring_init(&ring, &access, TEST_PARTITION_SIZE, 100, TEST_CHANNELS));
+    TEST_CHECK_EQUAL(ESP_ERR_INVALID_ARG, user_store_ring_init(&ring, &access, TEST_PARTITION_SIZE, 0, TEST_CHANNELS));
+}
+
+int main(void)
+{
+    TEST_CASE(test_crc);
+    TEST_CASE(test_append_release);
+    TEST_CASE(test_wrap);
+    TEST_CASE(test_mark_failure);
+    TEST_CASE(test_torn_record);
+    TEST_CASE(test_init_invalid);
+
+    return TEST_RESULT();
+}
+/******************************** End of File *********************************/
@@ -0,0 +1,269 @@
+/**
+ *****************************************************************************
+ * @file    : test_telemetry_filter.c
+ * @brief   : Host tests of the telemetry report-by-exception filter
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *
+ * @note Recorded window means are replayed through the filter with the
+ *       firmware defaults of user_esp32_telemetry.c, the way the publish task
+ *       drives it: check, hand over, then update with the outcome.
+ *****************************************************************************
+ */
+
+#include <string.h>
+
+#include "test_host.h"
+#include "user_telemetry_filter.h"
+
+/** @brief Firmware defaults, soil moisture and air temperature channels. */
+static const user_telemetry_filter_t test_soil = { 50, 500, 60 * 1000U, 15 * 60 * 1000U };
+static const user_telemetry_filter_t test_temp = { 20, 100, 60 * 1000U, 15 * 60 * 1000U };
+
+/**
+ * @brief Soil moisture of a greenhouse bed, 1/100 %, one window per minute.
+ *        Two hours of drying with probe noise, a watering at minute 70.
+ */
+static const int32_t test_soil_trace[] = {
+    4012, 4010, 4013, 4009, 4008, 4011, 4007, 4006, 4008, 4004, 4003, 4005, 4001, 4000, 4002, 3998,
+    3997, 3999, 3995, 3994, 3996, 3992, 3991, 3993, 3989, 3988, 3990, 3986, 3985, 3987, 3983, 3982,
+    3984, 3980, 3979, 3981, 3977, 3976, 3978, 3974, 3973, 3975, 3971, 3970, 3972, 3968, 3967, 3969,
+    3965, 3964, 3966, 3962, 3961, 3963, 3959, 3958, 3960, 3956, 3955, 3957, 3953, 3952, 3954, 3950,
+    3949, 3951, 3947, 3946, 3948, 3944, 4162, 4371, 4405, 4412, 4410, 4413, 4409, 4408, 4411, 4407,
+    4406, 4408, 4404, 4403, 4405, 4401, 4400, 4402, 4398, 4397, 4399, 4395, 4394, 4396, 4392, 4391,
+    4393, 4389, 4388, 4390, 4386, 4385, 4387, 4383, 4382, 4384, 4380, 4379, 4381, 4377, 4376, 4378,
+    4374, 4373, 4375, 4371, 4370, 4372, 4368, 4367,
+};
+
+/** @brief Air temperature, 1/100 degree Celsius, hourly points of a sunny day. */
+static const int32_t test_temp_hours[] = {
+    1620, 1580, 1540, 1510, 1490, 1500, 1580, 1760, 1990, 2230, 2450, 2630,
+    2770, 2840, 2850, 2790, 2660, 2470, 2240, 2030, 1880, 1780, 1710, 1660, 1620,
+};
+
+/** @brief Outcome of a replay. */
+typedef struct
+{
+    uint32_t windows;       /* Windows replayed. */
+    uint32_t reports;       /* Values handed over. */
+    uint32_t max_gap_ms;    /* Longest time between two reports. */
+    int32_t max_error;      /* Largest drift of a suppressed value from the last report, once min_interval elapsed. */
+    uint32_t first_report;  /* Window of the first report after start_window. */
+} test_replay_t;
+
+/**
+ * @brief  Replay a trace, every window a step_ms apart, every hand-off succeeds.
+ */
+static void test_replay(const user_telemetry_filter_t *filter, const int32_t *trace, uint32_t count, uint32_t step_ms,
+                        uint32_t start_ms, uint32_t start_window, test_replay_t *out)
+{
+    user_telemetry_filter_state_t state;
+    uint32_t now = start_ms;
+
+    memset(&state, 0, sizeof(state));
+    memset(out, 0, sizeof(*out));
+    out->first_report = UINT32_MAX;
+
+    for (uint32_t i = 0; i < count; i++, now += step_ms)
+    {
+        bool report = user_telemetry_filter_check(filter, &state, trace[i], now);
+
+        if (report)
+        {
+            if (state.reported && ((now - state.last_ms) > out->max_gap_ms))
+            {
+                out->max_gap_ms = now - state.last_ms;
+            }
+            if ((i >= start_window) && (out->first_report == UINT32_MAX))
+            {
+                out->first_report = i;
+            }
+            out->reports++;
+        }
+        else if ((now - state.last_ms) >= filter->min_interval_ms)
+        {
+            int32_t error = trace[i] - state.last_value;
+            error = (error < 0) ? -error : error;
+            out->max_error = (error > out->max_error) ? error : out->max_error;
+        }
+
+        user_telemetry_filter_update(&state, trace[i], now, report);
+        out->windows++;
+    }
+}
+/**
+ * @brief  Slow soil drying is mostly suppressed, the watering step is reported in its own window.
+ */
+static void test_soil_trace_replay(void)
+{
+    uint32_t count = sizeof(test_soil_trace) / sizeof(test_soil_trace[0]);
+    test_replay_t result;
+
+    test_replay(&test_soil, test_soil_trace, count, 60 * 1000U, 0, 70, &result);
+
+    TEST_CHECK_EQUAL(count, result.windows);
+    TEST_CHECK_EQUAL(70, result.first_report);
+    TEST_CHECK(result.max_error < test_soil.deadband);
+    TEST_CHECK(result.max_gap_ms <= test_soil.max_silence_ms);
+
+    /* The first value, a dead-band crossing every ~20 minutes of drying, the step and a few heartbeats. */
+    TEST_CHECK(result.reports >= 4);
+    TEST_CHECK(result.reports * 8 <= count);
+}
+/**
+ * @brief  A day of air temperature with sensor noise, reported within the dead-band and the heartbeat.
+ */
+static void test_temp_day_replay(void)
+{
+    static int32_t trace[24 * 60];
+    uint32_t seed = 12345;
+    test_replay_t result;
+
+    /* Minute windows interpolated from the hourly points, with +/-0.05 degree of noise. */
+    for (uint32_t minute = 0; minute < 24 * 60; minute++)
+    {
+        int32_t from = test_temp_hours[minute / 60];
+        int32_t to = test_temp_hours[minute / 60 + 1];
+
+        seed = seed * 1103515245U + 12345U;
+        trace[minute] = from + (to - from) * (int32_t)(minute % 60) / 60 + (int32_t)((seed >> 16) % 11) - 5;
+    }
+
+    test_replay(&test_temp, trace, 24 * 60, 60 * 1000U, 0, 0, &result);
+
+    TEST_CHECK_EQUAL(0, result.first_report);
+    TEST_CHECK(result.max_error < test_temp.deadband);
+    TEST_CHECK(result.max_gap_ms <= test_temp.max_silence_ms);
+
+    /* Noise alone never crosses the dead-band, the day curve does about every 10 minutes at its steepest. */
+    TEST_CHECK(result.reports >= 24 * 60 / 15);
+    TEST_CHECK(result.reports * 2 <= 24 * 60);
+}
+/**
+ * @brief  Flat values are reported by the heartbeat only, across a wrap-around of the millisecond clock.
+ */
+static void test_heartbeat(void)
+{
+    static int32_t trace[3 * 60];
+    test_replay_t result;
+
+    for (uint32_t i = 0; i < 3 * 60; i++)
+    {
+        trace[i] = 2500 + (int32_t)(i % 3);
+    }
+
+    test_replay(&test_soil, trace, 3 * 60, 60 * 1000U, UINT32_MAX - 30 * 60 * 1000U, 0, &result);
+
+    /* The first value, then one every 15 minutes of the 3 hours. */
+    TEST_CHECK_EQUAL(3 * 60 / 15, result.reports);
+    TEST_CHECK_EQUAL(test_soil.max_silence_ms, result.max_gap_ms);
+}
+/**
+ * @brief  A fast change is reported inside the minimum interval, a slow one of the same size is not.
+ */
+static void test_rate(void)
+{
+    user_telemetry_filter_state_t state;
+    user_telemetry_filter_t flat = test_soil;
+    uint32_t now = 1000;
+
+    memset(&state, 0, sizeof(state));
+    TEST_CHECK(user_telemetry_filter_check(&test_soil, &state, 4000, now));
+    user_telemetry_filter_update(&state, 4000, now, true);
+
+    /* 10 s windows, 0.5 % in 10 s is 3 %/min, under the rate. */
+    now += 10 * 1000U;
+    TEST_CHECK(user_telemetry_filter_check(&test_soil, &state, 4050, now) == false);
+    user_telemetry_filter_update(&state, 4050, now, false);
+
+    /* 1 % in 10 s is 6 %/min, reported 20 s after the last report. */
+    now += 10 * 1000U;
+    TEST_CHECK(user_telemetry_filter_check(&test_soil, &state, 4150, now));
+    user_telemetry_filter_update(&state, 4150, now, true);
+
+    /* The rate is measured against the previous window, the same level is not a change. */
+    now += 10 * 1000U;
+    TEST_CHECK(user_telemetry_filter_check(&test_soil, &state, 4150, now) == false);
+    user_telemetry_filter_update(&state, 4150, now, false);
+
+    /* Falling as fast counts too. */
+    now += 10 * 1000U;
+    TEST_CHECK(user_telemetry_filter_check(&test_soil, &state, 4040, now));
+
+    /* A window in the same millisecond carries no rate, and no rate when it is off. */
+    TEST_CHECK(user_telemetry_filter_check(&test_soil, &state, 4150, now - 10 * 1000U) == false);
+    flat.rate_per_min = 0;
+    TEST_CHECK(user_telemetry_filter_check(&flat, &state, 4040, now) == false);
+}
+/**
+ * @brief  A value that could not be handed over is not taken as reported, the next window retries it.
+ */
+static void test_failed_hand_off(void)
+{
+    user_telemetry_filter_state_t state;
+    uint32_t now = 0;
+
+    memset(&state, 0, sizeof(state));
+
+    /* The first value is lost, it stays first. */
+    TEST_CHECK(user_telemetry_filter_check(&test_soil, &state, 4000, now));
+    user_telemetry_filter_update(&state, 4000, now, false);
+    TEST_CHECK(state.reported == false);
+    now += 60 * 1000U;
+    TEST_CHECK(user_telemetry_filter_check(&test_soil, &state, 4001, now));
+    user_telemetry_filter_update(&state, 4001, now, true);
+
+    /* A dead-band crossing is lost, the following window still crosses against the last report. */
+    now += 60 * 1000U;
+    TEST_CHECK(user_telemetry_filter_check(&test_soil, &state, 4060, now));
+    user_telemetry_filter_update(&state, 4060, now, false);
+    TEST_CHECK_EQUAL(4001, state.last_value);
+    now += 60 * 1000U;
+    TEST_CHECK(user_telemetry_filter_check(&test_soil, &state, 4061, now));
+    user_telemetry_filter_update(&state, 4061, now, true);
+
+    /* A lost heartbeat is due again next window. */
+    now += test_soil.max_silence_ms;
+    TEST_CHECK(user_telemetry_filter_check(&test_soil, &state, 4061, now));
+    user_telemetry_filter_update(&state, 4061, now, false);
+    now += 60 * 1000U;
+    TEST_CHECK(user_telemetry_filter_check(&test_soil, &state, 4061, now));
+}
+/**
+ * @brief  Configurations the filter can not honour are refused.
+ */
+static void test_valid(void)
+{
+    user_telemetry_filter_t filter = test_soil;
+
+    TEST_CHECK(user_telemetry_filter_valid(&test_soil));
+    TEST_CHECK(user_telemetry_filter_valid(&test_temp));
+
+    filter.deadband = -1;
+    TEST_CHECK(user_telemetry_filter_valid(&filter) == false);
+
+    filter = test_soil;
+    filter.rate_per_min = -1;
+    TEST_CHECK(user_telemetry_filter_valid(&filter) == false);
+
+    filter = test_soil;
+    filter.max_silence_ms = filter.min_interval_ms - 1;
+    TEST_CHECK(user_telemetry_filter_valid(&filter) == false);
+
+    filter.max_silence_ms = filter.min_interval_ms;
+    TEST_CHECK(user_telemetry_filter_valid(&filter));
+}
+
+int main(void)
+{
+    TEST_CASE(test_soil_trace_replay);
+    TEST_CASE(test_temp_day_replay);
+    TEST_CASE(test_heartbeat);
+    TEST_CASE(test_rate);
+    TEST_CASE(test_failed_hand_off);
+    TEST_CASE(test_valid);
+
+    return TEST_RESULT();
+}
+/******************************** End of File *********************************/
@@ -0,0 +1,255 @@
+/**
+ *****************************************************************************
+ * @file    : test_uart_ring.c
+ * @brief   : Host tests of the UART stream byte ring
+ * @author  : Cao Jin
+ * @date    : 16-Oct-2026
+ * @version : 1.0.0
+ *
+ * @note The driver is a byte source that counts up. Bytes that do not fit the
+ *       ring are discarded from the source, like the receive task does, and a
+ *       reference queue tells which bytes the consumer must see.
+ *****************************************************************************
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+
+#include "test_host.h"
+#include "user_uart_ring.h"
+
+/** @brief Small ring, so most writes and reads wrap. */
+#define TEST_RING_SIZE          (16U)
+
+/** @brief Random writes and reads of the single thread tests. */
+#define TEST_OPERATIONS         (200000U)
+
+/** @brief Bytes moved by the two thread test. */
+#define TEST_THREAD_BYTES       (4000000U)
+
+/** @brief Driver model, hands out a counting byte sequence. */
+typedef struct
+{
+    uint32_t next;      /* Value of the next byte. */
+    size_t limit;       /* Bytes the driver has, a fill gets no more. */
+} test_source_t;
+
+static uint32_t test_seed = 1;
+
+/**
+ * @brief  Pseudo-random number, the same sequence every run.
+ */
+static uint32_t test_random(void)
+{
+    test_seed = test_seed * 1103515245U + 12345U;
+
+    return test_seed >> 8;
+}
+
+static int test_fill(void *ctx, uint8_t *dst, size_t len)
+{
+    test_source_t *source = ctx;
+    size_t count = (len < source->limit) ? len : source->limit;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        dst[i] = (uint8_t)source->next++;
+    }
+    source->limit -= count;
+
+    return (int)count;
+}
+/**
+ * @brief  Only power of two sizes are accepted, the indexes are masked.
+ */
+static void test_init(void)
+{
+    uint8_t buffer[TEST_RING_SIZE];
+    user_uart_ring_t ring;
+
+    TEST_CHECK_EQUAL(ESP_ERR_INVALID_ARG, user_uart_ring_init(&ring, buffer, 0));
+    TEST_CHECK_EQUAL(ESP_ERR_INVALID_ARG, user_uart_ring_init(&ring, buffer, 12));
+    TEST_CHECK_EQUAL(ESP_OK, user_uart_ring_init(&ring, buffer, TEST_RING_SIZE));
+    TEST_CHECK_EQUAL(0, user_uart_ring_available(&ring));
+}
+/**
+ * @brief  Random writes and reads against a reference queue, the indexes start just below 2^32.
+ *
+ * @note Covers segments split at the buffer end, index wrap, a full ring,
+ *       overflow counting and a driver that has fewer bytes than announced.
+ */
+static void test_wrap_and_overflow(void)
+{
+    uint8_t buffer[TEST_RING_SIZE];
+    uint8_t reference[TEST_RING_SIZE];
+    uint32_t reference_head = 0;
+    uint32_t reference_count = 0;
+    user_uart_ring_t ring;
+    test_source_t source = { 0, 0 };
+    uint64_t offered = 0;
+    uint64_t stored_total = 0;
+    uint64_t overflow_total = 0;
+    uint64_t expected_overflow = 0;
+    uint64_t read_total = 0;
+    uint32_t mismatches = 0;
+
+    user_uart_ring_init(&ring, buffer, TEST_RING_SIZE);
+    ring.head = 0xFFFFFFF0U;
+    ring.tail = 0xFFFFFFF0U;
+
+    for (uint32_t i = 0; i < TEST_OPERATIONS; i++)
+    {
+        if ((test_random() % 2) == 0)
+        {
+            size_t size = test_random() % (2 * TEST_RING_SIZE);
+            size_t free_space = TEST_RING_SIZE - reference_count;
+            size_t overflow = 0;
+
+            /* Sometimes the driver has fewer bytes than the event announced. */
+            source.limit = ((test_random() % 8) == 0) ? (test_random() % (size + 1)) : size;
+            size_t expected = (size < free_space) ? size : free_space;
+            expected = (expected < source.limit) ? expected : source.limit;
+            uint32_t first = source.next;
+
+            size_t stored = user_uart_ring_write(&ring, size, test_fill, &source, &overflow);
+            TEST_CHECK_EQUAL(expected, stored);
+            TEST_CHECK_EQUAL((size > free_space) ? size - free_space : 0, overflow);
+            for (size_t j = 0; j < stored; j++)
+            {
+                reference[(reference_head + reference_count++) % TEST_RING_SIZE] = (uint8_t)(first + j);
+            }
+
+            /* The receive task discards what did not fit. */
+            source.next += (uint32_t)overflow;
+            offered += size;
+            stored_total += stored;
+            overflow_total += overflow;
+            expected_overflow += (size > free_space) ? size - free_space : 0;
+        }
+        else
+        {
+            uint8_t out[2 * TEST_RING_SIZE];
+            size_t len = test_random() % sizeof(out);
+            size_t read = user_uart_ring_read(&ring, out, len);
+
+            TEST_CHECK_EQUAL((len < reference_count) ? len : reference_count, read);
+            for (size_t j = 0; j < read; j++)
+            {
+                mismatches += (out[j] != reference[reference_head]) ? 1 : 0;
+                reference_head = (reference_head + 1) % TEST_RING_SIZE;
+                reference_count--;
+            }
+            read_total += read;
+        }
+        TEST_CHECK_EQUAL(reference_count, user_uart_ring_available(&ring));
+    }
+
+    TEST_CHECK_EQUAL(0, mismatches);
+    TEST_CHECK(ring.head < 0xFFFFFFF0U);
+    TEST_CHECK(overflow_total > 0);
+    TEST_CHECK_EQUAL(expected_overflow, overflow_total);
+    TEST_CHECK(stored_total + overflow_total <= offered);
+    TEST_CHECK_EQUAL(stored_total, read_total + reference_count);
+}
+/**
+ * @brief  A full ring takes nothing, clear drops every stored byte.
+ */
+static void test_full_and_clear(void)
+{
+    uint8_t buffer[TEST_RING_SIZE];
+    uint8_t out[TEST_RING_SIZE];
+    user_uart_ring_t ring;
+    test_source_t source = { 0, TEST_RING_SIZE + 5 };
+    size_t overflow = 0;
+
+    user_uart_ring_init(&ring, buffer, TEST_RING_SIZE);
+    TEST_CHECK_EQUAL(TEST_RING_SIZE, user_uart_ring_write(&ring, TEST_RING_SIZE + 5, test_fill, &source, &overflow));
+    TEST_CHECK_EQUAL(5, overflow);
+
+    source.limit = 3;
+    TEST_CHECK_EQUAL(0, user_uart_ring_write(&ring, 3, test_fill, &source, &overflow));
+    TEST_CHECK_EQUAL(3, overflow);
+    TEST_CHECK_EQUAL(3, source.limit);
+
+    user_uart_ring_clear(&ring);
+    TEST_CHECK_EQUAL(0, user_uart_ring_available(&ring));
+    TEST_CHECK_EQUAL(0, user_uart_ring_read(&ring, out, sizeof(out)));
+
+    /* The bytes after the clear come out in order. */
+    TEST_CHECK_EQUAL(3, user_uart_ring_write(&ring, 3, test_fill, &source, &overflow));
+    TEST_CHECK_EQUAL(0, overflow);
+    TEST_CHECK_EQUAL(3, user_uart_ring_read(&ring, out, sizeof(out)));
+    TEST_CHECK((out[0] == TEST_RING_SIZE) && (out[1] == TEST_RING_SIZE + 1) && (out[2] == TEST_RING_SIZE + 2));
+}
+
+/** @brief Ring shared by the producer and consumer threads. */
+static user_uart_ring_t test_shared_ring;
+
+static void *test_producer(void *arg)
+{
+    test_source_t source = { 0, 0 };
+    uint32_t seed = 7;
+
+    (void)arg;
+    while (source.next < TEST_THREAD_BYTES)
+    {
+        size_t overflow = 0;
+
+        seed = seed * 1103515245U + 12345U;
+        source.limit = 1 + (seed >> 8) % TEST_RING_SIZE;
+        source.limit = (source.limit < TEST_THREAD_BYTES - source.next) ? source.limit : TEST_THREAD_BYTES - source.next;
+
+        /* Bytes that did not fit stay in the source and are offered again, the consumer sees every byte. */
+        user_uart_ring_write(&test_shared_ring, source.limit, test_fill, &source, &overflow);
+        if (overflow > 0)
+        {
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+/**
+ * @brief  A producer and a consumer thread move bytes through the ring without a lock.
+ */
+static void test_threads(void)
+{
+    static uint8_t buffer[TEST_RING_SIZE];
+    pthread_t producer;
+    uint32_t expected = 0;
+    uint32_t mismatches = 0;
+
+    user_uart_ring_init(&test_shared_ring, buffer, TEST_RING_SIZE);
+    TEST_CHECK_EQUAL(0, pthread_create(&producer, NULL, test_producer, NULL));
+
+    while (expected < TEST_THREAD_BYTES)
+    {
+        uint8_t out[TEST_RING_SIZE];
+        size_t read = user_uart_ring_read(&test_shared_ring, out, 1 + test_random() % sizeof(out));
+
+        for (size_t i = 0; i < read; i++)
+        {
+            mismatches += (out[i] != (uint8_t)expected++) ? 1 : 0;
+        }
+        if (read == 0)
+        {
+            sched_yield();
+        }
+    }
+
+    pthread_join(producer, NULL);
+    TEST_CHECK_EQUAL(0, mismatches);
+    TEST_CHECK_EQUAL(0, user_uart_ring_available(&test_shared_ring));
+}
+
+int main(void)
+{
+    TEST_CASE(test_init);
+    TEST_CASE(test_wrap_and_overflow);
+    TEST_CASE(test_full_and_clear);
+    TEST_CASE(test_threads);
+
+    return TEST_RESULT();
+}
+/******************************** End of File *********************************/